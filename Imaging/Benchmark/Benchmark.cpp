@@ -0,0 +1,555 @@
+/* Copyright (C) 20xx Jason Tully - All Rights Reserved
+ * You may use, distribute and modify this code under the
+ * terms of the Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License
+ * http://www.supersinfulsilicon.com/
+ *
+This work is licensed under the Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+To view a copy of this license, visit http://creativecommons.org/licenses/by-nc-sa/4.0/
+or send a letter to Creative Commons, PO Box 1866, Mountain View, CA 94042, USA.
+ */
+
+// Imaging benchmark, console application. All images are synthetic & in memory (no file i/o besides the json report / baseline).
+//
+// Benchmark.exe [-sizes 256,1023,4096] [-time 0.25] [-filter name] [-json report.json] [-baseline previous.json] [-threshold 0.10]
+//
+//  -sizes      square image sizes swept, odd sizes exercise the partial groups at the end of rows
+//  -time       minimum seconds measured per case (at least 3 iterations, the best iteration is reported)
+//  -filter     only cases whose name contains the string
+//  -json       writes the results, one result per line so a report can be used as a baseline
+//  -baseline   compares against a previous report, returns 1 if any case is slower by more than -threshold (fraction)
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define _USE_MATH_DEFINES
+#include <Math/superfastmath.h>
+
+#include <tbb/tbb.h>
+#include "../Imaging/Imaging.h"
+#include <fmt/format.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cfloat>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace synthetic { // deterministic content, smooth gradients + noise so block encoders & lut interpolation see realistic variance
+
+	static constexpr uint32_t const NOISE_AMPLITUDE = 32; // 8bit steps, peak to peak
+
+	static uint32_t const __vectorcall xorshift(uint32_t& __restrict state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return(state);
+	}
+
+	static uint32_t const __vectorcall component_bytes(eIMAGINGMODE const mode)
+	{
+		if (MODE_F32 == mode || MODE_U32 == mode) {
+			return(4);
+		}
+		if ((MODE_L16 | MODE_LA16 | MODE_RGB16 | MODE_BGRX16 | MODE_BGRA16) & mode) {
+			return(2);
+		}
+		return(1);
+	}
+
+	// 0 ... 255, each component of a pixel has a different gradient direction
+	static uint32_t const __vectorcall value(uint32_t const x, uint32_t const y, uint32_t const component, uint32_t const width, uint32_t const height, uint32_t& __restrict state)
+	{
+		uint32_t const gradient((0 == (component & 1)) ? (x * 255u) / width : (y * 255u) / height);
+		int32_t const v(int32_t((gradient + component * 64u) & 0xffu) + int32_t(xorshift(state) % NOISE_AMPLITUDE) - int32_t(NOISE_AMPLITUDE >> 1));
+
+		return(uint32_t(SFM::min(SFM::max(v, 0), 255)));
+	}
+
+	static ImagingMemoryInstance* const __restrict __vectorcall image(eIMAGINGMODE const mode, int const width, int const height)
+	{
+		Imaging const im(ImagingNew(mode, width, height));
+		if (nullptr == im) {
+			return(nullptr);
+		}
+
+		uint32_t const bytes(component_bytes(mode));
+		uint32_t const components(uint32_t(im->pixelsize) / bytes);
+
+		tbb::parallel_for(int(0), height, [=](int const y) {
+
+			uint32_t state(0x9E3779B9u ^ (uint32_t(y) * 0x85EBCA6Bu)); // per row, independent of the thread
+			xorshift(state);
+
+			uint8_t* const __restrict row(im->image[y]);
+
+			for (int x = 0; x < width; ++x) {
+				for (uint32_t c = 0; c < components; ++c) {
+
+					uint32_t const v(value(uint32_t(x), uint32_t(y), c, uint32_t(width), uint32_t(height), state));
+					size_t const i(size_t(x) * components + c);
+
+					switch (bytes)
+					{
+					case 4:
+						if (MODE_F32 == mode) {
+							reinterpret_cast<float* const __restrict>(row)[i] = float(v) / 255.0f;
+						}
+						else {
+							reinterpret_cast<uint32_t* const __restrict>(row)[i] = v;
+						}
+						break;
+					case 2:
+						reinterpret_cast<uint16_t* const __restrict>(row)[i] = uint16_t(v * 257u);
+						break;
+					default:
+						row[i] = uint8_t(v);
+						break;
+					}
+				}
+			}
+		});
+
+		return(im);
+	}
+
+	// MODE_L16 rolling terrain (0.0 ... 1.0) w/ fine detail, input for the normal map cases
+	static ImagingMemoryInstance* const __restrict __vectorcall height_map(int const width, int const height)
+	{
+		Imaging const im(ImagingNew(MODE_L16, width, height));
+		if (nullptr == im) {
+			return(nullptr);
+		}
+
+		tbb::parallel_for(int(0), height, [=](int const y) {
+
+			uint32_t state(0x2545F491u ^ (uint32_t(y) * 0x9E3779B1u));
+			xorshift(state);
+
+			uint16_t* const __restrict row(reinterpret_cast<uint16_t* const __restrict>(im->image[y]));
+
+			for (int x = 0; x < width; ++x) {
+
+				float const h(0.5f + 0.3f * std::sin(float(x) * 0.031f) * std::cos(float(y) * 0.047f) + 0.1f * std::sin(float(x + y) * 0.173f)
+							  + 0.02f * (float(xorshift(state) & 0xffffu) / 65535.0f - 0.5f));
+
+				row[x] = uint16_t(SFM::min(SFM::max(h, 0.0f), 1.0f) * 65535.0f + 0.5f);
+			}
+		});
+
+		return(im);
+	}
+
+	// identity 3D lut, entry (r, g, b) at ((b * size + g) * size + r) * 4 - same layout as a loaded .cube
+	static ImagingLUT* const __restrict __vectorcall identity_lut(uint32_t const size)
+	{
+		ImagingLUT* const __restrict lut(ImagingNew(int(size)));
+		if (nullptr == lut) {
+			return(nullptr);
+		}
+
+		for (uint32_t b = 0; b < size; ++b) {
+			for (uint32_t g = 0; g < size; ++g) {
+				for (uint32_t r = 0; r < size; ++r) {
+
+					uint16_t* const __restrict entry(lut->block + ((((b * size) + g) * size + r) << 2));
+
+					entry[0] = uint16_t((r * 65535u) / (size - 1));
+					entry[1] = uint16_t((g * 65535u) / (size - 1));
+					entry[2] = uint16_t((b * 65535u) / (size - 1));
+					entry[3] = 0xffffu;
+				}
+			}
+		}
+
+		return(lut);
+	}
+
+	typedef struct fixtures { // source images for one size, shared (read only, or restored) by all cases
+
+		Imaging bgrx, bgra, bgrx16, la, l, l16, f32, height, normals, normals_bgra16;
+		ImagingLUT* lut;
+
+		bool const __vectorcall create(int const size)
+		{
+			bgrx = image(MODE_BGRX, size, size);
+			bgra = image(MODE_BGRA, size, size);
+			bgrx16 = image(MODE_BGRX16, size, size);
+			la = image(MODE_LA, size, size);
+			l = image(MODE_L, size, size);
+			l16 = image(MODE_L16, size, size);
+			f32 = image(MODE_F32, size, size);
+			height = height_map(size, size);
+			normals = (nullptr != height ? ImagingHeightMapToNormalMap(height) : nullptr);
+			normals_bgra16 = (nullptr != normals ? ImagingConvert(normals, MODE_BGRA16) : nullptr);
+			lut = identity_lut(33);
+
+			return(nullptr != bgrx && nullptr != bgra && nullptr != bgrx16 && nullptr != la && nullptr != l && nullptr != l16 && nullptr != f32 &&
+				   nullptr != height && nullptr != normals && nullptr != normals_bgra16 && nullptr != lut);
+		}
+
+		void __vectorcall destroy()
+		{
+			for (Imaging const im : { bgrx, bgra, bgrx16, la, l, l16, f32, height, normals, normals_bgra16 }) {
+				ImagingDelete(im);
+			}
+			ImagingDelete(lut);
+			*this = fixtures{};
+		}
+
+	} fixtures;
+
+} // end ns
+
+namespace bench {
+
+	static constexpr uint32_t const MIN_ITERATIONS = 3,
+		                            MAX_ITERATIONS = 10000;
+
+	typedef struct result {
+
+		std::string name;
+		int         width, height;
+		uint32_t    iterations;
+		double      seconds;				// best iteration
+		double      pixels_per_second;		// source pixels
+		double      bytes_per_second;		// source bytes
+
+	} result;
+
+	typedef struct settings {
+
+		std::vector<int> sizes{ 256, 1023, 4096 };
+		double           min_time = 0.25;
+		double           threshold = 0.10;
+		std::string_view filter, json, baseline;
+
+	} settings;
+
+	typedef struct context {
+
+		settings const&     options;
+		std::vector<result> results;
+		uint32_t            failed;
+
+	} context;
+
+	// nullptr is a failed operation, anything else is released
+	static bool const __vectorcall release(ImagingMemoryInstance* const __restrict im) { ImagingDelete(im); return(nullptr != im); }
+	static bool const __vectorcall release(ImagingHistogram* const __restrict histo) { ImagingDelete(histo); return(nullptr != histo); }
+	static bool const __vectorcall release(ImagingMipChain* const __restrict chain) { ImagingDelete(chain); return(nullptr != chain); }
+
+	// op returns false on failure. one warm up iteration (excluded), then iterations until min_time has been measured
+	template<typename Op>
+	static void __vectorcall run(context& __restrict ctx, std::string_view const name, ImagingMemoryInstance const* const __restrict src, Op&& op)
+	{
+		if (!ctx.options.filter.empty() && std::string_view::npos == name.find(ctx.options.filter)) {
+			return;
+		}
+
+		using clock = std::chrono::steady_clock;
+
+		if (!op()) {
+			fmt::print("{:<32} {:>5} x {:<5} FAILED\n", name, src->xsize, src->ysize);
+			++ctx.failed;
+			return;
+		}
+
+		double best(DBL_MAX), total(0.0);
+		uint32_t iterations(0);
+
+		do {
+			clock::time_point const start(clock::now());
+			bool const ok(op());
+			double const seconds(std::chrono::duration<double>(clock::now() - start).count());
+
+			if (!ok) {
+				fmt::print("{:<32} {:>5} x {:<5} FAILED\n", name, src->xsize, src->ysize);
+				++ctx.failed;
+				return;
+			}
+			best = SFM::min(best, seconds);
+			total += seconds;
+
+		} while (++iterations < MAX_ITERATIONS && (iterations < MIN_ITERATIONS || total < ctx.options.min_time));
+
+		double const pixels(double(src->xsize) * double(src->ysize));
+		double const bytes(pixels * double(src->pixelsize));
+
+		result const r{ std::string(name), src->xsize, src->ysize, iterations, best, pixels / best, bytes / best };
+
+		fmt::print("{:<32} {:>5} x {:<5} {:>6} it {:>10.3f} ms {:>10.1f} Mpixels/s {:>8.2f} GB/s\n",
+				   r.name, r.width, r.height, r.iterations, r.seconds * 1000.0, r.pixels_per_second * 1e-6, r.bytes_per_second * 1e-9);
+
+		ctx.results.emplace_back(r);
+	}
+
+	static void __vectorcall run_all(context& __restrict ctx, synthetic::fixtures& __restrict f)
+	{
+		static constexpr struct {
+			std::string_view name;
+			int              filter;
+		} const filters[] = {
+			{ "box", IMAGING_TRANSFORM_BOX }, { "bilinear", IMAGING_TRANSFORM_BILINEAR }, { "hamming", IMAGING_TRANSFORM_HAMMING },
+			{ "bicubic", IMAGING_TRANSFORM_BICUBIC }, { "lanczos", IMAGING_TRANSFORM_LANCZOS }
+		};
+
+		int const size(f.bgrx->xsize), half(SFM::max(1, size >> 1));
+
+		// resample, every filter down & up w/ BGRX, lanczos for the other pixel types
+		for (auto const& filter : filters) {
+			run(ctx, fmt::format("resample_{}_down_bgrx", filter.name), f.bgrx, [&] { return(release(ImagingResample(f.bgrx, half, half, filter.filter))); });
+			run(ctx, fmt::format("resample_{}_up_bgrx", filter.name), f.bgrx, [&] { return(release(ImagingResample(f.bgrx, size + half, size + half, filter.filter))); });
+		}
+		run(ctx, "resample_lanczos_down_l", f.l, [&] { return(release(ImagingResample(f.l, half, half, IMAGING_TRANSFORM_LANCZOS))); });
+		run(ctx, "resample_lanczos_down_la", f.la, [&] { return(release(ImagingResample(f.la, half, half, IMAGING_TRANSFORM_LANCZOS))); });
+		run(ctx, "resample_lanczos_down_bgrx16", f.bgrx16, [&] { return(release(ImagingResample(f.bgrx16, half, half, IMAGING_TRANSFORM_LANCZOS))); });
+		run(ctx, "resample_lanczos_down_f32", f.f32, [&] { return(release(ImagingResample(f.f32, half, half, IMAGING_TRANSFORM_LANCZOS))); });
+		ImagingResampleFlushCache();
+
+		// convert
+		run(ctx, "convert_bgrx_to_l", f.bgrx, [&] { return(release(ImagingConvert(f.bgrx, MODE_L))); });
+		run(ctx, "convert_bgrx_to_bgrx16", f.bgrx, [&] { return(release(ImagingConvert(f.bgrx, MODE_BGRX16))); });
+		run(ctx, "convert_bgrx16_to_bgrx", f.bgrx16, [&] { return(release(ImagingConvert(f.bgrx16, MODE_BGRX))); });
+		run(ctx, "convert_l16_to_f32", f.l16, [&] { return(release(ImagingConvert(f.l16, MODE_F32))); });
+		run(ctx, "convert_f32_to_l16", f.f32, [&] { return(release(ImagingF32ToL16(f.f32, 0.0, 1.0))); });
+
+		// histogram
+		run(ctx, "histogram_bgrx", f.bgrx, [&] { return(release(ImagingNewHistogram(f.bgrx))); });
+		run(ctx, "histogram_l16", f.l16, [&] { return(release(ImagingNewHistogram(f.l16))); });
+		run(ctx, "histogram_f32", f.f32, [&] { return(release(ImagingNewHistogram(f.f32, 0.0f, 1.0f))); });
+
+		// lut, identity so the image is unchanged between iterations
+		run(ctx, "lut_tetrahedral_bgrx", f.bgrx, [&] { return(ImagingApplyLUT(f.bgrx, f.lut, IMAGING_LUT_TETRAHEDRAL)); });
+		run(ctx, "lut_trilinear_bgrx", f.bgrx, [&] { return(ImagingApplyLUT(f.bgrx, f.lut, IMAGING_LUT_TRILINEAR)); });
+		run(ctx, "lut_tetrahedral_bgrx16", f.bgrx16, [&] { return(ImagingApplyLUT(f.bgrx16, f.lut, IMAGING_LUT_TETRAHEDRAL)); });
+
+		// rotate & flip, inplace ops are their own inverse over 2 iterations
+		run(ctx, "rotate_cw_bgrx", f.bgrx, [&] { return(release(ImagingRotateCW(f.bgrx))); });
+		run(ctx, "rotate_ccw_l", f.l, [&] { return(release(ImagingRotateCCW(f.l))); });
+		run(ctx, "rotate_180_bgrx", f.bgrx, [&] { return(ImagingRotate180(f.bgrx)); });
+		run(ctx, "flip_vertical_bgrx", f.bgrx, [&] { ImagingVerticalFlip(f.bgrx); return(true); });
+		run(ctx, "flip_horizontal_bgrx", f.bgrx, [&] { return(ImagingHorizontalFlip(f.bgrx)); });
+
+		// block compression, native encoders (bc7 below 0.5 quality never loads Compressonator.dll)
+		run(ctx, "bc1_bgrx", f.bgrx, [&] { return(release(ImagingCompressBGRAToBC1(f.bgrx))); });
+		run(ctx, "bc4_l", f.l, [&] { return(release(ImagingCompressToBC4(f.l))); });
+		run(ctx, "bc5_la", f.la, [&] { return(release(ImagingCompressToBC5(f.la))); });
+		run(ctx, "bc7_bgra_native", f.bgra, [&] { return(release(ImagingCompressBGRAToBC7(f.bgra, 0.25f))); });
+
+		// color space
+		run(ctx, "srgb_to_linear16_bgrx", f.bgrx, [&] { return(release(ImagingSRGBToLinear16(f.bgrx))); });
+		run(ctx, "linear16_to_srgb_bgrx16", f.bgrx16, [&] { return(release(ImagingLinear16ToSRGB(f.bgrx16))); });
+		run(ctx, "oklab_roundtrip_bgrx16", f.bgrx16, [&] { return(ImagingLinearToOKLAB(f.bgrx16) && ImagingOKLABToLinear(f.bgrx16)); });
+		run(ctx, "oklab_planes_bgrx16", f.bgrx16, [&] {
+			Imaging L(nullptr), a(nullptr), b(nullptr);
+			bool const ok(ImagingLinearToOKLAB(f.bgrx16, L, a, b));
+			ImagingDelete(L); ImagingDelete(a); ImagingDelete(b);
+			return(ok);
+		});
+
+		// normal maps
+		run(ctx, "height_to_normal_sobel_l16", f.height, [&] { return(release(ImagingHeightMapToNormalMap(f.height, 1.0f, IMAGING_NORMAL_SOBEL))); });
+		run(ctx, "height_to_normal_scharr_l16", f.height, [&] { return(release(ImagingHeightMapToNormalMap(f.height, 1.0f, IMAGING_NORMAL_SCHARR))); });
+		run(ctx, "normal_renormalize_bgrx16", f.normals, [&] { return(ImagingRenormalizeNormalMap(f.normals)); });
+		run(ctx, "normal_mip_chain_bgrx16", f.normals, [&] { return(release(ImagingGenerateNormalMipChain(f.normals))); });
+		run(ctx, "normal_to_derivative_bgra16", f.normals_bgra16, [&] { return(release(ImagingTangentSpaceNormalMapToDerivativeMapBGRA16(f.normals_bgra16))); });
+	}
+
+	static bool const __vectorcall save_json(settings const& __restrict options, std::vector<result> const& __restrict results)
+	{
+		FILE* fOut(nullptr);
+
+		if (0 != fopen_s(&fOut, std::string(options.json).c_str(), "wb")) {
+			return(false);
+		}
+
+		fmt::print(fOut, "{{\n  \"benchmark\": \"Imaging\",\n  \"threads\": {},\n  \"min_time\": {},\n  \"results\": [\n", tbb::this_task_arena::max_concurrency(), options.min_time);
+
+		for (size_t i = 0; i < results.size(); ++i) {
+
+			result const& r(results[i]);
+
+			fmt::print(fOut, "    {{ \"name\": \"{}\", \"width\": {}, \"height\": {}, \"iterations\": {}, \"seconds\": {:.9f}, \"pixels_per_second\": {:.1f}, \"bytes_per_second\": {:.1f} }}{}\n",
+					   r.name, r.width, r.height, r.iterations, r.seconds, r.pixels_per_second, r.bytes_per_second, (i + 1 < results.size() ? "," : ""));
+		}
+
+		fmt::print(fOut, "  ]\n}}\n");
+		fclose(fOut); fOut = nullptr;
+
+		return(true);
+	}
+
+	// reads the results of a report written by save_json (one result per line)
+	static bool const __vectorcall load_json(std::string_view const filename, std::vector<result>& __restrict results)
+	{
+		FILE* fIn(nullptr);
+
+		if (0 != fopen_s(&fIn, std::string(filename).c_str(), "rb")) {
+			return(false);
+		}
+
+		char line[1024];
+		while (nullptr != fgets(line, sizeof(line), fIn)) {
+
+			static constexpr char const NAME[] = "\"name\": \"";
+
+			char const* const name(strstr(line, NAME));
+			if (nullptr == name) {
+				continue;
+			}
+
+			char const* const name_begin(name + (sizeof(NAME) - 1));
+			char const* const name_end(strchr(name_begin, '"'));
+			char const* const width(strstr(line, "\"width\":"));
+			char const* const height(strstr(line, "\"height\":"));
+			char const* const pixels(strstr(line, "\"pixels_per_second\":"));
+
+			if (nullptr == name_end || nullptr == width || nullptr == height || nullptr == pixels) {
+				continue;
+			}
+
+			result r{ std::string(name_begin, name_end), 0, 0, 0, 0.0, 0.0, 0.0 };
+
+			r.width = atoi(width + 8);
+			r.height = atoi(height + 9);
+			r.pixels_per_second = atof(pixels + 20);
+
+			if (r.pixels_per_second > 0.0) {
+				results.emplace_back(r);
+			}
+		}
+
+		fclose(fIn); fIn = nullptr;
+
+		return(!results.empty());
+	}
+
+	// returns the number of cases slower than the baseline by more than the threshold
+	static uint32_t const __vectorcall compare(settings const& __restrict options, std::vector<result> const& __restrict results, std::vector<result> const& __restrict baseline)
+	{
+		uint32_t regressions(0);
+
+		fmt::print("\ncompared to {} (threshold {:.0f}%)\n", options.baseline, options.threshold * 100.0);
+
+		for (result const& r : results) {
+
+			result const* match(nullptr);
+			for (result const& b : baseline) {
+				if (b.width == r.width && b.height == r.height && b.name == r.name) {
+					match = &b;
+					break;
+				}
+			}
+
+			if (nullptr == match) {
+				fmt::print("{:<32} {:>5} x {:<5} new\n", r.name, r.width, r.height);
+				continue;
+			}
+
+			double const ratio(r.pixels_per_second / match->pixels_per_second);
+			bool const regressed(ratio < (1.0 - options.threshold));
+
+			regressions += uint32_t(regressed);
+
+			fmt::print("{:<32} {:>5} x {:<5} {:>10.1f} -> {:>10.1f} Mpixels/s {:>7.2f}x{}\n",
+					   r.name, r.width, r.height, match->pixels_per_second * 1e-6, r.pixels_per_second * 1e-6, ratio, (regressed ? "  REGRESSION" : ""));
+		}
+
+		fmt::print("{} regression(s)\n", regressions);
+
+		return(regressions);
+	}
+
+	static bool const __vectorcall parse(int const argc, char const* const* const argv, settings& __restrict options)
+	{
+		for (int i = 1; i < argc; ++i) {
+
+			std::string_view const arg(argv[i]);
+			bool const value(i + 1 < argc);
+
+			if ("-sizes" == arg && value) {
+				options.sizes.clear();
+				for (char const* p = argv[++i]; '\0' != *p; ) {
+					char* end(nullptr);
+					long const size(strtol(p, &end, 10));
+					if (end == p || size <= 0) {
+						return(false);
+					}
+					options.sizes.emplace_back(int(size));
+					p = (',' == *end ? end + 1 : end);
+				}
+			}
+			else if ("-time" == arg && value) {
+				options.min_time = atof(argv[++i]);
+			}
+			else if ("-threshold" == arg && value) {
+				options.threshold = atof(argv[++i]);
+			}
+			else if ("-filter" == arg && value) {
+				options.filter = argv[++i];
+			}
+			else if ("-json" == arg && value) {
+				options.json = argv[++i];
+			}
+			else if ("-baseline" == arg && value) {
+				options.baseline = argv[++i];
+			}
+			else {
+				return(false);
+			}
+		}
+		return(!options.sizes.empty());
+	}
+
+} // end ns
+
+int main(int argc, char* argv[])
+{
+	bench::settings options;
+
+	if (!bench::parse(argc, argv, options)) {
+		fmt::print("usage: Benchmark [-sizes 256,1023,4096] [-time 0.25] [-filter name] [-json report.json] [-baseline previous.json] [-threshold 0.10]\n");
+		return(2);
+	}
+
+	std::vector<bench::result> baseline;
+	if (!options.baseline.empty() && !bench::load_json(options.baseline, baseline)) {
+		fmt::print("baseline {} could not be read\n", options.baseline);
+		return(2);
+	}
+
+	bench::context ctx{ options, {}, 0 };
+
+	fmt::print("Imaging benchmark, {} threads\n", tbb::this_task_arena::max_concurrency());
+
+	for (int const size : options.sizes) {
+
+		synthetic::fixtures f{};
+
+		if (!f.create(size)) {
+			fmt::print("{} x {} synthetic images could not be created\n", size, size);
+			f.destroy();
+			return(2);
+		}
+
+		bench::run_all(ctx, f);
+
+		f.destroy();
+	}
+
+	if (!options.json.empty() && !bench::save_json(options, ctx.results)) {
+		fmt::print("{} could not be written\n", options.json);
+		return(2);
+	}
+
+	uint32_t regressions(0);
+	if (!baseline.empty()) {
+		regressions = bench::compare(options, ctx.results, baseline);
+	}
+
+	return((0 != ctx.failed || 0 != regressions) ? 1 : 0);
+}
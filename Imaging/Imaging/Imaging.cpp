@@ -3,6 +3,8 @@
 #include "Imaging.h"
 #include <set>
 #include <Math/superfastmath.h>
+#include <tbb/scalable_allocator.h>
+#include <Utility/mem.h>
 
 #pragma intrinsic(memcpy)
 #pragma intrinsic(memset)
@@ -13,12 +15,45 @@ namespace palette_Konstants {
 	XMGLOBALCONST inline XMVECTORF32 const _luma{ { { 0.2126f, 0.7152f, 0.0722f, 0.f } } }; // #define LUMA vec3(0.2126f, 0.7152f, 0.0722f)
 } // end ns
 
+namespace palette_search {
+
+	// range of the palette searched for a color, greys search the greyscale range only, saturated colors exclude it
+	static void __vectorcall search_range(ivec4_t const& __restrict rgba, uint32_t const size, uint32_t& __restrict begin, uint32_t& __restrict end)
+	{
+		constexpr uint32_t const stride_default(256U);
+		constexpr int32_t const grey_variance_max(1);  // empiraclly found value ***do NOT change***
+
+		begin = 0; end = size;  // defaults to complete range (including greyscale range)
+
+		if (size <= stride_default) { // palette w/o the greyscale stride is searched entirely
+			return;
+		}
+
+		if (rgba.r == rgba.g == rgba.b) { // grey ?
+			begin = size - stride_default;  // skip to greyscale range
+			end = size;
+		}
+		else {
+			// +(R - G), +(R - B)
+			// -(G - R), +(G - B)
+			// -(B - R), -(B - G)
+			ivec4_v abs_diff(rgba.r - rgba.g, rgba.r - rgba.b, rgba.g - rgba.b, 0);
+
+			abs_diff.v = SFM::abs(abs_diff.v);
+
+			__m128i const xmTmp = _mm_cmpgt_epi32(abs_diff.v, _mm_set1_epi32(grey_variance_max));
+
+			if ((_mm_movemask_ps(_mm_castsi128_ps(xmTmp)) & 7) == 7) { // all (3) components greater than
+				// decidely not gray
+				end = size - stride_default;   // exclude greyscale range improving accuracy
+			}
+		}
+	}
+} // end ns
+
 // **** xmRGB should be converted to linear space b4 call to this function
 uint32_t const __vectorcall ImagingPaletteIndexClosestColor(uvec4_v const xmRGB, ImagingMemoryInstance const* const __restrict palette)
 {
-	constexpr uint32_t const stride_default(256U);
-	constexpr int32_t const grey_variance_max(1);  // empiraclly found value ***do NOT change***
-
 	uint32_t const size(palette->xsize);
 
 	ivec4_t rgba;
@@ -28,27 +63,8 @@ uint32_t const __vectorcall ImagingPaletteIndexClosestColor(uvec4_v const xmRGB,
 		return(0U); // index 0 is always black
 	}
 
-	uint32_t begin(0), end(size);  // defaults to complete range (including greyscale range)
-
-	if (rgba.r == rgba.g == rgba.b) { // grey ?
-		begin = size - stride_default;  // skip to greyscale range
-		end = size;
-	}
-	else {
-		// +(R - G), +(R - B)
-		// -(G - R), +(G - B)
-		// -(B - R), -(B - G)
-		ivec4_v abs_diff(rgba.r - rgba.g, rgba.r - rgba.b, rgba.g - rgba.b, 0);
-		
-		abs_diff.v = SFM::abs(abs_diff.v);
-
-		__m128i const xmTmp = _mm_cmpgt_epi32(abs_diff.v, _mm_set1_epi32(grey_variance_max));
-
-		if ((_mm_movemask_ps(_mm_castsi128_ps(xmTmp)) & 7) == 7) { // all (3) components greater than
-			// decidely not gray
-			end = size - stride_default;   // exclude greyscale range improving accuracy
-		}
-	}
+	uint32_t begin, end;
+	palette_search::search_range(rgba, size, begin, end);
 
 	struct { // ordered by sequential access order
 		ivec4_v const xmColor;
@@ -105,6 +121,289 @@ uint32_t const __vectorcall ImagingPaletteIndexClosestColor(uvec4_v const xmRGB,
 	return(p.paletteIndex);
 }
 
+namespace palette_search { // AVX2 search of 8 palette entries at a time, same result as the reference ImagingPaletteIndexClosestColor above
+
+	static constexpr uint32_t const QUANTIZE_GRAIN = 16; // rows
+
+	// same expression as the reference for a bit exact dot product
+	static XMVECTOR const __vectorcall direction(ivec4_v const xmColor)
+	{
+		return(XMVector3Normalize(XMVectorScale(xmColor.v4f(), 1.0f / 255.0f)));
+	}
+
+	static uint32_t const __vectorcall closest(ImagingPaletteAccelerator const* const __restrict accel, uvec4_v const xmRGB, ivec4_t const& __restrict rgba, uint32_t const begin, uint32_t const end)
+	{
+		alignas(32) int32_t distances[8];
+
+		__m256i const xmR(_mm256_set1_epi32(rgba.r)), xmG(_mm256_set1_epi32(rgba.g)), xmB(_mm256_set1_epi32(rgba.b));
+		__m256i const xmBegin(_mm256_set1_epi32(int32_t(begin) - 1)), xmEnd(_mm256_set1_epi32(int32_t(end)));
+		__m256i const xmLanes(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+		XMVECTOR const xmfColor(direction(ivec4_v(xmRGB.v)));
+
+		uint32_t minimumDistance(UINT32_MAX - 1U), paletteIndex(0);
+		float dotProduct(0.0f);
+
+		for (uint32_t block = begin & ~7U; block < end; block += 8) {
+
+			__m256i const xmIndex(_mm256_add_epi32(_mm256_set1_epi32(int32_t(block)), xmLanes));
+			__m256i const xmValid(_mm256_and_si256(_mm256_cmpgt_epi32(xmIndex, xmBegin), _mm256_cmpgt_epi32(xmEnd, xmIndex)));
+
+			__m256i const xmDR(_mm256_sub_epi32(xmR, _mm256_load_si256(reinterpret_cast<__m256i const*>(accel->r + block))));
+			__m256i const xmDG(_mm256_sub_epi32(xmG, _mm256_load_si256(reinterpret_cast<__m256i const*>(accel->g + block))));
+			__m256i const xmDB(_mm256_sub_epi32(xmB, _mm256_load_si256(reinterpret_cast<__m256i const*>(accel->b + block))));
+
+			// values are in a range 0...255 - so this will never overflow
+			__m256i const xmDistance(_mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(xmDR, xmDR), _mm256_mullo_epi32(xmDG, xmDG)), _mm256_mullo_epi32(xmDB, xmDB)));
+
+			// candidates are lanes w/ distance <= minimum distance at the start of the block, the minimum only decreases so no candidate of the reference is missed
+			__m256i const xmLimit(_mm256_set1_epi32(int32_t(SFM::min(minimumDistance, uint32_t(INT32_MAX)))));
+			uint32_t candidates(uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(_mm256_cmpgt_epi32(xmDistance, xmLimit), xmValid)))));
+
+			if (0 == candidates)
+				continue;
+
+			_mm256_store_si256(reinterpret_cast<__m256i*>(distances), xmDistance);
+
+			do { // in index order, identical to the sequential scan
+				uint32_t const lane(_tzcnt_u32(candidates));
+				candidates &= candidates - 1U;
+
+				uint32_t const index(block + lane);
+				uint32_t const distance_sq(uint32_t(distances[lane]));
+
+				if (0U == distance_sq) { // exact match
+					return(index);
+				}
+				// minimum distance check
+				if (distance_sq <= minimumDistance) {
+
+					// ensure direction is the closest to a dot product equal to one
+					float const dot = XMVectorGetX(SFM::abs(XMVector3Dot(xmfColor, XMLoadFloat4A(reinterpret_cast<XMFLOAT4A const*>(accel->direction + (index << 2U))))));
+
+					if (dot >= dotProduct) {
+
+						minimumDistance = distance_sq;
+						paletteIndex = index;
+						dotProduct = dot;
+					}
+				}
+
+			} while (candidates);
+		}
+
+		return(paletteIndex);
+	}
+
+	static uint32_t const __vectorcall closest(ImagingPaletteAccelerator const* const __restrict accel, uvec4_v const xmRGB)
+	{
+		ivec4_t rgba;
+		ivec4_v(xmRGB.v).xyzw(rgba);
+
+		if (0 == (rgba.r | rgba.g | rgba.b)) { // zero (black)
+			return(0U); // index 0 is always black
+		}
+
+		uint32_t begin, end;
+		search_range(rgba, accel->size, begin, end);
+
+		return(closest(accel, xmRGB, rgba, begin, end));
+	}
+
+	static __inline uint32_t const __vectorcall cube_index(uint32_t const cube_size, uint32_t const shift, uint32_t const r, uint32_t const g, uint32_t const b)
+	{
+		return((((r >> shift) * cube_size) + (g >> shift)) * cube_size + (b >> shift));
+	}
+
+	static void ImagingDestroyPaletteAccelerator(ImagingPaletteAccelerator* const __restrict accel)
+	{
+		if (accel) {
+			if (accel->cube) {
+				scalable_aligned_free(accel->cube); accel->cube = nullptr;
+			}
+			if (accel->r) {
+				scalable_aligned_free(accel->r); accel->r = accel->g = accel->b = nullptr; accel->direction = nullptr; // single block
+			}
+		}
+	}
+
+	template<typename T>
+	static void __vectorcall quantize_rows(ImagingMemoryInstance* const __restrict out, ImagingMemoryInstance const* const __restrict im, ImagingPaletteAccelerator const* const __restrict accel, int32_t const y_begin, int32_t const y_end)
+	{
+		uint32_t const cube_size(accel->cube_size);
+		uint32_t const shift(64 == cube_size ? 2 : 3);
+		int32_t const width(im->xsize);
+
+		for (int32_t y = y_begin; y < y_end; ++y) {
+
+			uint32_t const* __restrict pIn(reinterpret_cast<uint32_t const*>(im->block + size_t(y) * size_t(im->linesize)));
+			T* __restrict pOut(reinterpret_cast<T*>(out->block + size_t(y) * size_t(out->linesize)));
+
+			uint32_t last_color(0), last_index(0); // black is always index 0
+
+			for (int32_t x = 0; x < width; ++x) {
+
+				uint32_t const color(pIn[x] & 0x00FFFFFFU);
+
+				if (color != last_color) { // runs of the same color are common
+					uvec4_t rgba;
+					SFM::unpack_rgba(color, rgba);
+
+					if (accel->cube) {
+						last_index = (0 == color) ? 0U : accel->cube[cube_index(cube_size, shift, rgba.r, rgba.g, rgba.b)];
+					}
+					else {
+						last_index = closest(accel, uvec4_v(rgba));
+					}
+					last_color = color;
+				}
+				pOut[x] = T(last_index);
+			}
+		}
+	}
+} // end ns
+
+ImagingPaletteAccelerator* const __restrict __vectorcall ImagingNewPaletteAccelerator(ImagingMemoryInstance const* const __restrict palette, uint32_t const cube_size)
+{
+	if (nullptr == palette || MODE_BGRX != palette->mode || palette->xsize <= 0) {
+		return (ImagingPaletteAccelerator*)ImagingError_ModeError();
+	}
+	if (0 != cube_size && 32 != cube_size && 64 != cube_size) {
+		return (ImagingPaletteAccelerator*)ImagingError_ValueError("bad lookup cube size");
+	}
+	if (palette->xsize > 65536) { // indices are at most 16bit (MODE_L16)
+		return (ImagingPaletteAccelerator*)ImagingError_ValueError("palette larger than 65536 colors");
+	}
+
+	ImagingPaletteAccelerator* const __restrict accel((ImagingPaletteAccelerator*)scalable_malloc(1 * sizeof(ImagingPaletteAccelerator)));
+	if (!accel) {
+		return (ImagingPaletteAccelerator*)ImagingError_MemoryError();
+	}
+	memset(accel, 0, sizeof(ImagingPaletteAccelerator));
+	accel->destroy = static_cast<void(*)(ImagingPaletteAccelerator* const __restrict)>(&palette_search::ImagingDestroyPaletteAccelerator);
+
+	uint32_t const size(uint32_t(palette->xsize));
+	uint32_t const padded(uint32_t(SFM::roundToMultipleOf<true>(int64_t(size), 8ll)));
+
+	accel->palette = palette;
+	accel->size = size;
+	accel->padded = padded;
+
+	// single block: r, g, b (int32 each) & direction (float4)
+	accel->r = (int32_t*)scalable_aligned_malloc(size_t(padded) * (3 * sizeof(int32_t) + 4 * sizeof(float)), CACHE_LINE_BYTES);
+	if (!accel->r) {
+		ImagingDelete(accel);
+		return (ImagingPaletteAccelerator*)ImagingError_MemoryError();
+	}
+	accel->g = accel->r + padded;
+	accel->b = accel->g + padded;
+	accel->direction = reinterpret_cast<float*>(accel->b + padded);
+	memset(accel->r, 0, size_t(padded) * (3 * sizeof(int32_t) + 4 * sizeof(float)));
+
+	uint32_t const* const __restrict paletteBlock(reinterpret_cast<uint32_t const* const __restrict>(palette->block));
+
+	for (uint32_t index = 0; index < size; ++index) {
+
+		uvec4_t rgba;
+		SFM::unpack_rgba(paletteBlock[index] & 0x00FFFFFFU, rgba);
+
+		accel->r[index] = int32_t(rgba.r);
+		accel->g[index] = int32_t(rgba.g);
+		accel->b[index] = int32_t(rgba.b);
+
+		XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(accel->direction + (index << 2U)), palette_search::direction(ivec4_v(uvec4_v(rgba).v)));
+	}
+
+	if (0 != cube_size) {
+
+		uint32_t const cells(cube_size * cube_size * cube_size);
+		accel->cube = (uint16_t*)scalable_aligned_malloc(cells * sizeof(uint16_t), CACHE_LINE_BYTES);
+		if (!accel->cube) {
+			ImagingDelete(accel);
+			return (ImagingPaletteAccelerator*)ImagingError_MemoryError();
+		}
+		accel->cube_size = cube_size;
+
+		uint32_t const shift(64 == cube_size ? 2 : 3);
+
+		// each cell holds the closest color to the center of the cell
+		tbb::parallel_for(uint32_t(0), cube_size, [accel, cube_size, shift](uint32_t const r) {
+
+			uint32_t const half(1U << (shift - 1U));
+
+			for (uint32_t g = 0; g < cube_size; ++g) {
+				for (uint32_t b = 0; b < cube_size; ++b) {
+
+					uvec4_v const xmRGB((r << shift) + half, (g << shift) + half, (b << shift) + half, 0U);
+
+					accel->cube[palette_search::cube_index(cube_size, 0, r, g, b)] = uint16_t(palette_search::closest(accel, xmRGB));
+				}
+			}
+		});
+	}
+
+	return(accel);
+}
+
+// **** xmRGB should be converted to linear space b4 call to this function
+uint32_t const __vectorcall ImagingPaletteIndexClosestColor(uvec4_v const xmRGB, ImagingPaletteAccelerator const* const __restrict accel)
+{
+	if (accel->cube) {
+
+		uvec4_t rgba;
+		xmRGB.xyzw(rgba);
+
+		if (0 == (rgba.r | rgba.g | rgba.b)) { // zero (black)
+			return(0U); // index 0 is always black
+		}
+
+		uint32_t const shift(64 == accel->cube_size ? 2 : 3);
+		return(accel->cube[palette_search::cube_index(accel->cube_size, shift, SFM::min(rgba.r, 255U), SFM::min(rgba.g, 255U), SFM::min(rgba.b, 255U))]);
+	}
+
+	return(palette_search::closest(accel, xmRGB));
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingQuantizeToPalette(ImagingMemoryInstance const* const __restrict im, ImagingPaletteAccelerator const* const __restrict accel)
+{
+	if (nullptr == im || nullptr == accel || (MODE_BGRX != im->mode && MODE_BGRA != im->mode)) {
+		return (ImagingMemoryInstance*)ImagingError_ModeError();
+	}
+
+	bool const bIndex8(accel->size <= 256U);
+
+	ImagingMemoryInstance* const __restrict out(ImagingNew(bIndex8 ? MODE_L : MODE_L16, im->xsize, im->ysize));
+	if (!out) {
+		return(nullptr);
+	}
+
+	tbb::parallel_for(tbb::blocked_range<int32_t>(0, im->ysize, palette_search::QUANTIZE_GRAIN), [out, im, accel, bIndex8](tbb::blocked_range<int32_t> const& r) {
+
+		if (bIndex8) {
+			palette_search::quantize_rows<uint8_t>(out, im, accel, r.begin(), r.end());
+		}
+		else {
+			palette_search::quantize_rows<uint16_t>(out, im, accel, r.begin(), r.end());
+		}
+	});
+
+	return(out);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingQuantizeToPalette(ImagingMemoryInstance const* const __restrict im, ImagingMemoryInstance const* const __restrict palette)
+{
+	ImagingPaletteAccelerator const* const __restrict accel(ImagingNewPaletteAccelerator(palette, 64));
+	if (!accel) {
+		return(nullptr);
+	}
+
+	ImagingMemoryInstance* const __restrict out(ImagingQuantizeToPalette(im, accel));
+
+	ImagingDelete(accel);
+
+	return(out);
+}
+
 struct PaletteColor
 {
 	uint32_t color,
@@ -700,6 +999,31 @@ eIMAGINGMODE const VKtoImagingMode(uint32_t const vkFormat) {
 	return MODE_ERROR;
 }
 
+uint32_t const ImagingModeToVKFormat(eIMAGINGMODE const mode) {
+	switch (mode) {
+	case MODE_L:
+		return VK_FORMAT_R8_UNORM;
+	case MODE_LA:
+		return VK_FORMAT_R8G8_UNORM;
+	case MODE_L16:
+		return VK_FORMAT_R16_UNORM;
+	case MODE_LA16:
+		return VK_FORMAT_R16G16_UNORM;
+	case MODE_BGRX: // saved as is, same as ImagingSaveToKTX (GL_RGBA8)
+	case MODE_BGRA:
+		return VK_FORMAT_R8G8B8A8_UNORM;
+	case MODE_BGRX16:
+	case MODE_BGRA16:
+		return VK_FORMAT_R16G16B16A16_UNORM;
+	case MODE_BC7:
+		return VK_FORMAT_BC7_UNORM_BLOCK;
+	default:
+		break;
+	}
+
+	return VK_FORMAT_UNDEFINED;
+}
+
 /* exception state */
 
 void *
@@ -1032,3 +1356,279 @@ uint32_t const ImagingSRGBtoLinear(uint32_t const packed_srgb)
 }
 
 
+
+/* mipmaps */
+
+namespace { // local to this file only
+
+	static constexpr int32_t const MIP_TILE_ROWS = 32,  // output tile dimensions for the 2x2 reduction
+		                           MIP_TILE_COLS = 512;
+
+	// 32bit versions of the srgb <-> linear tables for AVX2 gathers, 10bit linear
+	typedef struct srgb_tables {
+
+		alignas(64) uint32_t to_linear[256];
+		alignas(64) uint32_t to_srgb[1024];
+
+		srgb_tables()
+		{
+			for (uint32_t i = 0; i < 256; ++i) {
+				to_linear[i] = srgb_to_linear_lut[i];
+			}
+			// inverse of srgb_to_linear_lut, nearest srgb value for each linear value (table is monotonic)
+			uint32_t srgb(0);
+			for (uint32_t linear = 0; linear < 1024; ++linear) {
+				while (srgb < 255 && (int32_t)srgb_to_linear_lut[srgb + 1] - (int32_t)linear <= (int32_t)linear - (int32_t)srgb_to_linear_lut[srgb]) {
+					++srgb;
+				}
+				to_srgb[linear] = srgb;
+			}
+		}
+	} srgb_tables;
+
+	static srgb_tables const& __vectorcall get_srgb_tables()
+	{
+		static srgb_tables const tables;
+		return(tables);
+	}
+
+	static __inline uint8_t const  mip_average(uint8_t const a, uint8_t const b, uint8_t const c, uint8_t const d) { return((uint8_t)((uint32_t(a) + uint32_t(b) + uint32_t(c) + uint32_t(d) + 2u) >> 2u)); }
+	static __inline uint16_t const mip_average(uint16_t const a, uint16_t const b, uint16_t const c, uint16_t const d) { return((uint16_t)((uint32_t(a) + uint32_t(b) + uint32_t(c) + uint32_t(d) + 2u) >> 2u)); }
+	static __inline uint32_t const mip_average(uint32_t const a, uint32_t const b, uint32_t const c, uint32_t const d) { return((uint32_t)((uint64_t(a) + uint64_t(b) + uint64_t(c) + uint64_t(d) + 2ull) >> 2ull)); }
+	static __inline float const    mip_average(float const a, float const b, float const c, float const d) { return((a + b + c + d) * 0.25f); }
+
+	// reduces output columns [x0, x1) of one output row, source coordinates clamp to the edge (odd or 1 pixel dimensions)
+	template<typename T, int32_t const channels>
+	static void __vectorcall mip_reduce_span(T* const __restrict out, T const* const __restrict row0, T const* const __restrict row1, int32_t const src_width, int32_t const x0, int32_t const x1)
+	{
+		for (int32_t x = x0; x < x1; ++x) {
+			int32_t const sx0(SFM::min(x << 1, src_width - 1) * channels),
+				          sx1(SFM::min((x << 1) + 1, src_width - 1) * channels);
+
+			for (int32_t c = 0; c < channels; ++c) {
+				out[x * channels + c] = mip_average(row0[sx0 + c], row0[sx1 + c], row1[sx0 + c], row1[sx1 + c]);
+			}
+		}
+	}
+
+	template<typename T, int32_t const channels>
+	static void __vectorcall mip_reduce_tile(ImagingMemoryInstance* const __restrict dst, ImagingMemoryInstance const* const __restrict src, tbb::blocked_range2d<int32_t> const& r)
+	{
+		for (int32_t y = r.rows().begin(); y < r.rows().end(); ++y) {
+			T const* const __restrict row0((T const*)src->image[SFM::min(y << 1, src->ysize - 1)]);
+			T const* const __restrict row1((T const*)src->image[SFM::min((y << 1) + 1, src->ysize - 1)]);
+
+			mip_reduce_span<T, channels>((T*)dst->image[y], row0, row1, src->xsize, r.cols().begin(), r.cols().end());
+		}
+	}
+
+	// 8bpc BGRX/BGRA, linear
+	static void __vectorcall mip_reduce_tile_8bpc(ImagingMemoryInstance* const __restrict dst, ImagingMemoryInstance const* const __restrict src, tbb::blocked_range2d<int32_t> const& r)
+	{
+		__m256i const round(_mm256_set1_epi16(2));
+
+		int32_t const simd_end(SFM::min(r.cols().end(), src->xsize >> 1)); // 2 output pixels read 4 source pixels
+
+		for (int32_t y = r.rows().begin(); y < r.rows().end(); ++y) {
+			uint8_t const* const __restrict row0(src->image[SFM::min(y << 1, src->ysize - 1)]);
+			uint8_t const* const __restrict row1(src->image[SFM::min((y << 1) + 1, src->ysize - 1)]);
+			uint32_t* const __restrict out((uint32_t*)dst->image[y]);
+
+			int32_t x(r.cols().begin());
+			for (; (x + 1) < simd_end; x += 2) {
+				__m256i const sum(_mm256_add_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const*)&row0[x << 3])),
+					                               _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const*)&row1[x << 3])))); // lanes: px0 px1 | px2 px3
+
+				__m256i s(_mm256_add_epi16(sum, _mm256_srli_si256(sum, 8))); // px0 + px1 | px2 + px3
+				s = _mm256_srli_epi16(_mm256_add_epi16(s, round), 2);
+				s = _mm256_packus_epi16(s, s);
+
+				out[x] = _mm_cvtsi128_si32(_mm256_castsi256_si128(s));
+				out[x + 1] = _mm_cvtsi128_si32(_mm256_extracti128_si256(s, 1));
+			}
+			mip_reduce_span<uint8_t, 4>((uint8_t*)out, row0, row1, src->xsize, x, r.cols().end());
+		}
+	}
+
+	// 8bpc BGRX/BGRA, color is averaged in linear space, alpha is linear
+	static void __vectorcall mip_reduce_tile_8bpc_srgb(ImagingMemoryInstance* const __restrict dst, ImagingMemoryInstance const* const __restrict src, tbb::blocked_range2d<int32_t> const& r)
+	{
+		srgb_tables const& __restrict tables(get_srgb_tables());
+		int const* const __restrict to_linear((int const*)tables.to_linear);
+		int const* const __restrict to_srgb((int const*)tables.to_srgb);
+
+		__m256i const round(_mm256_set1_epi32(2));
+
+		int32_t const src_width(src->xsize);
+		int32_t const simd_end(SFM::min(r.cols().end(), src_width >> 1)); // 2 output pixels read 4 source pixels
+
+		for (int32_t y = r.rows().begin(); y < r.rows().end(); ++y) {
+			uint8_t const* const __restrict row0(src->image[SFM::min(y << 1, src->ysize - 1)]);
+			uint8_t const* const __restrict row1(src->image[SFM::min((y << 1) + 1, src->ysize - 1)]);
+			uint32_t* const __restrict out((uint32_t*)dst->image[y]);
+
+			int32_t x(r.cols().begin());
+			for (; (x + 1) < simd_end; x += 2) {
+				__m128i const a(_mm_loadu_si128((__m128i const*)&row0[x << 3]));
+				__m128i const b(_mm_loadu_si128((__m128i const*)&row1[x << 3]));
+
+				__m256i const ia0(_mm256_cvtepu8_epi32(a)), ia1(_mm256_cvtepu8_epi32(_mm_srli_si128(a, 8))),
+					          ib0(_mm256_cvtepu8_epi32(b)), ib1(_mm256_cvtepu8_epi32(_mm_srli_si128(b, 8)));
+
+				// srgb -> linear, alpha lanes (3, 7) keep the source value
+				__m256i const s0(_mm256_add_epi32(_mm256_blend_epi32(_mm256_i32gather_epi32(to_linear, ia0, 4), ia0, 0x88),
+					                              _mm256_blend_epi32(_mm256_i32gather_epi32(to_linear, ib0, 4), ib0, 0x88))); // px0 | px1
+				__m256i const s1(_mm256_add_epi32(_mm256_blend_epi32(_mm256_i32gather_epi32(to_linear, ia1, 4), ia1, 0x88),
+					                              _mm256_blend_epi32(_mm256_i32gather_epi32(to_linear, ib1, 4), ib1, 0x88))); // px2 | px3
+
+				__m256i s(_mm256_add_epi32(_mm256_permute2x128_si256(s0, s1, 0x20), _mm256_permute2x128_si256(s0, s1, 0x31))); // px0 + px1 | px2 + px3
+				s = _mm256_srli_epi32(_mm256_add_epi32(s, round), 2);
+
+				// linear -> srgb
+				s = _mm256_blend_epi32(_mm256_i32gather_epi32(to_srgb, s, 4), s, 0x88);
+				s = _mm256_packus_epi32(s, s);
+				s = _mm256_packus_epi16(s, s);
+
+				out[x] = _mm_cvtsi128_si32(_mm256_castsi256_si128(s));
+				out[x + 1] = _mm_cvtsi128_si32(_mm256_extracti128_si256(s, 1));
+			}
+			for (; x < r.cols().end(); ++x) {
+				int32_t const sx0(SFM::min(x << 1, src_width - 1) << 2),
+					          sx1(SFM::min((x << 1) + 1, src_width - 1) << 2);
+
+				uint8_t* const __restrict pixel((uint8_t*)&out[x]);
+				for (int32_t c = 0; c < 3; ++c) {
+					uint32_t const linear((tables.to_linear[row0[sx0 + c]] + tables.to_linear[row0[sx1 + c]] + tables.to_linear[row1[sx0 + c]] + tables.to_linear[row1[sx1 + c]] + 2u) >> 2u);
+					pixel[c] = (uint8_t)tables.to_srgb[linear];
+				}
+				pixel[3] = mip_average(row0[sx0 + 3], row0[sx1 + 3], row1[sx0 + 3], row1[sx1 + 3]);
+			}
+		}
+	}
+
+	// 16bpc BGRX16/BGRA16
+	static void __vectorcall mip_reduce_tile_16bpc(ImagingMemoryInstance* const __restrict dst, ImagingMemoryInstance const* const __restrict src, tbb::blocked_range2d<int32_t> const& r)
+	{
+		__m128i const round(_mm_set1_epi32(2));
+
+		int32_t const simd_end(SFM::min(r.cols().end(), src->xsize >> 1)); // 1 output pixel reads 2 source pixels
+
+		for (int32_t y = r.rows().begin(); y < r.rows().end(); ++y) {
+			uint16_t const* const __restrict row0((uint16_t const*)src->image[SFM::min(y << 1, src->ysize - 1)]);
+			uint16_t const* const __restrict row1((uint16_t const*)src->image[SFM::min((y << 1) + 1, src->ysize - 1)]);
+			uint16_t* const __restrict out((uint16_t*)dst->image[y]);
+
+			int32_t x(r.cols().begin());
+			for (; x < simd_end; ++x) {
+				__m256i const sum(_mm256_add_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const*)&row0[x << 3])),
+					                               _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const*)&row1[x << 3])))); // px0 | px1
+
+				__m128i s(_mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)));
+				s = _mm_srli_epi32(_mm_add_epi32(s, round), 2);
+				_mm_storel_epi64((__m128i*)&out[x << 2], _mm_packus_epi32(s, s));
+			}
+			mip_reduce_span<uint16_t, 4>(out, row0, row1, src->xsize, x, r.cols().end());
+		}
+	}
+
+	static void __vectorcall mip_reduce(ImagingMemoryInstance* const __restrict dst, ImagingMemoryInstance const* const __restrict src, bool const srgb)
+	{
+		tbb::parallel_for(tbb::blocked_range2d<int32_t>(0, dst->ysize, MIP_TILE_ROWS, 0, dst->xsize, MIP_TILE_COLS), [dst, src, srgb](tbb::blocked_range2d<int32_t> const& r) {
+
+			switch (src->mode)
+			{
+			case MODE_L:
+				mip_reduce_tile<uint8_t, 1>(dst, src, r);
+				break;
+			case MODE_LA:
+				mip_reduce_tile<uint8_t, 2>(dst, src, r);
+				break;
+			case MODE_L16:
+				mip_reduce_tile<uint16_t, 1>(dst, src, r);
+				break;
+			case MODE_LA16:
+				mip_reduce_tile<uint16_t, 2>(dst, src, r);
+				break;
+			case MODE_U32:
+				mip_reduce_tile<uint32_t, 1>(dst, src, r);
+				break;
+			case MODE_F32:
+				mip_reduce_tile<float, 1>(dst, src, r);
+				break;
+			case MODE_BGRX:
+			case MODE_BGRA:
+				if (srgb) {
+					mip_reduce_tile_8bpc_srgb(dst, src, r);
+				}
+				else {
+					mip_reduce_tile_8bpc(dst, src, r);
+				}
+				break;
+			case MODE_BGRX16:
+			case MODE_BGRA16:
+				mip_reduce_tile_16bpc(dst, src, r);
+				break;
+			default:
+				break;
+			}
+		});
+	}
+} // end ns
+
+ImagingMipChain* const __restrict __vectorcall ImagingGenerateMipChain(ImagingMemoryInstance const* const __restrict im, uint32_t const maxLevels, bool const srgb, int const filter)
+{
+	if (!im) {
+		return(nullptr);
+	}
+
+	if ((MODE_L | MODE_LA | MODE_L16 | MODE_LA16 | MODE_BGRX | MODE_BGRA | MODE_BGRX16 | MODE_BGRA16 | MODE_U32 | MODE_F32) & im->mode) {
+
+		// full chain down to 1x1
+		uint32_t count(1);
+		while ((uint32_t(SFM::max(im->xsize, im->ysize)) >> count) > 0) {
+			++count;
+		}
+		if (0 != maxLevels) {
+			count = SFM::min(count, maxLevels);
+		}
+
+		ImagingMipChain* const __restrict chain(ImagingNewMipChain(count));
+		if (!chain) {
+			return(nullptr);
+		}
+
+		chain->levels[0] = ImagingCopy(im);
+		if (!chain->levels[0]) {
+			ImagingDelete(chain);
+			return(nullptr);
+		}
+
+		for (uint32_t level = 1; level < count; ++level) {
+
+			ImagingMemoryInstance const* const __restrict previous(chain->levels[level - 1]);
+			int const width(mipScale(im->xsize, level)), height(mipScale(im->ysize, level));
+
+			ImagingMemoryInstance* __restrict next(nullptr);
+
+			if (IMAGING_TRANSFORM_BOX == filter) {
+				next = ImagingNew(im->mode, width, height);
+				if (next) {
+					mip_reduce(next, previous, srgb);
+				}
+			}
+			else {
+				next = ImagingResample(previous, width, height, filter);
+			}
+
+			if (!next) {
+				ImagingDelete(chain);
+				return(nullptr);
+			}
+			chain->levels[level] = next;
+		}
+
+		return(chain);
+	}
+
+	return((ImagingMipChain*)ImagingError_ModeError());
+}
@@ -14,6 +14,7 @@ or send a letter to Creative Commons, PO Box 1866, Mountain View, CA 94042, USA.
 #include <string_view>
 #include <Math/vec4_t.h>
 #include <vector>
+#include <future>
 
 // REQUIRES: LIBRARIES TO BE LINKED IN APPLICATION
 // tbb.lib;tbbmalloc.lib;fmt.lib
@@ -43,10 +44,29 @@ enum eIMAGINGMODE
 
 	MODE_BC7 = (1 << 14),
 	MODE_BC6A = (1 << 15),
+
+	MODE_BC1 = (1 << 16),
+	MODE_BC4 = (1 << 17),
+	MODE_BC5 = (1 << 18),
 	
 	MODE_ERROR
 };
 
+enum eIMAGINGLUMA // weights of R, G, B for color to gray
+{
+	LUMA_REC601 = 0,	/* 0.299, 0.587, 0.114 */
+	LUMA_REC709,		/* 0.2126, 0.7152, 0.0722 */
+	LUMA_AVERAGE		/* 1/3 each */
+};
+
+enum eIMAGINGEXPORT // file format of an export queue job
+{
+	EXPORT_RAW = 0,		/* ImagingSaveRaw */
+	EXPORT_KTX,			/* ImagingSaveToKTX, .ktx or .ktx2 by extension */
+	EXPORT_TIF,			/* ImagingSaveToTif, requires INCLUDE_TIF_SUPPORT */
+	EXPORT_JPEG			/* ImagingSaveJPEG, requires INCLUDE_JPEG_SUPPORT */
+};
+
 /* pixel types */
 #define IMAGING_TYPE_UINT8 (1<<0)        
 #define IMAGING_TYPE_UINT32 (1<<1)       
@@ -60,6 +80,12 @@ enum eIMAGINGMODE
 #define IMAGING_TRANSFORM_BICUBIC 3
 #define IMAGING_TRANSFORM_LANCZOS 4
 
+#define IMAGING_LUT_TETRAHEDRAL 0
+#define IMAGING_LUT_TRILINEAR 1
+
+#define IMAGING_NORMAL_SOBEL 0
+#define IMAGING_NORMAL_SCHARR 1
+
 #define IMAGING_PIXEL_U32(im,x,y) ((im)->image32[(y)][(x)])
 #define IMAGING_PIXEL_U16(im,x,y) ((reinterpret_cast<uint16_t* const* const>((im)->image32))[(y)][(x)])
 
@@ -135,6 +161,23 @@ typedef struct ImagingSequence
 	void(*destroy)(ImagingSequence* __restrict im);
 } ImagingSequence;
 
+typedef struct ImagingCompressedSequence // frames stored as the changed rectangle from the previous frame (palette indices or BGRX, run length coded) with periodic keyframes, decoded on demand
+{
+	uint32_t count;
+	uint32_t xsize;		/* Image dimension. */
+	uint32_t ysize;
+	static inline constexpr uint32_t const pixelsize = sizeof(uint32_t);
+	uint32_t linesize;	/* Size of a line, in bytes (xsize * pixelsize) */
+	uint32_t keyframe_interval;	/* every nth frame is stored whole, worst case # of frames applied for a random access */
+	size_t bytes;		/* compressed size of all frames */
+
+	/* Internals */
+	void* __restrict internal;
+
+	/* Virtual methods */
+	void(*destroy)(ImagingCompressedSequence* __restrict seq);
+} ImagingCompressedSequence;
+
 typedef struct ImagingLUT	// 16bit/channel 3D LUT
 {
 	static inline constexpr uint32_t const bands = 3;		/* BGRX --======= */
@@ -152,24 +195,162 @@ typedef struct ImagingLUT	// 16bit/channel 3D LUT
 
 typedef struct ImagingHistogram // Histogram for ImagingMemoryInstance
 {
-	uint32_t* __restrict block;// 1D Array of count - could be 65536 or 256 depending on image used to create the histogram
+	uint32_t* __restrict block;// 1D Array of count per channel - could be 65536 or 256 depending on image used to create the histogram, channel c begins at block + c * count
 	uint32_t             count;
+	uint32_t             bands;     // # of channels in memory order (B, G, R, A), BGRX & BGRX16 exclude X
+	int                  type;      // IMAGING_TYPE_UINT32 (8bpc & 16bpc, bin is the value) or IMAGING_TYPE_FLOAT32
+	uint64_t             total;     // # of pixels counted (nan excluded)
+	float                range[2];  // value of the first bin, value after the last bin
+	float                minmax[2]; // exact min & max value of the data (all channels)
 
 	/* Virtual methods */
 	void(*destroy)(ImagingHistogram* __restrict im);
 } ImagingHistogram;
 
+typedef struct ImagingMipChain // Mip levels of an image, level 0 is full resolution
+{
+	ImagingMemoryInstance* __restrict* __restrict levels;
+	uint32_t count;
+
+	/* Virtual methods */
+	void(*destroy)(ImagingMipChain* __restrict chain);
+} ImagingMipChain;
+
+typedef struct ImagingTileRect // placement of a streamed tile in the full image
+{
+	int32_t x, y;					/* interior origin in the full image */
+	int32_t xsize, ysize;			/* interior dimension */
+	int32_t apron_left, apron_top;	/* interior origin inside the tile, the apron is clamped to the image edges */
+} ImagingTileRect;
+
+typedef struct ImagingTileStream // tiled read access to an image file larger than memory, only the tiles being processed are resident
+{
+	eIMAGINGMODE mode;				/* mode of the tiles read (RGB & RGB16 are promoted to BGRX & BGRX16) */
+	int32_t xsize;					/* Full image dimension. */
+	int32_t ysize;
+	int32_t tile_xsize;				/* Tile dimension, excluding apron */
+	int32_t tile_ysize;
+	int32_t apron;					/* overlap in pixels on each side of a tile */
+	uint32_t tiles_x, tiles_y;
+	uint32_t next;					/* next tile index for ImagingReadNextTile (row major), set to 0 to restart */
+
+	/* Internals */
+	void* __restrict source;
+
+	/* Virtual methods */
+	void(*destroy)(ImagingTileStream* __restrict stream);
+} ImagingTileStream;
+
+typedef struct ImagingTileWriter // tiled write access to an image file larger than memory
+{
+	eIMAGINGMODE mode;
+	int32_t xsize;					/* Full image dimension. */
+	int32_t ysize;
+
+	/* Internals */
+	void* __restrict sink;
+
+	/* Virtual methods */
+	void(*destroy)(ImagingTileWriter* __restrict writer);
+} ImagingTileWriter;
+
+typedef struct ImagingPaletteAccelerator // precomputed search data for a palette, built once & shared (read only) by all queries
+{
+	ImagingMemoryInstance const* __restrict palette; /* not owned, must outlive the accelerator */
+	uint32_t size;					/* # of palette entries */
+	uint32_t padded;				/* size rounded up to a multiple of 8 */
+
+	/* Internals */
+	int32_t* __restrict r;			/* palette components (SoA), padded */
+	int32_t* __restrict g;
+	int32_t* __restrict b;
+	float* __restrict direction;	/* normalized color direction (xyz_) of each entry */
+
+	uint16_t* __restrict cube;		/* optional nearest index lookup, cube_size^3 entries indexed [r][g][b] (nullptr if not built) */
+	uint32_t cube_size;				/* 0, 32 or 64 */
+
+	/* Virtual methods */
+	void(*destroy)(ImagingPaletteAccelerator* __restrict accel);
+} ImagingPaletteAccelerator;
+
+typedef struct ImagingPool // recycles ImagingNew images, ImagingDelete returns block images of the same mode & size to the pool while it is installed
+{
+	size_t capacity;				/* maximum bytes cached */
+	bool huge_pages;				/* large allocations are backed by huge pages (os permitting) */
+
+	/* Internals */
+	void* __restrict internal;
+
+	/* Virtual methods */
+	void(*destroy)(ImagingPool* __restrict pool);
+} ImagingPool;
+
+typedef struct ImagingExportQueue // bounded queue of save jobs, encoding runs on the compute threads (tbb) & file writes on dedicated i/o threads
+{
+	uint32_t capacity;				/* maximum jobs in flight, ImagingExport blocks while the queue is full */
+	uint32_t io_threads;
+	bool unbuffered;				/* encoded files are written bypassing the os file cache */
+
+	/* Internals */
+	void* __restrict internal;
+
+	/* Virtual methods */
+	void(*destroy)(ImagingExportQueue* __restrict queue);
+} ImagingExportQueue;
+
+typedef struct ImagingExportStats
+{
+	uint64_t submitted, completed, failed;	/* jobs, completed includes failed */
+	uint64_t pending;						/* jobs in flight */
+	uint64_t bytes;							/* written */
+	double seconds;							/* since the queue was created */
+	double images_per_second, bytes_per_second;
+	double encode_seconds, write_seconds;	/* total time spent encoding & writing, over all threads */
+} ImagingExportStats;
+
+// returns the processed tile for the interior of rect_in, rect_out is initialized to rect_in and describes the placement of the returned tile in the output. Can return tile (inplace) or a new instance, nullptr is failure.
+typedef ImagingMemoryInstance* const(__vectorcall* ImagingTileOp)(ImagingMemoryInstance* const __restrict tile, ImagingTileRect const& __restrict rect_in, ImagingTileRect& __restrict rect_out, void* const __restrict user);
+
 
 // color operations //
 uvec4_v const  ImagingSRGBtoLinearVector(uint32_t const packed_srgb); // packed input 8bit SRGB, output 10bit LINEAR unpacked vector
 uint32_t const ImagingSRGBtoLinear(uint32_t const packed_srgb);       // ""  "" "" ""  ""   ""   ""  ""   ""  ""  "" packed
+// whole image passes, rows in parallel. srgb <-> linear: MODE_L, MODE_LA, MODE_RGB, MODE_BGRX, MODE_BGRA (8bpc srgb) <-> the 16bpc mode of the same layout (linear), alpha is scaled linearly
+ImagingMemoryInstance* const __restrict __vectorcall ImagingSRGBToLinear16(ImagingMemoryInstance const* const __restrict im);
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLinear16ToSRGB(ImagingMemoryInstance const* const __restrict im, bool const dither = true); // dither = ordered dither (+-0.5 of an 8bit step) to prevent banding in dark gradients, false is an exact inverse of ImagingSRGBToLinear16
+// OKLAB: linear MODE_BGRX16 / MODE_BGRA16 <-> L, a + 0.5, b + 0.5 (16bit, INPLACE, alpha is unchanged) or L, a, b (3 x MODE_F32 planes, unscaled). out of gamut colors are clamped when converted back to linear
+bool const __vectorcall                              ImagingLinearToOKLAB(ImagingMemoryInstance* const __restrict im);
+bool const __vectorcall                              ImagingOKLABToLinear(ImagingMemoryInstance* const __restrict im);
+bool const __vectorcall                              ImagingLinearToOKLAB(ImagingMemoryInstance const* const __restrict im, ImagingMemoryInstance*& __restrict L, ImagingMemoryInstance*& __restrict a, ImagingMemoryInstance*& __restrict b);
+ImagingMemoryInstance* const __restrict __vectorcall ImagingOKLABToLinear(ImagingMemoryInstance const* const __restrict L, ImagingMemoryInstance const* const __restrict a, ImagingMemoryInstance const* const __restrict b); // MODE_BGRX16
 
 
 // OPERATIONS //
 ImagingMemoryInstance* const __restrict __vectorcall ImagingNew( eIMAGINGMODE const mode, int const xsize, int const ysize);
 ImagingLUT* const __restrict __vectorcall			 ImagingNew(int const size);
-ImagingHistogram* const __restrict __vectorcall		 ImagingNewHistogram(ImagingMemoryInstance const* const __restrict im);
-ImagingMemoryInstance* const __restrict __vectorcall ImagingNewCompressed(eIMAGINGMODE const mode /*should be MODE_BC7 or MODE_BC6A*/, int const xsize, int const ysize, int BufferSize);
+ImagingHistogram* const __restrict __vectorcall		 ImagingNewHistogram(ImagingMemoryInstance const* const __restrict im); // all modes except MODE_U32 & MODE_F32, per channel
+ImagingHistogram* const __restrict __vectorcall		 ImagingNewHistogram(ImagingMemoryInstance const* const __restrict im, float const fMin, float const fMax, uint32_t const count = 4096); // MODE_F32, values outside of the range are counted in the first/last bin
+ImagingMipChain* const __restrict __vectorcall		 ImagingNewMipChain(uint32_t const count); // levels are empty (nullptr)
+ImagingMemoryInstance* const __restrict __vectorcall ImagingNewCompressed(eIMAGINGMODE const mode /*should be MODE_BC1, MODE_BC4, MODE_BC5, MODE_BC7 or MODE_BC6A*/, int const xsize, int const ysize, int BufferSize);
+
+// IMAGE POOL // images of a pipeline that are created & deleted over and over (same mode & size) are recycled instead of reallocated. Pixels of a recycled image are not cleared (same as ImagingNew).
+ImagingPool* const __restrict __vectorcall ImagingNewPool(size_t const capacity = (1ull << 30ull), bool const huge_pages = false); // capacity is the maximum bytes cached
+void __vectorcall ImagingPoolInstall(ImagingPool* const __restrict pool); // ImagingNew & ImagingDelete route thru the installed pool, nullptr uninstalls. images created before the pool was installed are also recycled.
+ImagingPool* const __restrict __vectorcall ImagingPoolInstalled();
+size_t const __vectorcall ImagingPoolCached(ImagingPool const* const __restrict pool); // bytes cached
+void __vectorcall ImagingPoolTrim(ImagingPool* const __restrict pool, size_t const keep); // frees cached images until at most keep bytes remain. ImagingPoolTrim & ImagingPoolReset must not overlap ImagingNew/ImagingDelete on other threads (call between batches)
+void __vectorcall ImagingPoolReset(ImagingPool* const __restrict pool); // frees all cached images
+
+// EXPORT QUEUE // batched, asynchronous saving. RAW & KTX (uncompressed modes) are encoded to memory on the compute threads then written in large sequential writes by the i/o threads, TIF, JPEG & block compressed KTX are saved by the i/o threads.
+ImagingExportQueue* const __restrict __vectorcall ImagingNewExportQueue(uint32_t const capacity = 64, uint32_t const io_threads = 2, bool const unbuffered = false);
+std::future<bool> __vectorcall ImagingExport(ImagingExportQueue* const __restrict queue, ImagingMemoryInstance* const __restrict image /*owned, deleted by the queue*/, eIMAGINGEXPORT const format, std::wstring_view const filenamepath, int const option = 0); // option is the KTX2 zstd supercompression level or the JPEG output mode (eIMAGINGMODE, 0 is MODE_BGRX). the future is false on failure
+void __vectorcall ImagingExportWait(ImagingExportQueue* const __restrict queue); // returns when all submitted jobs are complete
+ImagingExportStats const __vectorcall ImagingExportQueueStats(ImagingExportQueue const* const __restrict queue);
+
+// COMPRESSED SEQUENCE // a loaded sequence kept in memory at a fraction of the size, frames are decoded on demand into a small cache while the next frame is prefetched in the background
+ImagingCompressedSequence* const __restrict __vectorcall ImagingCompressSequence(ImagingSequence const* const __restrict seq, uint32_t const keyframe_interval = 30, uint32_t const cached_frames = 4); // lossless, the source sequence can be deleted afterwards. cached_frames is the # of decoded frames kept (minimum 3)
+ImagingMemoryInstance const* const __restrict __vectorcall ImagingSequenceFrame(ImagingCompressedSequence* const __restrict seq, uint32_t const index); // MODE_BGRX frame, valid until the next ImagingSequenceFrame of this sequence (single consumer). forward playback (looping) is decoded ahead of time
+uint32_t const __vectorcall ImagingSequenceFrameDelay(ImagingCompressedSequence const* const __restrict seq, uint32_t const index); // 0 if index is out of range
 
 ImagingMemoryInstance* const __restrict __vectorcall ImagingCopy(ImagingMemoryInstance const* const __restrict im);
 ImagingLUT* const __restrict __vectorcall			 ImagingCopy(ImagingLUT const* const __restrict lut);
@@ -180,13 +361,37 @@ void __vectorcall ImagingDelete(ImagingMemoryInstance* __restrict im);
 void __vectorcall ImagingDelete(ImagingMemoryInstance const* __restrict im);
 void __vectorcall ImagingDelete(ImagingSequence* __restrict im);
 void __vectorcall ImagingDelete(ImagingSequence const* __restrict im);
+void __vectorcall ImagingDelete(ImagingCompressedSequence* __restrict seq);
+void __vectorcall ImagingDelete(ImagingCompressedSequence const* __restrict seq);
 void __vectorcall ImagingDelete(ImagingLUT* __restrict im);
 void __vectorcall ImagingDelete(ImagingLUT const* __restrict im);
 void __vectorcall ImagingDelete(ImagingHistogram* __restrict im);
 void __vectorcall ImagingDelete(ImagingHistogram const* __restrict im);
+void __vectorcall ImagingDelete(ImagingMipChain* __restrict im);
+void __vectorcall ImagingDelete(ImagingMipChain const* __restrict im);
+void __vectorcall ImagingDelete(ImagingTileStream* __restrict stream);
+void __vectorcall ImagingDelete(ImagingTileStream const* __restrict stream);
+void __vectorcall ImagingDelete(ImagingTileWriter* __restrict writer); // abandons the writer, the file is left incomplete - use ImagingCloseTileWriter
+void __vectorcall ImagingDelete(ImagingPaletteAccelerator* __restrict accel);
+void __vectorcall ImagingDelete(ImagingPool* __restrict pool); // uninstalls the pool if installed, waits for ImagingNew/ImagingDelete calls already using it, then cached images are freed
+void __vectorcall ImagingDelete(ImagingExportQueue* __restrict queue); // waits for all submitted jobs to complete
+void __vectorcall ImagingDelete(ImagingPaletteAccelerator const* __restrict accel);
 
 // SPECIAL FUNCTIONS //
-extern ImagingMemoryInstance* const __restrict __vectorcall ImagingResample(ImagingMemoryInstance const* const __restrict imIn, int const xsize, int const ysize, int const filter = IMAGING_TRANSFORM_BOX); // box filter (default)
+extern ImagingMemoryInstance* const __restrict __vectorcall ImagingResample(ImagingMemoryInstance const* const __restrict imIn, int const xsize, int const ysize, int const filter = IMAGING_TRANSFORM_BOX); // box filter (default). all modes except MODE_1BIT, MODE_RGB & MODE_RGB16
+ImagingSequence* const __restrict __vectorcall ImagingResample(ImagingSequence const* const __restrict imIn, int const xsize, int const ysize, int const filter = IMAGING_TRANSFORM_BOX); // frames in parallel sharing the coefficient tables, output frames are one contiguous allocation
+ImagingMemoryInstance* const __restrict __vectorcall ImagingResampleRegion(ImagingMemoryInstance const* const __restrict imIn, int const src_x, int const src_y, int const full_xsize, int const full_ysize,
+																		   int const out_xsize, int const out_ysize, int const x0, int const y0, int const xsize, int const ysize, int const filter = IMAGING_TRANSFORM_BOX); // output region (x0, y0, xsize, ysize) of the full image resampled to out_xsize x out_ysize, imIn is the part of the full image at (src_x, src_y). filter windows are in global coordinates so regions tile seamlessly
+void __vectorcall ImagingResampleFlushCache(); // releases the cached resampling coefficient tables (cached per input size, output size & filter)
+
+// Mip chain down to 1x1 (maxLevels = 0) or maxLevels, each level is derived from the previous level. Supports MODE_L, MODE_LA, MODE_L16, MODE_LA16, MODE_BGRX, MODE_BGRA, MODE_BGRX16, MODE_BGRA16, MODE_U32, MODE_F32
+// IMAGING_TRANSFORM_BOX is a 2x2 reduction, srgb = true averages the color of 8bpc BGRX/BGRA in linear space (alpha is always linear). Other filters use ImagingResample (no colorspace conversion).
+ImagingMipChain* const __restrict __vectorcall ImagingGenerateMipChain(ImagingMemoryInstance const* const __restrict im, uint32_t const maxLevels = 0, bool const srgb = true, int const filter = IMAGING_TRANSFORM_BOX);
+
+// HISTOGRAM //
+void __vectorcall  ImagingHistogramCDF(ImagingHistogram const* const __restrict histo, float* const __restrict cdf, uint32_t const channel = 0); // cdf is histo->count floats, normalized 0.0 ... 1.0
+float const __vectorcall ImagingHistogramPercentile(ImagingHistogram const* const __restrict histo, float const percentile, uint32_t const channel = 0); // percentile 0.0 ... 1.0, returns the value (F32 is interpolated within the bin)
+void __vectorcall  ImagingHistogramAutoLevels(ImagingHistogram const* const __restrict histo, double& __restrict dMin, double& __restrict dMax, float const clip = 0.0f, uint32_t const channel = 0); // black & white points, clip is the fraction of pixels clipped at each end. F32 w/ clip = 0 is the exact data min/max. can be passed to ImagingF32ToL16
 
 void __vectorcall ImagingChromaKey(ImagingMemoryInstance* const __restrict im);	// (INPLACE) key[ 0x00b140 ] r g b
 void __vectorcall ImagingDither(ImagingMemoryInstance* const __restrict im);
@@ -194,21 +399,36 @@ void __vectorcall ImagingLerpL16(ImagingMemoryInstance* const __restrict A, Imag
 void __vectorcall ImagingLerp(ImagingMemoryInstance* const __restrict im_dst, ImagingMemoryInstance const* const __restrict im_src, float const tT); // im_dst = A, im_src = B, op: A = lerp(A, B, t)
 void __vectorcall ImagingLerp(ImagingMemoryInstance* const __restrict out, ImagingMemoryInstance const* const __restrict A, ImagingMemoryInstance const* const __restrict B, float const tT);
 void __vectorcall ImagingLUTLerp(ImagingLUT* const __restrict lut_dst, ImagingLUT const* const __restrict lut_src, float const tT);
+bool const __vectorcall ImagingApplyLUT(ImagingMemoryInstance* const __restrict im, ImagingLUT const* const __restrict lut, int const interpolation = IMAGING_LUT_TETRAHEDRAL, ImagingLUT const* const __restrict lut_b = nullptr, float const tT = 0.0f); // (INPLACE) BGRX, BGRA, BGRX16, BGRA16. optional lut_b is crossfaded w/ lut, same as ImagingLUTLerp(lut, lut_b, tT) w/o the blended lut
 void __vectorcall ImagingBlend(ImagingMemoryInstance* const __restrict im_dst, ImagingMemoryInstance const* const __restrict im_src);
 void __vectorcall ImagingVerticalFlip(ImagingMemoryInstance* const __restrict im); // flip Y / invert Y axis / vertical flip (INPLACE)
+bool const __vectorcall ImagingHorizontalFlip(ImagingMemoryInstance* const __restrict im); // mirror / invert X axis / horizontal flip (INPLACE), false for an unsupported pixel size
+bool const __vectorcall ImagingRotate180(ImagingMemoryInstance* const __restrict im); // (INPLACE), false for an unsupported pixel size
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingOffset(ImagingMemoryInstance const* const __restrict im, int const xoffset, int const yoffset); // (NOT INPLACE) **
-ImagingMemoryInstance* const __restrict __vectorcall ImagingRotateCW(ImagingMemoryInstance const* const __restrict im); // (NOT INPLACE)  ** 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingRotateCCW(ImagingMemoryInstance const* const __restrict im); // (NOT INPLACE) ** 
+ImagingMemoryInstance* const __restrict __vectorcall ImagingOffset(ImagingMemoryInstance const* const __restrict im, int const xoffset, int const yoffset); // (NOT INPLACE) ** negative offsets wrap around
+ImagingMemoryInstance* const __restrict __vectorcall ImagingRotateCW(ImagingMemoryInstance const* const __restrict im); // (NOT INPLACE)  ** nullptr for an unsupported pixel size
+ImagingMemoryInstance* const __restrict __vectorcall ImagingRotateCCW(ImagingMemoryInstance const* const __restrict im); // (NOT INPLACE) ** nullptr for an unsupported pixel size 
 
 ImagingMemoryInstance* const __restrict __vectorcall ImagingTangentSpaceNormalMapToDerivativeMapBGRA16(ImagingMemoryInstance* const __restrict im); // (NOT INPLACE) - new image returned of LA16 type, requires normal map of type BGRA16 input. RGB16 images should be converted to BGRX16 first.
                                                                                                                                                     // Tangent space Normal map is standards TS. red X+ (right), green Y+ (down), blue Z+ (near) [set as default coordinate system in ShaderMap (TS)]
+ImagingMemoryInstance* const __restrict __vectorcall ImagingHeightMapToNormalMap(ImagingMemoryInstance const* const __restrict im, float const strength = 1.0f, int const kernel = IMAGING_NORMAL_SOBEL, bool const wrap = true); // (NOT INPLACE) - MODE_L16 or MODE_F32 height (0.0f ... 1.0f) to a BGRX16 normal map (same TS). strength scales the gradient (height per pixel), wrap = tiling texture otherwise the edges are clamped
+bool const __vectorcall                              ImagingRenormalizeNormalMap(ImagingMemoryInstance* const __restrict im); // (INPLACE) BGRX16 / BGRA16, unit length normals (zero length is flat), alpha is unchanged
+ImagingMipChain* const __restrict __vectorcall       ImagingGenerateNormalMipChain(ImagingMemoryInstance const* const __restrict im, uint32_t const maxLevels = 0, bool const toksvig = false); // BGRX16 / BGRA16, each level averages the normals of its whole footprint & is renormalized. toksvig = alpha of levels > 0 is the length of the average normal (1.0 is flat, shorter is rougher)
                                                                                                                                                     
 // PALETTE GENERAL // 
 
 // **** xmRGB should be converted to linear space range  b4 call to this function
 uint32_t const __vectorcall ImagingPaletteIndexClosestColor(uvec4_v const xmRGB, ImagingMemoryInstance const* const __restrict palette);
 
+// palette is MODE_BGRX (ImagingGenerateSuperPalette1D), cube_size = 0 (exact search only), 32 or 64 builds the nearest index lookup cube. palettes are limited to 65536 entries (16bit indices), nullptr for larger palettes
+ImagingPaletteAccelerator* const __restrict __vectorcall ImagingNewPaletteAccelerator(ImagingMemoryInstance const* const __restrict palette, uint32_t const cube_size = 0);
+// same result as above using 8 palette entries at a time. w/ the lookup cube the result is the closest color to the center of the cube cell (approximate)
+uint32_t const __vectorcall ImagingPaletteIndexClosestColor(uvec4_v const xmRGB, ImagingPaletteAccelerator const* const __restrict accel);
+
+// (NOT INPLACE) remaps a MODE_BGRX or MODE_BGRA image to palette indices, returns MODE_L (palette of 256 entries or less) or MODE_L16. colors should be in the same space as the palette.
+ImagingMemoryInstance* const __restrict __vectorcall ImagingQuantizeToPalette(ImagingMemoryInstance const* const __restrict im, ImagingPaletteAccelerator const* const __restrict accel);
+ImagingMemoryInstance* const __restrict __vectorcall ImagingQuantizeToPalette(ImagingMemoryInstance const* const __restrict im, ImagingMemoryInstance const* const __restrict palette); // builds a temporary accelerator w/ a 64^3 lookup cube
+
 
 // SUPER PALETTE //	
 
@@ -253,29 +473,63 @@ ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryL16(ui
 ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryL(uint8_t const* __restrict pMemLoad, int const width, int const height);
 ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryF32(uint8_t const* __restrict pMemLoad, int const width, int const height);
 
+// MAPPED (ZERO-COPY) //
+// block & image rows point directly into a read only memory mapped file, ImagingDelete unmaps. The pixels must never be written - ImagingMakeWritable is the copy on write.
+ImagingMemoryInstance const* const __restrict __vectorcall ImagingMapRaw(eIMAGINGMODE const mode, std::wstring_view const filenamepath, int const width, int const height);
+ImagingMemoryInstance const* const __restrict __vectorcall ImagingMapKTX(std::wstring_view const filenamepath, uint32_t const mipLevel = 0); // RGB & RGB16 are promoted to BGRX (copied) same as ImagingLoadKTX
+bool const __vectorcall									   ImagingIsMapped(ImagingMemoryInstance const* const __restrict im);
+ImagingMemoryInstance* const __restrict __vectorcall	   ImagingMakeWritable(ImagingMemoryInstance const* const __restrict im); // mapped: returns a heap copy and im is deleted (unmapped), otherwise returns im. returns nullptr on failure and im is still valid.
+
+// STREAMING (TILED) //
+// images are not limited by IMAGING_LIMIT or memory, the file is memory mapped read only and each tile (+ apron) is copied into a new ImagingMemoryInstance. tile size of 0 is the native layout of the file (raw: full width strips of 256 rows)
+ImagingTileStream* const __restrict __vectorcall	 ImagingOpenTileStreamRaw(eIMAGINGMODE const mode, std::wstring_view const filenamepath, int const width, int const height, int const tile_xsize = 0, int const tile_ysize = 0, int const apron = 0);
+ImagingMemoryInstance* const __restrict __vectorcall ImagingReadTile(ImagingTileStream const* const __restrict stream, uint32_t const tile_index, ImagingTileRect& __restrict rect); // random access, thread safe. caller deletes the tile
+ImagingMemoryInstance* const __restrict __vectorcall ImagingReadNextTile(ImagingTileStream* const __restrict stream, ImagingTileRect& __restrict rect); // nullptr when all tiles have been read
+
+ImagingTileWriter* const __restrict __vectorcall	 ImagingCreateTileWriterRaw(eIMAGINGMODE const mode, std::wstring_view const filenamepath, int const width, int const height);
+bool const __vectorcall								 ImagingWriteTile(ImagingTileWriter* const __restrict writer, ImagingMemoryInstance const* const __restrict tile, ImagingTileRect const& __restrict rect); // writes the interior of rect, tiles can be written in any order. not thread safe
+bool const __vectorcall								 ImagingCloseTileWriter(ImagingTileWriter* const __restrict writer); // finishes the file and deletes the writer, false if any write failed
+
+// serial read -> parallel op -> serial write, bounded number of tiles in flight
+bool const __vectorcall								 ImagingTransformTiles(ImagingTileStream* const __restrict stream, ImagingTileWriter* const __restrict writer, ImagingTileOp const op, void* const __restrict user = nullptr);
+bool const __vectorcall								 ImagingStreamResample(ImagingTileStream* const __restrict stream, ImagingTileWriter* const __restrict writer, int const filter = IMAGING_TRANSFORM_BOX); // output size is the writer size. seamless when the apron covers the filter support, in source pixels
+bool const __vectorcall								 ImagingStreamF32ToL16(ImagingTileStream* const __restrict stream, ImagingTileWriter* const __restrict writer, double dMin = FLT_MAX, double dMax = -FLT_MAX, bool const dither = false); // range is determined by a first pass over all tiles if not specified
+ImagingHistogram* const __restrict __vectorcall		 ImagingNewHistogram(ImagingTileStream* const __restrict stream); // apron is excluded. MODE_F32 range is determined by a first pass over all tiles (4096 bins)
+ImagingHistogram* const __restrict __vectorcall		 ImagingNewHistogram(ImagingTileStream* const __restrict stream, float const fMin, float const fMax, uint32_t const count = 4096); // MODE_F32, apron is excluded
+
 // GREYSCALE //
 
 // 2 seperate greyscale L images to one combined LA image
 ImagingMemoryInstance* const __restrict __vectorcall  ImagingLLToLA(ImagingMemoryInstance const* const __restrict pSrcImageL, ImagingMemoryInstance const* const __restrict pSrcImageA);
 ImagingMemoryInstance* const __restrict __vectorcall  ImagingL16L16ToLA16(ImagingMemoryInstance const* const __restrict pSrcImageL, ImagingMemoryInstance const* const __restrict pSrcImageA);
-ImagingMemoryInstance* const __restrict __vectorcall  ImagingF32ToL16(ImagingMemoryInstance const* const __restrict pSrcImageF, double dMin = FLT_MAX, double dMax = -FLT_MAX);
+ImagingMemoryInstance* const __restrict __vectorcall  ImagingF32ToL16(ImagingMemoryInstance const* const __restrict pSrcImageF, double dMin = FLT_MAX, double dMax = -FLT_MAX, bool const dither = false); // dither = ordered dither to prevent banding
+bool const __vectorcall                               ImagingF32MinMax(ImagingMemoryInstance const* const __restrict pSrcImageF, double& __restrict dMin, double& __restrict dMax); // nan is ignored, false if there is no data
 
 // CONVERSION //
 void                                                  ImagingFastRGBTOBGRX(uint8_t* const __restrict blockOut, uint8_t const* const __restrict blockIn, uint32_t const width, uint32_t const height); // exposed for usage with other buffers, or direct access to two existing Imaging instances' raw data blocks
 void                                                  ImagingFastRGB16TOBGRX16(uint16_t* const __restrict blockOut, uint16_t const* const __restrict blockIn, uint32_t const width, uint32_t const height);
 ImagingMemoryInstance* const __restrict __vectorcall  ImagingRGBToBGRX(ImagingMemoryInstance const* const __restrict pSrcImageRGB);
 ImagingMemoryInstance* const __restrict __vectorcall  ImagingRGB16ToBGRX16(ImagingMemoryInstance const* const __restrict pSrcImageRGB16);
+// any mode to any other mode (except compressed modes): bit depth (8 <-> 16bpc, F32 is normalized 0.0f...1.0f, U32 is the integer value), gray <-> color, adding / dropping alpha (added alpha is opaque). MODE_1BIT is 0 or 255
+// reference = scalar path, for validation of the AVX2 kernels
+ImagingMemoryInstance* const __restrict __vectorcall  ImagingConvert(ImagingMemoryInstance const* const __restrict im, eIMAGINGMODE const mode, eIMAGINGLUMA const luma = LUMA_REC601, bool const reference = false);
+ImagingMemoryInstance* const __restrict __vectorcall  ImagingExtractChannel(ImagingMemoryInstance const* const __restrict im, uint32_t const channel, bool const reference = false); // channel in memory order to MODE_L or MODE_L16 (8 or 16bpc modes)
+ImagingMemoryInstance* const __restrict __vectorcall  ImagingMergeChannels(eIMAGINGMODE const mode, ImagingMemoryInstance const* const* const __restrict planes, uint32_t const count, bool const reference = false); // inverse of ImagingExtractChannel, count planes in memory order (MODE_L or MODE_L16, same size) to MODE_LA (2), MODE_BGRX (3, x is opaque), MODE_BGRA (4) or the 16bpc versions
 
 // FILE SUPPORT, DEFAULT SUPPORTED : KTX, KTX2, GIF and LUT's
 
-// ImagingLoadKTX will load the format (UNORM / SRGB) as is, no colorspace manipulations occur. *does not support mipmaps, file cannot contain mipmaps*
+// ImagingLoadKTX will load the format (UNORM / SRGB) as is, no colorspace manipulations occur. *only the first mip level is loaded, use ImagingLoadKTXMipChain for all levels*
 ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadKTX(std::wstring_view const filenamepath); // RGB images loaded are internally promoted to BGRX (16bpc versions aswell)
-ImagingSequence* const __restrict __vectorcall		 ImagingLoadGIFSequence(std::wstring_view const giffilenamepath, uint32_t width = 0, uint32_t height = 0);  // chroma-key[ 0x00b140 ] enabled internally  ** do not load multiple sequences at the same time in multiple threads - this is because of lockless file reading (optimization) **
-ImagingLUT* const __restrict __vectorcall			 ImagingLoadLUT(std::wstring_view const cubefilenamepath);
+ImagingMipChain* const __restrict __vectorcall		 ImagingLoadKTXMipChain(std::wstring_view const filenamepath); // all mip levels, "" ""
+ImagingSequence* const __restrict __vectorcall		 ImagingLoadGIFSequence(std::wstring_view const giffilenamepath, uint32_t width = 0, uint32_t height = 0, bool const pipelined = false);  // chroma-key[ 0x00b140 ] enabled internally  ** single threaded by default, pipelined uses all available threads. multiple sequences can be loaded at the same time in multiple threads **
+ImagingLUT* const __restrict __vectorcall			 ImagingLoadLUT(std::wstring_view const cubefilenamepath); // .cube or binary .lutb (detected by content)
+ImagingLUT const* const __restrict __vectorcall		 ImagingMapLUT(std::wstring_view const filenamepath); // binary .lutb is memory mapped (zero-copy, read only - ImagingCopy for a writable lut), .cube is loaded. ImagingDelete unmaps
 
 #if INCLUDE_TIF_SUPPORT
 // supports loading L, L16, LA, LA16, RGB, RGB16, RGBA, RGBA16
 ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadTif(std::wstring_view const filenamepath);
+// streaming, uncompressed & interleaved/chunky stripped or tiled tif (classic or BigTIFF, little endian) - additionally supports F32
+ImagingTileStream* const __restrict __vectorcall	 ImagingOpenTileStreamTif(std::wstring_view const filenamepath, int const tile_xsize = 0, int const tile_ysize = 0, int const apron = 0);
 #endif
 
 // RAW COPY 
@@ -285,7 +539,7 @@ void __vectorcall ImagingCopyRaw(void* const pDstMemory, ImagingMemoryInstance c
 void __vectorcall ImagingSwapRB(ImagingMemoryInstance* const __restrict im); // Red and Blue component swap (INPLACE)
 
 // SAVING //
-bool const __vectorcall ImagingSaveLUT(ImagingLUT const* const __restrict lut, std::string_view const title, std::wstring_view const cubefilenamepath);
+bool const __vectorcall ImagingSaveLUT(ImagingLUT const* const __restrict lut, std::string_view const title, std::wstring_view const cubefilenamepath); // .lutb extension saves the binary format (raw 16bit block)
 bool const __vectorcall ImagingSaveRaw(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath);
 
 // only MODE_L and MODE_RGB seem to work when saving JPEGS
@@ -297,14 +551,21 @@ void ImagingSaveJPEG(tbb::task_group& __restrict tG, eIMAGINGMODE const outClrSp
 #if INCLUDE_TIF_SUPPORT
 // supports saving L, L16, LA, LA16, RGBA, RGBA16
 bool const __vectorcall ImagingSaveToTif(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath);
+// streaming, uncompressed BigTIFF - additionally supports F32
+ImagingTileWriter* const __restrict __vectorcall ImagingCreateTileWriterTif(eIMAGINGMODE const mode, std::wstring_view const filenamepath, int const width, int const height);
 #endif
 
 // SaveToKTX will save in the as is (no colorspace conversion) [ linear ]. If the data for the image is supposed to be SRGB, use ImageView to export a srgb copy.
-bool const __vectorcall ImagingSaveToKTX(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath); // RGB images should be converted to BGRX first
+bool const __vectorcall ImagingSaveToKTX(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath, int const supercompression = 0); // RGB images should be converted to BGRX first. .ktx2 is saved as a single level chain (ImagingSaveMipChainToKTX)
 bool const __vectorcall ImagingSaveLayersToKTX(ImagingMemoryInstance const* const* const __restrict pSrcImages, uint32_t const numLayers, std::wstring_view const filenamepath); // RGB images should be converted to BGRX first
-bool const __vectorcall ImagingSaveCompressedBC7ToKTX(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath);
+bool const __vectorcall ImagingSaveCompressedBC7ToKTX(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath); // BC1, BC4, BC5 & BC7
+bool const __vectorcall ImagingSaveMipChainToKTX(ImagingMipChain const* const __restrict chain, std::wstring_view const filenamepath, int const supercompression = 0); // all levels, .ktx or .ktx2 (by extension) ""  "". supercompression = zstd level (1 ... 22) for .ktx2, 0 is none. requires INCLUDE_ZSTD_SUPPORT
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingCompressBGRAToBC7(ImagingMemoryInstance const* const __restrict pSrcImage, float const normalizedQuality = 0.82f);
+// block compression, 4x4 blocks encoded in parallel. normalizedQuality is the search effort (0.0 fastest ... 1.0), >= 0.5 enables the exhaustive trials. images that are not a multiple of 4 have the edge pixels replicated into the partial blocks.
+ImagingMemoryInstance* const __restrict __vectorcall ImagingCompressBGRAToBC1(ImagingMemoryInstance const* const __restrict pSrcImage, float const normalizedQuality = 0.82f); // BGRX, BGRA (1 bit alpha, punch through < 128)
+ImagingMemoryInstance* const __restrict __vectorcall ImagingCompressToBC4(ImagingMemoryInstance const* const __restrict pSrcImage, float const normalizedQuality = 0.82f); // L, LA, BGRX, BGRA (L or R)
+ImagingMemoryInstance* const __restrict __vectorcall ImagingCompressToBC5(ImagingMemoryInstance const* const __restrict pSrcImage, float const normalizedQuality = 0.82f); // LA (L, A), BGRX, BGRA (R, G) ie.) normal maps
+ImagingMemoryInstance* const __restrict __vectorcall ImagingCompressBGRAToBC7(ImagingMemoryInstance const* const __restrict pSrcImage, float const normalizedQuality = 0.82f); // BGRX, BGRA - Compressonator.dll (all modes) when present and normalizedQuality >= 0.5, otherwise the native fast encoder (mode 6, single subset rgba)
 
 
 
@@ -319,6 +580,7 @@ static constexpr uint32_t const KTX_ENDIAN_REF(0x04030201);
 
 uint32_t const GLtoVKFormat(uint32_t const glFormat);
 eIMAGINGMODE const VKtoImagingMode(uint32_t const vkFormat);
+uint32_t const ImagingModeToVKFormat(eIMAGINGMODE const mode); // UNORM, 0 if unsupported
 
 enum KTX_VERSION
 {
@@ -326,7 +588,7 @@ enum KTX_VERSION
 	KTX2 = 2
 };
 
-/// Layout of a KTX or KTX2 file in a buffer. - Unsupported KTX2 "super compression", always just the data in it's original format
+/// Layout of a KTX or KTX2 file in a buffer. - KTX2 "super compression" is supported for zstd (scheme 2) only, offsets & compressed_size() are then of the compressed level data which the loaders decompress
 template<uint32_t const version = KTX_VERSION::KTX1>  // KTX "1"  or  KTX "2"
 class KTXFileLayout {
 
@@ -406,7 +668,7 @@ public:
 				imageSizes_.push_back(imageSize);
 
 				p += 4; // offset for reading layer imagesize above
-				imageOffsets_.push_back((uint32_t)(p - begin));
+				imageOffsets_.push_back(uint64_t(p - begin));
 
 				if (p + imageSize > end) {
 					// see https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
@@ -438,28 +700,26 @@ public:
 
 			vkformat_ = header_data.v2.format;
 			if (!vkformat_) return;
+			if (0 != header_data.v2.supercompressionScheme && 2 != header_data.v2.supercompressionScheme) return; // none or zstd
 			format_ = VKtoImagingMode(vkformat_);
 
 			p += sizeof(HeaderV2);
 
-			// ktx2 image data start offset
-			uint32_t imageOffset(0);
-			// *bugfix - (only affects .ktx2 files) apparently these chunks of data are optional, to get the correct image offset....
-			if (0 != header_data.v2.sgdOffset) { // image offset is after supercompression global data, IF PRESENT
-				imageOffset = (uint32_t)(header_data.v2.sgdOffset + header_data.v2.sgdLength);
-			}
-			else if (0 != header_data.v2.kvdOffset) { // image offset is after key value data, IF PRESENT
-				imageOffset = (uint32_t)(header_data.v2.kvdOffset + header_data.v2.kvdLength);
-			}
-			else if (0 != header_data.v2.dfdOffset) { // image offset is after data format descriptor data, IF PRESENT
-				imageOffset = (uint32_t)(header_data.v2.dfdOffset + header_data.v2.dfdLength);
-			}
-			else { // no extra data present, image data starts after header and the mipmap levels (variable size)
-				return; // ktx2 file is malformed, can't calculate start of image data without traversing the mipmap levels and the offsets & lengths it contains for each level.
-			}
-
+			// level index follows the header, each level has its own absolute byte offset. (levels are usually stored smallest first)
 			for (uint32_t mipLevel = 0; mipLevel != header_data.v2.numberOfMipmapLevels; ++mipLevel) {
 
+				if (p + 24 > end) return;
+
+				uint64_t const byteOffset(*(uint64_t*)(p));
+				uint64_t const byteLength(*(uint64_t*)(p + 8));
+				uint64_t const fileSize(uint64_t(end - begin));
+				if (byteOffset > fileSize || byteLength > fileSize - byteOffset) { // truncated, keep the complete levels (no wrap around of offset + length)
+					if (0 == mipLevel) return;
+					header_data.v2.numberOfMipmapLevels = mipLevel;
+					break;
+				}
+				compressedSizes_.push_back(byteLength);
+				uncompressedSizes_.push_back(*(uint64_t*)(p + 16));
 				p += 16; // skip byte offset & length (uint64_t's, 8 bytes each), now on mip image image size
 
 				// bugfix for arraylayers and faces not being factored into final size for this mip
@@ -485,20 +745,19 @@ public:
 
 				p += 8; // offset for reading layer imagesize above
 
-				imageOffsets_.push_back(imageOffset); // relative to start of image data in ktx v2
-				imageOffset += imageSize;
+				imageOffsets_.push_back(byteOffset); // absolute offset in file
 			}
 		}
 		ok_ = true;
 	}
 
-	uint32_t const offset(uint32_t const mipLevel, uint32_t const arrayLayer, uint32_t const face) const {
+	uint64_t const offset(uint32_t const mipLevel, uint32_t const arrayLayer, uint32_t const face) const { // absolute offset in file
 
 		if constexpr (KTX_VERSION::KTX2 == version) {
-			return imageOffsets_[mipLevel] + (arrayLayer * header_data.v2.numberOfFaces + face) * layerImageSizes_[mipLevel];
+			return imageOffsets_[mipLevel] + uint64_t(arrayLayer * header_data.v2.numberOfFaces + face) * uint64_t(layerImageSizes_[mipLevel]);
 		}
 
-		return imageOffsets_[mipLevel] + (arrayLayer * header_data.v1.numberOfFaces + face) * layerImageSizes_[mipLevel];
+		return imageOffsets_[mipLevel] + uint64_t(arrayLayer * header_data.v1.numberOfFaces + face) * uint64_t(layerImageSizes_[mipLevel]);
 	}
 
 	uint32_t const size(uint32_t const mipLevel) const {
@@ -511,6 +770,11 @@ public:
 	}
 	std::vector<uint32_t> const& layer_sizes() const { return(layerImageSizes_); }
 
+	// KTX2 only
+	uint32_t const supercompression() const { if constexpr (KTX_VERSION::KTX2 == version) return header_data.v2.supercompressionScheme; return 0; }
+	uint64_t const compressed_size(uint32_t const mipLevel) const { return compressedSizes_[mipLevel]; }     // bytes of the level in the file
+	uint64_t const uncompressed_size(uint32_t const mipLevel) const { return uncompressedSizes_[mipLevel]; } // bytes of the level after decompression (unpadded)
+
 	bool const         ok() const { return ok_; }
 	eIMAGINGMODE const format() const { return format_; }
 	uint32_t const     vkformat() const { return vkformat_; } // can be cast to vk::Format by user
@@ -520,37 +784,37 @@ public:
 	uint32_t const     height(uint32_t const mipLevel) const { if constexpr (KTX_VERSION::KTX2 == version) return mipScale(header_data.v2.pixelHeight, mipLevel); return mipScale(header_data.v1.pixelHeight, mipLevel); }
 	uint32_t const     depth(uint32_t const mipLevel) const { if constexpr (KTX_VERSION::KTX2 == version) return mipScale(header_data.v2.pixelDepth, mipLevel); return mipScale(header_data.v1.pixelDepth, mipLevel); }
 
-	// only these image formats are supported natively for ktx to Imaging, **only the first miplevel is uploaded to an ImagingMemoryInstance**
-	ImagingMemoryInstance* const __restrict upload(uint8_t const* const __restrict pFileBegin) const {
+	// only these image formats are supported natively for ktx to Imaging, uploads a single mip level to an ImagingMemoryInstance
+	ImagingMemoryInstance* const __restrict upload(uint8_t const* const __restrict pFileBegin, uint32_t const mipLevel = 0) const {
 
 		switch (format()) 
 		{
 		case MODE_BGRA16:
-			return(ImagingLoadFromMemoryBGRA16(pFileBegin, width(0), height(0)));
+			return(ImagingLoadFromMemoryBGRA16(pFileBegin, width(mipLevel), height(mipLevel)));
 		case MODE_RGB16: // promote to BGRX16, so that the returned image is consistent and the end user never has to work if it's RGB or BGRX or BGRA, it's always BGRX or BGRA when dealing with these images. BGRX and BGRA are the same, in memory usage.
 		{
-			Imaging image(ImagingLoadFromMemoryRGB16(pFileBegin, width(0), height(0)));
+			Imaging image(ImagingLoadFromMemoryRGB16(pFileBegin, width(mipLevel), height(mipLevel)));
 			Imaging const promoted_image(ImagingRGB16ToBGRX16(image));
 			ImagingDelete(image); image = nullptr;
 			return(promoted_image);
 		}
 		case MODE_BGRA:
-			return(ImagingLoadFromMemoryBGRA(pFileBegin, width(0), height(0)));
+			return(ImagingLoadFromMemoryBGRA(pFileBegin, width(mipLevel), height(mipLevel)));
 		case MODE_RGB: // promote to BGRX, so that the returned image is consistent and the end user never has to work if it's RGB or BGRX or BGRA, it's always BGRX or BGRA when dealing with these images. BGRX and BGRA are the same, in memory usage.
 		{
-			Imaging image(ImagingLoadFromMemoryRGB(pFileBegin, width(0), height(0)));
+			Imaging image(ImagingLoadFromMemoryRGB(pFileBegin, width(mipLevel), height(mipLevel)));
 			Imaging const promoted_image(ImagingRGBToBGRX(image));
 			ImagingDelete(image); image = nullptr;
 			return(promoted_image);
 		}
 		case MODE_LA16:
-			return(ImagingLoadFromMemoryLA16(pFileBegin, width(0), height(0)));
+			return(ImagingLoadFromMemoryLA16(pFileBegin, width(mipLevel), height(mipLevel)));
 		case MODE_LA:
-			return(ImagingLoadFromMemoryLA(pFileBegin, width(0), height(0)));
+			return(ImagingLoadFromMemoryLA(pFileBegin, width(mipLevel), height(mipLevel)));
 		case MODE_L16:
-			return(ImagingLoadFromMemoryL16(pFileBegin, width(0), height(0)));
+			return(ImagingLoadFromMemoryL16(pFileBegin, width(mipLevel), height(mipLevel)));
 		case MODE_L:
-			return(ImagingLoadFromMemoryL(pFileBegin, width(0), height(0)));
+			return(ImagingLoadFromMemoryL(pFileBegin, width(mipLevel), height(mipLevel)));
 		default:
 			break;
 		}
@@ -606,9 +870,11 @@ private:
 	eIMAGINGMODE format_;
 	uint32_t vkformat_; // aka. vk::Format
 	bool ok_ = false;
-	std::vector<uint32_t> imageOffsets_;
+	std::vector<uint64_t> imageOffsets_;
 	std::vector<uint32_t> imageSizes_;
 	std::vector<uint32_t> layerImageSizes_;
+	std::vector<uint64_t> compressedSizes_;
+	std::vector<uint64_t> uncompressedSizes_;
 };
 
 
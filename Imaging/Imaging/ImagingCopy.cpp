@@ -5,8 +5,16 @@
 #include "RBFilter_AVX2.h"
 #include "gif_lib.h"
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <semaphore>
+#include <condition_variable>
+#include <future>
+#include <unordered_map>
 #include <fmt/format.h>
 #include <sstream>
+#include <charconv>
 #include <Objbase.h>
 #include <filesystem>
 #include <Utility/stringconv.h>
@@ -22,6 +30,10 @@ namespace fs = std::filesystem;
 #include "jpeglib.h"
 #endif
 
+#if INCLUDE_ZSTD_SUPPORT
+#include <zstd.h>
+#endif
+
 #include <Compressonator.h>
 #include <tbb/scalable_allocator.h>
 #include <Utility/mio/mmap.hpp>
@@ -137,6 +149,9 @@ ImagingNewPrologueSubtype(eIMAGINGMODE const mode, int const xsize, int const ys
 		im->pixelsize = 4;
 		im->type = IMAGING_TYPE_FLOAT32;
 		break;
+	case MODE_BC1:
+	case MODE_BC4:
+	case MODE_BC5:
 	case MODE_BC7:
 	case MODE_BC6A:
 		// setup same as bgra
@@ -196,6 +211,278 @@ ImagingNewEpilogue(ImagingMemoryInstance* const __restrict im)
 	return(im);
 }
 
+/* Image Pool */
+/* ---------- */
+/* Block images returned by ImagingDelete are kept as is (instance, line pointers & block) and handed out again by ImagingNew for the same mode & size. */
+
+static void ImagingDestroyBlock_MemoryInstance(ImagingMemoryInstance* const __restrict im);
+
+namespace image_pool { // size class buckets keyed on (mode, xsize, ysize) behind small per thread caches. recycled blocks are already committed, so reuse has no allocator round trip & no page faults.
+
+	static constexpr uint32_t const LOCAL_SLOTS = 4;		// images cached per thread, in front of the shared buckets
+	static constexpr int32_t const MAX_DIMENSION = (1 << 20); // key packing limit
+
+	typedef struct local_cache {
+
+		Imaging slots[LOCAL_SLOTS]{};
+		uint64_t keys[LOCAL_SLOTS]{};
+
+	} local_cache;
+
+	typedef struct state {
+
+		tbb::enumerable_thread_specific<local_cache> locals;
+		std::unordered_map<uint64_t, std::vector<Imaging>> buckets;
+		tbb::spin_mutex lock; // buckets
+
+		std::atomic<size_t> cached;	// bytes
+		size_t const capacity;		// bytes
+
+		explicit state(size_t const capacity_)
+			: cached(0), capacity(capacity_)
+		{}
+
+	} state;
+
+	static std::atomic<ImagingPool*> installed(nullptr);
+	static std::atomic<uint32_t> readers(0); // acquire & release in flight, the pool state is only freed once there are none
+
+	typedef struct reader { // scoped, registered before the installed pool is loaded
+
+		reader() { readers.fetch_add(1, std::memory_order_seq_cst); }
+		~reader() { readers.fetch_sub(1, std::memory_order_release); }
+
+	} reader;
+
+	STATIC_INLINE_PURE uint64_t const key(eIMAGINGMODE const mode, int32_t const xsize, int32_t const ysize)
+	{
+		return((uint64_t(mode) << 40ull) | (uint64_t(xsize) << 20ull) | uint64_t(ysize));
+	}
+
+	STATIC_INLINE_PURE size_t const bytes(ImagingMemoryInstance const* const __restrict im)
+	{
+		return(sizeof(ImagingMemoryInstance) + size_t(im->ysize) * (sizeof(uint8_t*) + size_t(im->linesize)));
+	}
+
+	// plain ImagingNew block images only, mapped, compressed or modified images are freed as usual
+	static bool const __vectorcall recyclable(ImagingMemoryInstance const* const __restrict im)
+	{
+		static constexpr uint32_t const COMPRESSED(MODE_BC1 | MODE_BC4 | MODE_BC5 | MODE_BC7 | MODE_BC6A);
+
+		return(static_cast<void(*)(ImagingMemoryInstance* const __restrict)>(&ImagingDestroyBlock_MemoryInstance) == im->destroy &&
+			   nullptr != im->block && nullptr != im->image && im->block == im->image[0] &&
+			   0 == (COMPRESSED & im->mode) && im->linesize == im->xsize * im->pixelsize &&
+			   im->xsize > 0 && im->ysize > 0 && im->xsize < MAX_DIMENSION && im->ysize < MAX_DIMENSION);
+	}
+
+	static void __vectorcall free_image(ImagingMemoryInstance* const __restrict im)
+	{
+		if (im->destroy)
+			im->destroy(im);
+
+		if (im->image) {
+
+			scalable_free(im->image);
+
+		}
+
+		scalable_free(im);
+	}
+
+	static ImagingMemoryInstance* const __restrict __vectorcall acquire(eIMAGINGMODE const mode, int const xsize, int const ysize)
+	{
+		if (nullptr == installed.load(std::memory_order_relaxed)) { // no pool, no reader registration
+			return(nullptr);
+		}
+
+		reader const registered;
+
+		ImagingPool* const __restrict pool(installed.load(std::memory_order_seq_cst));
+		if (nullptr == pool || xsize <= 0 || ysize <= 0 || xsize >= MAX_DIMENSION || ysize >= MAX_DIMENSION) {
+			return(nullptr);
+		}
+
+		state& __restrict s(*static_cast<state* const>(pool->internal));
+		uint64_t const k(key(mode, xsize, ysize));
+
+		Imaging im(nullptr);
+
+		{ // this thread
+			local_cache& __restrict local(s.locals.local());
+
+			for (uint32_t i = 0; i < LOCAL_SLOTS; ++i) {
+				if (local.slots[i] && k == local.keys[i]) {
+					im = local.slots[i];
+					local.slots[i] = nullptr;
+					break;
+				}
+			}
+		}
+
+		if (nullptr == im) { // shared
+			tbb::spin_mutex::scoped_lock lock(s.lock);
+
+			auto const bucket(s.buckets.find(k));
+			if (s.buckets.end() != bucket && !bucket->second.empty()) {
+				im = bucket->second.back();
+				bucket->second.pop_back();
+			}
+		}
+
+		if (im) {
+			s.cached.fetch_sub(bytes(im), std::memory_order_relaxed);
+		}
+		return(im);
+	}
+
+	static bool const __vectorcall release(ImagingMemoryInstance* const im)
+	{
+		if (nullptr == installed.load(std::memory_order_relaxed)) { // no pool, no reader registration
+			return(false);
+		}
+
+		reader const registered;
+
+		ImagingPool* const __restrict pool(installed.load(std::memory_order_seq_cst));
+		if (nullptr == pool || !recyclable(im)) {
+			return(false);
+		}
+
+		state& __restrict s(*static_cast<state* const>(pool->internal));
+		size_t const size(bytes(im));
+
+		if (s.cached.fetch_add(size, std::memory_order_relaxed) + size > s.capacity) { // full, freed as usual
+			s.cached.fetch_sub(size, std::memory_order_relaxed);
+			return(false);
+		}
+
+		uint64_t const k(key(im->mode, im->xsize, im->ysize));
+
+		{ // this thread
+			local_cache& __restrict local(s.locals.local());
+
+			for (uint32_t i = 0; i < LOCAL_SLOTS; ++i) {
+				if (nullptr == local.slots[i]) {
+					local.slots[i] = im;
+					local.keys[i] = k;
+					return(true);
+				}
+			}
+		}
+
+		{ // shared
+			tbb::spin_mutex::scoped_lock lock(s.lock);
+			s.buckets[k].push_back(im);
+		}
+		return(true);
+	}
+
+	// frees cached images until at most keep bytes remain, thread caches first
+	static void __vectorcall trim(state& __restrict s, size_t const keep)
+	{
+		for (local_cache& local : s.locals) {
+			for (uint32_t i = 0; i < LOCAL_SLOTS && s.cached.load(std::memory_order_relaxed) > keep; ++i) {
+				if (local.slots[i]) {
+					s.cached.fetch_sub(bytes(local.slots[i]), std::memory_order_relaxed);
+					free_image(local.slots[i]); local.slots[i] = nullptr;
+				}
+			}
+		}
+
+		tbb::spin_mutex::scoped_lock lock(s.lock);
+
+		for (auto bucket = s.buckets.begin(); s.buckets.end() != bucket; ) {
+
+			while (!bucket->second.empty() && s.cached.load(std::memory_order_relaxed) > keep) {
+				s.cached.fetch_sub(bytes(bucket->second.back()), std::memory_order_relaxed);
+				free_image(bucket->second.back());
+				bucket->second.pop_back();
+			}
+
+			if (bucket->second.empty()) {
+				bucket = s.buckets.erase(bucket);
+			}
+			else {
+				++bucket;
+			}
+		}
+	}
+
+} // end ns
+
+static void ImagingDestroyBlock_Pool(ImagingPool* const __restrict pool)
+{
+	if (pool) {
+		ImagingPool* expected(pool);
+		image_pool::installed.compare_exchange_strong(expected, nullptr); // uninstall
+
+		// threads that loaded this pool before it was uninstalled (or replaced) are still using it
+		while (0 != image_pool::readers.load(std::memory_order_seq_cst)) {
+			std::this_thread::yield();
+		}
+
+		if (pool->internal) {
+
+			image_pool::state* const __restrict s(static_cast<image_pool::state* const>(pool->internal));
+			image_pool::trim(*s, 0);
+
+			std::destroy_at(s);
+			scalable_free(s); pool->internal = nullptr;
+		}
+		pool->destroy = nullptr;
+	}
+}
+
+ImagingPool* const __restrict __vectorcall ImagingNewPool(size_t const capacity, bool const huge_pages)
+{
+	ImagingPool* const __restrict pool((ImagingPool*)scalable_malloc(sizeof(ImagingPool)));
+	if (!pool) {
+		return (ImagingPool*)ImagingError_MemoryError();
+	}
+	memset(&(*pool), 0, sizeof(ImagingPool));
+
+	void* const __restrict internal(scalable_malloc(sizeof(image_pool::state)));
+	if (!internal) {
+		scalable_free(pool);
+		return (ImagingPool*)ImagingError_MemoryError();
+	}
+	pool->internal = new (internal) image_pool::state(capacity);
+	pool->capacity = capacity;
+	pool->destroy = static_cast<void(*)(ImagingPool* const __restrict)>(&ImagingDestroyBlock_Pool);
+
+	if (huge_pages) {
+		// large allocations (image blocks) are backed by huge pages where the os allows it (process wide setting of tbbmalloc, stays enabled)
+		pool->huge_pages = (TBBMALLOC_OK == scalable_allocation_mode(TBBMALLOC_USE_HUGE_PAGES, 1));
+	}
+
+	return(pool);
+}
+
+void __vectorcall ImagingPoolInstall(ImagingPool* const __restrict pool)
+{
+	image_pool::installed.store(pool, std::memory_order_release);
+}
+
+ImagingPool* const __restrict __vectorcall ImagingPoolInstalled()
+{
+	return(image_pool::installed.load(std::memory_order_acquire));
+}
+
+size_t const __vectorcall ImagingPoolCached(ImagingPool const* const __restrict pool)
+{
+	return(static_cast<image_pool::state const* const>(pool->internal)->cached.load(std::memory_order_relaxed));
+}
+
+void __vectorcall ImagingPoolTrim(ImagingPool* const __restrict pool, size_t const keep)
+{
+	image_pool::trim(*static_cast<image_pool::state* const>(pool->internal), keep);
+}
+
+void __vectorcall ImagingPoolReset(ImagingPool* const __restrict pool)
+{
+	image_pool::trim(*static_cast<image_pool::state* const>(pool->internal), 0);
+}
+
 void __vectorcall
 ImagingClear(ImagingMemoryInstance* __restrict im)
 {
@@ -208,16 +495,10 @@ ImagingDelete(ImagingMemoryInstance* __restrict im)
 	if (!im)
 		return;
 
-	if (im->destroy)
-		im->destroy(im);
-
-	if (im->image) {
-
-		scalable_free(im->image);
-
-	}
+	if (image_pool::release(im)) // recycled
+		return;
 
-	scalable_free(im); im = nullptr;
+	image_pool::free_image(im); im = nullptr;
 }
 void __vectorcall ImagingDelete(ImagingMemoryInstance const* __restrict im)
 {
@@ -240,6 +521,22 @@ void __vectorcall ImagingDelete(ImagingSequence const* __restrict im)
 	ImagingDelete(const_cast<ImagingSequence*>(im));
 }
 
+void __vectorcall
+ImagingDelete(ImagingCompressedSequence* __restrict seq)
+{
+	if (!seq)
+		return;
+
+	if (seq->destroy)
+		seq->destroy(seq);
+
+	scalable_free(seq); seq = nullptr;
+}
+void __vectorcall ImagingDelete(ImagingCompressedSequence const* __restrict seq)
+{
+	ImagingDelete(const_cast<ImagingCompressedSequence*>(seq));
+}
+
 void __vectorcall
 ImagingDelete(ImagingLUT* __restrict im)
 {
@@ -272,6 +569,90 @@ void __vectorcall ImagingDelete(ImagingHistogram const* __restrict im)
 	ImagingDelete(const_cast<ImagingHistogram*>(im));
 }
 
+void __vectorcall
+ImagingDelete(ImagingMipChain* __restrict im)
+{
+	if (!im)
+		return;
+
+	if (im->destroy)
+		im->destroy(im);
+
+	scalable_free(im); im = nullptr;
+}
+void __vectorcall ImagingDelete(ImagingMipChain const* __restrict im)
+{
+	ImagingDelete(const_cast<ImagingMipChain*>(im));
+}
+
+void __vectorcall
+ImagingDelete(ImagingTileStream* __restrict stream)
+{
+	if (!stream)
+		return;
+
+	if (stream->destroy)
+		stream->destroy(stream);
+
+	scalable_free(stream); stream = nullptr;
+}
+void __vectorcall ImagingDelete(ImagingTileStream const* __restrict stream)
+{
+	ImagingDelete(const_cast<ImagingTileStream*>(stream));
+}
+
+void __vectorcall
+ImagingDelete(ImagingPool* __restrict pool)
+{
+	if (!pool)
+		return;
+
+	if (pool->destroy)
+		pool->destroy(pool);
+
+	scalable_free(pool); pool = nullptr;
+}
+
+void __vectorcall
+ImagingDelete(ImagingExportQueue* __restrict queue)
+{
+	if (!queue)
+		return;
+
+	if (queue->destroy)
+		queue->destroy(queue);
+
+	scalable_free(queue); queue = nullptr;
+}
+
+void __vectorcall
+ImagingDelete(ImagingTileWriter* __restrict writer)
+{
+	if (!writer)
+		return;
+
+	if (writer->destroy)
+		writer->destroy(writer);
+
+	scalable_free(writer); writer = nullptr;
+}
+
+void __vectorcall
+ImagingDelete(ImagingPaletteAccelerator* __restrict accel)
+{
+	if (!accel)
+		return;
+
+	if (accel->destroy)
+		accel->destroy(accel);
+
+	scalable_free(accel); accel = nullptr;
+}
+void __vectorcall ImagingDelete(ImagingPaletteAccelerator const* __restrict accel)
+{
+	ImagingDelete(const_cast<ImagingPaletteAccelerator*>(accel));
+}
+
 /* Block Storage Type */
 /* ------------------ */
 /* Allocate image as a single block. */
@@ -333,6 +714,20 @@ static void ImagingDestroyBlock_Histogram(ImagingHistogram* const __restrict im)
 		im->destroy = nullptr;
 	}
 }
+static void ImagingDestroyBlock_MipChain(ImagingMipChain* const __restrict im)
+{
+	if (im) {
+		if (im->levels) {
+
+			for (uint32_t i = 0; i < im->count; ++i) {
+				ImagingDelete(im->levels[i]); im->levels[i] = nullptr;
+			}
+
+			scalable_free(im->levels); im->levels = nullptr;
+		}
+		im->destroy = nullptr;
+	}
+}
 
 static ImagingMemoryInstance* const __restrict __vectorcall
 ImagingNewBlock(eIMAGINGMODE const mode, int const xsize, int const ysize)
@@ -391,6 +786,10 @@ ImagingNew(eIMAGINGMODE const mode, int const xsize, int const ysize)
 	}
 
 	if ((uint64_t)xsize * (uint64_t)ysize < IMAGE_SIZE_THRESHOLD) {
+		im = image_pool::acquire(mode, xsize, ysize); // recycled, if a pool is installed
+		if (im)
+			return(im);
+
 		im = ImagingNewBlock(mode, xsize, ysize);
 		if (im)
 			return(im);
@@ -402,2335 +801,9010 @@ ImagingNew(eIMAGINGMODE const mode, int const xsize, int const ysize)
 
 	return(im);
 }
-ImagingLUT* const __restrict __vectorcall ImagingNew(int const size)
-{
-	ImagingLUT* lut(nullptr);
-
-	if (size <= 0) {
-		return (ImagingLUT*)ImagingError_ValueError("bad image size");
-	}
 
-	if (size < MAX_LUT_DIMENSION_SIZE) {
-		lut = (ImagingLUT*)scalable_malloc(1 * sizeof(ImagingLUT));
-		memset(&(*lut), 0, sizeof(ImagingLUT));
+/* Mapped Storage Type */
+/* ------------------- */
+/* Image pixels point directly into a read only memory mapped file (zero-copy). */
 
-		lut->destroy = static_cast<void(*)(ImagingLUT* const __restrict)>(&ImagingDestroyBlock_LUT);
+typedef struct ImagingMappedInstance : ImagingMemoryInstance {
 
-		lut->size = size;  // size of dimension
+	mio::mmap_source mapping;
 
-		//  X  *   Y  *  (sizeof(uint16_t) * 4)
-		lut->slicesize = lut->size * lut->size * lut->pixelsize;
+} ImagingMappedInstance;
 
-		// Z * slicesize
-		uint32_t const cubesize(lut->size * lut->slicesize);
-		lut->block = (uint16_t*)scalable_malloc(cubesize);
-		memset(&(*lut->block), 0, cubesize);
-		
+static void ImagingDestroyBlock_Mapped(ImagingMemoryInstance* const __restrict im)
+{
+	if (im) {
+		std::destroy_at(&static_cast<ImagingMappedInstance* const>(im)->mapping); // unmaps
+		im->block = nullptr;
+		im->destroy = nullptr;
 	}
-	else
-		return (ImagingLUT*)ImagingError_ValueError("image lut size too big");
-
-	return(lut);
 }
-ImagingMemoryInstance* const __restrict __vectorcall ImagingNewCompressed(eIMAGINGMODE const mode /*should be MODE_BC7 or MODE_BC6A*/, int const xsize, int const ysize, int BufferSize)
-{
-	Imaging im(nullptr);
 
+static ImagingMemoryInstance const* const __restrict __vectorcall
+ImagingNewMapped(eIMAGINGMODE const mode, int const xsize, int const ysize, mio::mmap_source&& mapping, size_t const offset)
+{
 	if (xsize <= 0 || ysize <= 0) {
 		return (Imaging)ImagingError_ValueError("bad image size");
 	}
 
-	if ((uint64_t)xsize * (uint64_t)ysize < IMAGE_SIZE_THRESHOLD) {
-		im = ImagingNewBlock(mode, xsize, ysize);
-		if (im)
-			return(im);
-		/* assume memory error; try allocating in array mode instead */
-		ImagingError_Clear();
+	Imaging im(ImagingNewPrologueSubtype(mode, xsize, ysize, sizeof(ImagingMappedInstance)));
+	if (!im)
+		return(nullptr);
+
+	if (offset + (size_t)im->ysize * (size_t)im->linesize > mapping.size()) {
+		scalable_free(im->image);
+		scalable_free(im);
+		return (Imaging)ImagingError_ValueError("file too small for image size");
 	}
-	else
-		return (Imaging)ImagingError_ValueError("image size too big");
 
-	return(im);
-}
+	ImagingMappedInstance* const __restrict mapped(static_cast<ImagingMappedInstance* const>(im));
+	std::construct_at(&mapped->mapping, std::move(mapping));
 
-ImagingHistogram* const __restrict __vectorcall ImagingNewHistogram(ImagingMemoryInstance const* const __restrict im)
-{
-	ImagingHistogram* histo(nullptr);
+	im->block = const_cast<uint8_t*>(reinterpret_cast<uint8_t const*>(mapped->mapping.data())) + offset;
 
-	if (!im) {
-		return(nullptr);
+	// map alias lines to block memory
+	for (size_t y = 0, i = 0; y < (size_t)im->ysize; ++y) {
+		im->image[y] = im->block + i;
+		i += im->linesize;
 	}
 
-	histo = (ImagingHistogram*)scalable_malloc(1 * sizeof(ImagingHistogram));
-	memset(&(*histo), 0, sizeof(ImagingHistogram));
+	im->destroy = static_cast<void(*)(ImagingMemoryInstance* const __restrict)>(&ImagingDestroyBlock_Mapped);
 
-	histo->destroy = static_cast<void(*)(ImagingHistogram* const __restrict)>(&ImagingDestroyBlock_Histogram);
+	return( ImagingNewEpilogue(im) );
+}
 
-	bool bHDR(false);
+bool const __vectorcall ImagingIsMapped(ImagingMemoryInstance const* const __restrict im)
+{
+	return(im && static_cast<void(*)(ImagingMemoryInstance* const __restrict)>(&ImagingDestroyBlock_Mapped) == im->destroy);
+}
 
-	// unsupported formats:
-	// MODE_U32
-	// MODE_F32
+ImagingMemoryInstance* const __restrict __vectorcall ImagingMakeWritable(ImagingMemoryInstance const* const __restrict im)
+{
+	if (!ImagingIsMapped(im)) {
+		return(const_cast<ImagingMemoryInstance*>(im));
+	}
 
-	switch (im->mode)
-	{
-	case MODE_L16:
-	case MODE_LA16:
-	case MODE_BGRA16:
-	case MODE_BGRX16:
-	case MODE_RGB16:
-		histo->count = UINT16_MAX + 1;    // # of histogram bins for 16bpc image
-		bHDR = true;
-		break;
-	default:
-		histo->count = UINT8_MAX + 1;     // # of histogram bins for 8bpc image
-		break;
+	Imaging const imOut(ImagingNew(im->mode, im->xsize, im->ysize));
+	if (!imOut) {
+		return(nullptr); // im is still valid
 	}
 
-	histo->block = (uint32_t*)scalable_malloc(histo->count * sizeof(uint32_t));
-	memset(&(*histo->block), 0, histo->count * sizeof(uint32_t));
+	memcpy(imOut->block, im->block, (size_t)im->ysize * (size_t)im->linesize);
+
+	ImagingDelete(im); // unmap
+
+	return(imOut);
+}
 
-	// build histogram
-	int const width(im->xsize), height(im->ysize);
+ImagingMemoryInstance const* const __restrict __vectorcall ImagingMapRaw(eIMAGINGMODE const mode, std::wstring_view const filenamepath, int const width, int const height)
+{
+	std::error_code error{};
 
-	uint32_t* const __restrict counts = (uint32_t * const __restrict)histo->block;
-	uint32_t count(width * height);
+	mio::mmap_source mmap = mio::make_mmap_source(filenamepath, false, error);
+	if (error || !mmap.is_open() || !mmap.is_mapped()) {
+		return(nullptr);
+	}
 
-	if (bHDR) {
-		uint16_t const* pIn16 = (uint16_t const*)im->block;
+	return(ImagingNewMapped(mode, width, height, std::move(mmap), 0));
+}
 
-		while (--count != 0) { // for every pixel in the image
+ImagingLUT* const __restrict __vectorcall ImagingNew(int const size)
+{
+	ImagingLUT* lut(nullptr);
 
-			++counts[*pIn16];
-			++pIn16;
-		}
+	if (size <= 0) {
+		return (ImagingLUT*)ImagingError_ValueError("bad image size");
 	}
-	else {
-		uint8_t const* pIn8 = (uint8_t const*)im->block;
 
-		while (--count != 0) { // for every pixel in the image
+	if (size < MAX_LUT_DIMENSION_SIZE) {
+		lut = (ImagingLUT*)scalable_malloc(1 * sizeof(ImagingLUT));
+		memset(&(*lut), 0, sizeof(ImagingLUT));
 
-			++counts[*pIn8];
-			++pIn8;	
-		}
+		lut->destroy = static_cast<void(*)(ImagingLUT* const __restrict)>(&ImagingDestroyBlock_LUT);
+
+		lut->size = size;  // size of dimension
+
+		//  X  *   Y  *  (sizeof(uint16_t) * 4)
+		lut->slicesize = lut->size * lut->size * lut->pixelsize;
+
+		// Z * slicesize
+		uint32_t const cubesize(lut->size * lut->slicesize);
+		lut->block = (uint16_t*)scalable_malloc(cubesize);
+		memset(&(*lut->block), 0, cubesize);
+		
 	}
+	else
+		return (ImagingLUT*)ImagingError_ValueError("image lut size too big");
 
-	return(histo);
+	return(lut);
 }
-static ImagingMemoryInstance* const __restrict __vectorcall
-_copy(ImagingMemoryInstance const * const __restrict imIn)
+ImagingMemoryInstance* const __restrict __vectorcall ImagingNewCompressed(eIMAGINGMODE const mode /*should be MODE_BC1, MODE_BC4, MODE_BC5, MODE_BC7 or MODE_BC6A*/, int const xsize, int const ysize, int BufferSize)
 {
-    if (!imIn)
-		return (Imaging)ImagingError_ValueError(NULL);
-
-	ImagingMemoryInstance* __restrict imOut = ImagingNew(imIn->mode, imIn->xsize, imIn->ysize);
-    if (!imOut)
-        return(nullptr);
+	Imaging im(nullptr);
 
-	{
-		if (nullptr != imIn->block && nullptr != imOut->block)
-			memcpy(imOut->block, imIn->block, imIn->ysize * imIn->linesize);
+	if (xsize <= 0 || ysize <= 0) {
+		return (Imaging)ImagingError_ValueError("bad image size");
 	}
 
-    return(imOut);
-}
+	if ((uint64_t)xsize * (uint64_t)ysize < IMAGE_SIZE_THRESHOLD) {
+		im = ImagingNewBlock(mode, xsize, ysize);
+		if (im) {
+			size_t const size((size_t)im->ysize * (size_t)im->linesize);
+
+			if (BufferSize > 0 && (size_t)BufferSize > size) { // images smaller than a 4x4 block, compressed data is whole blocks
+				uint8_t* const __restrict block((uint8_t*)scalable_realloc(im->block, (size_t)BufferSize));
+				if (!block) {
+					ImagingDelete(im);
+					return (Imaging)ImagingError_MemoryError();
+				}
+				im->block = block;
 
-ImagingMemoryInstance* const __restrict __vectorcall
-ImagingCopy(ImagingMemoryInstance const* const __restrict imIn)
-{
-    return(_copy(imIn));
+				for (size_t y = 0; y < (size_t)im->ysize; ++y) {
+					im->image[y] = im->block + y * im->linesize;
+				}
+			}
+			return(im);
+		}
+		/* assume memory error; try allocating in array mode instead */
+		ImagingError_Clear();
+	}
+	else
+		return (Imaging)ImagingError_ValueError("image size too big");
+
+	return(im);
 }
 
-static ImagingLUT* const __restrict __vectorcall
-_copy(ImagingLUT const* const __restrict lutIn)
+ImagingMipChain* const __restrict __vectorcall ImagingNewMipChain(uint32_t const count)
 {
-	if (!lutIn)
-		return (ImagingLUT*)ImagingError_ValueError(NULL);
+	if (0 == count) {
+		return (ImagingMipChain*)ImagingError_ValueError("bad mip level count");
+	}
 
-	ImagingLUT* __restrict lutOut = ImagingNew(lutIn->size);
+	ImagingMipChain* const __restrict chain((ImagingMipChain*)scalable_malloc(1 * sizeof(ImagingMipChain)));
+	if (!chain) {
+		return (ImagingMipChain*)ImagingError_MemoryError();
+	}
 
-	if (!lutOut)
-		return(nullptr);
+	chain->levels = (ImagingMemoryInstance** __restrict)scalable_malloc(count * sizeof(ImagingMemoryInstance*));
+	if (!chain->levels) {
+		scalable_free(chain);
+		return (ImagingMipChain*)ImagingError_MemoryError();
+	}
+	memset(chain->levels, 0, count * sizeof(ImagingMemoryInstance*));
 
-	if (nullptr != lutIn->block && nullptr != lutOut->block)
-		memcpy(lutOut->block, lutIn->block, lutIn->size * lutIn->slicesize);
+	chain->count = count;
+	chain->destroy = static_cast<void(*)(ImagingMipChain* const __restrict)>(&ImagingDestroyBlock_MipChain);
 
-	return(lutOut);
+	return(chain);
 }
 
-ImagingLUT* const __restrict __vectorcall
-ImagingCopy(ImagingLUT const* const __restrict lutIn)
-{
-	return(_copy(lutIn));
-}
+namespace histogram { // per-thread privatized bins merged at the end. bins that fit in L1 are replicated (copies), consecutive pixels increment different copies so runs of equal values do not serialize on the same counter (store to load forwarding).
 
+	static constexpr uint32_t const MAX_REPLICATED_BINS = 4096;	// per channel
+	static constexpr uint32_t const COPIES = 4;					// power of 2
 
-void __vectorcall ImagingChromaKey(ImagingMemoryInstance* const __restrict im)	// (INPLACE) key[ 0x00b140 ] - for best results this function should be used earliest in the pipeline before any image alteration are made like dithering, etc.
-{																				//                           - this function specifies the exact color key to use, but compensates for +-1 in differences.
-	static constexpr uint32_t const color_key(0x0040b100);	// abgr
+	using bins = std::vector<uint32_t, tbb::scalable_allocator<uint32_t>>;
 
-	uint32_t* __restrict block(reinterpret_cast<uint32_t*>(im->block));
-	uvec4_t rgba{};
-	uvec4_v const color_key_comp(0x00, 0xb1, 0x40); // color key per-component
+	typedef void(__vectorcall* row_function)(uint32_t* const __restrict local, uint32_t const count, size_t const copy_stride, uint8_t const* const __restrict row, uint32_t const width);
 
-	uint32_t count(im->xsize * im->ysize);
-	while (--count != 0) { // for every pixel in the image
+	// copy_stride is 0 when the bins are not replicated
+	template<typename T, uint32_t const bands, uint32_t const stride>
+	static void __vectorcall build_row(uint32_t* const __restrict local, uint32_t const count, size_t const copy_stride, uint8_t const* const __restrict row, uint32_t const width)
+	{
+		T const* __restrict pIn((T const*)row);
 
-		// remove color & alpha component  (remove green screen color & set what ever alpha it was before, possibly opaque, to transparent)
-		
-		//                         //									  a r g b        a b g r
-		//if (*block == 0x00b140)  // a, b, g, r // r g b a backwards  [0x0000b140 --> 0x0040b100]
-		uint32_t const color_dont_care_alpha(*block & 0x00ffffff);
+		uint32_t x(0);
+		for (; (x + COPIES) <= width; x += COPIES) {
 
-		if (color_dont_care_alpha == color_key) // color key takes care of the swizzle mentioned above
-		{
-			*block = 0; // remove color & alpha component  (remove green screen color & set what ever alpha it was before, possibly opaque, to transparent)
-		}
-		else {
+			for (uint32_t i = 0; i < COPIES; ++i) {
 
-			SFM::unpack_rgba(color_dont_care_alpha, rgba.r, rgba.g, rgba.b, rgba.a);
-			
-			// for colors close enough to color key (off by +-1 in any component)
-			if (uvec4_v::all<3>(color_key_comp == uvec4_v(rgba.r - 1, rgba.g, rgba.b, rgba.a)) || //	 uvec4_v::all(color_key_comp == uvec4_v(rgba.r + 1, rgba.g, rgba.b, rgba.a))  // exception r is zero for color key
-				uvec4_v::all<3>(color_key_comp == uvec4_v(rgba.r, rgba.g - 1, rgba.b, rgba.a)) ||
-				uvec4_v::all<3>(color_key_comp == uvec4_v(rgba.r, rgba.g + 1, rgba.b, rgba.a)) ||
-				uvec4_v::all<3>(color_key_comp == uvec4_v(rgba.r, rgba.g, rgba.b - 1, rgba.a)) ||
-				uvec4_v::all<3>(color_key_comp == uvec4_v(rgba.r, rgba.g, rgba.b + 1, rgba.a)))
-			{
-				*block = 0;
+				uint32_t* const __restrict copy(local + i * copy_stride);
+				for (uint32_t c = 0; c < bands; ++c) {
+					++copy[c * count + pIn[c]];
+				}
+				pIn += stride;
 			}
 		}
+		for (; x < width; ++x) {
 
-		++block;
+			for (uint32_t c = 0; c < bands; ++c) {
+				++local[c * count + pIn[c]];
+			}
+			pIn += stride;
+		}
 	}
-}
 
-namespace dithering {
-	XMGLOBALCONST inline uint32_t const _n255by15{ (255U / 15U) };
-	XMGLOBALCONST inline uint32_t const _table[64]{ 
-	3U,129U,34U,160U,10U,136U,42U,168U,192U,66U,223U,97U,200U,73U,231U,105U,50U,
-	176U,18U,144U,58U,184U,26U,152U,239U,113U,207U,81U,247U,121U,215U,89U,14U,
-	140U,46U,180U,7U,133U,38U,164U,203U,77U,235U,109U,196U,70U,227U,101U,62U,188U,
-	30U,156U,54U,180U,22U,148U,251U,125U,219U,93U,243U,117U,211U,85U 
-	};
-} // end ns
-void __vectorcall ImagingDither(ImagingMemoryInstance* const __restrict im)
-{
-	uint32_t const width(im->xsize);
-	uint32_t const height(im->ysize);
+	typedef struct local_f32 {
 
-	uint32_t* const __restrict block(reinterpret_cast<uint32_t* const>(im->block));
+		bins counts;
+		float fMin, fMax;	// exact data min/max
 
-	uvec4_t rgba{};
+	} local_f32;
 
-	__m128i const 
-		nF0{ _mm_set1_epi32(0xF0) },
-		n0F{ _mm_set1_epi32(0x0F) };
+	// nan is not counted, values outside of the range are clamped to the first/last bin
+	static void __vectorcall build_row_f32(local_f32& __restrict local, uint32_t const count, size_t const copy_stride, float const* __restrict pIn, uint32_t const width, float const fMin, float const fScale)
+	{
+		uint32_t* const __restrict counts(local.counts.data());
+		float const fLast(float(count - 1));
 
-	for (uint32_t y = 0; y < height; ++y) {
+		__m256 const xmMin(_mm256_set1_ps(fMin)), xmScale(_mm256_set1_ps(fScale)), xmLast(_mm256_set1_ps(fLast)), xmZero(_mm256_setzero_ps());
+		__m256 xmDataMin(_mm256_set1_ps(local.fMin)), xmDataMax(_mm256_set1_ps(local.fMax));
 
-		for (uint32_t x = 0; x < width; ++x) {
+		alignas(32) int32_t index[8];
 
-			uint32_t const pixel(y * width + x);
+		uint32_t x(0);
+		for (; (x + 8) <= width; x += 8) {
+
+			__m256 const v(_mm256_loadu_ps(pIn + x));
+
+			// nan in v returns the second operand
+			xmDataMin = _mm256_min_ps(v, xmDataMin);
+			xmDataMax = _mm256_max_ps(v, xmDataMax);
+
+			// bin = clamp((v - min) * scale, 0, count - 1)
+			_mm256_store_si256((__m256i*)index, _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(v, xmMin), xmScale), xmZero), xmLast)));
+
+			uint32_t const ordered(_mm256_movemask_ps(_mm256_cmp_ps(v, v, _CMP_ORD_Q)));
+
+			if (0xff == ordered) {
+				for (uint32_t i = 0; i < 8; ++i) {
+					++counts[(i & (COPIES - 1)) * copy_stride + index[i]];
+				}
+			}
+			else {
+				for (uint32_t i = 0; i < 8; ++i) {
+					if (ordered & (1 << i)) {
+						++counts[(i & (COPIES - 1)) * copy_stride + index[i]];
+					}
+				}
+			}
+		}
 
-			SFM::unpack_rgba(block[pixel], rgba.r, rgba.g, rgba.b, rgba.a);
+		alignas(32) float fDataMin[8], fDataMax[8];
+		_mm256_store_ps(fDataMin, xmDataMin);
+		_mm256_store_ps(fDataMax, xmDataMax);
 
-			// lookup
-			uint32_t const d = dithering::_table[(((y & 7U) << 3U) + 7U) - (x & 7U)];
+		for (uint32_t i = 0; i < 8; ++i) {
+			local.fMin = SFM::min(local.fMin, fDataMin[i]);
+			local.fMax = SFM::max(local.fMax, fDataMax[i]);
+		}
 
-			// saturating addition
-			//ucolor = (ucolor & nF0) + ((d - (ucolor & n0F) * n255by15) >> 4U & 16U);
-			uvec4_v ucolor(rgba);
-			ucolor.v = _mm_add_epi32(_mm_and_si128(ucolor.v, nF0),
-				_mm_and_si128(
-					_mm_srli_epi32(_mm_sub_epi32(_mm_set1_epi32(d),
-						           _mm_mullo_epi32(_mm_and_si128(ucolor.v, n0F), _mm_set1_epi32(dithering::_n255by15))), 4), // SSE4.2 req for _mm_mullo_epi32
-				_mm_set1_epi32(16))
-			);
-			//ucolor = clamp(ucolor, 0U, 255U);
-			ucolor.v = SFM::saturate_to_u8(ucolor.v);
+		for (; x < width; ++x) {
 
-			// combine high and low bytes
-			//ucolor = (ucolor & nF0) | ((ucolor >> 4) & n0F);
-			ucolor.v = _mm_or_si128(_mm_and_si128(ucolor.v, nF0), _mm_and_si128(_mm_srli_epi32(ucolor.v, 4), n0F));
+			float const value(pIn[x]);
+			if (value == value) { // not nan
 
-			ucolor.rgba(rgba);
+				local.fMin = SFM::min(local.fMin, value);
+				local.fMax = SFM::max(local.fMax, value);
 
-			block[pixel] = SFM::pack_rgba(rgba.r, rgba.g, rgba.b, rgba.a);
+				++counts[int32_t(SFM::min(SFM::max((value - fMin) * fScale, 0.0f), fLast))];
+			}
 		}
 	}
-}
 
-// overwrites input
-void __vectorcall ImagingLerpL16(ImagingMemoryInstance* const __restrict A, ImagingMemoryInstance const* const __restrict B, float const tT)
-{
-	uint32_t const height(B->ysize);
-	uint32_t const width(B->xsize);
+	static ImagingHistogram* const __restrict __vectorcall new_histogram(uint32_t const count, uint32_t const bands)
+	{
+		ImagingHistogram* const __restrict histo((ImagingHistogram*)scalable_malloc(1 * sizeof(ImagingHistogram)));
+		if (!histo) {
+			return (ImagingHistogram*)ImagingError_MemoryError();
+		}
+		memset(&(*histo), 0, sizeof(ImagingHistogram));
 
-	uint16_t* const __restrict blockA(reinterpret_cast<uint16_t* const>(A->block));
-	uint16_t const* const __restrict blockB(reinterpret_cast<uint16_t const* const>(B->block));
+		histo->block = (uint32_t*)scalable_malloc(size_t(count) * size_t(bands) * sizeof(uint32_t));
+		if (!histo->block) {
+			scalable_free(histo);
+			return (ImagingHistogram*)ImagingError_MemoryError();
+		}
+		memset(&(*histo->block), 0, size_t(count) * size_t(bands) * sizeof(uint32_t));
 
-	static constexpr float const NORMALIZE = 1.0f / float(UINT16_MAX);
-	static constexpr float const DENORMALIZE = float(UINT16_MAX);
+		histo->type = IMAGING_TYPE_UINT32;
+		histo->count = count;
+		histo->bands = bands;
+		histo->destroy = static_cast<void(*)(ImagingHistogram* const __restrict)>(&ImagingDestroyBlock_Histogram);
 
-	for (uint32_t y = 0; y < height; ++y) {
+		return(histo);
+	}
 
-		for (uint32_t x = 0; x < width; ++x) {
+	static void __vectorcall merge(ImagingHistogram* const __restrict histo, uint32_t const* const __restrict local, uint32_t const copies)
+	{
+		size_t const size(size_t(histo->count) * size_t(histo->bands));
 
-			uint32_t const pixel(y * width + x);
+		for (uint32_t copy = 0; copy < copies; ++copy) {
+
+			uint32_t const* const __restrict counts(local + copy * size);
+			for (size_t bin = 0; bin < size; ++bin) {
+				histo->block[bin] += counts[bin];
+			}
+		}
+	}
+
+	// total & minmax for integer histograms, from the bins (all channels)
+	static void __vectorcall finish(ImagingHistogram* const __restrict histo)
+	{
+		uint32_t first(histo->count), last(0);
 
-			uint32_t const bA(blockA[pixel]),
-				           bB(blockB[pixel]);
+		for (uint32_t c = 0; c < histo->bands; ++c) {
 
-			float const fA(((float)bA) * NORMALIZE),
-				        fB(((float)bB) * NORMALIZE);
+			uint32_t const* const __restrict counts(histo->block + size_t(c) * size_t(histo->count));
+			for (uint32_t bin = 0; bin < histo->count; ++bin) {
+				if (counts[bin]) {
+					first = SFM::min(first, bin);
+					last = SFM::max(last, bin);
+				}
+			}
+		}
 
-			// floating point precision is best in [0.0f ... 1.0f] range, so normalizing before lerp then denormalization after is a huge benefit
-			blockA[pixel] = SFM::saturate_to_u16(DENORMALIZE * SFM::lerp(fA, fB, tT));
+		histo->total = 0;
+		for (uint32_t bin = 0; bin < histo->count; ++bin) {
+			histo->total += histo->block[bin];
 		}
+
+		histo->range[0] = 0.0f;
+		histo->range[1] = float(histo->count);
+		histo->minmax[0] = float(first);
+		histo->minmax[1] = float(last);
 	}
-}
+} // end ns
 
-// overwrites input
-void __vectorcall ImagingLerp(ImagingMemoryInstance* const __restrict A, ImagingMemoryInstance const* const __restrict B, float const tT)
+ImagingHistogram* const __restrict __vectorcall ImagingNewHistogram(ImagingMemoryInstance const* const __restrict im)
 {
-	uint32_t const height(B->ysize);
-	uint32_t const width(B->xsize);
+	if (!im) {
+		return(nullptr);
+	}
 
-	uint32_t* const __restrict blockA(reinterpret_cast<uint32_t* const>(A->block));
-	uint32_t const* const __restrict blockB(reinterpret_cast<uint32_t const* const>(B->block));
+	histogram::row_function row(nullptr);
+	uint32_t count(UINT8_MAX + 1), bands(0);  // # of histogram bins for 8bpc image
 
-	static constexpr float const NORMALIZE = 1.0f / float(UINT8_MAX);
-	static constexpr float const DENORMALIZE = float(UINT8_MAX);
-	XMVECTOR const xmNorm(_mm_set1_ps(NORMALIZE));
-	XMVECTOR const xmDeNorm(_mm_set1_ps(DENORMALIZE));
+	// unsupported formats:
+	// MODE_U32
+	// MODE_F32 (see ImagingNewHistogram w/ range)
+
+	switch (im->mode)
+	{
+	case MODE_1BIT:
+	case MODE_L:
+		row = &histogram::build_row<uint8_t, 1, 1>; bands = 1;
+		break;
+	case MODE_LA:
+		row = &histogram::build_row<uint8_t, 2, 2>; bands = 2;
+		break;
+	case MODE_RGB:
+		row = &histogram::build_row<uint8_t, 3, 3>; bands = 3;
+		break;
+	case MODE_BGRX:
+		row = &histogram::build_row<uint8_t, 3, 4>; bands = 3;
+		break;
+	case MODE_BGRA:
+		row = &histogram::build_row<uint8_t, 4, 4>; bands = 4;
+		break;
+	case MODE_L16:
+		row = &histogram::build_row<uint16_t, 1, 1>; bands = 1; count = UINT16_MAX + 1; // # of histogram bins for 16bpc image
+		break;
+	case MODE_LA16:
+		row = &histogram::build_row<uint16_t, 2, 2>; bands = 2; count = UINT16_MAX + 1;
+		break;
+	case MODE_RGB16:
+		row = &histogram::build_row<uint16_t, 3, 3>; bands = 3; count = UINT16_MAX + 1;
+		break;
+	case MODE_BGRX16:
+		row = &histogram::build_row<uint16_t, 3, 4>; bands = 3; count = UINT16_MAX + 1;
+		break;
+	case MODE_BGRA16:
+		row = &histogram::build_row<uint16_t, 4, 4>; bands = 4; count = UINT16_MAX + 1;
+		break;
+	default:
+		return (ImagingHistogram*)ImagingError_ModeError();
+	}
+
+	ImagingHistogram* const __restrict histo(histogram::new_histogram(count, bands));
+	if (!histo) {
+		return(nullptr);
+	}
 
-	uvec4_t rgba_dst{}, rgba_src{};
+	size_t const size(size_t(count) * size_t(bands));
+	uint32_t const copies(count <= histogram::MAX_REPLICATED_BINS ? histogram::COPIES : 1);
 
-	for (uint32_t y = 0; y < height; ++y) {
+	tbb::enumerable_thread_specific<histogram::bins> locals(histogram::bins(size * copies, 0));
 
-		for (uint32_t x = 0; x < width; ++x) {
+	struct { // avoid lambda heap
+		uint8_t const* const* const __restrict image;
+		histogram::row_function const row;
+		uint32_t const width, count;
+		size_t const copy_stride;
 
-			uint32_t const pixel(y * width + x);
+	} const p = { (uint8_t const* const*)im->image, row, (uint32_t)im->xsize, count, (1 == copies ? 0 : size) };
 
-			SFM::unpack_rgba(blockA[pixel], rgba_dst.r, rgba_dst.g, rgba_dst.b, rgba_dst.a);
-			SFM::unpack_rgba(blockB[pixel], rgba_src.r, rgba_src.g, rgba_src.b, rgba_src.a);
+	tbb::parallel_for(tbb::blocked_range<int>(0, im->ysize), [&p, &locals](tbb::blocked_range<int> const& r) {
 
-			// floating point precision is best in [0.0f ... 1.0f] range, so normalizing before lerp then denormalization after is a huge benefit
-			SFM::saturate_to_u8(XMVectorMultiply(xmDeNorm, SFM::lerp(XMVectorMultiply(xmNorm, uvec4_v(rgba_dst).v4f()), XMVectorMultiply(xmNorm, uvec4_v(rgba_src).v4f()), tT)), rgba_dst);
+		uint32_t* const __restrict local(locals.local().data());
 
-			blockA[pixel] = SFM::pack_rgba(rgba_dst.r, rgba_dst.g, rgba_dst.b, rgba_dst.a);
+		for (int y = r.begin(); y < r.end(); ++y) {
+			p.row(local, p.count, p.copy_stride, p.image[y], p.width);
 		}
-	}
+	});
+
+	locals.combine_each([histo, copies](histogram::bins const& local) {
+		histogram::merge(histo, local.data(), copies);
+	});
+
+	histogram::finish(histo);
+
+	return(histo);
 }
 
-void __vectorcall ImagingLerp(ImagingMemoryInstance* const __restrict out, ImagingMemoryInstance const* const __restrict A, ImagingMemoryInstance const* const __restrict B, float const tT)
+ImagingHistogram* const __restrict __vectorcall ImagingNewHistogram(ImagingMemoryInstance const* const __restrict im, float const fMin, float const fMax, uint32_t const count)
 {
-	uint32_t const height(B->ysize);
-	uint32_t const width(B->xsize);
+	if (!im) {
+		return(nullptr);
+	}
 
-	uint32_t* const __restrict blockOut(reinterpret_cast<uint32_t* const>(out->block));
-	uint32_t const* const __restrict blockA(reinterpret_cast<uint32_t const* const>(A->block));
-	uint32_t const* const __restrict blockB(reinterpret_cast<uint32_t const* const>(B->block));
+	if (MODE_F32 != im->mode) {
+		return (ImagingHistogram*)ImagingError_ModeError();
+	}
 
-	static constexpr float const NORMALIZE = 1.0f / float(UINT8_MAX);
-	static constexpr float const DENORMALIZE = float(UINT8_MAX);
-	XMVECTOR const xmNorm(_mm_set1_ps(NORMALIZE));
-	XMVECTOR const xmDeNorm(_mm_set1_ps(DENORMALIZE));
+	if (0 == count || !(fMax > fMin)) {
+		return (ImagingHistogram*)ImagingError_ValueError("bad histogram range");
+	}
 
-	for (uint32_t y = 0; y < height; ++y) {
+	ImagingHistogram* const __restrict histo(histogram::new_histogram(count, 1));
+	if (!histo) {
+		return(nullptr);
+	}
 
-		for (uint32_t x = 0; x < width; ++x) {
+	uint32_t const copies(count <= histogram::MAX_REPLICATED_BINS ? histogram::COPIES : 1);
 
-			uint32_t const pixel(y * width + x);
+	tbb::enumerable_thread_specific<histogram::local_f32> locals(histogram::local_f32{ histogram::bins(size_t(count) * copies, 0), FLT_MAX, -FLT_MAX });
+
+	struct { // avoid lambda heap
+		float const* const* const __restrict image;
+		uint32_t const width, count;
+		size_t const copy_stride;
+		float const fMin, fScale;
+
+	} const p = { (float const* const*)im->image32, (uint32_t)im->xsize, count, (1 == copies ? 0 : size_t(count)), fMin, float(double(count) / (double(fMax) - double(fMin))) };
 
-			uvec4_t rgba_srcA, rgba_srcB;
-			SFM::unpack_rgba(blockA[pixel], rgba_srcA.r, rgba_srcA.g, rgba_srcA.b, rgba_srcA.a);
-			SFM::unpack_rgba(blockB[pixel], rgba_srcB.r, rgba_srcB.g, rgba_srcB.b, rgba_srcB.a);
+	tbb::parallel_for(tbb::blocked_range<int>(0, im->ysize), [&p, &locals](tbb::blocked_range<int> const& r) {
 
-			// floating point precision is best in [0.0f ... 1.0f] range, so normalizing before lerp then denormalization after is a huge benefit
-			uvec4_t rgba_dst;
-			SFM::saturate_to_u8(XMVectorMultiply(xmDeNorm, SFM::lerp(XMVectorMultiply(xmNorm, uvec4_v(rgba_srcA).v4f()), XMVectorMultiply(xmNorm, uvec4_v(rgba_srcB).v4f()), tT)), rgba_dst);
+		histogram::local_f32& __restrict local(locals.local());
 
-			blockOut[pixel] = SFM::pack_rgba(rgba_dst.r, rgba_dst.g, rgba_dst.b, rgba_dst.a);
+		for (int y = r.begin(); y < r.end(); ++y) {
+			histogram::build_row_f32(local, p.count, p.copy_stride, p.image[y], p.width, p.fMin, p.fScale);
 		}
+	});
+
+	histo->minmax[0] = FLT_MAX;
+	histo->minmax[1] = -FLT_MAX;
+
+	locals.combine_each([histo, copies](histogram::local_f32 const& local) {
+		histogram::merge(histo, local.counts.data(), copies);
+		histo->minmax[0] = SFM::min(histo->minmax[0], local.fMin);
+		histo->minmax[1] = SFM::max(histo->minmax[1], local.fMax);
+	});
+
+	histo->total = 0;
+	for (uint32_t bin = 0; bin < count; ++bin) {
+		histo->total += histo->block[bin];
 	}
+
+	histo->type = IMAGING_TYPE_FLOAT32;
+	histo->range[0] = fMin;
+	histo->range[1] = fMax;
+
+	return(histo);
 }
 
-// overwrites input
-void __vectorcall ImagingLUTLerp(ImagingLUT* const __restrict A, ImagingLUT const* const __restrict B, float const tT)
+void __vectorcall ImagingHistogramCDF(ImagingHistogram const* const __restrict histo, float* const __restrict cdf, uint32_t const channel)
 {
-	if (A->size != B->size)
+	if (!histo || !cdf || channel >= histo->bands) {
 		return;
+	}
 
-	uint32_t const lut_size(B->size);
-
-	uint16_t* const __restrict blockA(A->block);
-	uint16_t const* const __restrict blockB(B->block);
-
-	static constexpr float const NORMALIZE = 1.0f / float(UINT16_MAX);
-	static constexpr float const DENORMALIZE = float(UINT16_MAX);
-	XMVECTOR const xmNorm(_mm_set1_ps(NORMALIZE));
-	XMVECTOR const xmDeNorm(_mm_set1_ps(DENORMALIZE));
-
-	for (uint32_t b = 0; b < lut_size; ++b) {
-
-		for (uint32_t g = 0; g < lut_size; ++g) {
-
-			for (uint32_t r = 0; r < lut_size; ++r) {
+	uint32_t const* const __restrict counts(histo->block + size_t(channel) * size_t(histo->count));
 
-				uint32_t const index(((b * lut_size * lut_size) + (g * lut_size) + r) << 2);
-				uint16_t* const lut_colorA(blockA + index);
-				uint16_t const* const lut_colorB(blockB + index);
+	uint64_t total(0);
+	for (uint32_t bin = 0; bin < histo->count; ++bin) {
+		total += counts[bin];
+	}
 
-				uvec4_t rgba_dst{};
+	double const normalize(total ? 1.0 / double(total) : 0.0);
 
-				// floating point precision is best in [0.0f ... 1.0f] range, so normalizing before lerp then denormalization after is a huge benefit
-				SFM::saturate_to_u16(XMVectorMultiply(xmDeNorm, SFM::lerp(XMVectorMultiply(xmNorm, uvec4_v(lut_colorA[0], lut_colorA[1], lut_colorA[2]).v4f()),
-																		  XMVectorMultiply(xmNorm, uvec4_v(lut_colorB[0], lut_colorB[1], lut_colorB[2]).v4f()), tT)), rgba_dst);
-				// overwrite input A
-				lut_colorA[0] = rgba_dst.r;
-				lut_colorA[1] = rgba_dst.g;
-				lut_colorA[2] = rgba_dst.b;
-			}
-		}
+	uint64_t sum(0);
+	for (uint32_t bin = 0; bin < histo->count; ++bin) {
+		sum += counts[bin];
+		cdf[bin] = float(double(sum) * normalize);
 	}
 }
 
-void __vectorcall ImagingBlend(ImagingMemoryInstance* const __restrict A, ImagingMemoryInstance const* const __restrict B)
+float const __vectorcall ImagingHistogramPercentile(ImagingHistogram const* const __restrict histo, float const percentile, uint32_t const channel)
 {
-	uint32_t const height(B->ysize);
-	uint32_t const width(B->xsize);
-
-	uint32_t* const __restrict blockA(reinterpret_cast<uint32_t* const>(A->block));
-	uint32_t const* const __restrict blockB(reinterpret_cast<uint32_t const* const>(B->block));
+	if (!histo || channel >= histo->bands) {
+		return(0.0f);
+	}
 
-	uvec4_t rgba_dst{}, rgba_src{};
+	uint32_t const* const __restrict counts(histo->block + size_t(channel) * size_t(histo->count));
 
-	for (uint32_t y = 0; y < height; ++y) {
+	uint64_t total(0);
+	for (uint32_t bin = 0; bin < histo->count; ++bin) {
+		total += counts[bin];
+	}
 
-		for (uint32_t x = 0; x < width; ++x) {
+	bool const bInteger(IMAGING_TYPE_FLOAT32 != histo->type); // 8bpc, 16bpc bins are exact values
+	double const width((double(histo->range[1]) - double(histo->range[0])) / double(histo->count));
+	double const target(double(SFM::saturate(percentile)) * double(total));
 
-			uint32_t const pixel(y * width + x);
+	uint64_t sum(0);
+	for (uint32_t bin = 0; bin < histo->count; ++bin) {
 
-			SFM::unpack_rgba(blockA[pixel], rgba_dst.r, rgba_dst.g, rgba_dst.b, rgba_dst.a);
-			SFM::unpack_rgba(blockB[pixel], rgba_src.r, rgba_src.g, rgba_src.b, rgba_src.a);
+		if (0 == counts[bin]) {
+			continue;
+		}
 
-			SFM::blend(uvec4_v(rgba_dst), uvec4_v(rgba_src)).rgba(rgba_dst);
+		uint64_t const next(sum + counts[bin]);
+		if (double(next) >= target) {
 
-			blockA[pixel] = SFM::pack_rgba(rgba_dst.r, rgba_dst.g, rgba_dst.b, rgba_dst.a);
+			if (bInteger) {
+				return(float(bin));
+			}
+			// linear within the bin
+			double const fraction((target - double(sum)) / double(counts[bin]));
+			return(float(double(histo->range[0]) + (double(bin) + fraction) * width));
 		}
+		sum = next;
 	}
+
+	return(histo->range[1]);
 }
 
-void __vectorcall ImagingVerticalFlip(ImagingMemoryInstance* const __restrict im) // flip Y / invert Y axis / vertical flip (INPLACE)
+void __vectorcall ImagingHistogramAutoLevels(ImagingHistogram const* const __restrict histo, double& __restrict dMin, double& __restrict dMax, float const clip, uint32_t const channel)
 {
-	size_t const stride = (size_t const)im->linesize;
-	size_t const height = (size_t const)im->ysize;
-	size_t const half_height = height >> 1;
-
-	uint8_t* __restrict pTarget = im->block + (height * stride) - stride;
-	uint8_t* __restrict pSrc = im->block;
+	if (!histo) {
+		return;
+	}
 
-	for (size_t scanline = height; half_height != scanline; --scanline) {
+	if (clip <= 0.0f && IMAGING_TYPE_FLOAT32 == histo->type) { // exact
+		dMin = histo->minmax[0];
+		dMax = histo->minmax[1];
+		return;
+	}
 
-		uint8_t* __restrict pTargetByte = pTarget;
-		for (size_t byte = stride; 0ULL != byte; --byte) {
+	dMin = ImagingHistogramPercentile(histo, clip, channel);
+	dMax = ImagingHistogramPercentile(histo, 1.0f - clip, channel);
+}
+static ImagingMemoryInstance* const __restrict __vectorcall
+_copy(ImagingMemoryInstance const * const __restrict imIn)
+{
+    if (!imIn)
+		return (Imaging)ImagingError_ValueError(NULL);
 
-			std::swap(*pTargetByte, *pSrc);
+	ImagingMemoryInstance* __restrict imOut = ImagingNew(imIn->mode, imIn->xsize, imIn->ysize);
+    if (!imOut)
+        return(nullptr);
 
-			++pTargetByte;
-			++pSrc;
-		}
-		pTarget -= stride;
+	{
+		if (nullptr != imIn->block && nullptr != imOut->block)
+			memcpy(imOut->block, imIn->block, imIn->ysize * imIn->linesize);
 	}
+
+    return(imOut);
 }
 
-STATIC_INLINE_PURE uint32_t const wrap(int const n, int const dimension)
+ImagingMemoryInstance* const __restrict __vectorcall
+ImagingCopy(ImagingMemoryInstance const* const __restrict imIn)
 {
-	return(SFM::abs(n % dimension));
+    return(_copy(imIn));
 }
 
-template<typename T>
-STATIC_INLINE_PURE ImagingMemoryInstance* const __restrict __vectorcall ImagingOffset(ImagingMemoryInstance const* const __restrict im, int const xoffset, int const yoffset)
+static ImagingLUT* const __restrict __vectorcall
+_copy(ImagingLUT const* const __restrict lutIn)
 {
-	Imaging const img_offset(ImagingCopy(im));
-
-	int32_t const width(im->xsize);
-	int32_t const height(im->ysize);
+	if (!lutIn)
+		return (ImagingLUT*)ImagingError_ValueError(NULL);
 
-	T const* const __restrict blockIn(reinterpret_cast<T const* const __restrict>(im->block));
-	T* const __restrict blockOut(reinterpret_cast<T* const __restrict>(img_offset->block));
+	ImagingLUT* __restrict lutOut = ImagingNew(lutIn->size);
 
-	for (int32_t y = 0; y < height; ++y) {
+	if (!lutOut)
+		return(nullptr);
 
-		uint32_t const out_y(wrap(y + yoffset, height));
+	if (nullptr != lutIn->block && nullptr != lutOut->block)
+		memcpy(lutOut->block, lutIn->block, lutIn->size * lutIn->slicesize);
 
-		for (int32_t x = 0; x < width; ++x) {
+	return(lutOut);
+}
 
-			uint32_t const out_x(wrap(x + xoffset, width));
+ImagingLUT* const __restrict __vectorcall
+ImagingCopy(ImagingLUT const* const __restrict lutIn)
+{
+	return(_copy(lutIn));
+}
 
-			blockOut[out_y * width + out_x] = blockIn[y * width + x];
-		}
-	}
 
-	return(img_offset);
-}
+namespace dithering {
+	XMGLOBALCONST inline uint32_t const _n255by15{ (255U / 15U) };
+	XMGLOBALCONST inline uint32_t const _table[64]{ 
+	3U,129U,34U,160U,10U,136U,42U,168U,192U,66U,223U,97U,200U,73U,231U,105U,50U,
+	176U,18U,144U,58U,184U,26U,152U,239U,113U,207U,81U,247U,121U,215U,89U,14U,
+	140U,46U,180U,7U,133U,38U,164U,203U,77U,235U,109U,196U,70U,227U,101U,62U,188U,
+	30U,156U,54U,180U,22U,148U,251U,125U,219U,93U,243U,117U,211U,85U 
+	};
+} // end ns
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingOffset(ImagingMemoryInstance const* const __restrict im, int const xoffset, int const yoffset) // translate image while wrapping around (*NOT INPLACE)
-{
-	eIMAGINGMODE const mode(im->mode);
+namespace pixel_ops { // 8 BGRA pixels per iteration w/ AVX2 (the project baseline), a remaining group of 4 w/ the 128bit kernels. The final partial group goes thru a small stack buffer so there is no scalar path to keep in sync - lut_ops, f32_ops, color_space & normal_map below end their rows the same way.
 
-	switch (mode)
+	// chroma key
+	// color key matches when the sum of absolute differences of r, g & b is <= 1 (exact or a single component off by +-1), alpha is ignored.
+	// (v & 0x00fefefe) == 0 -> every component differs by at most 1, (v & (v - 1)) == 0 -> at most one component differs.
+	static __inline __m256i const __vectorcall chroma_key8(__m256i const pixels)
 	{
-	case MODE_L:
-		return(ImagingOffset<uint8_t>(im, xoffset, yoffset));
-
-	case MODE_LA:
-	case MODE_L16:
-		return(ImagingOffset<uint16_t>(im, xoffset, yoffset));
+		__m256i const key(_mm256_set1_epi32(0x0040b100));  // abgr
+		__m256i const zero(_mm256_setzero_si256());
 
-	case MODE_BGRX16:
-	case MODE_BGRA16:
-		return(ImagingOffset<uint64_t>(im, xoffset, yoffset));
+		__m256i const v(_mm256_and_si256(_mm256_sub_epi8(_mm256_max_epu8(pixels, key), _mm256_min_epu8(pixels, key)), _mm256_set1_epi32(0x00ffffff)));
+		__m256i const match(_mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(v, _mm256_set1_epi32(0x00fefefe)), zero),
+			                                 _mm256_cmpeq_epi32(_mm256_and_si256(v, _mm256_sub_epi32(v, _mm256_set1_epi32(1))), zero)));
 
-	case MODE_LA16:
-	case MODE_BGRX:
-	case MODE_BGRA:
-	default:
-		return(ImagingOffset<uint32_t>(im, xoffset, yoffset));
+		return(_mm256_andnot_si256(match, pixels)); // remove color & alpha component
 	}
+	static __inline __m128i const __vectorcall chroma_key4(__m128i const pixels)
+	{
+		__m128i const key(_mm_set1_epi32(0x0040b100));  // abgr
+		__m128i const zero(_mm_setzero_si128());
 
-	return(nullptr);
-}
+		__m128i const v(_mm_and_si128(_mm_sub_epi8(_mm_max_epu8(pixels, key), _mm_min_epu8(pixels, key)), _mm_set1_epi32(0x00ffffff)));
+		__m128i const match(_mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(0x00fefefe)), zero),
+			                              _mm_cmpeq_epi32(_mm_and_si128(v, _mm_sub_epi32(v, _mm_set1_epi32(1))), zero)));
 
-// image[y][x] // assuming this is the original orientation 
-// image[x][original_width - y] // rotated 90 degrees ccw
-// image[original_height - x][y] // 90 degrees cw 
-// image[original_height - y][original_width - x] // 180 degrees
+		return(_mm_andnot_si128(match, pixels)); // remove color & alpha component
+	}
 
-template<typename T>
-STATIC_INLINE_PURE void ImagingRotateCW(ImagingMemoryInstance* const __restrict img_returned, ImagingMemoryInstance const* const __restrict im,
-	                                    uint32_t const width, uint32_t const height)
-{
-	T* const __restrict blockOut(reinterpret_cast<T* const __restrict>(img_returned->block));
-	T const* const __restrict blockIn(reinterpret_cast<T const* const __restrict>(im->block));
+	// ordered dither
+	// reference: c = (c & 0xF0) + (((d - (c & 0x0F) * 17) >> 4) & 16), saturated, then c = (c & 0xF0) | ((c >> 4) & 0x0F)
+	// (c & 0x0F) * 17 never exceeds a byte, and bit 4 of the shifted difference is set only when it is greater than d.
+	static __inline __m256i const __vectorcall dither8(__m256i const pixels, __m256i const d)
+	{
+		__m256i const n0F(_mm256_set1_epi8(0x0F)), nF0(_mm256_set1_epi8((char)0xF0));
 
-	for (uint32_t y = 0; y < height; ++y) {
+		__m256i const lo(_mm256_and_si256(pixels, n0F));
+		__m256i const lo17(_mm256_or_si256(lo, _mm256_slli_epi16(lo, 4)));
+		__m256i const le(_mm256_cmpeq_epi8(_mm256_max_epu8(lo17, d), d)); // lo17 <= d
 
-		for (uint32_t x = 0; x < width; ++x) {
+		__m256i const c(_mm256_adds_epu8(_mm256_and_si256(pixels, nF0), _mm256_andnot_si256(le, _mm256_set1_epi8(16))));
 
-			uint32_t const out_x((height - 1) - y);
-			uint32_t const out_y(x);
-			blockOut[out_y * height + out_x] = blockIn[y * width + x]; // image[x][original_width - y] // rotated 90 degrees ccw
-		}
+		return(_mm256_or_si256(_mm256_and_si256(c, nF0), _mm256_and_si256(_mm256_srli_epi16(c, 4), n0F)));
 	}
-}
+	static __inline __m128i const __vectorcall dither4(__m128i const pixels, __m128i const d)
+	{
+		__m128i const n0F(_mm_set1_epi8(0x0F)), nF0(_mm_set1_epi8((char)0xF0));
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingRotateCW(ImagingMemoryInstance const* const __restrict im)
-{
-	uint32_t const width(im->xsize);
-	uint32_t const height(im->ysize);
+		__m128i const lo(_mm_and_si128(pixels, n0F));
+		__m128i const lo17(_mm_or_si128(lo, _mm_slli_epi16(lo, 4)));
+		__m128i const le(_mm_cmpeq_epi8(_mm_max_epu8(lo17, d), d)); // lo17 <= d
 
-	eIMAGINGMODE const mode(im->mode);
-	Imaging img_returned(ImagingNew(mode, height, width));
+		__m128i const c(_mm_adds_epu8(_mm_and_si128(pixels, nF0), _mm_andnot_si128(le, _mm_set1_epi8(16))));
 
-	switch (mode)
+		return(_mm_or_si128(_mm_and_si128(c, nF0), _mm_and_si128(_mm_srli_epi16(c, 4), n0F)));
+	}
+
+	// blend
+	// A = (A * A.alpha + B * (255 - A.alpha)) >> 8, all 4 channels. The sum never exceeds 255 * 255, so 16bit lanes are exact.
+	static __inline __m256i const __vectorcall blend8(__m256i const A, __m256i const B)
 	{
-	case MODE_L:
-		ImagingRotateCW<uint8_t>(img_returned, im, width, height);
-		break;
+		__m256i const zero(_mm256_setzero_si256());
+		__m256i const n255(_mm256_set1_epi16(255));
+		__m256i const alpha_shuffle(_mm256_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15,
+			                                         6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15));
 
-	case MODE_LA:
-	case MODE_L16:
-		ImagingRotateCW<uint16_t>(img_returned, im, width, height);
-		break;
-	
-	case MODE_BGRX16:
-	case MODE_BGRA16:
-		ImagingRotateCW<uint64_t>(img_returned, im, width, height);
-		break;
+		__m256i const A_lo(_mm256_unpacklo_epi8(A, zero)), A_hi(_mm256_unpackhi_epi8(A, zero));
+		__m256i const B_lo(_mm256_unpacklo_epi8(B, zero)), B_hi(_mm256_unpackhi_epi8(B, zero));
 
-	case MODE_LA16:
-	case MODE_BGRX:
-	case MODE_BGRA:
-	default:
-		ImagingRotateCW<uint32_t>(img_returned, im, width, height);
-		break;
-	}
+		__m256i const alpha_lo(_mm256_shuffle_epi8(A_lo, alpha_shuffle)), alpha_hi(_mm256_shuffle_epi8(A_hi, alpha_shuffle));
 
-	return(img_returned);
-}
+		__m256i const lo(_mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(A_lo, alpha_lo), _mm256_mullo_epi16(B_lo, _mm256_sub_epi16(n255, alpha_lo))), 8));
+		__m256i const hi(_mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(A_hi, alpha_hi), _mm256_mullo_epi16(B_hi, _mm256_sub_epi16(n255, alpha_hi))), 8));
 
-template<typename T>
-STATIC_INLINE_PURE void ImagingRotateCCW(ImagingMemoryInstance* const __restrict img_returned, ImagingMemoryInstance const* const __restrict im,
-	                                     uint32_t const width, uint32_t const height)
-{
-	T* const __restrict blockOut(reinterpret_cast<T* const __restrict>(img_returned->block));
-	T const* const __restrict blockIn(reinterpret_cast<T const* const __restrict>(im->block));
+		return(_mm256_packus_epi16(lo, hi));
+	}
+	static __inline __m128i const __vectorcall blend4(__m128i const A, __m128i const B)
+	{
+		__m128i const zero(_mm_setzero_si128());
+		__m128i const n255(_mm_set1_epi16(255));
+		__m128i const alpha_shuffle(_mm_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15));
 
-	for (uint32_t y = 0; y < height; ++y) {
+		__m128i const A_lo(_mm_unpacklo_epi8(A, zero)), A_hi(_mm_unpackhi_epi8(A, zero));
+		__m128i const B_lo(_mm_unpacklo_epi8(B, zero)), B_hi(_mm_unpackhi_epi8(B, zero));
 
-		for (uint32_t x = 0; x < width; ++x) {
+		__m128i const alpha_lo(_mm_shuffle_epi8(A_lo, alpha_shuffle)), alpha_hi(_mm_shuffle_epi8(A_hi, alpha_shuffle));
 
-			uint32_t const out_x(y);
-			uint32_t const out_y((width - 1) - x);
-			blockOut[out_y * height + out_x] = blockIn[y * width + x]; // image[x][original_width - y] // rotated 90 degrees ccw
-		}
+		__m128i const lo(_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(A_lo, alpha_lo), _mm_mullo_epi16(B_lo, _mm_sub_epi16(n255, alpha_lo))), 8));
+		__m128i const hi(_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(A_hi, alpha_hi), _mm_mullo_epi16(B_hi, _mm_sub_epi16(n255, alpha_hi))), 8));
+
+		return(_mm_packus_epi16(lo, hi));
 	}
-}
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingRotateCCW(ImagingMemoryInstance const* const __restrict im)
-{
-	uint32_t const width(im->xsize);
-	uint32_t const height(im->ysize);
+	// lerp
+	// floating point precision is best in [0.0f ... 1.0f] range, so normalizing before lerp then denormalization after is a huge benefit
+	static __inline __m256i const __vectorcall lerp2_u8(__m128i const A, __m128i const B, __m256 const t) // 2 pixels, low 8 bytes of A & B
+	{
+		__m256 const norm(_mm256_set1_ps(1.0f / float(UINT8_MAX)));
 
-	eIMAGINGMODE const mode(im->mode);
-	Imaging img_returned(ImagingNew(mode, height, width));
+		__m256 const fA(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(A)), norm)),
+			         fB(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(B)), norm));
 
-	switch (mode)
+		return(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_fmadd_ps(_mm256_sub_ps(fB, fA), t, fA), _mm256_set1_ps(float(UINT8_MAX)))));
+	}
+	static __inline __m256i const __vectorcall lerp8(__m256i const A, __m256i const B, __m256 const t)
 	{
-	case MODE_L:
-		ImagingRotateCCW<uint8_t>(img_returned, im, width, height);
-		break;
-
-	case MODE_LA:
-	case MODE_L16:
-		ImagingRotateCCW<uint16_t>(img_returned, im, width, height);
-		break;
+		__m128i const A_lo(_mm256_castsi256_si128(A)), A_hi(_mm256_extracti128_si256(A, 1));
+		__m128i const B_lo(_mm256_castsi256_si128(B)), B_hi(_mm256_extracti128_si256(B, 1));
 
-	case MODE_BGRX16:
-	case MODE_BGRA16:
-		ImagingRotateCCW<uint64_t>(img_returned, im, width, height);
-		break;
+		__m256i const p01(lerp2_u8(A_lo, B_lo, t)), p23(lerp2_u8(_mm_srli_si128(A_lo, 8), _mm_srli_si128(B_lo, 8), t)),
+			          p45(lerp2_u8(A_hi, B_hi, t)), p67(lerp2_u8(_mm_srli_si128(A_hi, 8), _mm_srli_si128(B_hi, 8), t));
 
-	case MODE_LA16:
-	case MODE_BGRX:
-	case MODE_BGRA:
-	default:
-		ImagingRotateCCW<uint32_t>(img_returned, im, width, height);
-		break;
+		// saturating packs are in-lane: [0 2 4 6 | 1 3 5 7] -> [0 1 2 3 4 5 6 7]
+		__m256i const packed(_mm256_packus_epi16(_mm256_packus_epi32(p01, p23), _mm256_packus_epi32(p45, p67)));
+		return(_mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
 	}
+	static __inline __m128i const __vectorcall lerp1_u8(__m128i const A, __m128i const B, __m128 const t) // 1 pixel, low 4 bytes of A & B
+	{
+		__m128 const norm(_mm_set1_ps(1.0f / float(UINT8_MAX)));
 
-	return(img_returned);
-}
+		__m128 const fA(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(A)), norm)),
+			         fB(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(B)), norm));
 
-// (NOT INPLACE) - new image returned of LA16 type, requires normal map of type BGRA16 input.
-ImagingMemoryInstance* const __restrict __vectorcall ImagingTangentSpaceNormalMapToDerivativeMapBGRA16(ImagingMemoryInstance* const __restrict im)
-{
-	uint32_t const width(im->xsize);
-	uint32_t const height(im->ysize);
-	 
-	Imaging img_returned(ImagingNew(MODE_LA16, width, height));
+		return(_mm_cvtps_epi32(_mm_mul_ps(_mm_fmadd_ps(_mm_sub_ps(fB, fA), t, fA), _mm_set1_ps(float(UINT8_MAX))))); // same rounding as lerp8
+	}
+	static __inline __m128i const __vectorcall lerp4(__m128i const A, __m128i const B, __m128 const t)
+	{
+		__m128i const p0(lerp1_u8(A, B, t)), p1(lerp1_u8(_mm_srli_si128(A, 4), _mm_srli_si128(B, 4), t)),
+			          p2(lerp1_u8(_mm_srli_si128(A, 8), _mm_srli_si128(B, 8), t)), p3(lerp1_u8(_mm_srli_si128(A, 12), _mm_srli_si128(B, 12), t));
 
-	uint32_t* const __restrict blockOut(reinterpret_cast<uint32_t* const>(img_returned->block));
-	uint64_t const* const __restrict blockIn(reinterpret_cast<uint64_t const* const>(im->block));
+		return(_mm_packus_epi16(_mm_packus_epi32(p0, p1), _mm_packus_epi32(p2, p3)));
+	}
 
-	static constexpr float const NORMALIZE = 1.0f / float(UINT16_MAX);
-	static constexpr float const DENORMALIZE = float(UINT16_MAX);
-	XMVECTOR const xmNorm(_mm_set1_ps(NORMALIZE));
-	XMVECTOR const xmDeNorm(_mm_set1_ps(DENORMALIZE));
-	
-	for (uint32_t y = 0; y < height; ++y) {
+	// lerp L16, 16 values per iteration, a remaining group of 8 w/ the 128bit kernel
+	static __inline __m256i const __vectorcall lerp16_u16(__m256i const A, __m256i const B, __m256 const t)
+	{
+		__m256 const norm(_mm256_set1_ps(1.0f / float(UINT16_MAX)));
+		__m256 const denorm(_mm256_set1_ps(float(UINT16_MAX)));
 
-		for (uint32_t x = 0; x < width; ++x) {
+		__m256 const fA_lo(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(A))), norm)),
+			         fB_lo(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(B))), norm)),
+			         fA_hi(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(A, 1))), norm)),
+			         fB_hi(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(B, 1))), norm));
 
-			uint64_t const uNormal(blockIn[y * width + x]);
+		__m256i const lo(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_fmadd_ps(_mm256_sub_ps(fB_lo, fA_lo), t, fA_lo), denorm))),
+			          hi(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_fmadd_ps(_mm256_sub_ps(fB_hi, fA_hi), t, fA_hi), denorm)));
 
-			XMVECTOR xmTangentSpaceNormal = XMVectorMultiply(xmNorm, uvec4_v((uNormal & 0xffff), ((uNormal >> 16) & 0xffff), ((uNormal >> 32) & 0xffff)).v4f());
-			xmTangentSpaceNormal = SFM::__fms(xmTangentSpaceNormal, XMVectorReplicate(2.0f), XMVectorReplicate(1.0f));
-			xmTangentSpaceNormal = XMVector3Normalize(xmTangentSpaceNormal);
+		return(_mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+	static __inline __m128i const __vectorcall lerp8_u16(__m128i const A, __m128i const B, __m128 const t)
+	{
+		__m128 const norm(_mm_set1_ps(1.0f / float(UINT16_MAX)));
+		__m128 const denorm(_mm_set1_ps(float(UINT16_MAX)));
 
-			// Mikkelsen2020Bump.pdf - https://mmikkelsen3d.blogspot.com/2011/07/derivative-maps.html
-			
-			// This is setup expecting the input normal map in standard Tangent Space Coordinates
-			// red X+ (right), green Y+ (down), blue Z+ (near) [set as default coordinate system in ShaderMap (TS)]
-		 
-			constexpr float const scale = 1.0f / 128.0f; // 89.55 degrees
+		__m128 const fA_lo(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(A)), norm)),
+			         fB_lo(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(B)), norm)),
+			         fA_hi(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(A, 8))), norm)),
+			         fB_hi(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(B, 8))), norm));
 
-			XMFLOAT3A vM, vMa;
-			XMStoreFloat3A(&vM, xmTangentSpaceNormal);
-			XMStoreFloat3A(&vMa, SFM::abs(xmTangentSpaceNormal));
-			                           // avoid division by zero on absolute value
-			float const z_ma = SFM::max(0.0001f, SFM::max(vMa.z, scale * SFM::max(vMa.x, vMa.y)));
-			                                                                                                                                              // in vulkan texture origin is upper-left, however TS (tangent space) uses -1 as up aswell. So the *y component is already negated* So it passes thru untouched, do not negate it again!
-			XMVECTOR xmDerivative = XMVectorDivide(XMVectorNegate(XMVectorSet(vM.x, vM.y, 0.0f, 0.0f)), XMVectorReplicate(z_ma));                         // *bugfix - -float2(vM.x, (-1.0f)*vM.y)/z_ma is supposed to be the output of the derivative map (signed here then packed unsigned)
-			// back to 0 ... 1, and then finally uint16_t range                                                                    
-			xmDerivative = SFM::saturate(SFM::__fma(xmDerivative, XMVectorReplicate(0.5f), XMVectorReplicate(0.5f)));
-			xmDerivative = XMVectorMultiply(xmDeNorm, xmDerivative);                                                               
+		__m128i const lo(_mm_cvtps_epi32(_mm_mul_ps(_mm_fmadd_ps(_mm_sub_ps(fB_lo, fA_lo), t, fA_lo), denorm))),
+			          hi(_mm_cvtps_epi32(_mm_mul_ps(_mm_fmadd_ps(_mm_sub_ps(fB_hi, fA_hi), t, fA_hi), denorm)));
 
-			uvec4_t la16{};
+		return(_mm_packus_epi32(lo, hi));
+	}
+
+	// spans
+	static void __vectorcall chroma_key_span(uint32_t* const __restrict block, size_t const count)
+	{
+		size_t i(0);
 
-			SFM::saturate_to_u16(xmDerivative, la16);
-			//                                      ABGR              GR              AL   <--- in memory 
-			// store the 2 16bit components         RGBA (backwards)  RG (backwards)  LA
-			blockOut[y * width + x] = la16.r | ((la16.g << 16) & 0xffff0000); 
+		for (; i + 8 <= count; i += 8) {
+			_mm256_storeu_si256((__m256i*)&block[i], chroma_key8(_mm256_loadu_si256((__m256i const*)&block[i])));
+		}
+		for (; i + 4 <= count; i += 4) {
+			_mm_storeu_si128((__m128i*)&block[i], chroma_key4(_mm_loadu_si128((__m128i const*)&block[i])));
+		}
+		if (i < count) {
+			alignas(16) uint32_t tail[4]{};
+			memcpy(tail, &block[i], (count - i) * sizeof(uint32_t));
+			_mm_store_si128((__m128i*)tail, chroma_key4(_mm_load_si128((__m128i const*)tail)));
+			memcpy(&block[i], tail, (count - i) * sizeof(uint32_t));
 		}
 	}
 
-	return(img_returned);
-}
+	static void __vectorcall dither_row(uint32_t* const __restrict row, uint32_t const width, uint32_t const y)
+	{
+		// ordered dither table broadcast for this row, 8 pixels wide (x & 7) with every channel of a pixel sharing the same threshold
+		uint32_t const* const __restrict thresholds(&dithering::_table[(y & 7U) << 3U]);
+		__m256i const d(_mm256_setr_epi32(thresholds[7] * 0x01010101U, thresholds[6] * 0x01010101U, thresholds[5] * 0x01010101U, thresholds[4] * 0x01010101U,
+			                              thresholds[3] * 0x01010101U, thresholds[2] * 0x01010101U, thresholds[1] * 0x01010101U, thresholds[0] * 0x01010101U));
+		__m128i const d_half[2]{ _mm256_castsi256_si128(d), _mm256_extracti128_si256(d, 1) };
 
-static ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRaw(eIMAGINGMODE const mode, std::wstring_view const filenamepath, int const width, int const height)
-{
-	Imaging returnL(nullptr);
+		uint32_t x(0);
+
+		for (; x + 8 <= width; x += 8) {
+			_mm256_storeu_si256((__m256i*)&row[x], dither8(_mm256_loadu_si256((__m256i const*)&row[x]), d));
+		}
+		for (; x + 4 <= width; x += 4) {
+			_mm_storeu_si128((__m128i*)&row[x], dither4(_mm_loadu_si128((__m128i const*)&row[x]), d_half[(x >> 2) & 1]));
+		}
+		if (x < width) {
+			alignas(16) uint32_t tail[4]{};
+			memcpy(tail, &row[x], (width - x) * sizeof(uint32_t));
+			_mm_store_si128((__m128i*)tail, dither4(_mm_load_si128((__m128i const*)tail), d_half[(x >> 2) & 1]));
+			memcpy(&row[x], tail, (width - x) * sizeof(uint32_t));
+		}
+	}
 
-	FILE* fIn;
+	static void __vectorcall blend_span(uint32_t* const __restrict A, uint32_t const* const __restrict B, size_t const count)
+	{
+		size_t i(0);
+
+		for (; i + 8 <= count; i += 8) {
+			_mm256_storeu_si256((__m256i*)&A[i], blend8(_mm256_loadu_si256((__m256i const*)&A[i]), _mm256_loadu_si256((__m256i const*)&B[i])));
+		}
+		for (; i + 4 <= count; i += 4) {
+			_mm_storeu_si128((__m128i*)&A[i], blend4(_mm_loadu_si128((__m128i const*)&A[i]), _mm_loadu_si128((__m128i const*)&B[i])));
+		}
+		if (i < count) {
+			alignas(16) uint32_t tailA[4]{}, tailB[4]{};
+			memcpy(tailA, &A[i], (count - i) * sizeof(uint32_t));
+			memcpy(tailB, &B[i], (count - i) * sizeof(uint32_t));
+			_mm_store_si128((__m128i*)tailA, blend4(_mm_load_si128((__m128i const*)tailA), _mm_load_si128((__m128i const*)tailB)));
+			memcpy(&A[i], tailA, (count - i) * sizeof(uint32_t));
+		}
+	}
 
-	if (0 == _wfopen_s(&fIn, filenamepath.data(), L"rbS"))
+	static void __vectorcall lerp_span(uint32_t* const out, uint32_t const* const A, uint32_t const* const __restrict B, size_t const count, float const tT) // out may alias A
 	{
-		returnL = ImagingNew(mode, width, height);
+		size_t i(0);
 
-		uint8_t*  __restrict pOut = returnL->block;
-		uint32_t const stride = returnL->linesize;
+		__m256 const t8(_mm256_set1_ps(tT));
+		for (; i + 8 <= count; i += 8) {
+			_mm256_storeu_si256((__m256i*)&out[i], lerp8(_mm256_loadu_si256((__m256i const*)&A[i]), _mm256_loadu_si256((__m256i const*)&B[i]), t8));
+		}
 
-		uint32_t scanline(height);
-		while (0 != scanline) {
+		__m128 const t(_mm_set1_ps(tT));
+		for (; i + 4 <= count; i += 4) {
+			_mm_storeu_si128((__m128i*)&out[i], lerp4(_mm_loadu_si128((__m128i const*)&A[i]), _mm_loadu_si128((__m128i const*)&B[i]), t));
+		}
+		if (i < count) {
+			alignas(16) uint32_t tailA[4]{}, tailB[4]{};
+			memcpy(tailA, &A[i], (count - i) * sizeof(uint32_t));
+			memcpy(tailB, &B[i], (count - i) * sizeof(uint32_t));
+			_mm_store_si128((__m128i*)tailA, lerp4(_mm_load_si128((__m128i const*)tailA), _mm_load_si128((__m128i const*)tailB), t));
+			memcpy(&out[i], tailA, (count - i) * sizeof(uint32_t));
+		}
+	}
 
-			_fread_nolock_s(pOut, stride, 1, stride, fIn);
-			pOut += stride;
+	static void __vectorcall lerp_span(uint16_t* const __restrict A, uint16_t const* const __restrict B, size_t const count, float const tT)
+	{
+		size_t i(0);
 
-			--scanline;
+		__m256 const t16(_mm256_set1_ps(tT));
+		for (; i + 16 <= count; i += 16) {
+			_mm256_storeu_si256((__m256i*)&A[i], lerp16_u16(_mm256_loadu_si256((__m256i const*)&A[i]), _mm256_loadu_si256((__m256i const*)&B[i]), t16));
 		}
 
-		_fclose_nolock(fIn); fIn = nullptr;
+		__m128 const t(_mm_set1_ps(tT));
+		for (; i + 8 <= count; i += 8) {
+			_mm_storeu_si128((__m128i*)&A[i], lerp8_u16(_mm_loadu_si128((__m128i const*)&A[i]), _mm_loadu_si128((__m128i const*)&B[i]), t));
+		}
+		if (i < count) {
+			alignas(16) uint16_t tailA[8]{}, tailB[8]{};
+			memcpy(tailA, &A[i], (count - i) * sizeof(uint16_t));
+			memcpy(tailB, &B[i], (count - i) * sizeof(uint16_t));
+			_mm_store_si128((__m128i*)tailA, lerp8_u16(_mm_load_si128((__m128i const*)tailA), _mm_load_si128((__m128i const*)tailB), t));
+			memcpy(&A[i], tailA, (count - i) * sizeof(uint16_t));
+		}
 	}
-	return(returnL);
-}
+} // end ns
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawBGRA16(std::wstring_view const filenamepath, int const width, int const height)
-{
-	return(ImagingLoadRaw(MODE_BGRA16, filenamepath, width, height));
+void __vectorcall ImagingChromaKey(ImagingMemoryInstance* const __restrict im)	// (INPLACE) key[ 0x00b140 ] - for best results this function should be used earliest in the pipeline before any image alteration are made like dithering, etc.
+{																				//                           - this function specifies the exact color key to use, but compensates for +-1 in differences.
+	// remove color & alpha component  (remove green screen color & set what ever alpha it was before, possibly opaque, to transparent)
+	pixel_ops::chroma_key_span(reinterpret_cast<uint32_t*>(im->block), size_t(im->xsize) * size_t(im->ysize));
 }
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawRGB16(std::wstring_view const filenamepath, int const width, int const height)
+
+void __vectorcall ImagingDither(ImagingMemoryInstance* const __restrict im)
 {
-	return(ImagingLoadRaw(MODE_RGB16, filenamepath, width, height));
-}
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawBGRA(std::wstring_view const filenamepath, int const width, int const height)
-{
-	return(ImagingLoadRaw(MODE_BGRA, filenamepath, width, height));
-}
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawRGB(std::wstring_view const filenamepath, int const width, int const height)
-{
-	return(ImagingLoadRaw(MODE_RGB, filenamepath, width, height));
-}
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawLA16(std::wstring_view const filenamepath, int const width, int const height)
-{
-	return(ImagingLoadRaw(MODE_LA16, filenamepath, width, height));
+	uint32_t const width(im->xsize);
+	uint32_t const height(im->ysize);
+
+	uint32_t* const __restrict block(reinterpret_cast<uint32_t* const>(im->block));
+
+	for (uint32_t y = 0; y < height; ++y) {
+
+		pixel_ops::dither_row(block + size_t(y) * size_t(width), width, y);
+	}
 }
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawL16(std::wstring_view const filenamepath, int const width, int const height)
+
+// overwrites input
+void __vectorcall ImagingLerpL16(ImagingMemoryInstance* const __restrict A, ImagingMemoryInstance const* const __restrict B, float const tT)
 {
-	return(ImagingLoadRaw(MODE_L16, filenamepath, width, height));
+	pixel_ops::lerp_span(reinterpret_cast<uint16_t* const>(A->block), reinterpret_cast<uint16_t const* const>(B->block), size_t(B->xsize) * size_t(B->ysize), tT);
 }
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawLA(std::wstring_view const filenamepath, int const width, int const height)
+
+// overwrites input
+void __vectorcall ImagingLerp(ImagingMemoryInstance* const __restrict A, ImagingMemoryInstance const* const __restrict B, float const tT)
 {
-	return(ImagingLoadRaw(MODE_LA, filenamepath, width, height));
+	uint32_t* const blockA(reinterpret_cast<uint32_t* const>(A->block));
+
+	pixel_ops::lerp_span(blockA, blockA, reinterpret_cast<uint32_t const* const>(B->block), size_t(B->xsize) * size_t(B->ysize), tT);
 }
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawL(std::wstring_view const filenamepath, int const width, int const height)
+
+void __vectorcall ImagingLerp(ImagingMemoryInstance* const __restrict out, ImagingMemoryInstance const* const __restrict A, ImagingMemoryInstance const* const __restrict B, float const tT)
 {
-	return(ImagingLoadRaw(MODE_L, filenamepath, width, height));
+	pixel_ops::lerp_span(reinterpret_cast<uint32_t* const>(out->block), reinterpret_cast<uint32_t const* const>(A->block), reinterpret_cast<uint32_t const* const>(B->block), size_t(B->xsize) * size_t(B->ysize), tT);
 }
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawF32(std::wstring_view const filenamepath, int const width, int const height)
+
+// overwrites input
+void __vectorcall ImagingLUTLerp(ImagingLUT* const __restrict A, ImagingLUT const* const __restrict B, float const tT)
 {
-	return(ImagingLoadRaw(MODE_F32, filenamepath, width, height));
+	if (A->size != B->size)
+		return;
+
+	uint32_t const lut_size(B->size);
+
+	uint16_t* const __restrict blockA(A->block);
+	uint16_t const* const __restrict blockB(B->block);
+
+	static constexpr float const NORMALIZE = 1.0f / float(UINT16_MAX);
+	static constexpr float const DENORMALIZE = float(UINT16_MAX);
+	XMVECTOR const xmNorm(_mm_set1_ps(NORMALIZE));
+	XMVECTOR const xmDeNorm(_mm_set1_ps(DENORMALIZE));
+
+	for (uint32_t b = 0; b < lut_size; ++b) {
+
+		for (uint32_t g = 0; g < lut_size; ++g) {
+
+			for (uint32_t r = 0; r < lut_size; ++r) {
+
+				uint32_t const index(((b * lut_size * lut_size) + (g * lut_size) + r) << 2);
+				uint16_t* const lut_colorA(blockA + index);
+				uint16_t const* const lut_colorB(blockB + index);
+
+				uvec4_t rgba_dst{};
+
+				// floating point precision is best in [0.0f ... 1.0f] range, so normalizing before lerp then denormalization after is a huge benefit
+				SFM::saturate_to_u16(XMVectorMultiply(xmDeNorm, SFM::lerp(XMVectorMultiply(xmNorm, uvec4_v(lut_colorA[0], lut_colorA[1], lut_colorA[2]).v4f()),
+																		  XMVectorMultiply(xmNorm, uvec4_v(lut_colorB[0], lut_colorB[1], lut_colorB[2]).v4f()), tT)), rgba_dst);
+				// overwrite input A
+				lut_colorA[0] = rgba_dst.r;
+				lut_colorA[1] = rgba_dst.g;
+				lut_colorA[2] = rgba_dst.b;
+			}
+		}
+	}
 }
 
-STATIC_INLINE_PURE ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemory(Imaging&& __restrict returnL, uint8_t const* __restrict pMemLoad)
-{
-	uint8_t* __restrict pOut = returnL->block;
-	uint32_t const stride = returnL->linesize;
+namespace lut_ops { // AVX2 8 pixels per iteration, lut entries are gathered as 2 x 32bit (r|g, b|x).
 
-	uint32_t scanline(returnL->ysize);
-	while (0 != scanline) {
+	typedef struct params {
 
-		memcpy(pOut, pMemLoad, stride);
-		pMemLoad += stride;
-		pOut += stride;
+		int32_t const* __restrict a;	// lut
+		int32_t const* __restrict b;	// [optional] second lut crossfaded w/ t (nullptr)
+		float scale;					// input value to lut coordinate, (size - 1) / max input value
+		float t;
+		int32_t max_base;				// size - 2, the last cell
+		int32_t stride_g, stride_b;		// in entries, r is 1
 
-		--scanline;
+	} params;
+
+	typedef struct rgb {
+
+		__m256 r, g, b;
+
+	} rgb;
+
+	// weighted sum of the lut entries, values are 0.0f ... 65535.0f
+	template<uint32_t const corners>
+	static __forceinline rgb const __vectorcall blend_corners(int32_t const* const __restrict lut, __m256i const (&entry)[corners], __m256 const (&weight)[corners])
+	{
+		__m256i const xmLow16(_mm256_set1_epi32(0xFFFF));
+
+		rgb sum{ _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+
+		for (uint32_t i = 0; i < corners; ++i) {
+
+			__m256i const index(_mm256_slli_epi32(entry[i], 1)); // 2 x 32bit per entry
+			__m256i const rg(_mm256_i32gather_epi32(lut, index, 4));
+			__m256i const bx(_mm256_i32gather_epi32(lut + 1, index, 4));
+
+			sum.r = _mm256_fmadd_ps(weight[i], _mm256_cvtepi32_ps(_mm256_and_si256(rg, xmLow16)), sum.r);
+			sum.g = _mm256_fmadd_ps(weight[i], _mm256_cvtepi32_ps(_mm256_srli_epi32(rg, 16)), sum.g);
+			sum.b = _mm256_fmadd_ps(weight[i], _mm256_cvtepi32_ps(_mm256_and_si256(bx, xmLow16)), sum.b);
+		}
+
+		return(sum);
 	}
 
-	return(returnL);
-}
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryBGRA16(uint8_t const* __restrict pMemLoad, int const width, int const height)
-{
-	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_BGRA16, width, height)), pMemLoad));
-}
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryRGB16(uint8_t const* __restrict pMemLoad, int const width, int const height)
-{
-	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_RGB16, width, height)), pMemLoad));
-}
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryBGRA(uint8_t const* __restrict pMemLoad, int const width, int const height)
-{
-	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_BGRA, width, height)), pMemLoad));
-}
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryRGB(uint8_t const* __restrict pMemLoad, int const width, int const height)
-{
-	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_RGB, width, height)), pMemLoad));
-}
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryLA16(uint8_t const* __restrict pMemLoad, int const width, int const height)
-{
-	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_LA16, width, height)), pMemLoad));
-}
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryLA(uint8_t const* __restrict pMemLoad, int const width, int const height)
-{
-	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_LA, width, height)), pMemLoad));
-}
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryL16(uint8_t const* __restrict pMemLoad, int const width, int const height)
-{
-	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_L16, width, height)), pMemLoad));
-}
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryL(uint8_t const* __restrict pMemLoad, int const width, int const height)
+	// swaps lanes so that f0 >= f1, the stride follows its fraction
+	static __forceinline void __vectorcall order(__m256& __restrict f0, __m256i& __restrict s0, __m256& __restrict f1, __m256i& __restrict s1)
+	{
+		__m256 const swap(_mm256_cmp_ps(f0, f1, _CMP_LT_OQ));
+
+		__m256 const f(f0);
+		f0 = _mm256_blendv_ps(f0, f1, swap);
+		f1 = _mm256_blendv_ps(f1, f, swap);
+
+		__m256i const s(s0);
+		s0 = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(s0), _mm256_castsi256_ps(s1), swap));
+		s1 = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(s1), _mm256_castsi256_ps(s), swap));
+	}
+
+	// r, g, b in the input range (0 ... 255 or 0 ... 65535), returns 0.0f ... 65535.0f
+	template<bool const tetrahedral>
+	static __forceinline rgb const __vectorcall lookup(params const& __restrict p, __m256 r, __m256 g, __m256 b)
+	{
+		__m256 const xmScale(_mm256_set1_ps(p.scale));
+		__m256i const xmMaxBase(_mm256_set1_epi32(p.max_base));
+		__m256i const xmStrideG(_mm256_set1_epi32(p.stride_g)), xmStrideB(_mm256_set1_epi32(p.stride_b));
+
+		r = _mm256_mul_ps(r, xmScale);
+		g = _mm256_mul_ps(g, xmScale);
+		b = _mm256_mul_ps(b, xmScale);
+
+		// input is never negative so truncation is floor, the last lut entry is the far corner of the last cell (fraction = 1)
+		__m256i const ir(_mm256_min_epi32(_mm256_cvttps_epi32(r), xmMaxBase));
+		__m256i const ig(_mm256_min_epi32(_mm256_cvttps_epi32(g), xmMaxBase));
+		__m256i const ib(_mm256_min_epi32(_mm256_cvttps_epi32(b), xmMaxBase));
+
+		r = _mm256_sub_ps(r, _mm256_cvtepi32_ps(ir));
+		g = _mm256_sub_ps(g, _mm256_cvtepi32_ps(ig));
+		b = _mm256_sub_ps(b, _mm256_cvtepi32_ps(ib));
+
+		__m256i const base(_mm256_add_epi32(_mm256_add_epi32(ir, _mm256_mullo_epi32(ig, xmStrideG)), _mm256_mullo_epi32(ib, xmStrideB)));
+
+		__m256 const xmOne(_mm256_set1_ps(1.0f));
+
+		rgb a{}, c{};
+
+		if constexpr (tetrahedral) {
+
+			// sort the fractions (descending), the 4 corners of the tetrahedron are found by stepping along the axis of the largest, then the middle, then the smallest fraction
+			__m256 f0(r), f1(g), f2(b);
+			__m256i s0(_mm256_set1_epi32(1)), s1(xmStrideG), s2(xmStrideB);
+
+			order(f0, s0, f1, s1);
+			order(f1, s1, f2, s2);
+			order(f0, s0, f1, s1);
+
+			__m256i const e1(_mm256_add_epi32(base, s0));
+			__m256i const e2(_mm256_add_epi32(e1, s1));
+			__m256i const e3(_mm256_add_epi32(e2, s2));
+
+			__m256i const entry[4]{ base, e1, e2, e3 };
+			__m256 const weight[4]{ _mm256_sub_ps(xmOne, f0), _mm256_sub_ps(f0, f1), _mm256_sub_ps(f1, f2), f2 };
+
+			a = blend_corners<4>(p.a, entry, weight);
+			if (p.b) {
+				c = blend_corners<4>(p.b, entry, weight);
+			}
+		}
+		else {
+
+			__m256 const r0(_mm256_sub_ps(xmOne, r)), g0(_mm256_sub_ps(xmOne, g)), b0(_mm256_sub_ps(xmOne, b));
+			__m256 const rg00(_mm256_mul_ps(r0, g0)), rg10(_mm256_mul_ps(r, g0)), rg01(_mm256_mul_ps(r0, g)), rg11(_mm256_mul_ps(r, g));
+
+			__m256i const eG(_mm256_add_epi32(base, xmStrideG)), eB(_mm256_add_epi32(base, xmStrideB)), eGB(_mm256_add_epi32(eG, xmStrideB));
+			__m256i const xmOneI(_mm256_set1_epi32(1));
+
+			__m256i const entry[8]{ base, _mm256_add_epi32(base, xmOneI), eG, _mm256_add_epi32(eG, xmOneI),
+									eB, _mm256_add_epi32(eB, xmOneI), eGB, _mm256_add_epi32(eGB, xmOneI) };
+			__m256 const weight[8]{ _mm256_mul_ps(rg00, b0), _mm256_mul_ps(rg10, b0), _mm256_mul_ps(rg01, b0), _mm256_mul_ps(rg11, b0),
+									_mm256_mul_ps(rg00, b),  _mm256_mul_ps(rg10, b),  _mm256_mul_ps(rg01, b),  _mm256_mul_ps(rg11, b) };
+
+			a = blend_corners<8>(p.a, entry, weight);
+			if (p.b) {
+				c = blend_corners<8>(p.b, entry, weight);
+			}
+		}
+
+		if (p.b) { // same as ImagingLUTLerp(a, b, t) w/o materializing the blended lut
+			__m256 const xmT(_mm256_set1_ps(p.t));
+
+			a.r = _mm256_fmadd_ps(_mm256_sub_ps(c.r, a.r), xmT, a.r);
+			a.g = _mm256_fmadd_ps(_mm256_sub_ps(c.g, a.g), xmT, a.g);
+			a.b = _mm256_fmadd_ps(_mm256_sub_ps(c.b, a.b), xmT, a.b);
+		}
+
+		return(a);
+	}
+
+	// rounded & saturated to 0 ... max
+	static __forceinline __m256i const __vectorcall to_int(__m256 const v, __m256 const xmMax)
+	{
+		return(_mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), xmMax)));
+	}
+
+	// 8 BGRX/BGRA pixels, alpha is preserved
+	template<bool const tetrahedral>
+	static __forceinline __m256i const __vectorcall apply8(params const& __restrict p, __m256i const pixels)
+	{
+		__m256i const xmLow8(_mm256_set1_epi32(0xFF));
+
+		rgb const c(lookup<tetrahedral>(p, _mm256_cvtepi32_ps(_mm256_and_si256(pixels, xmLow8)),
+											_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pixels, 8), xmLow8)),
+											_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pixels, 16), xmLow8))));
+
+		__m256 const xmDeNorm(_mm256_set1_ps(255.0f / 65535.0f)), xmMax(_mm256_set1_ps(255.0f));
+
+		__m256i out(_mm256_and_si256(pixels, _mm256_set1_epi32(0xFF000000)));
+		out = _mm256_or_si256(out, to_int(_mm256_mul_ps(c.r, xmDeNorm), xmMax));
+		out = _mm256_or_si256(out, _mm256_slli_epi32(to_int(_mm256_mul_ps(c.g, xmDeNorm), xmMax), 8));
+		out = _mm256_or_si256(out, _mm256_slli_epi32(to_int(_mm256_mul_ps(c.b, xmDeNorm), xmMax), 16));
+
+		return(out);
+	}
+
+	// 8 BGRX16/BGRA16 pixels in 2 registers (4 pixels each), alpha is preserved
+	template<bool const tetrahedral>
+	static __forceinline void __vectorcall apply8(params const& __restrict p, __m256i& __restrict lo, __m256i& __restrict hi)
+	{
+		// deinterleave to 8 x (r|g) & 8 x (b|a) in pixel order
+		__m256i const rg(_mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+		__m256i const ba(_mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+
+		__m256i const xmLow16(_mm256_set1_epi32(0xFFFF));
+
+		rgb const c(lookup<tetrahedral>(p, _mm256_cvtepi32_ps(_mm256_and_si256(rg, xmLow16)),
+											_mm256_cvtepi32_ps(_mm256_srli_epi32(rg, 16)),
+											_mm256_cvtepi32_ps(_mm256_and_si256(ba, xmLow16))));
+
+		__m256 const xmMax(_mm256_set1_ps(65535.0f));
+
+		__m256i const rg_out(_mm256_permute4x64_epi64(_mm256_or_si256(to_int(c.r, xmMax), _mm256_slli_epi32(to_int(c.g, xmMax), 16)), _MM_SHUFFLE(3, 1, 2, 0)));
+		__m256i const ba_out(_mm256_permute4x64_epi64(_mm256_or_si256(to_int(c.b, xmMax), _mm256_andnot_si256(xmLow16, ba)), _MM_SHUFFLE(3, 1, 2, 0)));
+
+		// reinterleave
+		lo = _mm256_unpacklo_epi32(rg_out, ba_out);
+		hi = _mm256_unpackhi_epi32(rg_out, ba_out);
+	}
+
+	template<bool const tetrahedral>
+	static void __vectorcall apply_row8(params const& __restrict p, uint8_t* const __restrict row, uint32_t const width)
+	{
+		uint32_t* const __restrict pixels(reinterpret_cast<uint32_t* const __restrict>(row));
+
+		uint32_t x(0);
+		for (; (x + 8) <= width; x += 8) {
+			_mm256_storeu_si256((__m256i*)(pixels + x), apply8<tetrahedral>(p, _mm256_loadu_si256((__m256i const*)(pixels + x))));
+		}
+		if (x < width) {
+
+			alignas(32) uint32_t in[8]{};
+
+			memcpy(in, pixels + x, (width - x) * sizeof(uint32_t));
+			_mm256_store_si256((__m256i*)in, apply8<tetrahedral>(p, _mm256_load_si256((__m256i const*)in)));
+			memcpy(pixels + x, in, (width - x) * sizeof(uint32_t));
+		}
+	}
+
+	template<bool const tetrahedral>
+	static void __vectorcall apply_row16(params const& __restrict p, uint8_t* const __restrict row, uint32_t const width)
+	{
+		uint64_t* const __restrict pixels(reinterpret_cast<uint64_t* const __restrict>(row));
+
+		uint32_t x(0);
+		for (; (x + 8) <= width; x += 8) {
+
+			__m256i lo(_mm256_loadu_si256((__m256i const*)(pixels + x))), hi(_mm256_loadu_si256((__m256i const*)(pixels + x + 4)));
+			apply8<tetrahedral>(p, lo, hi);
+			_mm256_storeu_si256((__m256i*)(pixels + x), lo);
+			_mm256_storeu_si256((__m256i*)(pixels + x + 4), hi);
+		}
+		if (x < width) {
+
+			alignas(32) uint64_t in[8]{};
+
+			memcpy(in, pixels + x, (width - x) * sizeof(uint64_t));
+
+			__m256i lo(_mm256_load_si256((__m256i const*)in)), hi(_mm256_load_si256((__m256i const*)(in + 4)));
+			apply8<tetrahedral>(p, lo, hi);
+			_mm256_store_si256((__m256i*)in, lo);
+			_mm256_store_si256((__m256i*)(in + 4), hi);
+
+			memcpy(pixels + x, in, (width - x) * sizeof(uint64_t));
+		}
+	}
+
+	using row_function = void(__vectorcall*)(params const& __restrict, uint8_t* const __restrict, uint32_t const);
+
+} // end ns
+
+// (INPLACE) color grading of BGRX, BGRA, BGRX16 & BGRA16 images, alpha is preserved. lut_b is optional, the result is the same as applying ImagingLUTLerp(lut, lut_b, tT) w/o modifying or copying either lut
+bool const __vectorcall ImagingApplyLUT(ImagingMemoryInstance* const __restrict im, ImagingLUT const* const __restrict lut, int const interpolation, ImagingLUT const* const __restrict lut_b, float const tT)
 {
-	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_L, width, height)), pMemLoad));
+	if (!im || !lut) {
+		return(false);
+	}
+
+	bool const tetrahedral(IMAGING_LUT_TRILINEAR != interpolation);
+
+	lut_ops::row_function row(nullptr);
+	float max_value(0.0f);
+
+	switch (im->mode)
+	{
+	case MODE_BGRX:
+	case MODE_BGRA:
+		row = tetrahedral ? &lut_ops::apply_row8<true> : &lut_ops::apply_row8<false>;
+		max_value = float(UINT8_MAX);
+		break;
+	case MODE_BGRX16:
+	case MODE_BGRA16:
+		row = tetrahedral ? &lut_ops::apply_row16<true> : &lut_ops::apply_row16<false>;
+		max_value = float(UINT16_MAX);
+		break;
+	default:
+		ImagingError_ModeError();
+		return(false);
+	}
+
+	if (lut->size < 2) {
+		ImagingError_ValueError("bad lut size");
+		return(false);
+	}
+	if (lut_b && lut_b->size != lut->size) {
+		ImagingError_Mismatch();
+		return(false);
+	}
+
+	int32_t const lut_size(int32_t(lut->size));
+
+	struct { // avoid lambda heap
+		uint8_t* const* const __restrict image;
+		lut_ops::row_function const row;
+		uint32_t const width;
+		lut_ops::params const params;
+
+	} const p = { im->image, row, (uint32_t)im->xsize,
+				  lut_ops::params{ reinterpret_cast<int32_t const*>(lut->block), (lut_b ? reinterpret_cast<int32_t const*>(lut_b->block) : nullptr),
+								   float(lut_size - 1) / max_value, SFM::saturate(tT), lut_size - 2, lut_size, lut_size * lut_size } };
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, im->ysize), [&p](tbb::blocked_range<int> const& r) {
+
+		for (int y = r.begin(); y < r.end(); ++y) {
+			p.row(p.params, p.image[y], p.width);
+		}
+	});
+
+	return(true);
 }
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryF32(uint8_t const* __restrict pMemLoad, int const width, int const height)
+
+void __vectorcall ImagingBlend(ImagingMemoryInstance* const __restrict A, ImagingMemoryInstance const* const __restrict B)
 {
-	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_F32, width, height)), pMemLoad));
+	pixel_ops::blend_span(reinterpret_cast<uint32_t* const>(A->block), reinterpret_cast<uint32_t const* const>(B->block), size_t(B->xsize) * size_t(B->ysize));
 }
 
-#if INCLUDE_TIF_SUPPORT
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadTif(std::wstring_view const filenamepath)
-{
-	Imaging returnL(nullptr);
+namespace geometry { // cache blocked transforms. tiles are transposed w/ SIMD register blocks (16x16 8bit, 8x8 16bit, 8x8 32bit, 4x4 64bit), rows are reversed 32 bytes at a time. rotations are a transpose w/ one of the sides walked bottom up (negative stride).
 
-	TinyTIFFReaderFile* tif(nullptr);
-	tif = TinyTIFFReader_open(stringconv::ws2s(filenamepath).c_str());
+	static constexpr uint32_t const TILE_BYTES = 256; // tile side in bytes (row of a tile), 64 x 64 BGRA pixels. src + dst tiles fit in L1
+	static constexpr ptrdiff_t const ROW_SWAP_CHUNK = 4096; // stack buffer for row swaps
 
-	if (tif) {
+	template<typename T>
+	static constexpr uint32_t const block_size() // SIMD register block side in pixels
+	{
+		return(1 == sizeof(T) ? 16 : (8 == sizeof(T) ? 4 : 8));
+	}
 
-		uint32_t const bits(TinyTIFFReader_getBitsPerSample(tif, 0));          // bit depth of component
-		uint32_t const samples(TinyTIFFReader_getSamplesPerPixel(tif));        // # of components
+	template<typename T>
+	static constexpr uint32_t const tile_size() // cache block side in pixels
+	{
+		return(TILE_BYTES / sizeof(T) > 64 ? 64 : TILE_BYTES / sizeof(T));
+	}
 
-		// determine imaging mode
-		uint32_t mode(0);
+	// dst row n = src column n, for one register block. strides are in bytes & can be negative.
+	template<typename T>
+	static __inline void __vectorcall transpose_block(uint8_t const* const __restrict src, ptrdiff_t const src_stride, uint8_t* const __restrict dst, ptrdiff_t const dst_stride)
+	{
+		if constexpr (1 == sizeof(T)) {
 
-		switch (samples)
-		{
-		case 1:
-			if (bits > 8) {
-				mode = MODE_L16;
+			__m128i r[16], a[16], b[16], c[16];
+
+			for (uint32_t i = 0; i < 16; ++i) {
+				r[i] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + src_stride * ptrdiff_t(i)));
+			}
+
+			for (uint32_t i = 0; i < 8; ++i) { // rows 2i, 2i+1: columns 0...7 | 8...15
+				a[i] = _mm_unpacklo_epi8(r[2 * i], r[2 * i + 1]);
+				a[i + 8] = _mm_unpackhi_epi8(r[2 * i], r[2 * i + 1]);
+			}
+			for (uint32_t h = 0; h < 16; h += 8) { // rows 4i...4i+3: columns 0...3 | 4...7 (+8)
+				for (uint32_t i = 0; i < 4; ++i) {
+					b[h + i] = _mm_unpacklo_epi16(a[h + 2 * i], a[h + 2 * i + 1]);
+					b[h + i + 4] = _mm_unpackhi_epi16(a[h + 2 * i], a[h + 2 * i + 1]);
+				}
+			}
+			for (uint32_t j = 0; j < 16; j += 4) { // rows 8i...8i+7: columns j, j+1 | j+2, j+3
+				for (uint32_t i = 0; i < 2; ++i) {
+					c[j + i] = _mm_unpacklo_epi32(b[j + 2 * i], b[j + 2 * i + 1]);
+					c[j + i + 2] = _mm_unpackhi_epi32(b[j + 2 * i], b[j + 2 * i + 1]);
+				}
+			}
+			for (uint32_t j = 0; j < 16; j += 4) {
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride * ptrdiff_t(j + 0)), _mm_unpacklo_epi64(c[j + 0], c[j + 1]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride * ptrdiff_t(j + 1)), _mm_unpackhi_epi64(c[j + 0], c[j + 1]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride * ptrdiff_t(j + 2)), _mm_unpacklo_epi64(c[j + 2], c[j + 3]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride * ptrdiff_t(j + 3)), _mm_unpackhi_epi64(c[j + 2], c[j + 3]));
+			}
+		}
+		else if constexpr (2 == sizeof(T)) {
+
+			__m128i r[8], a[8], b[8];
+
+			for (uint32_t i = 0; i < 8; ++i) {
+				r[i] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + src_stride * ptrdiff_t(i)));
+			}
+
+			for (uint32_t i = 0; i < 4; ++i) { // rows 2i, 2i+1: columns 0...3 | 4...7
+				a[i] = _mm_unpacklo_epi16(r[2 * i], r[2 * i + 1]);
+				a[i + 4] = _mm_unpackhi_epi16(r[2 * i], r[2 * i + 1]);
+			}
+			for (uint32_t h = 0; h < 8; h += 4) { // rows 4i...4i+3: columns h, h+1 | h+2, h+3
+				for (uint32_t i = 0; i < 2; ++i) {
+					b[h + i] = _mm_unpacklo_epi32(a[h + 2 * i], a[h + 2 * i + 1]);
+					b[h + i + 2] = _mm_unpackhi_epi32(a[h + 2 * i], a[h + 2 * i + 1]);
+				}
+			}
+			for (uint32_t j = 0; j < 8; j += 4) {
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride * ptrdiff_t(j + 0)), _mm_unpacklo_epi64(b[j + 0], b[j + 1]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride * ptrdiff_t(j + 1)), _mm_unpackhi_epi64(b[j + 0], b[j + 1]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride * ptrdiff_t(j + 2)), _mm_unpacklo_epi64(b[j + 2], b[j + 3]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride * ptrdiff_t(j + 3)), _mm_unpackhi_epi64(b[j + 2], b[j + 3]));
+			}
+		}
+		else if constexpr (4 == sizeof(T)) {
+
+			__m256i r[8], a[8], b[8];
+
+			for (uint32_t i = 0; i < 8; ++i) {
+				r[i] = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + src_stride * ptrdiff_t(i)));
+			}
+
+			for (uint32_t i = 0; i < 8; i += 2) { // rows i, i+1: columns 0, 1 | 2, 3 (+4 in the high lane)
+				a[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+				a[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+			}
+			for (uint32_t i = 0; i < 8; i += 4) { // rows i...i+3: columns 0 | 1 | 2 | 3 (+4 in the high lane)
+				b[i + 0] = _mm256_unpacklo_epi64(a[i + 0], a[i + 2]);
+				b[i + 1] = _mm256_unpackhi_epi64(a[i + 0], a[i + 2]);
+				b[i + 2] = _mm256_unpacklo_epi64(a[i + 1], a[i + 3]);
+				b[i + 3] = _mm256_unpackhi_epi64(a[i + 1], a[i + 3]);
+			}
+			for (uint32_t j = 0; j < 4; ++j) {
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + dst_stride * ptrdiff_t(j)), _mm256_permute2x128_si256(b[j], b[j + 4], 0x20));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + dst_stride * ptrdiff_t(j + 4)), _mm256_permute2x128_si256(b[j], b[j + 4], 0x31));
+			}
+		}
+		else { // 8 == sizeof(T)
+
+			__m256i r[4];
+
+			for (uint32_t i = 0; i < 4; ++i) {
+				r[i] = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + src_stride * ptrdiff_t(i)));
+			}
+
+			__m256i const a0(_mm256_unpacklo_epi64(r[0], r[1])), a1(_mm256_unpackhi_epi64(r[0], r[1])), // columns 0 | 1 (+2 in the high lane)
+				          a2(_mm256_unpacklo_epi64(r[2], r[3])), a3(_mm256_unpackhi_epi64(r[2], r[3]));
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_permute2x128_si256(a0, a2, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + dst_stride), _mm256_permute2x128_si256(a1, a3, 0x20));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + dst_stride * 2), _mm256_permute2x128_si256(a0, a2, 0x31));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + dst_stride * 3), _mm256_permute2x128_si256(a1, a3, 0x31));
+		}
+	}
+
+	// dst[x][y] = src[y][x] for the region [x_begin, x_end) x [y_begin, y_end) of src
+	template<typename T>
+	static void __vectorcall transpose_tile(uint8_t const* const __restrict src, ptrdiff_t const src_stride, uint8_t* const __restrict dst, ptrdiff_t const dst_stride,
+		                                    uint32_t const x_begin, uint32_t const x_end, uint32_t const y_begin, uint32_t const y_end)
+	{
+		uint32_t x_blocks(x_begin), y_blocks(y_begin);
+
+		if constexpr (0 == (sizeof(T) & (sizeof(T) - 1))) { // 1, 2, 4 or 8 bytes, 3 & 6 byte pixels are transposed by the remainder loop only
+			constexpr uint32_t const N(block_size<T>());
+
+			x_blocks = x_begin + ((x_end - x_begin) / N) * N;
+			y_blocks = y_begin + ((y_end - y_begin) / N) * N;
+
+			for (uint32_t y = y_begin; y < y_blocks; y += N) {
+				for (uint32_t x = x_begin; x < x_blocks; x += N) {
+					transpose_block<T>(src + src_stride * ptrdiff_t(y) + x * sizeof(T), src_stride, dst + dst_stride * ptrdiff_t(x) + y * sizeof(T), dst_stride);
+				}
+			}
+		}
+
+		// remainder, right edge then bottom edge of the region
+		for (uint32_t y = y_begin; y < y_end; ++y) {
+
+			T const* const __restrict row(reinterpret_cast<T const*>(src + src_stride * ptrdiff_t(y)));
+
+			for (uint32_t x = (y < y_blocks ? x_blocks : x_begin); x < x_end; ++x) {
+				*reinterpret_cast<T*>(dst + dst_stride * ptrdiff_t(x) + y * sizeof(T)) = row[x];
+			}
+		}
+	}
+
+	template<typename T>
+	static void __vectorcall transpose(uint8_t const* const __restrict src, ptrdiff_t const src_stride, uint8_t* const __restrict dst, ptrdiff_t const dst_stride,
+		                               uint32_t const width, uint32_t const height) // width & height of src
+	{
+		constexpr uint32_t const TILE(tile_size<T>());
+
+		struct { // avoid lambda heap
+			uint8_t const* const __restrict src;
+			uint8_t* const __restrict dst;
+			ptrdiff_t const src_stride, dst_stride;
+			uint32_t const width, height;
+
+		} const p = { src, dst, src_stride, dst_stride, width, height };
+
+		tbb::parallel_for(tbb::blocked_range2d<uint32_t>(0, (height + TILE - 1) / TILE, 0, (width + TILE - 1) / TILE), [&p](tbb::blocked_range2d<uint32_t> const& r) {
+
+			for (uint32_t ty = r.rows().begin(); ty < r.rows().end(); ++ty) {
+				for (uint32_t tx = r.cols().begin(); tx < r.cols().end(); ++tx) {
+
+					uint32_t const x(tx * TILE), y(ty * TILE);
+					transpose_tile<T>(p.src, p.src_stride, p.dst, p.dst_stride, x, std::min(x + TILE, p.width), y, std::min(y + TILE, p.height));
+				}
+			}
+		});
+	}
+
+	// reverses the order of the pixels in 32 bytes
+	template<typename T>
+	static __inline __m256i const __vectorcall reverse(__m256i const v)
+	{
+		if constexpr (1 == sizeof(T)) {
+			return(_mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+				                                                                    15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)), _MM_SHUFFLE(1, 0, 3, 2)));
+		}
+		else if constexpr (2 == sizeof(T)) {
+			return(_mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, _mm256_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+				                                                                    14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1)), _MM_SHUFFLE(1, 0, 3, 2)));
+		}
+		else if constexpr (4 == sizeof(T)) {
+			return(_mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)));
+		}
+		else { // 8 == sizeof(T)
+			return(_mm256_permute4x64_epi64(v, _MM_SHUFFLE(0, 1, 2, 3)));
+		}
+	}
+
+	// 3 & 6 byte pixels (MODE_RGB, MODE_RGB16), reversed by the scalar loop only
+	typedef struct pixel24 { uint8_t v[3]; } pixel24;
+	typedef struct pixel48 { uint16_t v[3]; } pixel48;
+
+	// dst = reversed src, both rows of width pixels. (dst == src) is supported, the row is reversed inplace.
+	template<typename T>
+	static void __vectorcall reverse_row(T* const dst, T const* const src, uint32_t const width)
+	{
+		uint32_t left(0), right(width);
+
+		if constexpr (0 == (sizeof(T) & (sizeof(T) - 1))) { // 1, 2, 4 or 8 bytes
+			constexpr uint32_t const N(32 / sizeof(T));
+
+			// both ends at once, so inplace works the same
+			while (right - left >= (N << 1)) {
+
+				right -= N;
+
+				__m256i const l(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + left)));
+				__m256i const r(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + right)));
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + left), reverse<T>(r));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + right), reverse<T>(l));
+
+				left += N;
+			}
+		}
+
+		// middle
+		while (left < right) {
+
+			--right;
+
+			T const l(src[left]), r(src[right]);
+			dst[left] = r;
+			dst[right] = l;
+
+			++left;
+		}
+	}
+
+	template<typename T>
+	static void __vectorcall mirror(ImagingMemoryInstance* const __restrict im) // (INPLACE)
+	{
+		struct { // avoid lambda heap
+			uint8_t* const* const __restrict image;
+			uint32_t const width;
+
+		} const p = { im->image, (uint32_t)im->xsize };
+
+		tbb::parallel_for(tbb::blocked_range<uint32_t>(0, im->ysize), [&p](tbb::blocked_range<uint32_t> const& r) {
+
+			for (uint32_t y = r.begin(); y < r.end(); ++y) {
+				T* const row(reinterpret_cast<T*>(p.image[y]));
+				reverse_row<T>(row, row, p.width);
+			}
+		});
+	}
+
+	static void __vectorcall swap_rows(uint8_t* const __restrict a, uint8_t* const __restrict b, ptrdiff_t const row_bytes)
+	{
+		alignas(CACHE_LINE_BYTES) uint8_t temp[ROW_SWAP_CHUNK];
+
+		for (ptrdiff_t offset = 0; offset < row_bytes; offset += ROW_SWAP_CHUNK) {
+
+			size_t const bytes(std::min(ROW_SWAP_CHUNK, row_bytes - offset));
+
+			memcpy(temp, a + offset, bytes);
+			memcpy(a + offset, b + offset, bytes);
+			memcpy(b + offset, temp, bytes);
+		}
+	}
+
+	template<typename T>
+	static void __vectorcall rotate180(ImagingMemoryInstance* const __restrict im) // (INPLACE)
+	{
+		struct { // avoid lambda heap
+			uint8_t* const* const __restrict image;
+			ptrdiff_t const row_bytes;
+			uint32_t const width, height;
+
+		} const p = { im->image, ptrdiff_t(im->xsize) * ptrdiff_t(sizeof(T)), (uint32_t)im->xsize, (uint32_t)im->ysize };
+
+		// no temporary row, both rows are reversed inplace then swapped
+		tbb::parallel_for(tbb::blocked_range<uint32_t>(0, (p.height + 1) >> 1), [&p](tbb::blocked_range<uint32_t> const& r) {
+
+			for (uint32_t y = r.begin(); y < r.end(); ++y) {
+
+				T* const top(reinterpret_cast<T*>(p.image[y]));
+				T* const bottom(reinterpret_cast<T*>(p.image[p.height - 1 - y]));
+
+				reverse_row<T>(top, top, p.width);
+
+				if (top != bottom) { // not the middle row of odd height
+					reverse_row<T>(bottom, bottom, p.width);
+					swap_rows(reinterpret_cast<uint8_t*>(top), reinterpret_cast<uint8_t*>(bottom), p.row_bytes);
+				}
+			}
+		});
+	}
+
+	STATIC_INLINE_PURE uint32_t const wrap(int const n, int const dimension) // true modulo, negative offsets wrap around from the other side
+	{
+		int const m(n % dimension);
+		return(m < 0 ? m + dimension : m);
+	}
+
+	static void __vectorcall offset(ImagingMemoryInstance* const __restrict out, ImagingMemoryInstance const* const __restrict im, int const xoffset, int const yoffset)
+	{
+		uint32_t const width(im->xsize), height(im->ysize);
+		size_t const pixelsize(im->pixelsize);
+
+		struct { // avoid lambda heap
+			uint8_t const* const* const __restrict in;
+			uint8_t* const* const __restrict out;
+			size_t const right_bytes, left_bytes; // wrapped span [0, x) of output row, rest of output row [x, width)
+			uint32_t const height, y;
+
+		} const p = { im->image, out->image, (width - wrap(xoffset, width)) * pixelsize, wrap(xoffset, width) * pixelsize, height, wrap(yoffset, height) };
+
+		// out[(y + yoffset) % height][(x + xoffset) % width] = in[y][x], 2 memcpy per row
+		tbb::parallel_for(tbb::blocked_range<uint32_t>(0, height), [&p](tbb::blocked_range<uint32_t> const& r) {
+
+			for (uint32_t y = r.begin(); y < r.end(); ++y) {
+
+				uint8_t const* const __restrict src(p.in[y]);
+				uint8_t* const __restrict dst(p.out[(y + p.y) % p.height]);
+
+				memcpy(dst + p.left_bytes, src, p.right_bytes);
+				memcpy(dst, src + p.right_bytes, p.left_bytes);
+			}
+		});
+	}
+
+} // end ns
+
+void __vectorcall ImagingVerticalFlip(ImagingMemoryInstance* const __restrict im) // flip Y / invert Y axis / vertical flip (INPLACE)
+{
+	struct { // avoid lambda heap
+		uint8_t* const* const __restrict image;
+		ptrdiff_t const row_bytes;
+		uint32_t const height;
+
+	} const p = { im->image, (ptrdiff_t)im->linesize, (uint32_t)im->ysize };
+
+	tbb::parallel_for(tbb::blocked_range<uint32_t>(0, p.height >> 1), [&p](tbb::blocked_range<uint32_t> const& r) {
+
+		for (uint32_t y = r.begin(); y < r.end(); ++y) {
+			geometry::swap_rows(p.image[y], p.image[p.height - 1 - y], p.row_bytes);
+		}
+	});
+}
+
+bool const __vectorcall ImagingHorizontalFlip(ImagingMemoryInstance* const __restrict im) // mirror / invert X axis / horizontal flip (INPLACE)
+{
+	switch (im->pixelsize)
+	{
+	case 1:
+		geometry::mirror<uint8_t>(im);
+		break;
+	case 2:
+		geometry::mirror<uint16_t>(im);
+		break;
+	case 3:
+		geometry::mirror<geometry::pixel24>(im);
+		break;
+	case 4:
+		geometry::mirror<uint32_t>(im);
+		break;
+	case 6:
+		geometry::mirror<geometry::pixel48>(im);
+		break;
+	case 8:
+		geometry::mirror<uint64_t>(im);
+		break;
+	default:
+		ImagingError_ModeError();
+		return(false);
+	}
+	return(true);
+}
+
+bool const __vectorcall ImagingRotate180(ImagingMemoryInstance* const __restrict im) // (INPLACE)
+{
+	switch (im->pixelsize)
+	{
+	case 1:
+		geometry::rotate180<uint8_t>(im);
+		break;
+	case 2:
+		geometry::rotate180<uint16_t>(im);
+		break;
+	case 3:
+		geometry::rotate180<geometry::pixel24>(im);
+		break;
+	case 4:
+		geometry::rotate180<uint32_t>(im);
+		break;
+	case 6:
+		geometry::rotate180<geometry::pixel48>(im);
+		break;
+	case 8:
+		geometry::rotate180<uint64_t>(im);
+		break;
+	default:
+		ImagingError_ModeError();
+		return(false);
+	}
+	return(true);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingOffset(ImagingMemoryInstance const* const __restrict im, int const xoffset, int const yoffset) // translate image while wrapping around (*NOT INPLACE)
+{
+	Imaging const img_offset(ImagingNew(im->mode, im->xsize, im->ysize));
+	if (nullptr == img_offset)
+		return(nullptr);
+
+	geometry::offset(img_offset, im, xoffset, yoffset);
+
+	return(img_offset);
+}
+
+// image[y][x] // assuming this is the original orientation 
+// image[x][original_width - y] // rotated 90 degrees ccw
+// image[original_height - x][y] // 90 degrees cw 
+// image[original_height - y][original_width - x] // 180 degrees
+
+template<typename T>
+STATIC_INLINE_PURE void ImagingRotateCW(ImagingMemoryInstance* const __restrict img_returned, ImagingMemoryInstance const* const __restrict im,
+	                                    uint32_t const width, uint32_t const height)
+{
+	// out[x][(height - 1) - y] = in[y][x], transpose of the source walked bottom up
+	geometry::transpose<T>(im->block + ptrdiff_t(height - 1) * im->linesize, -ptrdiff_t(im->linesize), img_returned->block, ptrdiff_t(img_returned->linesize), width, height);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingRotateCW(ImagingMemoryInstance const* const __restrict im)
+{
+	uint32_t const width(im->xsize);
+	uint32_t const height(im->ysize);
+
+	Imaging img_returned(ImagingNew(im->mode, height, width));
+	if (nullptr == img_returned)
+		return(nullptr);
+
+	switch (im->pixelsize)
+	{
+	case 1:
+		ImagingRotateCW<uint8_t>(img_returned, im, width, height);
+		break;
+	case 2:
+		ImagingRotateCW<uint16_t>(img_returned, im, width, height);
+		break;
+	case 3:
+		ImagingRotateCW<geometry::pixel24>(img_returned, im, width, height);
+		break;
+	case 4:
+		ImagingRotateCW<uint32_t>(img_returned, im, width, height);
+		break;
+	case 6:
+		ImagingRotateCW<geometry::pixel48>(img_returned, im, width, height);
+		break;
+	case 8:
+		ImagingRotateCW<uint64_t>(img_returned, im, width, height);
+		break;
+	default:
+		ImagingDelete(img_returned);
+		return((Imaging)ImagingError_ModeError());
+	}
+
+	return(img_returned);
+}
+
+template<typename T>
+STATIC_INLINE_PURE void ImagingRotateCCW(ImagingMemoryInstance* const __restrict img_returned, ImagingMemoryInstance const* const __restrict im,
+	                                     uint32_t const width, uint32_t const height)
+{
+	// out[(width - 1) - x][y] = in[y][x], transpose written bottom up
+	geometry::transpose<T>(im->block, ptrdiff_t(im->linesize), img_returned->block + ptrdiff_t(width - 1) * img_returned->linesize, -ptrdiff_t(img_returned->linesize), width, height);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingRotateCCW(ImagingMemoryInstance const* const __restrict im)
+{
+	uint32_t const width(im->xsize);
+	uint32_t const height(im->ysize);
+
+	Imaging img_returned(ImagingNew(im->mode, height, width));
+	if (nullptr == img_returned)
+		return(nullptr);
+
+	switch (im->pixelsize)
+	{
+	case 1:
+		ImagingRotateCCW<uint8_t>(img_returned, im, width, height);
+		break;
+	case 2:
+		ImagingRotateCCW<uint16_t>(img_returned, im, width, height);
+		break;
+	case 3:
+		ImagingRotateCCW<geometry::pixel24>(img_returned, im, width, height);
+		break;
+	case 4:
+		ImagingRotateCCW<uint32_t>(img_returned, im, width, height);
+		break;
+	case 6:
+		ImagingRotateCCW<geometry::pixel48>(img_returned, im, width, height);
+		break;
+	case 8:
+		ImagingRotateCCW<uint64_t>(img_returned, im, width, height);
+		break;
+	default:
+		ImagingDelete(img_returned);
+		return((Imaging)ImagingError_ModeError());
+	}
+
+	return(img_returned);
+}
+
+static ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRaw(eIMAGINGMODE const mode, std::wstring_view const filenamepath, int const width, int const height)
+{
+	ImagingMemoryInstance const* const mapped(ImagingMapRaw(mode, filenamepath, width, height));
+	if (!mapped) {
+		return(nullptr);
+	}
+
+	Imaging const returnL(ImagingMakeWritable(mapped)); // single copy from the mapped file
+	if (!returnL) {
+		ImagingDelete(mapped);
+	}
+
+	return(returnL);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawBGRA16(std::wstring_view const filenamepath, int const width, int const height)
+{
+	return(ImagingLoadRaw(MODE_BGRA16, filenamepath, width, height));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawRGB16(std::wstring_view const filenamepath, int const width, int const height)
+{
+	return(ImagingLoadRaw(MODE_RGB16, filenamepath, width, height));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawBGRA(std::wstring_view const filenamepath, int const width, int const height)
+{
+	return(ImagingLoadRaw(MODE_BGRA, filenamepath, width, height));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawRGB(std::wstring_view const filenamepath, int const width, int const height)
+{
+	return(ImagingLoadRaw(MODE_RGB, filenamepath, width, height));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawLA16(std::wstring_view const filenamepath, int const width, int const height)
+{
+	return(ImagingLoadRaw(MODE_LA16, filenamepath, width, height));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawL16(std::wstring_view const filenamepath, int const width, int const height)
+{
+	return(ImagingLoadRaw(MODE_L16, filenamepath, width, height));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawLA(std::wstring_view const filenamepath, int const width, int const height)
+{
+	return(ImagingLoadRaw(MODE_LA, filenamepath, width, height));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawL(std::wstring_view const filenamepath, int const width, int const height)
+{
+	return(ImagingLoadRaw(MODE_L, filenamepath, width, height));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadRawF32(std::wstring_view const filenamepath, int const width, int const height)
+{
+	return(ImagingLoadRaw(MODE_F32, filenamepath, width, height));
+}
+
+STATIC_INLINE_PURE ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemory(Imaging&& __restrict returnL, uint8_t const* __restrict pMemLoad)
+{
+	uint8_t* __restrict pOut = returnL->block;
+	uint32_t const stride = returnL->linesize;
+
+	uint32_t scanline(returnL->ysize);
+	while (0 != scanline) {
+
+		memcpy(pOut, pMemLoad, stride);
+		pMemLoad += stride;
+		pOut += stride;
+
+		--scanline;
+	}
+
+	return(returnL);
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryBGRA16(uint8_t const* __restrict pMemLoad, int const width, int const height)
+{
+	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_BGRA16, width, height)), pMemLoad));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryRGB16(uint8_t const* __restrict pMemLoad, int const width, int const height)
+{
+	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_RGB16, width, height)), pMemLoad));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryBGRA(uint8_t const* __restrict pMemLoad, int const width, int const height)
+{
+	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_BGRA, width, height)), pMemLoad));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryRGB(uint8_t const* __restrict pMemLoad, int const width, int const height)
+{
+	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_RGB, width, height)), pMemLoad));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryLA16(uint8_t const* __restrict pMemLoad, int const width, int const height)
+{
+	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_LA16, width, height)), pMemLoad));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryLA(uint8_t const* __restrict pMemLoad, int const width, int const height)
+{
+	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_LA, width, height)), pMemLoad));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryL16(uint8_t const* __restrict pMemLoad, int const width, int const height)
+{
+	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_L16, width, height)), pMemLoad));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryL(uint8_t const* __restrict pMemLoad, int const width, int const height)
+{
+	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_L, width, height)), pMemLoad));
+}
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadFromMemoryF32(uint8_t const* __restrict pMemLoad, int const width, int const height)
+{
+	return(ImagingLoadFromMemory(std::forward<Imaging&& __restrict>(ImagingNew(MODE_F32, width, height)), pMemLoad));
+}
+
+#if INCLUDE_TIF_SUPPORT
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadTif(std::wstring_view const filenamepath)
+{
+	Imaging returnL(nullptr);
+
+	TinyTIFFReaderFile* tif(nullptr);
+	tif = TinyTIFFReader_open(stringconv::ws2s(filenamepath).c_str());
+
+	if (tif) {
+
+		uint32_t const bits(TinyTIFFReader_getBitsPerSample(tif, 0));          // bit depth of component
+		uint32_t const samples(TinyTIFFReader_getSamplesPerPixel(tif));        // # of components
+
+		// determine imaging mode
+		uint32_t mode(0);
+
+		switch (samples)
+		{
+		case 1:
+			if (bits > 8) {
+				mode = MODE_L16;
+			}
+			else {
+				mode = MODE_L;
+			}
+			break;
+		case 2:
+			if (bits > 8) {
+				mode = MODE_LA16;
+			}
+			else {
+				mode = MODE_LA;
+			}
+			break;
+		case 3:
+			if (bits > 8) {
+				mode = MODE_RGB16;
+			}
+			else {
+				mode = MODE_RGB;
+			}
+			break;
+		case 4:
+		default:
+			if (bits > 8) {
+				mode = MODE_BGRA16;
+			}
+			else {
+				mode = MODE_BGRA;
+			}
+			break;
+		}
+
+		uint32_t const width(TinyTIFFReader_getWidth(tif));
+		uint32_t const height(TinyTIFFReader_getHeight(tif));
+
+		returnL = ImagingNew((eIMAGINGMODE)mode, width, height);
+		ImagingClear(returnL); // ensure memory is zeroed
+
+		// read entire image data (only supporting tif with interleaved/chunky image data - single frame)
+		TinyTIFFWriter_readImage(tif, returnL->block, size_t(returnL->ysize) * size_t(returnL->linesize));
+
+		TinyTIFFReader_close(tif); tif = nullptr;
+
+		// auto convert to BGRX
+		if (MODE_RGB == mode) {
+			Imaging const promoted_image(ImagingRGBToBGRX(returnL));
+			ImagingDelete(returnL); returnL = promoted_image;
+		}
+		else if (MODE_RGB16 == mode) {
+			Imaging const promoted_image(ImagingRGB16ToBGRX16(returnL));
+			ImagingDelete(returnL); returnL = promoted_image;
+		}
+	}
+	
+	return(returnL);
+}
+#endif
+
+enum GIFConstants {
+	    //Graphics control extension has most of animation info
+	     GCE_Code = GRAPHICS_EXT_FUNC_CODE,
+	     GCE_Size = 4,
+	    //Fields of the above
+	     GCE_Flags = 0,
+	     GCE_Delay = 1,
+	     GCE_TransColor = 3,
+	    //Contents of mask
+	     GCE_DisposalUnspecified = DISPOSAL_UNSPECIFIED,		/* No disposal specified. */
+	     GCE_DisposalDoNot = DISPOSE_DO_NOT,					/* Leave image in place */
+	     GCE_DisposalBackground = DISPOSE_BACKGROUND,			/* Set area to background color */
+	     GCE_DisposalPrevious = DISPOSE_PREVIOUS,				/* Restore to previous content */
+};
+
+typedef struct Metadata
+{
+	uint32_t mode = DISPOSAL_UNSPECIFIED;
+	uint32_t delay = 100;
+	int32_t  trans_key = -1;  // -1 denotes an index that has no color key for transparency
+} Metadata;
+
+STATIC_INLINE_PURE uint32_t const frame_delay(uint8_t const* const __restrict loc) {
+	return (10 * (loc[0] | (((uint32_t)loc[1]) << 8)));
+}
+
+template<bool const replace_all_pixels = false>
+STATIC_INLINE_PURE void __vectorcall ImagingGIFSetPixels(
+											GifColorType const* const& __restrict colors,
+											ImagingMemoryInstance* const __restrict image_dst,
+											SavedImage const& __restrict image_src, 
+											uint32_t const exclude_index = 0)
+{
+	uint32_t* const __restrict block(reinterpret_cast<uint32_t* const __restrict>(image_dst->block));
+	uint32_t const dst_width(image_dst->xsize);
+	
+	for (int32_t y = 0; y < image_src.ImageDesc.Height; ++y) {
+
+		for (int32_t x = 0; x < image_src.ImageDesc.Width; ++x) {
+
+			uint32_t const src(y * image_src.ImageDesc.Width + x);
+			uint32_t const map = uint32_t((uint8_t const)image_src.RasterBits[src]);
+
+			uint32_t const dst((y + image_src.ImageDesc.Top) * dst_width + (x + image_src.ImageDesc.Left));
+
+			uint32_t alpha;
+
+			if constexpr (replace_all_pixels) {		
+				alpha = 0xFF; // opaque
+			}
+			else if (exclude_index != map) {
+				// only draw pixels that "exist" in current frame
+				alpha = 0xFF;
+			}
+			else {
+				alpha = 0x01; // bugfix - allows frame to decay so there isn't a persistant image in blend, after many blends
+			}
+			// GIF is almost 30 years old
+			block[dst] = SFM::pack_rgba(colors[map].Red, colors[map].Green, colors[map].Blue, alpha);
+		}
+	}
+}
+STATIC_INLINE_PURE void __vectorcall ImagingGIFDisposePixels(
+	ImagingMemoryInstance* const __restrict image_dst,
+	SavedImage const& __restrict image_src,
+	uint32_t const background_rgba)
+{
+	uint32_t* const __restrict block(reinterpret_cast<uint32_t* const __restrict>(image_dst->block));
+	uint32_t const dst_width(image_dst->xsize);
+
+	for (int32_t y = 0; y < image_src.ImageDesc.Height; ++y) {
+
+		uint32_t const dst((y + image_src.ImageDesc.Top) * dst_width + (image_src.ImageDesc.Left));
+
+		memset(&block[dst], background_rgba, image_src.ImageDesc.Width << 2u);
+	}
+}
+
+// GIF input is read from a memory mapped file. Each sequence load owns its reader & decoder state, so multiple sequences can be loaded concurrently.
+typedef struct gif_memory_reader {
+	uint8_t const* const __restrict data;
+	size_t const size;
+	size_t offset;
+} gif_memory_reader;
+
+static int gif_memory_read(GifFileType* const gif, GifByteType* const buf, int const len)
+{
+	gif_memory_reader* const __restrict reader(reinterpret_cast<gif_memory_reader* const>(gif->UserData));
+
+	size_t const count(std::min(size_t(len), reader->size - reader->offset));
+	memcpy(buf, reader->data + reader->offset, count);
+	reader->offset += count;
+
+	return((int)count);
+}
+
+typedef struct gif_frame { // one frame in flight
+	SavedImage				image;		// copy, SavedImages is reallocated as decoding progresses. (RasterBits & ExtensionBlocks are not, still owned by the decoder)
+	Imaging					composed;	// history for blending with the next frame
+	std::atomic_uint32_t	refs;		// composed frame is shared by the next frames blend and this frames resample
+	uint32_t				index;
+	uint32_t				delay;
+	bool					blend;
+} gif_frame;
+
+typedef struct gif_frame_result {
+	Imaging					image = nullptr;
+	uint32_t				delay = 0;
+} gif_frame_result;
+
+typedef struct _gif_sequence_data { // avoid lambda heap
+	GifFileType* const __restrict gif;
+	tbb::concurrent_vector<gif_frame_result>& __restrict results;
+	ColorMapObject const* const __restrict common_colormap;
+	int32_t const background_color_index;
+	uint32_t const xsize, ysize;		// native
+	uint32_t const width, height;		// resampled
+	std::atomic_bool& failed;
+} const gif_sequence_data;
+
+static void __vectorcall gif_release_frame(gif_frame* const __restrict frame)
+{
+	if (frame && 1 == frame->refs.fetch_sub(1)) {
+		ImagingDelete(frame->composed);
+		std::destroy_at(frame);
+		scalable_free(frame);
+	}
+}
+
+// stage 1 (serial) - LZW decode of the next frame
+static gif_frame* const __restrict __vectorcall gif_slurp_frame(uint32_t const index, gif_sequence_data& p)
+{
+	int image_index(-1);
+
+	if (GIF_ERROR == DGifSlurpNext(p.gif, &image_index)) {
+		p.failed = true;
+		return(nullptr);
+	}
+	if (image_index < 0) { // end of file
+		return(nullptr);
+	}
+
+	void* const __restrict memory(scalable_malloc(sizeof(gif_frame)));
+	if (!memory) {
+		p.failed = true;
+		return(nullptr);
+	}
+	gif_frame* const __restrict frame(std::construct_at((gif_frame*)memory)); // value initialized (zero), std::atomic requires construction
+
+	frame->image = p.gif->SavedImages[image_index];
+	frame->refs = 2;
+	frame->index = index;
+
+	p.results.grow_by(1);
+
+	return(frame);
+}
+
+// stage 2 (parallel) - frame pixels, disposal & chroma key, independent of any other frame
+static void __vectorcall gif_decode_frame(gif_frame* const __restrict frame, gif_sequence_data& p)
+{
+	SavedImage const& __restrict image(frame->image);
+
+	ExtensionBlock const* ext(nullptr);
+	for (auto i = 0; i < image.ExtensionBlockCount; ++i) {
+		if (GRAPHICS_EXT_FUNC_CODE == image.ExtensionBlocks[i].Function && GCE_Size == image.ExtensionBlocks[i].ByteCount) {
+			ext = &(image.ExtensionBlocks[i]);
+			break;
+		}
+	}
+	Metadata meta;
+	if (ext) {
+
+		if (ext->Bytes[GCE_Flags] & 1) {
+			meta.trans_key = ((uint8_t)ext->Bytes[GCE_TransColor]);
+		}
+		meta.mode = ((ext->Bytes[GCE_Flags] >> 2) & 7);
+
+		meta.delay = frame_delay((uint8_t const* const)&ext->Bytes[GCE_Delay]);
+		if (0 == meta.delay)
+			meta.delay = 1;
+	}
+	frame->delay = meta.delay; // for the output images, only the delay is needed, everything else is "pre-processed"
+
+	ColorMapObject const* const colormap(image.ImageDesc.ColorMap ? image.ImageDesc.ColorMap : p.common_colormap);
+	if (!colormap) { // no local or global colormap, corrupted file
+		p.failed = true;
+		return;
+	}
+	// GIF is almost 30 years old
+	uint32_t const background_rgba(SFM::pack_rgba(colormap->Colors[p.background_color_index].Red, colormap->Colors[p.background_color_index].Green, colormap->Colors[p.background_color_index].Blue, 0x00));
+	
+	Imaging returnL(ImagingNew(MODE_BGRA, p.xsize, p.ysize));
+	if (!returnL) {
+		p.failed = true;
+		return;
+	}
+
+	// always clear to transparent
+	memset(returnL->block, 0 == frame->index ? (background_rgba | 0xFF000000) : 0, returnL->ysize * returnL->linesize);
+
+	bool bBlend(false);
+
+	switch (meta.mode)
+	{
+/*3*/case GCE_DisposalPrevious: //- don't do anything and the last frame will just repeat (ImageBlend - dst all transparent, src will replace)
+		bBlend = (0 != frame->index);
+		break;
+/*0*/case GCE_DisposalUnspecified: // -all pixels are replaced regardless of transparency
+		ImagingGIFSetPixels<true>(colormap->Colors, returnL, image);
+		break;
+/*2*/case GCE_DisposalBackground: //-fill image rect defined for this frame with background color (note the opaque flag is set here, so ImageBlend composition doesn't replace these pixels)
+		ImagingGIFDisposePixels(returnL, image, background_rgba | 0xFF000000);	
+/*1*/case GCE_DisposalDoNot: // -new pixels are drawn with transparency ImageBlend then does the hard work of vomposition of dst and src
+		//fall-through//
+	default:
+		if (-1 != meta.trans_key) {
+			ImagingGIFSetPixels(colormap->Colors, returnL, image, meta.trans_key);
+		}
+		else {
+			ImagingGIFSetPixels<true>(colormap->Colors, returnL, image);
+		}
+		bBlend = (0 != frame->index);
+		break;
+	}
+
+	// apply chroma key filter 1st
+	ImagingChromaKey(returnL); // must be applied here, to the raw'ist of data before it becomes blended, dithered, etc.
+
+	frame->composed = returnL;
+	frame->blend = bBlend;
+}
+
+// stage 3 (serial) - composition with the previous frame, the dithered result is the history for the next frame
+static void __vectorcall gif_compose_frame(gif_frame* const __restrict frame, gif_frame const* const __restrict previous)
+{
+	if (!frame->composed) {
+		return;
+	}
+
+	if (frame->blend && previous && previous->composed) {
+
+		// blend previous frame with current frame based on transparency
+		ImagingBlend(frame->composed, previous->composed);
+	}
+
+	if (frame->index & 1) // only dither odd frames so static dither pattern doesn't persist between frames
+	{
+		static constexpr float const GOLDEN_RATIO = 0.61803398874989484820f; // slightly bias lerp to non dithered original version
+
+		ImagingMemoryInstance const* const original = ImagingCopy(frame->composed);
+
+		if (original) {
+			ImagingDither(frame->composed); // enhance by dithering, (any inter-frame blending also benefits!)
+
+			ImagingLerp(frame->composed, original, GOLDEN_RATIO);
+
+			ImagingDelete(original);
+		}
+	}
+}
+
+// stage 4 (parallel) - resample to the desired size
+static void __vectorcall gif_resample_frame(gif_frame const* const __restrict frame, gif_sequence_data& p)
+{
+	gif_frame_result& __restrict result(p.results[frame->index]);
+
+	result.delay = frame->delay;
+
+	if (frame->composed) {
+		result.image = ImagingResample(frame->composed, p.width, p.height, IMAGING_TRANSFORM_BICUBIC);
+	}
+
+	if (!result.image) {
+		p.failed = true;
+	}
+}
+
+#if TBB_VERSION_MAJOR >= 2021 // oneTBB
+static constexpr tbb::filter_mode const GIF_FILTER_SERIAL(tbb::filter_mode::serial_in_order), GIF_FILTER_PARALLEL(tbb::filter_mode::parallel);
+#else
+static constexpr tbb::filter::mode const GIF_FILTER_SERIAL(tbb::filter::serial_in_order), GIF_FILTER_PARALLEL(tbb::filter::parallel);
+#endif
+
+static void __vectorcall gif_load_frames_pipelined(gif_sequence_data& p)
+{
+	// bounded number of frames in flight (memory), lzw decode & composition are serial - pixels, disposal, chroma key and resampling are parallel
+	size_t const max_frames_in_flight(size_t(SFM::max(2, tbb::this_task_arena::max_concurrency())) << 1);
+
+	uint32_t next_index(0);
+	gif_frame* previous(nullptr);
+
+	tbb::parallel_pipeline(max_frames_in_flight,
+		tbb::make_filter<void, gif_frame*>(GIF_FILTER_SERIAL, [&](tbb::flow_control& fc) -> gif_frame* {
+
+			gif_frame* const frame(p.failed ? nullptr : gif_slurp_frame(next_index, p));
+			if (!frame) {
+				fc.stop();
+				return(nullptr);
+			}
+			++next_index;
+			return(frame);
+		}) &
+		tbb::make_filter<gif_frame*, gif_frame*>(GIF_FILTER_PARALLEL, [&](gif_frame* const frame) -> gif_frame* {
+
+			gif_decode_frame(frame, p);
+			return(frame);
+		}) &
+		tbb::make_filter<gif_frame*, gif_frame*>(GIF_FILTER_SERIAL, [&](gif_frame* const frame) -> gif_frame* {
+
+			gif_compose_frame(frame, previous);
+			gif_release_frame(previous); // previous frame no longer required for blending
+			previous = frame;
+			return(frame);
+		}) &
+		tbb::make_filter<gif_frame*, void>(GIF_FILTER_PARALLEL, [&](gif_frame* const frame) {
+
+			gif_resample_frame(frame, p);
+			gif_release_frame(frame);
+		})
+	);
+
+	gif_release_frame(previous);
+}
+
+// purposely single threaded, so when used asynchnously in a background thread it uses minimal cpu resources
+static void __vectorcall gif_load_frames(gif_sequence_data& p)
+{
+	gif_frame* previous(nullptr);
+
+	for (uint32_t i = 0; !p.failed; ++i) {
+
+		gif_frame* const frame(gif_slurp_frame(i, p));
+		if (!frame) {
+			break;
+		}
+
+		gif_decode_frame(frame, p);
+		gif_compose_frame(frame, previous);
+		gif_release_frame(previous); // previous frame no longer required for blending
+		previous = frame;
+
+		gif_resample_frame(frame, p);
+		gif_release_frame(frame);
+	}
+
+	gif_release_frame(previous);
+}
+
+ImagingSequence* const __restrict __vectorcall ImagingLoadGIFSequence(std::wstring_view const giffilenamepath, uint32_t width, uint32_t height, bool const pipelined)
+{
+	ImagingSequence* im(nullptr);
+	int	ErrorCode(0);
+
+	std::error_code error{};
+	mio::mmap_source mmap = mio::make_mmap_source(giffilenamepath, false, error);
+	if (error || !mmap.is_open() || !mmap.is_mapped()) {
+		return(nullptr);
+	}
+	___prefetch_vmem(mmap.data(), mmap.size());
+
+	gif_memory_reader reader{ (uint8_t const*)mmap.data(), mmap.length(), 0 };
+
+	GifFileType* GifFileIn(DGifOpen(&reader, &gif_memory_read, &ErrorCode));
+
+	if (nullptr != GifFileIn) {
+
+		// if zero is passed in for either width or height, default to the native corresponding dimension
+		if ( 0 == width )
+			width = GifFileIn->SWidth;
+		if ( 0 == height )
+			height = GifFileIn->SHeight;
+
+		// ########## Load all gif frames, while resampling to desired size
+		// non-contigous memory is used during this process for each sequence instance (frame)
+		tbb::concurrent_vector<gif_frame_result> results;
+		std::atomic_bool failed(false);
+
+		{
+			gif_sequence_data p{ GifFileIn, results, GifFileIn->SColorMap, GifFileIn->SBackGroundColor, (uint32_t)GifFileIn->SWidth, (uint32_t)GifFileIn->SHeight, width, height, failed };
+
+			if (pipelined) {
+				gif_load_frames_pipelined(p);
+			}
+			else {
+				gif_load_frames(p);
+			}
+		}
+
+		uint32_t const count((uint32_t)results.size());
+
+		if (!failed && 0 != count) {
+
+			im = (ImagingSequence*)scalable_malloc(1 * sizeof(ImagingSequence));
+			memset(&(*im), 0, sizeof(ImagingSequence));
+
+			/* Setup image descriptor */
+			im->count = count;
+			im->xsize = width;
+			im->ysize = height;
+
+			uint32_t const linesize(width * im->pixelsize),
+						   imagesize(height * linesize);
+
+			im->linesize = linesize;
+			im->destroy = static_cast<void(*)(ImagingSequence* const __restrict)>(&ImagingDestroyBlock_Sequence);
+
+			im->images = (ImagingSequenceInstance*)scalable_malloc(count * sizeof(ImagingSequenceInstance));
+			memset(im->images, 0, count * sizeof(ImagingSequenceInstance));
+
+			// ########## MOVE	
+			for (uint32_t i = 0; i < count; ++i) {
+
+				im->images[i].block = (uint8_t*)scalable_malloc(imagesize);
+				im->images[i].destroy = static_cast<void(*)(ImagingSequenceInstance* const __restrict)>(&ImagingDestroyBlock_SequenceInstance);
+
+				im->images[i].xsize = width;
+				im->images[i].ysize = height;
+				im->images[i].linesize = linesize;
+				im->images[i].delay = results[i].delay;
+
+				{ // moving to contigous memory im->images[]
+					memcpy(im->images[i].block, results[i].image->block, imagesize);
+				}
+			} // for count images
+		}
+
+		for (auto& result : results) {
+			ImagingDelete(result.image); result.image = nullptr;
+		}
+
+		// no longer need gif ....
+		DGifCloseFile(GifFileIn, &ErrorCode); GifFileIn = nullptr;
+	}
+
+	return(im);
+}
+
+
+namespace compressed_sequence { // a frame is the rectangle that changed from the previous frame (the whole frame every keyframe_interval frames), coded as palette indices when it has 256 colors or less, otherwise as BGRX.
+								// the symbols are run length coded, with a third run type for pixels inside the rectangle that did not change. a frame is decoded by applying the frames that follow the nearest cached frame (or keyframe).
+
+	static constexpr uint32_t const MAX_COLORS = 256;
+	static constexpr uint32_t const MIN_CACHED = 3;	// returned frame, its reference & the prefetched frame
+
+	// run length tokens - control byte, followed by the symbol(s)
+	static constexpr uint32_t const LITERAL = 0,	// 0...63    : 1...64 symbols follow
+									REPEAT = 64,	// 64...127  : 2...65 copies of the symbol that follows
+									SKIP = 128;		// 128...255 : 1...128 pixels unchanged, no symbol
+	static constexpr uint32_t const MAX_LITERAL = 64,
+									MAX_REPEAT = 65,
+									MAX_SKIP = 128;
+
+	typedef struct frame {
+
+		uint8_t* __restrict data;	// palette (colors * uint32_t) followed by the tokens
+		uint32_t bytes;
+		uint32_t x, y, w, h;		// changed rectangle, empty (0 == w) if identical to the previous frame
+		uint32_t colors;			// 0 = BGRX symbols, otherwise palette index symbols (uint8_t)
+		uint32_t delay;
+
+	} frame;
+
+	typedef struct cache_entry {
+
+		ImagingMemoryInstance* __restrict image;
+		uint32_t index;
+		uint64_t used;
+
+	} cache_entry;
+
+	typedef struct state {
+
+		frame* __restrict frames;
+		cache_entry* __restrict cache;
+		uint32_t const count, cached, keyframe_interval;
+		int32_t const xsize, ysize;
+
+		uint32_t current;				// last frame returned, never evicted
+		uint64_t tick;
+		tbb::spin_mutex lock;			// cache entries
+		std::mutex decoding;			// decodes are serialized (a frame depends on the previous frame), the cache only changes while held
+		tbb::task_group prefetcher;
+		std::atomic_bool prefetching;
+
+		explicit state(uint32_t const count_, uint32_t const cached_, uint32_t const keyframe_interval_, int32_t const xsize_, int32_t const ysize_)
+			: frames(nullptr), cache(nullptr), count(count_), cached(cached_), keyframe_interval(keyframe_interval_), xsize(xsize_), ysize(ysize_),
+			  current(UINT32_MAX), tick(0), prefetching(false)
+		{}
+
+	} state;
+
+	typedef struct palette_table { // open addressing, load factor <= 0.5
+
+		static constexpr uint32_t const SLOTS = MAX_COLORS * 2;
+
+		uint32_t key[SLOTS];
+		int32_t  value[SLOTS];		// -1 empty
+		uint32_t colors[MAX_COLORS];
+		uint32_t count;
+
+	} palette_table;
+
+	STATIC_INLINE_PURE uint32_t const hash(uint32_t const color)
+	{
+		return((color * 0x9E3779B1u) >> 23u); // 9 bits, SLOTS
+	}
+
+	// false if the color would be the 257th
+	static __inline bool const insert(palette_table& __restrict table, uint32_t const color)
+	{
+		uint32_t slot(hash(color));
+
+		while (table.value[slot] >= 0) {
+			if (color == table.key[slot])
+				return(true);
+			slot = (slot + 1) & (palette_table::SLOTS - 1);
+		}
+
+		if (MAX_COLORS == table.count)
+			return(false);
+
+		table.key[slot] = color;
+		table.value[slot] = table.count;
+		table.colors[table.count++] = color;
+		return(true);
+	}
+
+	static __inline uint8_t const find(palette_table const& __restrict table, uint32_t const color) // color must be in the table
+	{
+		uint32_t slot(hash(color));
+
+		while (color != table.key[slot] || table.value[slot] < 0) {
+			slot = (slot + 1) & (palette_table::SLOTS - 1);
+		}
+		return(uint8_t(table.value[slot]));
+	}
+
+	// changed rectangle between two frames, false if identical
+	static bool const __vectorcall changed(uint32_t const* const __restrict cur, uint32_t const* const __restrict prev, uint32_t const width, uint32_t const height,
+										   uint32_t& __restrict x, uint32_t& __restrict y, uint32_t& __restrict w, uint32_t& __restrict h)
+	{
+		size_t const linesize(size_t(width) * sizeof(uint32_t));
+
+		uint32_t y0(0), y1(height);
+		while (y0 < height && 0 == memcmp(cur + size_t(y0) * width, prev + size_t(y0) * width, linesize)) ++y0;
+		if (height == y0)
+			return(false);
+		while (0 == memcmp(cur + size_t(y1 - 1) * width, prev + size_t(y1 - 1) * width, linesize)) --y1;
+
+		uint32_t x0(width), x1(0);
+		for (uint32_t row = y0; row < y1; ++row) {
+
+			uint32_t const* const __restrict a(cur + size_t(row) * width);
+			uint32_t const* const __restrict b(prev + size_t(row) * width);
+
+			uint32_t left(0);
+			while (left < x0 && a[left] == b[left]) ++left;
+			x0 = std::min(x0, left);
+
+			uint32_t right(width);
+			while (right > x1 && a[right - 1] == b[right - 1]) --right;
+			x1 = std::max(x1, right);
+		}
+
+		x = x0; y = y0; w = x1 - x0; h = y1 - y0;
+		return(true);
+	}
+
+	// symbols in row order of the rectangle, unchanged pixels (keep) are skipped
+	template<typename Symbol>
+	static uint8_t* const __vectorcall encode_runs(uint8_t* __restrict out, Symbol const* const __restrict symbols, uint8_t const* const __restrict keep, uint32_t const n)
+	{
+		uint32_t p(0);
+
+		while (p < n) {
+
+			if (keep[p]) {
+				uint32_t run(1);
+				while (p + run < n && run < MAX_SKIP && keep[p + run]) ++run;
+
+				*out++ = uint8_t(SKIP + run - 1);
+				p += run;
+				continue;
+			}
+
+			uint32_t run(1);
+			while (p + run < n && run < MAX_REPEAT && !keep[p + run] && symbols[p + run] == symbols[p]) ++run;
+
+			if (run > 1) {
+				*out++ = uint8_t(REPEAT + run - 2);
+				memcpy(out, &symbols[p], sizeof(Symbol)); out += sizeof(Symbol);
+				p += run;
+				continue;
+			}
+
+			// literal, up to the start of a skip or repeat
+			uint32_t const begin(p);
+			do {
+				++p;
+			} while (p < n && p - begin < MAX_LITERAL && !keep[p] && !(p + 1 < n && !keep[p + 1] && symbols[p + 1] == symbols[p]));
+
+			uint32_t const length(p - begin);
+			*out++ = uint8_t(LITERAL + length - 1);
+			memcpy(out, &symbols[begin], length * sizeof(Symbol)); out += length * sizeof(Symbol);
+		}
+
+		return(out);
+	}
+
+	template<typename Symbol>
+	STATIC_INLINE_PURE uint32_t const lookup(uint8_t const* const __restrict in, uint32_t const* const __restrict palette)
+	{
+		if constexpr (sizeof(uint8_t) == sizeof(Symbol)) {
+			return(palette[*in]);
+		}
+		else {
+			uint32_t pixel;
+			memcpy(&pixel, in, sizeof(uint32_t));
+			return(pixel);
+		}
+	}
+
+	// n pixels of the rectangle starting at row (stride in pixels)
+	template<typename Symbol>
+	static void __vectorcall decode_runs(uint32_t* __restrict row, size_t const stride, uint32_t const w, uint8_t const* __restrict in, uint32_t const* const __restrict palette, uint32_t n)
+	{
+		uint32_t x(0);
+
+		while (n) {
+
+			uint32_t const c(*in++);
+
+			if (c >= SKIP) {
+				uint32_t const run(c - SKIP + 1);
+				n -= run;
+
+				x += run;
+				while (x >= w) {
+					x -= w; row += stride;
+				}
+			}
+			else if (c >= REPEAT) {
+				uint32_t run(c - REPEAT + 2);
+				n -= run;
+
+				uint32_t const pixel(lookup<Symbol>(in, palette)); in += sizeof(Symbol);
+				while (run) {
+					uint32_t const span(std::min(run, w - x));
+					std::fill_n(row + x, span, pixel);
+					run -= span;
+					x += span;
+					if (w == x) {
+						x = 0; row += stride;
+					}
+				}
+			}
+			else {
+				uint32_t run(c - LITERAL + 1);
+				n -= run;
+
+				while (run) {
+					uint32_t const span(std::min(run, w - x));
+					for (uint32_t i = 0; i < span; ++i) {
+						row[x + i] = lookup<Symbol>(in, palette); in += sizeof(Symbol);
+					}
+					run -= span;
+					x += span;
+					if (w == x) {
+						x = 0; row += stride;
+					}
+				}
+			}
+		}
+	}
+
+	// prev is nullptr for a keyframe. frame is left empty on failure (out of memory)
+	static bool const __vectorcall encode(frame& __restrict f, uint32_t const* const __restrict cur, uint32_t const* const __restrict prev, uint32_t const width, uint32_t const height)
+	{
+		if (prev) {
+			if (!changed(cur, prev, width, height, f.x, f.y, f.w, f.h)) {
+				return(true); // empty
+			}
+		}
+		else {
+			f.x = 0; f.y = 0; f.w = width; f.h = height;
+		}
+
+		uint32_t const n(f.w * f.h);
+
+		uint32_t* const __restrict pixels((uint32_t*)scalable_malloc(size_t(n) * (sizeof(uint32_t) + sizeof(uint8_t) * 2)));
+		palette_table* const __restrict table((palette_table*)scalable_malloc(sizeof(palette_table)));
+		if (!pixels || !table) {
+			scalable_free(pixels); scalable_free(table);
+			return(false);
+		}
+		uint8_t* const __restrict keep((uint8_t*)(pixels + n));
+		uint8_t* const __restrict indices(keep + n);
+
+		memset(table->value, -1, sizeof(table->value));
+		table->count = 0;
+
+		bool palettized(true);
+		for (uint32_t row = 0; row < f.h; ++row) {
+
+			size_t const offset(size_t(f.y + row) * width + f.x);
+			uint32_t const* const __restrict a(cur + offset);
+
+			memcpy(pixels + size_t(row) * f.w, a, f.w * sizeof(uint32_t));
+
+			uint8_t* const __restrict k(keep + size_t(row) * f.w);
+			if (prev) {
+				uint32_t const* const __restrict b(prev + offset);
+				for (uint32_t x = 0; x < f.w; ++x) {
+					k[x] = uint8_t(a[x] == b[x]);
+				}
+			}
+			else {
+				memset(k, 0, f.w);
+			}
+
+			for (uint32_t x = 0; x < f.w && palettized; ++x) {
+				palettized = k[x] || insert(*table, a[x]); // unchanged pixels are not symbols
+			}
+		}
+
+		uint32_t const colors(palettized ? table->count : 0);
+		size_t const symbol_size(palettized ? sizeof(uint8_t) : sizeof(uint32_t));
+		size_t const bound(colors * sizeof(uint32_t) + size_t(n) * (symbol_size + 1)); // worst case, a literal of 1 between every repeat
+
+		uint8_t* __restrict data((uint8_t*)scalable_malloc(bound));
+		if (!data) {
+			scalable_free(pixels); scalable_free(table);
+			return(false);
+		}
+
+		uint8_t* __restrict end;
+		if (palettized) {
+			for (uint32_t i = 0; i < n; ++i) {
+				indices[i] = keep[i] ? 0 : find(*table, pixels[i]);
+			}
+
+			memcpy(data, table->colors, colors * sizeof(uint32_t));
+			end = encode_runs<uint8_t>(data + colors * sizeof(uint32_t), indices, keep, n);
+		}
+		else {
+			end = encode_runs<uint32_t>(data, pixels, keep, n);
+		}
+
+		scalable_free(pixels); scalable_free(table);
+
+		f.bytes = uint32_t(end - data);
+		f.colors = colors;
+		f.data = (uint8_t*)scalable_realloc(data, f.bytes); // shrink to fit
+		if (!f.data) {
+			f.data = data;
+		}
+		return(true);
+	}
+
+	static void __vectorcall apply(frame const& __restrict f, ImagingMemoryInstance* const __restrict image)
+	{
+		if (0 == f.w)
+			return;
+
+		uint32_t* const __restrict row((uint32_t*)(image->block + size_t(f.y) * image->linesize) + f.x);
+		size_t const stride(image->linesize / sizeof(uint32_t));
+
+		if (f.colors) {
+			decode_runs<uint8_t>(row, stride, f.w, f.data + f.colors * sizeof(uint32_t), (uint32_t const*)f.data, f.w * f.h);
+		}
+		else {
+			decode_runs<uint32_t>(row, stride, f.w, f.data, nullptr, f.w * f.h);
+		}
+	}
+
+	// cached frame, acquire marks the frame as the one returned (never evicted) & most recently used
+	static ImagingMemoryInstance* const __restrict __vectorcall find(state& __restrict s, uint32_t const index, bool const acquire)
+	{
+		tbb::spin_mutex::scoped_lock lock(s.lock);
+
+		for (uint32_t i = 0; i < s.cached; ++i) {
+
+			cache_entry& __restrict entry(s.cache[i]);
+			if (entry.image && index == entry.index) {
+				if (acquire) {
+					entry.used = ++s.tick;
+					s.current = index;
+				}
+				return(entry.image);
+			}
+		}
+		return(nullptr);
+	}
+
+	// decoding must be held
+	static ImagingMemoryInstance* const __restrict __vectorcall decode(state& __restrict s, uint32_t const index, bool const acquire)
+	{
+		uint32_t const keyframe(index - index % s.keyframe_interval);
+
+		ImagingMemoryInstance const* __restrict base(nullptr);
+		uint32_t start(keyframe);
+		{ // nearest decoded frame this frame can be reached from
+			tbb::spin_mutex::scoped_lock lock(s.lock);
+
+			for (uint32_t i = 0; i < s.cached; ++i) {
+
+				cache_entry const& __restrict entry(s.cache[i]);
+				if (entry.image && entry.index >= keyframe && entry.index < index && entry.index >= start) {
+					base = entry.image;
+					start = entry.index + 1;
+				}
+			}
+		}
+
+		ImagingMemoryInstance* const __restrict image(ImagingNew(MODE_BGRX, s.xsize, s.ysize));
+		if (!image) {
+			return(nullptr);
+		}
+
+		if (base) {
+			memcpy(image->block, base->block, size_t(image->linesize) * size_t(image->ysize));
+		}
+		for (uint32_t i = start; i <= index; ++i) {
+			apply(s.frames[i], image);
+		}
+
+		ImagingMemoryInstance* __restrict evicted(nullptr);
+		{
+			tbb::spin_mutex::scoped_lock lock(s.lock);
+
+			cache_entry* __restrict slot(nullptr);
+			for (uint32_t i = 0; i < s.cached; ++i) {
+
+				cache_entry* const __restrict entry(&s.cache[i]);
+				if (nullptr == entry->image) {
+					slot = entry;
+					break;
+				}
+				if (s.current != entry->index && (nullptr == slot || entry->used < slot->used)) {
+					slot = entry;
+				}
+			}
+
+			evicted = slot->image;
+			slot->image = image;
+			slot->index = index;
+			slot->used = ++s.tick;
+			if (acquire) {
+				s.current = index;
+			}
+		}
+		ImagingDelete(evicted);
+
+		return(image);
+	}
+
+	typedef struct prefetch_task {
+
+		state* const __restrict s;
+		uint32_t const index;
+
+		void operator()() const
+		{
+			{
+				std::scoped_lock decoding(s->decoding);
+
+				if (nullptr == find(*s, index, false)) {
+					decode(*s, index, false);
+				}
+			}
+			s->prefetching.store(false, std::memory_order_release);
+		}
+
+	} prefetch_task;
+
+	static void __vectorcall prefetch(state& __restrict s, uint32_t const index)
+	{
+		bool expected(false);
+		if (nullptr == find(s, index, false) && s.prefetching.compare_exchange_strong(expected, true)) { // one in flight
+			s.prefetcher.run(prefetch_task{ &s, index });
+		}
+	}
+
+	static void __vectorcall destroy(state& __restrict s)
+	{
+		s.prefetcher.wait();
+
+		if (s.cache) {
+			for (uint32_t i = 0; i < s.cached; ++i) {
+				ImagingDelete(s.cache[i].image); s.cache[i].image = nullptr;
+			}
+			scalable_free(s.cache); s.cache = nullptr;
+		}
+
+		if (s.frames) {
+			for (uint32_t i = 0; i < s.count; ++i) {
+				scalable_free(s.frames[i].data); s.frames[i].data = nullptr;
+			}
+			scalable_free(s.frames); s.frames = nullptr;
+		}
+	}
+
+} // end ns
+
+static void ImagingDestroyBlock_CompressedSequence(ImagingCompressedSequence* const __restrict seq)
+{
+	if (seq) {
+		if (seq->internal) {
+
+			compressed_sequence::state* const __restrict s(static_cast<compressed_sequence::state* const>(seq->internal));
+			compressed_sequence::destroy(*s);
+
+			std::destroy_at(s);
+			scalable_free(s); seq->internal = nullptr;
+		}
+		seq->destroy = nullptr;
+	}
+}
+
+ImagingCompressedSequence* const __restrict __vectorcall ImagingCompressSequence(ImagingSequence const* const __restrict seq, uint32_t keyframe_interval, uint32_t cached_frames)
+{
+	if (nullptr == seq || 0 == seq->count || nullptr == seq->images) {
+		return(nullptr);
+	}
+	keyframe_interval = std::max(1u, keyframe_interval);
+	cached_frames = std::max(compressed_sequence::MIN_CACHED, cached_frames);
+
+	ImagingCompressedSequence* const __restrict cseq((ImagingCompressedSequence*)scalable_malloc(sizeof(ImagingCompressedSequence)));
+	if (!cseq) {
+		return (ImagingCompressedSequence*)ImagingError_MemoryError();
+	}
+	memset(&(*cseq), 0, sizeof(ImagingCompressedSequence));
+
+	void* const __restrict internal(scalable_malloc(sizeof(compressed_sequence::state)));
+	if (!internal) {
+		scalable_free(cseq);
+		return (ImagingCompressedSequence*)ImagingError_MemoryError();
+	}
+
+	/* Setup descriptor */
+	cseq->count = seq->count;
+	cseq->xsize = seq->xsize;
+	cseq->ysize = seq->ysize;
+	cseq->linesize = seq->xsize * cseq->pixelsize;
+	cseq->keyframe_interval = keyframe_interval;
+	cseq->internal = new (internal) compressed_sequence::state(seq->count, cached_frames, keyframe_interval, int32_t(seq->xsize), int32_t(seq->ysize));
+	cseq->destroy = static_cast<void(*)(ImagingCompressedSequence* const __restrict)>(&ImagingDestroyBlock_CompressedSequence);
+
+	compressed_sequence::state& __restrict s(*static_cast<compressed_sequence::state* const>(cseq->internal));
+
+	s.frames = (compressed_sequence::frame*)scalable_malloc(seq->count * sizeof(compressed_sequence::frame));
+	s.cache = (compressed_sequence::cache_entry*)scalable_malloc(cached_frames * sizeof(compressed_sequence::cache_entry));
+	if (!s.frames || !s.cache) {
+		ImagingDelete(cseq);
+		return (ImagingCompressedSequence*)ImagingError_MemoryError();
+	}
+	memset(s.frames, 0, seq->count * sizeof(compressed_sequence::frame));
+	memset(s.cache, 0, cached_frames * sizeof(compressed_sequence::cache_entry));
+
+	// every frame is independent when encoding (the source is fully expanded)
+	struct { // avoid lambda heap
+		ImagingSequence const* const __restrict seq;
+		compressed_sequence::frame* const __restrict frames;
+		uint32_t const keyframe_interval;
+		std::atomic_bool failed;
+	} p = { seq, s.frames, keyframe_interval, false };
+
+	tbb::parallel_for(tbb::blocked_range<uint32_t>(0, seq->count), [&p](tbb::blocked_range<uint32_t> const& r) {
+
+		for (uint32_t i = r.begin(); i < r.end(); ++i) {
+
+			uint32_t const* const __restrict cur((uint32_t const*)p.seq->images[i].block);
+			uint32_t const* const __restrict prev(0 == (i % p.keyframe_interval) ? nullptr : (uint32_t const*)p.seq->images[i - 1].block);
+
+			p.frames[i].delay = p.seq->images[i].delay;
+			if (!compressed_sequence::encode(p.frames[i], cur, prev, p.seq->xsize, p.seq->ysize)) {
+				p.failed = true;
+			}
+		}
+	});
+
+	if (p.failed) {
+		ImagingDelete(cseq);
+		return (ImagingCompressedSequence*)ImagingError_MemoryError();
+	}
+
+	for (uint32_t i = 0; i < seq->count; ++i) {
+		cseq->bytes += s.frames[i].bytes;
+	}
+
+	return(cseq);
+}
+
+ImagingMemoryInstance const* const __restrict __vectorcall ImagingSequenceFrame(ImagingCompressedSequence* const __restrict seq, uint32_t const index)
+{
+	if (nullptr == seq || index >= seq->count) {
+		return(nullptr);
+	}
+
+	compressed_sequence::state& __restrict s(*static_cast<compressed_sequence::state* const>(seq->internal));
+
+	ImagingMemoryInstance const* __restrict image(compressed_sequence::find(s, index, true));
+	if (nullptr == image) {
+		std::scoped_lock decoding(s.decoding);
+
+		image = compressed_sequence::find(s, index, true); // prefetched while waiting
+		if (nullptr == image) {
+			image = compressed_sequence::decode(s, index, true);
+		}
+	}
+
+	if (image && s.count > 1) {
+		compressed_sequence::prefetch(s, (index + 1) % s.count); // playback loops
+	}
+
+	return(image);
+}
+
+uint32_t const __vectorcall ImagingSequenceFrameDelay(ImagingCompressedSequence const* const __restrict seq, uint32_t const index)
+{
+	if (nullptr == seq || index >= seq->count) {
+		return(0);
+	}
+
+	return(static_cast<compressed_sequence::state const* const>(seq->internal)->frames[index].delay);
+}
+
+
+namespace cube_lut { // .cube text parsing from a memory mapped file, the table is split into chunks at line boundaries that are parsed in parallel. binary .lutb is the raw lut block following a small header (zero-copy when mapped)
+
+	static constexpr size_t const CHUNK_BYTES = 64 * 1024;		// ~2.5k lines of table data per chunk
+	static constexpr uint32_t const BINARY_VERSION = 1;
+	static constexpr char const BINARY_MAGIC[8] = { 'I', 'M', 'G', 'L', 'U', 'T', '1', '6' };
+	static constexpr wchar_t const* const EXTENSION_BINARY = L".lutb";
+
+	typedef struct binary_header { // 64 bytes, the block (cache line aligned) follows
+
+		char     magic[8];
+		uint32_t version;
+		uint32_t size;			// dimension
+		uint32_t pixelsize;		// sizeof(uint16_t) * 4
+		uint32_t reserved;
+		char     title[40];		// zero terminated, truncated
+
+	} binary_header;
+	static_assert(sizeof(binary_header) == 64);
+
+	typedef struct ImagingMappedLUT : ImagingLUT {
+
+		mio::mmap_source mapping;
+
+	} ImagingMappedLUT;
+
+	static __inline bool const is_space(char const c) { return(' ' == c || '\t' == c || '\r' == c); }
+	static __inline bool const is_data(char const c) { return((c >= '0' && c <= '9') || '-' == c || '+' == c || '.' == c); }
+
+	static __inline char const* skip_space(char const* __restrict p, char const* const __restrict end)
+	{
+		while (p < end && is_space(*p)) ++p;
+		return(p);
+	}
+	static __inline char const* next_line(char const* __restrict p, char const* const __restrict end)
+	{
+		char const* const __restrict eol((char const*)memchr(p, '\n', end - p));
+		return(eol ? eol + 1 : end);
+	}
+
+	// keyword at the beginning of the line
+	static __inline bool const keyword(char const* const __restrict p, char const* const __restrict end, std::string_view const word)
+	{
+		return(size_t(end - p) > word.length() && 0 == memcmp(p, word.data(), word.length()) && is_space(p[word.length()]));
+	}
+
+	static __inline char const* parse_float(char const* __restrict p, char const* const __restrict end, float& __restrict value)
+	{
+		p = skip_space(p, end);
+		if (p < end && '+' == *p) ++p; // from_chars does not accept a leading plus
+
+		std::from_chars_result const result(std::from_chars(p, end, value));
+		return(std::errc() == result.ec ? result.ptr : nullptr);
+	}
+
+	// # of table lines in [p, end), comments & blank lines are skipped
+	static uint32_t const __vectorcall count_lines(char const* __restrict p, char const* const __restrict end)
+	{
+		uint32_t count(0);
+
+		while (p < end) {
+			char const* const __restrict line(skip_space(p, end));
+			if (line < end && is_data(*line)) {
+				++count;
+			}
+			p = next_line(line, end);
+		}
+		return(count);
+	}
+
+	// slices ordered by r, (b * rMax * gMax) + (g * rMax) + r is the line index
+	static bool const __vectorcall parse_lines(uint16_t* __restrict lut_color, char const* __restrict p, char const* const __restrict end)
+	{
+		static constexpr float const DENORMALIZE = float(UINT16_MAX);
+
+		while (p < end) {
+			char const* __restrict line(skip_space(p, end));
+			if (line < end && is_data(*line)) {
+
+				float r, g, b;
+
+				if (nullptr == (line = parse_float(line, end, r)) ||
+					nullptr == (line = parse_float(line, end, g)) ||
+					nullptr == (line = parse_float(line, end, b))) {
+					return(false);
+				}
+
+				lut_color[0] = (uint16_t)SFM::saturate_to_u16(r * DENORMALIZE);
+				lut_color[1] = (uint16_t)SFM::saturate_to_u16(g * DENORMALIZE);
+				lut_color[2] = (uint16_t)SFM::saturate_to_u16(b * DENORMALIZE);
+
+				lut_color += 4;
+			}
+			p = next_line(line, end);
+		}
+		return(true);
+	}
+
+	static ImagingLUT* const __restrict __vectorcall parse(char const* const __restrict begin, char const* const __restrict end)
+	{
+		// .cube lut specification
+		// https://wwwimages2.adobe.com/content/dam/acom/en/products/speedgrade/cc/pdfs/cube-lut-specification-1.0.pdf
+		//
+		int32_t size(0);
+		char const* __restrict p(begin);
+
+		// keywords come before the table data, only LUT_3D_SIZE is used
+		while (p < end) {
+			char const* const __restrict line(skip_space(p, end));
+
+			if (line < end && is_data(*line)) {
+				break; // lines of table data come after keywords
+			}
+			if (keyword(line, end, "LUT_3D_SIZE")) {
+				std::from_chars(skip_space(line + 11, end), end, size);
+			}
+			p = next_line(line, end);
+		}
+
+		if (size <= 1) {
+			return (ImagingLUT*)ImagingError_ValueError("bad lut size");
+		}
+
+		ImagingLUT* const __restrict lut(ImagingNew(size));
+		if (nullptr == lut || nullptr == lut->block) {
+			ImagingDelete(lut);
+			return(nullptr);
+		}
+
+		// chunks begin at the start of a line
+		size_t const bytes(end - p);
+		size_t const chunks(std::max(size_t(1), bytes / CHUNK_BYTES));
+
+		std::vector<char const*> chunk_begin(chunks + 1);
+		std::vector<uint32_t> chunk_first(chunks + 1, 0); // first table line of each chunk
+
+		chunk_begin[0] = p;
+		chunk_begin[chunks] = end;
+		for (size_t i = 1; i < chunks; ++i) {
+			chunk_begin[i] = std::max(chunk_begin[i - 1], next_line(p + i * (bytes / chunks), end));
+		}
+
+		tbb::parallel_for(size_t(0), chunks, [&](size_t const i) {
+			chunk_first[i + 1] = count_lines(chunk_begin[i], chunk_begin[i + 1]);
+		});
+
+		for (size_t i = 1; i <= chunks; ++i) {
+			chunk_first[i] += chunk_first[i - 1];
+		}
+
+		uint32_t const lut_size(lut->size);
+		if (lut_size * lut_size * lut_size != chunk_first[chunks]) { // table does not match the size of the cube
+			ImagingDelete(lut);
+			return (ImagingLUT*)ImagingError_ValueError("bad lut table");
+		}
+
+		std::atomic_bool bFailed(false);
+
+		tbb::parallel_for(size_t(0), chunks, [&](size_t const i) {
+			if (!parse_lines(lut->block + (size_t(chunk_first[i]) << 2), chunk_begin[i], chunk_begin[i + 1])) {
+				bFailed = true;
+			}
+		});
+
+		if (bFailed) {
+			ImagingDelete(lut);
+			return (ImagingLUT*)ImagingError_ValueError("bad lut table");
+		}
+
+		return(lut);
+	}
+
+	static binary_header const* const __restrict __vectorcall binary(mio::mmap_source const& __restrict mmap)
+	{
+		if (mmap.size() < sizeof(binary_header)) {
+			return(nullptr);
+		}
+
+		binary_header const* const __restrict header(reinterpret_cast<binary_header const*>(mmap.data()));
+
+		if (0 != memcmp(header->magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) || BINARY_VERSION != header->version || ImagingLUT::pixelsize != header->pixelsize ||
+			header->size <= 1 || header->size >= MAX_LUT_DIMENSION_SIZE ||
+			mmap.size() < sizeof(binary_header) + size_t(header->size) * size_t(header->size) * size_t(header->size) * size_t(ImagingLUT::pixelsize)) {
+			return(nullptr);
+		}
+
+		return(header);
+	}
+
+	static void ImagingDestroyBlock_MappedLUT(ImagingLUT* const __restrict im)
+	{
+		if (im) {
+			std::destroy_at(&static_cast<ImagingMappedLUT* const>(im)->mapping); // unmaps
+			im->block = nullptr;
+			im->destroy = nullptr;
+		}
+	}
+
+	static ImagingLUT const* const __restrict __vectorcall map(mio::mmap_source&& mmap, binary_header const* const __restrict header)
+	{
+		ImagingMappedLUT* const __restrict lut((ImagingMappedLUT*)scalable_malloc(1 * sizeof(ImagingMappedLUT)));
+		if (!lut) {
+			return (ImagingLUT*)ImagingError_MemoryError();
+		}
+		memset(lut, 0, sizeof(ImagingMappedLUT));
+
+		lut->size = header->size;
+		lut->slicesize = lut->size * lut->size * lut->pixelsize;
+
+		std::construct_at(&lut->mapping, std::move(mmap));
+
+		lut->block = const_cast<uint16_t*>(reinterpret_cast<uint16_t const*>(lut->mapping.data() + sizeof(binary_header)));
+		lut->destroy = static_cast<void(*)(ImagingLUT* const __restrict)>(&ImagingDestroyBlock_MappedLUT);
+
+		return(lut);
+	}
+
+	static bool const __vectorcall save_binary(ImagingLUT const* const __restrict lut, std::string_view const title, std::wstring_view const filenamepath)
+	{
+		bool bReturn(false);
+
+		FILE* fOut;
+
+		if (0 == _wfopen_s(&fOut, filenamepath.data(), L"wbS"))
+		{
+			binary_header header{};
+
+			memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+			header.version = BINARY_VERSION;
+			header.size = lut->size;
+			header.pixelsize = lut->pixelsize;
+			memcpy(header.title, title.data(), std::min(title.length(), sizeof(header.title) - 1));
+
+			size_t const block_size(size_t(lut->size) * size_t(lut->slicesize));
+
+			bReturn = (1 == fwrite(&header, sizeof(binary_header), 1, fOut)) && (block_size == fwrite(lut->block, 1, block_size, fOut));
+
+			fclose(fOut); fOut = nullptr;
+		}
+		return(bReturn);
+	}
+} // end ns
+
+// .cube or .lutb (detected by content)
+ImagingLUT* const __restrict __vectorcall ImagingLoadLUT(std::wstring_view const cubefilenamepath)
+{
+	std::error_code error{};
+
+	mio::mmap_source mmap = mio::make_mmap_source(cubefilenamepath, false, error);
+	if (error || !mmap.is_open() || !mmap.is_mapped()) {
+		return(nullptr);
+	}
+
+	cube_lut::binary_header const* const __restrict header(cube_lut::binary(mmap));
+	if (header) {
+
+		ImagingLUT* const __restrict lut(ImagingNew(header->size));
+		if (lut && lut->block) {
+			memcpy(lut->block, mmap.data() + sizeof(cube_lut::binary_header), size_t(lut->size) * size_t(lut->slicesize));
+		}
+		return(lut);
+	}
+
+	return(cube_lut::parse(mmap.data(), mmap.data() + mmap.size()));
+}
+
+// .lutb is mapped (zero-copy), .cube is loaded
+ImagingLUT const* const __restrict __vectorcall ImagingMapLUT(std::wstring_view const filenamepath)
+{
+	std::error_code error{};
+
+	mio::mmap_source mmap = mio::make_mmap_source(filenamepath, false, error);
+	if (error || !mmap.is_open() || !mmap.is_mapped()) {
+		return(nullptr);
+	}
+
+	cube_lut::binary_header const* const __restrict header(cube_lut::binary(mmap));
+	if (header) {
+		return(cube_lut::map(std::move(mmap), header));
+	}
+
+	return(cube_lut::parse(mmap.data(), mmap.data() + mmap.size()));
+}
+
+void __vectorcall ImagingCopyRaw(void* const pDstMemory, ImagingMemoryInstance const* const __restrict pSrcImage)
+{
+	uint8_t* __restrict pOut(reinterpret_cast<uint8_t* const __restrict>(pDstMemory));
+	uint8_t const * __restrict pIn(pSrcImage->block);
+	uint32_t const stride = pSrcImage->linesize;
+
+	int scanline(pSrcImage->ysize);
+	while (0 != scanline) {
+
+		memcpy(pOut, pIn, stride);
+		pOut += stride; pIn += stride;
+
+		--scanline;
+	}
+}
+
+void __vectorcall ImagingSwapRB(ImagingMemoryInstance* const __restrict im)
+{
+	uint32_t const width(im->xsize);
+	uint32_t const height(im->ysize);
+
+	uint32_t* const __restrict block(reinterpret_cast<uint32_t* const>(im->block));
+
+	uvec4_t rgba_dst{};
+
+	for (uint32_t y = 0; y < height; ++y) {
+
+		for (uint32_t x = 0; x < width; ++x) {
+
+			uint32_t const pixel(y * width + x);
+
+			SFM::unpack_rgba(block[pixel], rgba_dst.r, rgba_dst.g, rgba_dst.b, rgba_dst.a);
+			block[pixel] = SFM::pack_rgba(rgba_dst.b, rgba_dst.g, rgba_dst.r, rgba_dst.a);
+		}
+	}
+}
+
+namespace f32_ops { // AVX2 8 floats per iteration. for min / max the partial group repeats the last value of the row, so it cannot change the result.
+
+	typedef struct range {
+
+		float fMin, fMax;
+
+	} range;
+
+	static float const __vectorcall hmin(__m256 const v)
+	{
+		__m128 m(_mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+		m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+		m = _mm_min_ss(m, _mm_movehdup_ps(m));
+		return(_mm_cvtss_f32(m));
+	}
+	static float const __vectorcall hmax(__m256 const v)
+	{
+		__m128 m(_mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+		m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+		m = _mm_max_ss(m, _mm_movehdup_ps(m));
+		return(_mm_cvtss_f32(m));
+	}
+
+	// nan in v returns the accumulator (second operand), so nan is ignored
+	static range const __vectorcall minmax_row(float const* const __restrict pIn, uint32_t const width, range const r)
+	{
+		__m256 xmMin0(_mm256_set1_ps(r.fMin)), xmMax0(_mm256_set1_ps(r.fMax));
+		__m256 xmMin1(xmMin0), xmMax1(xmMax0);
+
+		uint32_t x(0);
+		for (; (x + 16) <= width; x += 16) { // two independent chains
+
+			__m256 const v0(_mm256_loadu_ps(pIn + x)), v1(_mm256_loadu_ps(pIn + x + 8));
+
+			xmMin0 = _mm256_min_ps(v0, xmMin0); xmMax0 = _mm256_max_ps(v0, xmMax0);
+			xmMin1 = _mm256_min_ps(v1, xmMin1); xmMax1 = _mm256_max_ps(v1, xmMax1);
+		}
+		if ((x + 8) <= width) {
+
+			__m256 const v0(_mm256_loadu_ps(pIn + x));
+
+			xmMin0 = _mm256_min_ps(v0, xmMin0); xmMax0 = _mm256_max_ps(v0, xmMax0);
+			x += 8;
+		}
+		if (x < width) {
+
+			alignas(32) float in[8];
+			for (uint32_t i = 0; i < 8; ++i) {
+				in[i] = pIn[x + SFM::min(i, width - x - 1)]; // repeat the last value
+			}
+			__m256 const v0(_mm256_load_ps(in));
+
+			xmMin1 = _mm256_min_ps(v0, xmMin1); xmMax1 = _mm256_max_ps(v0, xmMax1);
+		}
+
+		return(range{ hmin(_mm256_min_ps(xmMin0, xmMin1)), hmax(_mm256_max_ps(xmMax0, xmMax1)) });
+	}
+
+	// (v - min) * scale, [optional] ordered dither offset in -0.5 ... +0.5 lsb, saturated & rounded to u16. nan is 0
+	static __inline __m128i const __vectorcall quantize8(__m256 const v, __m256 const xmMin, __m256 const xmScale, __m256 const xmDither)
+	{
+		__m256 value(_mm256_fmadd_ps(_mm256_sub_ps(v, xmMin), xmScale, xmDither)); // subtract first, min & v are close for large magnitude data
+		value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(float(UINT16_MAX)));
+
+		__m256i const i(_mm256_cvtps_epi32(value));
+		return(_mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+	}
+
+	static void __vectorcall quantize_row(uint16_t* const __restrict pOut, float const* const __restrict pIn, uint32_t const width, uint32_t const y, float const fMin, float const fScale, bool const dither)
+	{
+		__m256 const xmMin(_mm256_set1_ps(fMin)), xmScale(_mm256_set1_ps(fScale));
+
+		// 8x8 ordered dither, one row of the pattern per row of pixels - each iteration is 8 pixels so the pattern is aligned to the lanes
+		__m256 const xmDither(dither ? _mm256_fmsub_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((__m256i const*)(dithering::_table + ((y & 7) << 3)))), _mm256_set1_ps(1.0f / 256.0f), _mm256_set1_ps(127.5f / 256.0f))
+			                         : _mm256_setzero_ps());
+
+		uint32_t x(0);
+		for (; (x + 8) <= width; x += 8) {
+			_mm_storeu_si128((__m128i*)(pOut + x), quantize8(_mm256_loadu_ps(pIn + x), xmMin, xmScale, xmDither));
+		}
+		if (x < width) {
+
+			alignas(32) float in[8]{};
+			alignas(16) uint16_t out[8];
+
+			memcpy(in, pIn + x, (width - x) * sizeof(float));
+			_mm_store_si128((__m128i*)out, quantize8(_mm256_load_ps(in), xmMin, xmScale, xmDither));
+			memcpy(pOut + x, out, (width - x) * sizeof(uint16_t));
+		}
+	}
+} // end ns
+
+// parallel min/max of a MODE_F32 image (nan is ignored), can be cached by the caller & passed to ImagingF32ToL16
+bool const __vectorcall ImagingF32MinMax(ImagingMemoryInstance const* const __restrict pSrcImageF, double& __restrict dMin, double& __restrict dMax)
+{
+	if (!pSrcImageF || MODE_F32 != pSrcImageF->mode) {
+		return(false);
+	}
+
+	struct { // avoid lambda heap
+		float const* const* const __restrict image_in;
+		uint32_t const width;
+
+	} const p = { (float const* const*)pSrcImageF->image32, (uint32_t)pSrcImageF->xsize };
+
+	f32_ops::range const r(tbb::parallel_reduce(tbb::blocked_range<int>(0, pSrcImageF->ysize), f32_ops::range{ FLT_MAX, -FLT_MAX },
+		[&p](tbb::blocked_range<int> const& rows, f32_ops::range partial) -> f32_ops::range {
+
+			for (int y = rows.begin(); y < rows.end(); ++y) {
+				partial = f32_ops::minmax_row(p.image_in[y], p.width, partial);
+			}
+			return(partial);
+		},
+		[](f32_ops::range const a, f32_ops::range const b) -> f32_ops::range {
+			return(f32_ops::range{ SFM::min(a.fMin, b.fMin), SFM::max(a.fMax, b.fMax) });
+		}));
+
+	if (r.fMin > r.fMax) { // all nan
+		return(false);
+	}
+
+	dMin = r.fMin;
+	dMax = r.fMax;
+
+	return(true);
+}
+
+// dMin, dMax are optional - by default the range is automatically determined by the images data min/max. when both are specified (eg. from ImagingHistogramAutoLevels or a cached ImagingF32MinMax) the image is not scanned and values outside of the range are clamped.
+ImagingMemoryInstance* const __restrict __vectorcall  ImagingF32ToL16(ImagingMemoryInstance const* const __restrict pSrcImageF, double dMin, double dMax, bool const dither)
+{
+	ImagingMemoryInstance* const __restrict imageL = ImagingNew(eIMAGINGMODE::MODE_L16, pSrcImageF->xsize, pSrcImageF->ysize);
+	if (!imageL) {
+		return(nullptr);
+	}
+
+	if (dMin > dMax) { // range not specified
+
+		double dDataMin(0.0), dDataMax(0.0);
+		if (ImagingF32MinMax(pSrcImageF, dDataMin, dDataMax)) {
+			dMin = SFM::min(dMin, dDataMin);
+			dMax = SFM::max(dMax, dDataMax);
+		}
+	}
+
+	// scale in double precision, quantization in single precision relative to min
+	double const dRange(dMax - dMin);
+
+	struct { // avoid lambda heap
+		float const* const* const __restrict image_in;
+		uint16_t* const* const __restrict    image_out;
+		uint32_t const width;
+		float const fMin, fScale;
+		bool const dither;
+
+	} const p = { (float const* const*)pSrcImageF->image32, (uint16_t* const*)imageL->image32, (uint32_t)imageL->xsize,
+		          float(dMin), (dRange > 0.0 ? float(double(UINT16_MAX) / dRange) : 0.0f), dither };
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, imageL->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+		for (int y = rows.begin(); y < rows.end(); ++y) {
+			f32_ops::quantize_row(p.image_out[y], p.image_in[y], p.width, y, p.fMin, p.fScale, p.dither);
+		}
+	});
+
+	return(imageL);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLLToLA(ImagingMemoryInstance const* const __restrict pSrcImageL, ImagingMemoryInstance const* const __restrict pSrcImageA)
+{
+	int const width(pSrcImageL->xsize), height(pSrcImageL->ysize);
+
+	if (width != pSrcImageA->xsize
+		|| height != pSrcImageA->ysize) {
+
+		return(nullptr); // assume both L images passed in are the same dimensions.
+	}
+
+	Imaging returnLA(ImagingNew(MODE_LA, width, height));
+
+	uint8_t* __restrict pOut = returnLA->block;
+	uint8_t const* __restrict pInL = pSrcImageL->block;  // L
+	uint8_t const* __restrict pInA = pSrcImageA->block;  // A
+
+	uint32_t const stride = pSrcImageL->linesize; // using checked src dimensions, want iterations in bytes.
+
+	uint32_t scanline(height);
+	while (0 != scanline) {
+
+		uint32_t pixels(stride);
+		while (0 != pixels) {
+		
+			*pOut++ = *pInL++;
+			*pOut++ = *pInA++;
+
+			pixels -= 2;
+		}
+
+		--scanline;
+	}
+
+	return(returnLA);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingL16L16ToLA16(ImagingMemoryInstance const* const __restrict pSrcImageL, ImagingMemoryInstance const* const __restrict pSrcImageA)
+{
+	int const width(pSrcImageL->xsize), height(pSrcImageL->ysize);
+
+	if (width != pSrcImageA->xsize
+		|| height != pSrcImageA->ysize) {
+
+		return(nullptr); // assume both L images passed in are the same dimensions.
+	}
+
+	Imaging returnLA16(ImagingNew(MODE_LA16, width, height));
+
+	uint16_t* __restrict pOut = (uint16_t * __restrict)returnLA16->block;
+	uint16_t const* __restrict pInL16 = (uint16_t const* __restrict)pSrcImageL->block;  // L
+	uint16_t const* __restrict pInA16 = (uint16_t const* __restrict)pSrcImageA->block;  // A
+
+	uint32_t const stride = pSrcImageL->linesize; // using checked src dimensions, want iterations in bytes.
+
+	uint32_t scanline(height);
+	while (0 != scanline) {
+
+		uint32_t pixels(stride);
+		while (0 != pixels) {
+
+			*pOut++ = *pInL16++;
+			*pOut++ = *pInA16++;
+
+			pixels -= 2;
+		}
+
+		--scanline;
+	}
+
+	return(returnLA16);
+}
+// residual pixels
+STATIC_INLINE_PURE void convertRGBToBGRX(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const pixel_count)
+{
+	// compiler will optimize this simple loop //
+	for (uint32_t i = 0; i < pixel_count; ++i) {
+		dst[4 * i] = src[3 * i];
+		dst[4 * i + 1] = src[3 * i + 1];
+		dst[4 * i + 2] = src[3 * i + 2];
+		dst[4 * i + 3] = 0xff; // opaque
+	}
+}
+STATIC_INLINE_PURE void convertRGB16ToBGRX16(uint16_t* const __restrict dst, uint16_t const* const __restrict src, uint32_t const pixel_count)
+{
+	// compiler will optimize this simple loop //
+	for (uint32_t i = 0; i < pixel_count; ++i) {
+		dst[4 * i] = src[3 * i];
+		dst[4 * i + 1] = src[3 * i + 1];
+		dst[4 * i + 2] = src[3 * i + 2];
+		dst[4 * i + 3] = 0xffff; // opaque
+	}
+}
+
+void ImagingFastRGBTOBGRX(uint8_t* const __restrict blockOut, uint8_t const* const __restrict blockIn, uint32_t const width, uint32_t const height) // exposed for usage with other buffers, or direct access to two existing Imaging instances' raw data blocks
+{
+	// each line is done in parallel
+	tbb::parallel_for(uint32_t(0), height, [blockOut, blockIn, width](uint32_t const y) {
+
+		uint32_t const row(y * width);
+		convertRGBToBGRX(blockOut + row * 4, blockIn + row * 3, width);
+
+	});
+}
+void ImagingFastRGB16TOBGRX16(uint16_t* const __restrict blockOut, uint16_t const* const __restrict blockIn, uint32_t const width, uint32_t const height)
+{
+	// each line is done in parallel
+	tbb::parallel_for(uint32_t(0), height, [blockOut, blockIn, width](uint32_t const y) {
+
+		uint32_t const row(y * width);
+	    convertRGB16ToBGRX16(blockOut + row * 4, blockIn + row * 3, width);
+
+	});
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingRGBToBGRX(ImagingMemoryInstance const* const __restrict pSrcImageRGB)
+{
+	int const width(pSrcImageRGB->xsize), height(pSrcImageRGB->ysize);
+
+	Imaging returnBGRX(ImagingNew(MODE_BGRX, width, height));
+
+	ImagingFastRGBTOBGRX(returnBGRX->block, pSrcImageRGB->block, width, height);
+
+	return(returnBGRX);
+}
+
+
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingRGB16ToBGRX16(ImagingMemoryInstance const* const __restrict pSrcImageRGB16)
+{
+	int const width(pSrcImageRGB16->xsize), height(pSrcImageRGB16->ysize);
+
+	Imaging returnBGRX16(ImagingNew(MODE_BGRX16, width, height));
+
+	ImagingFastRGB16TOBGRX16(reinterpret_cast<uint16_t* const __restrict>(returnBGRX16->block), reinterpret_cast<uint16_t* const __restrict>(pSrcImageRGB16->block), width, height);
+
+	return(returnBGRX16);
+}
+
+namespace convert { // mode conversion is [depth] -> [layout] -> [depth] per row. a layout is converted at the higher integer depth of the two modes, 32 bytes of RGBA at a time (8 pixels at 8bpc, 4 pixels at 16bpc):
+					// the source pixels are expanded to RGBA w/ shuffles, luma (or a single channel) is a dot product & the RGBA is compressed to the destination w/ shuffles. depths are converted elementwise.
+					// every kernel has a scalar reference, which also completes the partial group at the end of a row.
+					// memory order is R, G, B, (A) for the color modes. U32 is an integer value, F32 is normalized (0.0f ... 1.0f) when converted to / from an integer depth of 8 or 16bpc
+
+	enum depth : uint32_t { U8, U16, U32, F32 };
+
+	typedef struct format {
+
+		uint32_t channels;	// 1 gray, 2 gray + alpha, 3 rgb, 4 rgba or rgbx
+		depth type;
+		bool alpha;			// last channel is alpha (otherwise 3 & 1 channels are opaque, the 4th channel of rgbx is unused)
+		bool bit;			// MODE_1BIT, 0 or 255
+
+	} format;
+
+	typedef struct weights { // fixed point, >> 15
+
+		int16_t  w8[4];		// 8bpc (16 bit madd), 1.0 = 32767
+		uint32_t w16[4];	// 16bpc (32 bit), 1.0 = 32768
+
+	} weights;
+
+	typedef void(__vectorcall* depth_function)(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference);
+	typedef void(__vectorcall* layout_function)(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const width, weights const& __restrict w, bool const reference);
+
+	static bool const __vectorcall describe(eIMAGINGMODE const mode, format& __restrict f)
+	{
+		switch (mode)
+		{
+		case MODE_1BIT:		f = { 1, U8, false, true };		break;
+		case MODE_L:		f = { 1, U8, false, false };	break;
+		case MODE_LA:		f = { 2, U8, true, false };		break;
+		case MODE_L16:		f = { 1, U16, false, false };	break;
+		case MODE_LA16:		f = { 2, U16, true, false };	break;
+		case MODE_U32:		f = { 1, U32, false, false };	break;
+		case MODE_F32:		f = { 1, F32, false, false };	break;
+		case MODE_RGB:		f = { 3, U8, false, false };	break;
+		case MODE_BGRX:		f = { 4, U8, false, false };	break;
+		case MODE_BGRA:		f = { 4, U8, true, false };		break;
+		case MODE_RGB16:	f = { 3, U16, false, false };	break;
+		case MODE_BGRX16:	f = { 4, U16, false, false };	break;
+		case MODE_BGRA16:	f = { 4, U16, true, false };	break;
+		default:
+			return(false); // compressed
+		}
+		return(true);
+	}
+
+	static weights const __vectorcall dot_weights(float const r, float const g, float const b, float const a)
+	{
+		float const total(r + g + b + a);
+
+		float const v[4]{ r / total, g / total, b / total, a / total };
+		int32_t q8[4], q16[4];
+		for (uint32_t i = 0; i < 4; ++i) {
+			q8[i] = int32_t(v[i] * 32767.0f + 0.5f);
+			q16[i] = int32_t(v[i] * 32768.0f + 0.5f);
+		}
+
+		// rounding can not exceed 1.0 (white stays white), the excess is taken from the largest weight
+		uint32_t const largest(uint32_t(std::max_element(v, v + 4) - v));
+		q8[largest] -= std::max(0, (q8[0] + q8[1] + q8[2] + q8[3]) - 32767);
+		q16[largest] -= std::max(0, (q16[0] + q16[1] + q16[2] + q16[3]) - 32768);
+
+		weights w{};
+		for (uint32_t i = 0; i < 4; ++i) {
+			w.w8[i] = int16_t(q8[i]);
+			w.w16[i] = uint32_t(q16[i]);
+		}
+		return(w);
+	}
+
+	static weights const __vectorcall luma_weights(eIMAGINGLUMA const luma)
+	{
+		switch (luma)
+		{
+		case LUMA_REC709:
+			return(dot_weights(0.2126f, 0.7152f, 0.0722f, 0.0f));
+		case LUMA_AVERAGE:
+			return(dot_weights(1.0f, 1.0f, 1.0f, 0.0f));
+		case LUMA_REC601:
+		default:
+			return(dot_weights(0.299f, 0.587f, 0.114f, 0.0f));
+		}
+	}
+
+	// ####################### depth (elementwise) ####################### //
+
+	STATIC_INLINE_PURE uint32_t const saturate_unorm(float const v, float const scale) // nan is 0
+	{
+		float const c(v > 0.0f ? (v < 1.0f ? v : 1.0f) : 0.0f);
+		return(uint32_t(_mm_cvtss_si32(_mm_set_ss(c * scale))));
+	}
+
+	static __m256i const __vectorcall quantize(__m256 const v, __m256 const scale)
+	{
+		return(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(1.0f)), scale))); // max returns the 2nd operand for nan
+	}
+
+	static void __vectorcall u8_to_u16(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		uint16_t* const __restrict out((uint16_t* const __restrict)dst);
+		uint32_t i(0);
+
+		if (!reference) {
+			for (; i + 16 <= count; i += 16) {
+				__m256i const v(_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const*)(src + i))));
+				_mm256_storeu_si256((__m256i*)(out + i), _mm256_or_si256(v, _mm256_slli_epi16(v, 8))); // * 257
+			}
+		}
+		for (; i < count; ++i) {
+			out[i] = uint16_t(src[i] * 257u);
+		}
+	}
+
+	static void __vectorcall u16_to_u8(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		uint16_t const* const __restrict in((uint16_t const* const __restrict)src);
+		uint32_t i(0);
+
+		if (!reference) {
+			for (; i + 16 <= count; i += 16) {
+				__m256i v(_mm256_loadu_si256((__m256i const*)(in + i)));
+				v = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mulhi_epu16(v, _mm256_set1_epi16(int16_t(0xFF01))), _mm256_set1_epi16(128)), 8); // round(v / 257)
+				_mm_storeu_si128((__m128i*)(dst + i), _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), _MM_SHUFFLE(3, 1, 2, 0))));
+			}
+		}
+		for (; i < count; ++i) {
+			dst[i] = uint8_t((((in[i] * 0xFF01u) >> 16u) + 128u) >> 8u);
+		}
+	}
+
+	static void __vectorcall u8_to_f32(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		static constexpr float const NORMALIZE(1.0f / float(UINT8_MAX));
+		float* const __restrict out((float* const __restrict)dst);
+		uint32_t i(0);
+
+		if (!reference) {
+			for (; i + 8 <= count; i += 8) {
+				_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const*)(src + i)))), _mm256_set1_ps(NORMALIZE)));
+			}
+		}
+		for (; i < count; ++i) {
+			out[i] = float(src[i]) * NORMALIZE;
+		}
+	}
+
+	static void __vectorcall u16_to_f32(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		static constexpr float const NORMALIZE(1.0f / float(UINT16_MAX));
+		uint16_t const* const __restrict in((uint16_t const* const __restrict)src);
+		float* const __restrict out((float* const __restrict)dst);
+		uint32_t i(0);
+
+		if (!reference) {
+			for (; i + 8 <= count; i += 8) {
+				_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const*)(in + i)))), _mm256_set1_ps(NORMALIZE)));
+			}
+		}
+		for (; i < count; ++i) {
+			out[i] = float(in[i]) * NORMALIZE;
+		}
+	}
+
+	static void __vectorcall f32_to_u8(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		float const* const __restrict in((float const* const __restrict)src);
+		uint32_t i(0);
+
+		if (!reference) {
+			__m256 const scale(_mm256_set1_ps(float(UINT8_MAX)));
+			for (; i + 8 <= count; i += 8) {
+				__m256i v(quantize(_mm256_loadu_ps(in + i), scale));
+				v = _mm256_packus_epi16(_mm256_packus_epi32(v, v), v);
+				_mm_storel_epi64((__m128i*)(dst + i), _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0))));
+			}
+		}
+		for (; i < count; ++i) {
+			dst[i] = uint8_t(saturate_unorm(in[i], float(UINT8_MAX)));
+		}
+	}
+
+	static void __vectorcall f32_to_u16(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		float const* const __restrict in((float const* const __restrict)src);
+		uint16_t* const __restrict out((uint16_t* const __restrict)dst);
+		uint32_t i(0);
+
+		if (!reference) {
+			__m256 const scale(_mm256_set1_ps(float(UINT16_MAX)));
+			for (; i + 8 <= count; i += 8) {
+				__m256i const v(quantize(_mm256_loadu_ps(in + i), scale));
+				_mm_storeu_si128((__m128i*)(out + i), _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), _MM_SHUFFLE(3, 1, 2, 0))));
+			}
+		}
+		for (; i < count; ++i) {
+			out[i] = uint16_t(saturate_unorm(in[i], float(UINT16_MAX)));
+		}
+	}
+
+	static void __vectorcall u8_to_u32(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		uint32_t* const __restrict out((uint32_t* const __restrict)dst);
+		uint32_t i(0);
+
+		if (!reference) {
+			for (; i + 8 <= count; i += 8) {
+				_mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const*)(src + i))));
+			}
+		}
+		for (; i < count; ++i) {
+			out[i] = src[i];
+		}
+	}
+
+	static void __vectorcall u16_to_u32(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		uint16_t const* const __restrict in((uint16_t const* const __restrict)src);
+		uint32_t* const __restrict out((uint32_t* const __restrict)dst);
+		uint32_t i(0);
+
+		if (!reference) {
+			for (; i + 8 <= count; i += 8) {
+				_mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const*)(in + i))));
+			}
+		}
+		for (; i < count; ++i) {
+			out[i] = in[i];
+		}
+	}
+
+	static void __vectorcall u32_to_u8(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		uint32_t const* const __restrict in((uint32_t const* const __restrict)src);
+		uint32_t i(0);
+
+		if (!reference) {
+			for (; i + 8 <= count; i += 8) {
+				__m256i v(_mm256_min_epu32(_mm256_loadu_si256((__m256i const*)(in + i)), _mm256_set1_epi32(UINT8_MAX)));
+				v = _mm256_packus_epi16(_mm256_packus_epi32(v, v), v);
+				_mm_storel_epi64((__m128i*)(dst + i), _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0))));
+			}
+		}
+		for (; i < count; ++i) {
+			dst[i] = uint8_t(std::min(in[i], uint32_t(UINT8_MAX)));
+		}
+	}
+
+	static void __vectorcall u32_to_u16(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		uint32_t const* const __restrict in((uint32_t const* const __restrict)src);
+		uint16_t* const __restrict out((uint16_t* const __restrict)dst);
+		uint32_t i(0);
+
+		if (!reference) {
+			for (; i + 8 <= count; i += 8) {
+				__m256i const v(_mm256_min_epu32(_mm256_loadu_si256((__m256i const*)(in + i)), _mm256_set1_epi32(UINT16_MAX)));
+				_mm_storeu_si128((__m128i*)(out + i), _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), _MM_SHUFFLE(3, 1, 2, 0))));
+			}
+		}
+		for (; i < count; ++i) {
+			out[i] = uint16_t(std::min(in[i], uint32_t(UINT16_MAX)));
+		}
+	}
+
+	static void __vectorcall u32_to_f32(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		uint32_t const* const __restrict in((uint32_t const* const __restrict)src);
+		float* const __restrict out((float* const __restrict)dst);
+		uint32_t i(0);
+
+		if (!reference) {
+			for (; i + 8 <= count; i += 8) {
+				__m256i const v(_mm256_loadu_si256((__m256i const*)(in + i)));
+				__m256 const hi(_mm256_cvtepi32_ps(_mm256_srli_epi32(v, 16))), lo(_mm256_cvtepi32_ps(_mm256_and_si256(v, _mm256_set1_epi32(0xFFFF))));
+				_mm256_storeu_ps(out + i, _mm256_fmadd_ps(hi, _mm256_set1_ps(65536.0f), lo)); // unsigned, single rounding
+			}
+		}
+		for (; i < count; ++i) {
+			out[i] = float(in[i]);
+		}
+	}
+
+	static void __vectorcall f32_to_u32(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const count, bool const reference)
+	{
+		static constexpr float const MAX_U32(4294967040.0f), // largest float < 2^32
+									 SIGN(2147483648.0f);
+		float const* const __restrict in((float const* const __restrict)src);
+		uint32_t* const __restrict out((uint32_t* const __restrict)dst);
+		uint32_t i(0);
+
+		if (!reference) {
+			for (; i + 8 <= count; i += 8) {
+				__m256 v(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), _mm256_setzero_ps()), _mm256_set1_ps(MAX_U32)));
+				__m256 const high(_mm256_cmp_ps(v, _mm256_set1_ps(SIGN), _CMP_GE_OQ));
+				v = _mm256_sub_ps(v, _mm256_and_ps(high, _mm256_set1_ps(SIGN)));
+				_mm256_storeu_si256((__m256i*)(out + i), _mm256_xor_si256(_mm256_cvtps_epi32(v), _mm256_slli_epi32(_mm256_castps_si256(high), 31)));
+			}
+		}
+		for (; i < count; ++i) {
+			float const v(in[i] > 0.0f ? (in[i] < MAX_U32 ? in[i] : MAX_U32) : 0.0f);
+			out[i] = uint32_t(std::nearbyint(double(v)));
+		}
+	}
+
+	static depth_function const __vectorcall select_depth(depth const from, depth const to)
+	{
+		static constexpr depth_function const table[4][4]{
+			//  U8			U16			U32			F32				<- to
+			{ nullptr,		&u8_to_u16,	&u8_to_u32,	&u8_to_f32 },	// U8
+			{ &u16_to_u8,	nullptr,	&u16_to_u32,&u16_to_f32 },	// U16
+			{ &u32_to_u8,	&u32_to_u16,nullptr,	&u32_to_f32 },	// U32
+			{ &f32_to_u8,	&f32_to_u16,&f32_to_u32,nullptr },		// F32
+		};
+		return(table[from][to]);
+	}
+
+	static void __vectorcall threshold(uint8_t* const __restrict row, uint32_t const width, bool const reference) // MODE_1BIT
+	{
+		uint32_t x(0);
+
+		if (!reference) {
+			for (; x + 32 <= width; x += 32) {
+				__m256i const v(_mm256_loadu_si256((__m256i const*)(row + x)));
+				_mm256_storeu_si256((__m256i*)(row + x), _mm256_cmpgt_epi8(_mm256_setzero_si256(), v)); // >= 128 (signed negative)
+			}
+		}
+		for (; x < width; ++x) {
+			row[x] = (row[x] >= 128) ? UINT8_MAX : 0;
+		}
+	}
+
+	// ####################### layout (canonical RGBA) ####################### //
+
+	template<typename T>
+	STATIC_INLINE_PURE __m256i const __vectorcall opaque()
+	{
+		if constexpr (sizeof(uint8_t) == sizeof(T)) {
+			return(_mm256_set1_epi32(int32_t(0xFF000000)));
+		}
+		else {
+			return(_mm256_set1_epi64x(int64_t(0xFFFF000000000000)));
+		}
+	}
+
+	// channels * 8 bytes in, 32 bytes of RGBA out. gray is replicated to RGB, alpha is undefined when the source has no alpha
+	template<typename T, uint32_t const channels>
+	STATIC_INLINE_PURE __m256i const __vectorcall expand(uint8_t const* const __restrict src)
+	{
+		if constexpr (4 == channels) {
+			return(_mm256_loadu_si256((__m256i const*)src));
+		}
+		else if constexpr (3 == channels) { // low lane bytes 0...11, high lane bytes 12...23 (as 4...15 of the upper load)
+			__m256i const v(_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((__m128i const*)src)), _mm_loadu_si128((__m128i const*)(src + 8)), 1));
+			if constexpr (sizeof(uint8_t) == sizeof(T)) {
+				return(_mm256_shuffle_epi8(v, _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+															   4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1)));
+			}
+			else {
+				return(_mm256_shuffle_epi8(v, _mm256_setr_epi8(0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, -1, -1,
+															   4, 5, 6, 7, 8, 9, -1, -1, 10, 11, 12, 13, 14, 15, -1, -1)));
+			}
+		}
+		else if constexpr (2 == channels) {
+			__m256i const v(_mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i const*)src)));
+			if constexpr (sizeof(uint8_t) == sizeof(T)) {
+				return(_mm256_shuffle_epi8(v, _mm256_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7,
+															   8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15)));
+			}
+			else {
+				return(_mm256_shuffle_epi8(v, _mm256_setr_epi8(0, 1, 0, 1, 0, 1, 2, 3, 4, 5, 4, 5, 4, 5, 6, 7,
+															   8, 9, 8, 9, 8, 9, 10, 11, 12, 13, 12, 13, 12, 13, 14, 15)));
+			}
+		}
+		else {
+			__m256i const v(_mm256_broadcastsi128_si256(_mm_loadl_epi64((__m128i const*)src)));
+			if constexpr (sizeof(uint8_t) == sizeof(T)) {
+				return(_mm256_shuffle_epi8(v, _mm256_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1,
+															   4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1)));
+			}
+			else {
+				return(_mm256_shuffle_epi8(v, _mm256_setr_epi8(0, 1, 0, 1, 0, 1, -1, -1, 2, 3, 2, 3, 2, 3, -1, -1,
+															   4, 5, 4, 5, 4, 5, -1, -1, 6, 7, 6, 7, 6, 7, -1, -1)));
+			}
+		}
+	}
+
+	// 32 bytes of RGBA in, channels * 8 bytes out. gray is R, gray + alpha is R & A
+	template<typename T, uint32_t const channels>
+	STATIC_INLINE_PURE void __vectorcall compress(uint8_t* const __restrict dst, __m256i const v)
+	{
+		if constexpr (4 == channels) {
+			_mm256_storeu_si256((__m256i*)dst, v);
+		}
+		else if constexpr (3 == channels) { // 12 bytes per lane, packed to 24
+			__m256i const rgb(sizeof(uint8_t) == sizeof(T) ? _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1)
+														   : _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1, 0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1));
+			__m256i const packed(_mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, rgb), _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7)));
+			_mm_storeu_si128((__m128i*)dst, _mm256_castsi256_si128(packed));
+			_mm_storel_epi64((__m128i*)(dst + 16), _mm256_extracti128_si256(packed, 1));
+		}
+		else if constexpr (2 == channels) { // 8 bytes per lane, packed to 16
+			__m256i const ga(sizeof(uint8_t) == sizeof(T) ? _mm256_setr_epi8(0, 3, 4, 7, 8, 11, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 4, 7, 8, 11, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1)
+														  : _mm256_setr_epi8(0, 1, 6, 7, 8, 9, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 6, 7, 8, 9, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1));
+			_mm_storeu_si128((__m128i*)dst, _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, ga), _MM_SHUFFLE(3, 1, 2, 0))));
+		}
+		else { // 4 bytes per lane, packed to 8
+			__m256i const g(sizeof(uint8_t) == sizeof(T) ? _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)
+														 : _mm256_setr_epi8(0, 1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+			_mm_storel_epi64((__m128i*)dst, _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, g), _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0))));
+		}
+	}
+
+	// R = dot(RGBA, weights), A is preserved. G & B are undefined
+	template<typename T>
+	STATIC_INLINE_PURE __m256i const __vectorcall dot(__m256i const v, __m256i const alpha, __m256i const w)
+	{
+		if constexpr (sizeof(uint8_t) == sizeof(T)) { // 16 bit madd, (r * wr + g * wg) + (b * wb + a * wa) per pixel in the low dword of each qword
+			__m256i lo(_mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)), w)),		// pixels 0...3
+					hi(_mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)), w));	// pixels 4...7
+			lo = _mm256_add_epi32(lo, _mm256_srli_epi64(lo, 32));
+			hi = _mm256_add_epi32(hi, _mm256_srli_epi64(hi, 32));
+
+			__m256i y(_mm256_permutevar8x32_epi32(_mm256_blend_epi32(lo, _mm256_slli_epi64(hi, 32), 0xAA), _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7)));
+			y = _mm256_srli_epi32(_mm256_add_epi32(y, _mm256_set1_epi32(1 << 14)), 15);
+
+			return(_mm256_or_si256(y, _mm256_and_si256(v, alpha)));
+		}
+		else { // 32 bit, 2 pixels per register
+			__m256i const lo(_mm256_mullo_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(v)), w)),		// pixels 0, 1
+						  hi(_mm256_mullo_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1)), w));	// pixels 2, 3
+			__m256i s(_mm256_hadd_epi32(lo, hi));
+			s = _mm256_hadd_epi32(s, s); // [ y0 y2 y0 y2 | y1 y3 y1 y3 ]
+			s = _mm256_srli_epi32(_mm256_add_epi32(s, _mm256_set1_epi32(1 << 14)), 15);
+
+			__m256i const y(_mm256_permutevar8x32_epi32(s, _mm256_setr_epi32(0, 0, 4, 4, 1, 1, 5, 5)));
+			return(_mm256_or_si256(_mm256_and_si256(y, _mm256_set1_epi64x(0xFFFF)), _mm256_and_si256(v, alpha)));
+		}
+	}
+
+	template<typename T, uint32_t const src_channels, bool const src_alpha, uint32_t const dst_channels, bool const dot_product>
+	static void __vectorcall layout_reference(T* __restrict dst, T const* __restrict src, uint32_t const count, weights const& __restrict w)
+	{
+		static constexpr uint32_t const OPAQUE(std::numeric_limits<T>::max());
+
+		for (uint32_t i = 0; i < count; ++i, src += src_channels, dst += dst_channels) {
+
+			uint32_t c[4];
+			if constexpr (src_channels <= 2) {
+				c[0] = c[1] = c[2] = src[0];
+				c[3] = (2 == src_channels) ? src[1] : OPAQUE;
+			}
+			else {
+				c[0] = src[0]; c[1] = src[1]; c[2] = src[2];
+				c[3] = (4 == src_channels && src_alpha) ? src[3] : OPAQUE;
+			}
+
+			if constexpr (dot_product) {
+				if constexpr (sizeof(uint8_t) == sizeof(T)) {
+					c[0] = uint32_t(int32_t(c[0]) * w.w8[0] + int32_t(c[1]) * w.w8[1] + int32_t(c[2]) * w.w8[2] + int32_t(c[3]) * w.w8[3] + (1 << 14)) >> 15;
+				}
+				else {
+					c[0] = (c[0] * w.w16[0] + c[1] * w.w16[1] + c[2] * w.w16[2] + c[3] * w.w16[3] + (1u << 14u)) >> 15u;
+				}
+			}
+
+			dst[0] = T(c[0]);
+			if constexpr (2 == dst_channels) {
+				dst[1] = T(c[3]);
+			}
+			else if constexpr (dst_channels >= 3) {
+				dst[1] = T(c[1]); dst[2] = T(c[2]);
+				if constexpr (4 == dst_channels) {
+					dst[3] = T(c[3]);
+				}
+			}
+		}
+	}
+
+	template<typename T, uint32_t const src_channels, bool const src_alpha, uint32_t const dst_channels, bool const dot_product>
+	static void __vectorcall layout_row(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const width, weights const& __restrict w, bool const reference)
+	{
+		static constexpr uint32_t const GROUP(32 / (4 * sizeof(T))); // pixels per 32 bytes of RGBA
+		uint32_t x(0);
+
+		if (!reference) {
+			__m256i const alpha(opaque<T>());
+			__m256i const weight(sizeof(uint8_t) == sizeof(T) ? _mm256_setr_epi16(w.w8[0], w.w8[1], w.w8[2], w.w8[3], w.w8[0], w.w8[1], w.w8[2], w.w8[3], w.w8[0], w.w8[1], w.w8[2], w.w8[3], w.w8[0], w.w8[1], w.w8[2], w.w8[3])
+															  : _mm256_setr_epi32(w.w16[0], w.w16[1], w.w16[2], w.w16[3], w.w16[0], w.w16[1], w.w16[2], w.w16[3]));
+
+			for (; x + GROUP <= width; x += GROUP) {
+
+				__m256i v(expand<T, src_channels>(src + x * src_channels * sizeof(T)));
+				if constexpr (!src_alpha) {
+					v = _mm256_or_si256(v, alpha);
+				}
+				if constexpr (dot_product) {
+					v = dot<T>(v, alpha, weight);
+				}
+				compress<T, dst_channels>(dst + x * dst_channels * sizeof(T), v);
+			}
+		}
+
+		layout_reference<T, src_channels, src_alpha, dst_channels, dot_product>((T*)(dst + x * dst_channels * sizeof(T)), (T const*)(src + x * src_channels * sizeof(T)), width - x, w);
+	}
+
+	template<typename T, uint32_t const src_channels, bool const src_alpha>
+	static layout_function const __vectorcall select_layout(uint32_t const dst_channels, bool const dot_product)
+	{
+		switch (dst_channels)
+		{
+		case 1:
+			return(dot_product ? &layout_row<T, src_channels, src_alpha, 1, true> : &layout_row<T, src_channels, src_alpha, 1, false>);
+		case 2:
+			return(dot_product ? &layout_row<T, src_channels, src_alpha, 2, true> : &layout_row<T, src_channels, src_alpha, 2, false>);
+		case 3:
+			return(&layout_row<T, src_channels, src_alpha, 3, false>);
+		default:
+			return(&layout_row<T, src_channels, src_alpha, 4, false>);
+		}
+	}
+
+	template<typename T>
+	static layout_function const __vectorcall select_layout(format const& __restrict source, uint32_t const dst_channels, bool const dot_product)
+	{
+		switch (source.channels)
+		{
+		case 1:
+			return(select_layout<T, 1, false>(dst_channels, dot_product));
+		case 2:
+			return(select_layout<T, 2, true>(dst_channels, dot_product));
+		case 3:
+			return(select_layout<T, 3, false>(dst_channels, dot_product));
+		default:
+			return(source.alpha ? select_layout<T, 4, true>(dst_channels, dot_product) : select_layout<T, 4, false>(dst_channels, dot_product));
+		}
+	}
+
+	STATIC_INLINE_PURE bool const integer(depth const d) { return(U8 == d || U16 == d); }
+	STATIC_INLINE_PURE uint32_t const size_of(depth const d) { return(U8 == d ? 1 : (U16 == d ? 2 : 4)); }
+
+	// extract = true, the destination is gray w/ the channel selected by the weights
+	static void __vectorcall run(ImagingMemoryInstance* const __restrict imOut, ImagingMemoryInstance const* const __restrict imIn, format const& __restrict source, format const& __restrict target,
+								 weights const& __restrict w, bool const extract, bool const reference)
+	{
+		bool const layout(extract || source.channels != target.channels || (4 == source.channels && source.alpha != target.alpha));
+
+		depth working(source.type); // depth the layout is converted at
+		if (layout) {
+			if (integer(source.type) && integer(target.type)) {
+				working = (depth)std::max(source.type, target.type);
+			}
+			else if (!integer(source.type)) {
+				working = target.type;
+			}
+		}
+
+		struct { // avoid lambda heap
+			uint8_t const* const* const __restrict image_in;
+			uint8_t* const* const __restrict image_out;
+			depth_function const in, out;
+			layout_function const layout;
+			weights const& __restrict w;
+			uint32_t const width, source_channels, target_channels;
+			size_t const linesize, buffer;	// bytes
+			bool const bit, reference;
+
+		} const p = { imIn->image, imOut->image,
+					  select_depth(source.type, working), select_depth(working, target.type),
+					  layout ? (U8 == working ? select_layout<uint8_t>(source, target.channels, extract || (source.channels >= 3 && target.channels <= 2))
+											  : select_layout<uint16_t>(source, target.channels, extract || (source.channels >= 3 && target.channels <= 2))) : nullptr,
+					  w, (uint32_t)imIn->xsize, source.channels, target.channels,
+					  (size_t)imOut->linesize, size_t(imIn->xsize) * 4 * sizeof(uint16_t),
+					  target.bit, reference };
+
+		tbb::parallel_for(tbb::blocked_range<int>(0, imIn->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+			uint8_t* const __restrict buffer((p.in || (p.layout && p.out)) ? (uint8_t*)scalable_malloc(p.buffer * 2) : nullptr);
+
+			for (int y = rows.begin(); y < rows.end(); ++y) {
+
+				uint8_t const* __restrict row(p.image_in[y]);
+				uint8_t* const __restrict out(p.image_out[y]);
+
+				if (p.in) {
+					p.in(buffer, row, p.width * p.source_channels, p.reference);
+					row = buffer;
+				}
+				if (p.layout) {
+					uint8_t* const __restrict to(p.out ? buffer + p.buffer : out);
+					p.layout(to, row, p.width, p.w, p.reference);
+					row = to;
+				}
+				if (p.out) {
+					p.out(out, row, p.width * p.target_channels, p.reference);
+					row = out;
+				}
+				if (row != out) { // 1bit <-> 8bit gray
+					memcpy(out, row, p.linesize);
+				}
+				if (p.bit) {
+					threshold(out, p.width, p.reference);
+				}
+			}
+
+			if (buffer) {
+				scalable_free(buffer);
+			}
+		});
+	}
+
+} // end ns
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingConvert(ImagingMemoryInstance const* const __restrict im, eIMAGINGMODE const mode, eIMAGINGLUMA const luma, bool const reference)
+{
+	if (!im) {
+		return(nullptr);
+	}
+
+	convert::format source, target;
+	if (!convert::describe(im->mode, source) || !convert::describe(mode, target)) {
+		return (Imaging)ImagingError_ModeError();
+	}
+
+	if (im->mode == mode) {
+		return(ImagingCopy(im));
+	}
+
+	Imaging const imOut(ImagingNew(mode, im->xsize, im->ysize));
+	if (!imOut) {
+		return(nullptr);
+	}
+
+	convert::run(imOut, im, source, target, convert::luma_weights(luma), false, reference);
+
+	return(imOut);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingExtractChannel(ImagingMemoryInstance const* const __restrict im, uint32_t const channel, bool const reference)
+{
+	if (!im) {
+		return(nullptr);
+	}
+
+	convert::format source;
+	if (!convert::describe(im->mode, source) || !convert::integer(source.type)) {
+		return (Imaging)ImagingError_ModeError();
+	}
+
+	uint32_t const channels((4 == source.channels && !source.alpha) ? 3 : source.channels); // x is unused
+	if (channel >= channels) {
+		return (Imaging)ImagingError_ValueError("channel out of range");
+	}
+
+	convert::format const target{ 1, source.type, false, false };
+
+	Imaging const imOut(ImagingNew(convert::U8 == source.type ? MODE_L : MODE_L16, im->xsize, im->ysize));
+	if (!imOut) {
+		return(nullptr);
+	}
+
+	uint32_t const slot((2 == source.channels && 1 == channel) ? 3 : channel); // gray + alpha expands to (g, g, g, a)
+	convert::run(imOut, im, source, target, convert::dot_weights(float(0 == slot), float(1 == slot), float(2 == slot), float(3 == slot)), true, reference);
+
+	return(imOut);
+}
+
+namespace merge { // single channel planes interleaved to one image, the inverse of ImagingExtractChannel. AVX2 32 pixels per iteration at 8bpc, the scalar path completes the row (and is the reference)
+
+	typedef void(__vectorcall* row_function)(uint8_t* const __restrict dst, uint8_t const* const* const __restrict src, uint32_t const width, bool const reference);
+
+	template<typename T, uint32_t const channels, uint32_t const planes>
+	static void __vectorcall row_scalar(T* const __restrict out, T const* const* const __restrict in, uint32_t const begin, uint32_t const width)
+	{
+		for (uint32_t x = begin; x < width; ++x) {
+			for (uint32_t c = 0; c < planes; ++c) {
+				out[x * channels + c] = in[c][x];
+			}
+			if constexpr (planes < channels) { // unused x channel is opaque
+				out[x * channels + (channels - 1)] = T(~T(0));
+			}
+		}
+	}
+
+	template<typename T, uint32_t const channels, uint32_t const planes>
+	static void __vectorcall row(uint8_t* const __restrict dst, uint8_t const* const* const __restrict src, uint32_t const width, bool const reference)
+	{
+		uint32_t x(0);
+
+		if constexpr (1 == sizeof(T)) {
+			if (!reference) {
+				for (; x + 32 <= width; x += 32) {
+
+					__m256i const c0(_mm256_loadu_si256((__m256i const*)(src[0] + x))), c1(_mm256_loadu_si256((__m256i const*)(src[1] + x)));
+
+					if constexpr (2 == channels) {
+						__m256i const lo(_mm256_unpacklo_epi8(c0, c1)), hi(_mm256_unpackhi_epi8(c0, c1)); // pixels 0-7 | 16-23, 8-15 | 24-31
+
+						_mm256_storeu_si256((__m256i*)(dst + x * 2), _mm256_permute2x128_si256(lo, hi, 0x20));
+						_mm256_storeu_si256((__m256i*)(dst + x * 2 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+					}
+					else {
+						__m256i const c2(_mm256_loadu_si256((__m256i const*)(src[2] + x)));
+						__m256i const c3(planes < channels ? _mm256_set1_epi8(-1) : _mm256_loadu_si256((__m256i const*)(src[3] + x)));
+
+						__m256i const lo01(_mm256_unpacklo_epi8(c0, c1)), hi01(_mm256_unpackhi_epi8(c0, c1)),
+									  lo23(_mm256_unpacklo_epi8(c2, c3)), hi23(_mm256_unpackhi_epi8(c2, c3));
+
+						__m256i const p0(_mm256_unpacklo_epi16(lo01, lo23)), p1(_mm256_unpackhi_epi16(lo01, lo23)), // pixels 0-3 | 16-19, 4-7 | 20-23
+									  p2(_mm256_unpacklo_epi16(hi01, hi23)), p3(_mm256_unpackhi_epi16(hi01, hi23)); // pixels 8-11 | 24-27, 12-15 | 28-31
+
+						_mm256_storeu_si256((__m256i*)(dst + x * 4), _mm256_permute2x128_si256(p0, p1, 0x20));
+						_mm256_storeu_si256((__m256i*)(dst + x * 4 + 32), _mm256_permute2x128_si256(p2, p3, 0x20));
+						_mm256_storeu_si256((__m256i*)(dst + x * 4 + 64), _mm256_permute2x128_si256(p0, p1, 0x31));
+						_mm256_storeu_si256((__m256i*)(dst + x * 4 + 96), _mm256_permute2x128_si256(p2, p3, 0x31));
+					}
+				}
+			}
+		}
+
+		row_scalar<T, channels, planes>((T*)dst, (T const* const*)src, x, width);
+	}
+
+	static row_function const __vectorcall select(eIMAGINGMODE const mode, uint32_t const planes)
+	{
+		switch (mode)
+		{
+		case MODE_LA:		return(2 == planes ? &row<uint8_t, 2, 2> : nullptr);
+		case MODE_BGRX:		return(3 == planes ? &row<uint8_t, 4, 3> : nullptr);
+		case MODE_BGRA:		return(4 == planes ? &row<uint8_t, 4, 4> : nullptr);
+		case MODE_LA16:		return(2 == planes ? &row<uint16_t, 2, 2> : nullptr);
+		case MODE_BGRX16:	return(3 == planes ? &row<uint16_t, 4, 3> : nullptr);
+		case MODE_BGRA16:	return(4 == planes ? &row<uint16_t, 4, 4> : nullptr);
+		default:
+			return(nullptr);
+		}
+	}
+
+} // end ns
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingMergeChannels(eIMAGINGMODE const mode, ImagingMemoryInstance const* const* const __restrict planes, uint32_t const count, bool const reference)
+{
+	if (!planes || 0 == count || count > 4) {
+		return(nullptr);
+	}
+
+	merge::row_function const row(merge::select(mode, count));
+	if (!row) {
+		return (Imaging)ImagingError_ModeError();
+	}
+
+	eIMAGINGMODE const plane_mode((MODE_LA | MODE_BGRX | MODE_BGRA) & mode ? MODE_L : MODE_L16);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		if (!planes[i]) {
+			return(nullptr);
+		}
+		if (plane_mode != planes[i]->mode) {
+			return (Imaging)ImagingError_ModeError();
+		}
+		if (planes[i]->xsize != planes[0]->xsize || planes[i]->ysize != planes[0]->ysize) {
+			return (Imaging)ImagingError_Mismatch();
+		}
+	}
+
+	Imaging const imOut(ImagingNew(mode, planes[0]->xsize, planes[0]->ysize));
+	if (!imOut) {
+		return(nullptr);
+	}
+
+	struct { // avoid lambda heap
+		ImagingMemoryInstance const* const* const __restrict planes;
+		uint8_t* const* const __restrict image_out;
+		merge::row_function const row;
+		uint32_t const count, width;
+		bool const reference;
+
+	} const p = { planes, imOut->image, row, count, (uint32_t)imOut->xsize, reference };
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, imOut->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+		uint8_t const* src[4]{};
+
+		for (int y = rows.begin(); y < rows.end(); ++y) {
+
+			for (uint32_t i = 0; i < p.count; ++i) {
+				src[i] = p.planes[i]->image[y];
+			}
+			p.row(p.image_out[y], src, p.width, p.reference);
+		}
+	});
+
+	return(imOut);
+}
+
+namespace color_space { // whole image srgb <-> linear & linear <-> OKLAB, AVX2 8 elements (or pixels) per iteration, rows in parallel.
+						// srgb8 -> linear16 is a gather from a 16bit table, linear16 -> srgb8 gathers & interpolates a 4096 step table (error < 0.005 of an 8bit step) w/ optional ordered dither.
+						// OKLAB (https://bottosson.github.io/posts/oklab) is stored in 16bit as L, a + 0.5, b + 0.5 or unscaled in F32 planes
+
+	static constexpr uint32_t const SRGB_STEPS = 4096;
+	static constexpr float const NORMALIZE_16BIT = 1.0f / float(UINT16_MAX),
+								 DENORMALIZE_16BIT = float(UINT16_MAX),
+								 AB_BIAS = 0.5f; // a & b are within -0.5 ... +0.5 for all colors in the srgb gamut
+
+	typedef struct tables {
+
+		alignas(64) uint32_t to_linear[512];				// srgb8 -> linear16, 256...511 is linear (alpha)
+		alignas(64) float    to_srgb[SRGB_STEPS + 1];		// linear (i / SRGB_STEPS) -> srgb8, unrounded
+
+		tables()
+		{
+			for (uint32_t i = 0; i < 256; ++i) {
+				double const srgb(double(i) / double(UINT8_MAX));
+				double const linear(srgb <= 0.04045 ? srgb / 12.92 : std::pow((srgb + 0.055) / 1.055, 2.4));
+				to_linear[i] = uint32_t(linear * double(UINT16_MAX) + 0.5);
+				to_linear[256 + i] = i * 257u;
+			}
+			for (uint32_t i = 0; i <= SRGB_STEPS; ++i) {
+				double const linear(double(i) / double(SRGB_STEPS));
+				double const srgb(linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055);
+				to_srgb[i] = float(srgb * double(UINT8_MAX));
+			}
+		}
+	} tables;
+
+	static tables const& __vectorcall get_tables()
+	{
+		static tables const t;
+		return(t);
+	}
+
+	// per element pattern of a row, repeats every 8 pixels (8 * channels elements, a multiple of the 8 lanes)
+	typedef struct pattern {
+
+		alignas(32) int32_t offset[32];	// table offset, 256 for alpha
+		alignas(32) int32_t alpha[32];	// -1 for alpha (linear)
+		alignas(32) float   dither[32];	// -0.5 ... +0.5 lsb, 0 for alpha
+		uint32_t period;
+
+	} pattern;
+
+	static void __vectorcall make_pattern(pattern& __restrict p, uint32_t const channels, bool const alpha, uint32_t const y, bool const dither)
+	{
+		p.period = 8 * channels;
+		for (uint32_t k = 0; k < p.period; ++k) {
+			bool const is_alpha(alpha && (channels - 1) == (k % channels));
+			p.offset[k] = is_alpha ? 256 : 0;
+			p.alpha[k] = is_alpha ? -1 : 0;
+			p.dither[k] = (dither && !is_alpha) ? (float(dithering::_table[((y & 7) << 3) + k / channels]) - 127.5f) / 256.0f : 0.0f;
+		}
+	}
+
+	static __inline void __vectorcall srgb_to_linear8(uint16_t* const __restrict out, uint8_t const* const __restrict in, int32_t const* const __restrict offset, uint32_t const* const __restrict to_linear)
+	{
+		__m256i const index(_mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const*)in)), _mm256_load_si256((__m256i const*)offset)));
+		__m256i const linear(_mm256_i32gather_epi32((int const*)to_linear, index, sizeof(uint32_t)));
+
+		_mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi32(linear, linear), _MM_SHUFFLE(3, 1, 2, 0))));
+	}
+
+	static void __vectorcall srgb_to_linear_row(uint16_t* const __restrict out, uint8_t const* const __restrict in, uint32_t const count, pattern const& __restrict p, uint32_t const* const __restrict to_linear)
+	{
+		uint32_t i(0);
+		for (; (i + 8) <= count; i += 8) {
+			srgb_to_linear8(out + i, in + i, p.offset + (i % p.period), to_linear);
+		}
+		if (i < count) {
+
+			alignas(16) uint8_t  src[16]{};
+			alignas(16) uint16_t dst[8];
+
+			memcpy(src, in + i, count - i);
+			srgb_to_linear8(dst, src, p.offset + (i % p.period), to_linear);
+			memcpy(out + i, dst, (count - i) * sizeof(uint16_t));
+		}
+	}
+
+	static __inline void __vectorcall linear_to_srgb8(uint8_t* const __restrict out, uint16_t const* const __restrict in, int32_t const* const __restrict alpha, float const* const __restrict dither, float const* const __restrict to_srgb)
+	{
+		__m256 const v(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const*)in))));
+
+		__m256 const x(_mm256_mul_ps(v, _mm256_set1_ps(float(SRGB_STEPS) * NORMALIZE_16BIT)));
+		__m256i const index(_mm256_min_epi32(_mm256_cvttps_epi32(x), _mm256_set1_epi32(SRGB_STEPS - 1)));
+		__m256 const t0(_mm256_i32gather_ps(to_srgb, index, sizeof(float))), t1(_mm256_i32gather_ps(to_srgb + 1, index, sizeof(float)));
+
+		__m256 srgb(_mm256_fmadd_ps(_mm256_sub_ps(x, _mm256_cvtepi32_ps(index)), _mm256_sub_ps(t1, t0), t0));
+		srgb = _mm256_blendv_ps(srgb, _mm256_mul_ps(v, _mm256_set1_ps(float(UINT8_MAX) * NORMALIZE_16BIT)), _mm256_castsi256_ps(_mm256_load_si256((__m256i const*)alpha)));
+		srgb = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(srgb, _mm256_load_ps(dither)), _mm256_setzero_ps()), _mm256_set1_ps(float(UINT8_MAX)));
+
+		__m256i q(_mm256_cvtps_epi32(srgb));
+		q = _mm256_packus_epi16(_mm256_packus_epi32(q, q), q);
+		_mm_storel_epi64((__m128i*)out, _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(q, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0))));
+	}
+
+	static void __vectorcall linear_to_srgb_row(uint8_t* const __restrict out, uint16_t const* const __restrict in, uint32_t const count, pattern const& __restrict p, float const* const __restrict to_srgb)
+	{
+		uint32_t i(0);
+		for (; (i + 8) <= count; i += 8) {
+			uint32_t const k(i % p.period);
+			linear_to_srgb8(out + i, in + i, p.alpha + k, p.dither + k, to_srgb);
+		}
+		if (i < count) {
+
+			alignas(16) uint16_t src[8]{};
+			alignas(16) uint8_t  dst[8];
+
+			uint32_t const k(i % p.period);
+			memcpy(src, in + i, (count - i) * sizeof(uint16_t));
+			linear_to_srgb8(dst, src, p.alpha + k, p.dither + k, to_srgb);
+			memcpy(out + i, dst, count - i);
+		}
+	}
+
+	// 8 pixels of 16bpc RGBA to / from 4 vectors of 32bit components
+	static __inline void __vectorcall load8(uint16_t const* const __restrict src, __m256i& __restrict r, __m256i& __restrict g, __m256i& __restrict b, __m256i& __restrict a)
+	{
+		__m256i const pair(_mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15)); // [ r0 g0 b0 a0 r1 g1 b1 a1 ] <-> [ r0 r1 g0 g1 b0 b1 a0 a1 ]
+		__m256i const order(_mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+
+		__m256i const lo(_mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256((__m256i const*)src), pair), order)),		 // [ r0...3 g0...3 | b0...3 a0...3 ]
+					  hi(_mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256((__m256i const*)(src + 16)), pair), order)); // [ r4...7 g4...7 | b4...7 a4...7 ]
+		__m256i const rb(_mm256_unpacklo_epi64(lo, hi)), ga(_mm256_unpackhi_epi64(lo, hi));
+
+		r = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(rb));
+		b = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(rb, 1));
+		g = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(ga));
+		a = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(ga, 1));
+	}
+	static __inline void __vectorcall store8(uint16_t* const __restrict dst, __m256i const r, __m256i const g, __m256i const b, __m256i const a) // saturated
+	{
+		__m256i const pair(_mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15));
+
+		__m256i const rg(_mm256_shuffle_epi8(_mm256_packus_epi32(r, g), pair)), ba(_mm256_shuffle_epi8(_mm256_packus_epi32(b, a), pair));
+		__m256i const lo(_mm256_unpacklo_epi32(rg, ba)), hi(_mm256_unpackhi_epi32(rg, ba)); // [ px0 px1 | px4 px5 ], [ px2 px3 | px6 px7 ]
+
+		_mm256_storeu_si256((__m256i*)dst, _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i*)(dst + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+
+	STATIC_INLINE_PURE __m256 const __vectorcall normalize(__m256i const v) { return(_mm256_mul_ps(_mm256_cvtepi32_ps(v), _mm256_set1_ps(NORMALIZE_16BIT))); }
+	STATIC_INLINE_PURE __m256i const __vectorcall denormalize(__m256 const v) { return(_mm256_cvtps_epi32(_mm256_mul_ps(v, _mm256_set1_ps(DENORMALIZE_16BIT)))); }
+
+	// row of the matrix * xyz
+	STATIC_INLINE_PURE __m256 const __vectorcall transform(float const m0, float const m1, float const m2, __m256 const x, __m256 const y, __m256 const z)
+	{
+		return(_mm256_fmadd_ps(_mm256_set1_ps(m0), x, _mm256_fmadd_ps(_mm256_set1_ps(m1), y, _mm256_mul_ps(_mm256_set1_ps(m2), z))));
+	}
+
+	static __inline void __vectorcall to_oklab(__m256& __restrict x, __m256& __restrict y, __m256& __restrict z) // linear rgb in, L a b out
+	{
+		using namespace SFM::oklab_Konstants; // linear srgb -> cone response (lms) & inverse
+
+		__m256 const third(_mm256_set1_ps(_r0)); // lms is never negative for rgb >= 0, all coefficients are positive
+		__m256 const l(_mm256_pow_ps(transform(_c0.m[0][0], _c0.m[1][0], _c0.m[2][0], x, y, z), third)),
+					 m(_mm256_pow_ps(transform(_c0.m[0][1], _c0.m[1][1], _c0.m[2][1], x, y, z), third)),
+					 s(_mm256_pow_ps(transform(_c0.m[0][2], _c0.m[1][2], _c0.m[2][2], x, y, z), third));
+
+		x = transform(0.2104542553f, 0.7936177850f, -0.0040720468f, l, m, s);
+		y = transform(1.9779984951f, -2.4285922050f, 0.4505937099f, l, m, s);
+		z = transform(0.0259040371f, 0.7827717662f, -0.8086757660f, l, m, s);
+	}
+
+	static __inline void __vectorcall from_oklab(__m256& __restrict x, __m256& __restrict y, __m256& __restrict z) // L a b in, linear rgb out
+	{
+		using namespace SFM::oklab_Konstants;
+
+		__m256 l(transform(1.0f, 0.3963377774f, 0.2158037573f, x, y, z)),
+			   m(transform(1.0f, -0.1055613458f, -0.0638541728f, x, y, z)),
+			   s(transform(1.0f, -0.0894841775f, -1.2914855480f, x, y, z));
+		l = _mm256_mul_ps(l, _mm256_mul_ps(l, l));
+		m = _mm256_mul_ps(m, _mm256_mul_ps(m, m));
+		s = _mm256_mul_ps(s, _mm256_mul_ps(s, s));
+
+		x = transform(_c1.m[0][0], _c1.m[1][0], _c1.m[2][0], l, m, s);
+		y = transform(_c1.m[0][1], _c1.m[1][1], _c1.m[2][1], l, m, s);
+		z = transform(_c1.m[0][2], _c1.m[1][2], _c1.m[2][2], l, m, s);
+	}
+
+	static __inline void __vectorcall linear_to_oklab8(uint16_t* const __restrict px)
+	{
+		__m256i r, g, b, a;
+		load8(px, r, g, b, a);
+
+		__m256 x(normalize(r)), y(normalize(g)), z(normalize(b));
+		to_oklab(x, y, z);
+
+		__m256 const bias(_mm256_set1_ps(AB_BIAS));
+		store8(px, denormalize(x), denormalize(_mm256_add_ps(y, bias)), denormalize(_mm256_add_ps(z, bias)), a);
+	}
+
+	static __inline void __vectorcall oklab_to_linear8(uint16_t* const __restrict px)
+	{
+		__m256i r, g, b, a;
+		load8(px, r, g, b, a);
+
+		__m256 const bias(_mm256_set1_ps(AB_BIAS));
+		__m256 x(normalize(r)), y(_mm256_sub_ps(normalize(g), bias)), z(_mm256_sub_ps(normalize(b), bias));
+		from_oklab(x, y, z);
+
+		store8(px, denormalize(x), denormalize(y), denormalize(z), a); // out of gamut is clamped by the saturation of store8 (nan is 0)
+	}
+
+	template<void(__vectorcall* const op)(uint16_t* const __restrict)>
+	static void __vectorcall inplace_row(uint16_t* const __restrict row, uint32_t const width)
+	{
+		uint32_t x(0);
+		for (; (x + 8) <= width; x += 8) {
+			op(row + (x << 2));
+		}
+		if (x < width) {
+
+			alignas(32) uint16_t px[8 * 4]{};
+
+			memcpy(px, row + (x << 2), (width - x) * 4 * sizeof(uint16_t));
+			op(px);
+			memcpy(row + (x << 2), px, (width - x) * 4 * sizeof(uint16_t));
+		}
+	}
+
+	static __inline void __vectorcall linear_to_planes8(float* const __restrict L, float* const __restrict A, float* const __restrict B, uint16_t const* const __restrict px)
+	{
+		__m256i r, g, b, a;
+		load8(px, r, g, b, a);
+
+		__m256 x(normalize(r)), y(normalize(g)), z(normalize(b));
+		to_oklab(x, y, z);
+
+		_mm256_storeu_ps(L, x); _mm256_storeu_ps(A, y); _mm256_storeu_ps(B, z);
+	}
+
+	static __inline void __vectorcall planes_to_linear8(uint16_t* const __restrict px, float const* const __restrict L, float const* const __restrict A, float const* const __restrict B)
+	{
+		__m256 x(_mm256_loadu_ps(L)), y(_mm256_loadu_ps(A)), z(_mm256_loadu_ps(B));
+		from_oklab(x, y, z);
+
+		store8(px, denormalize(x), denormalize(y), denormalize(z), _mm256_set1_epi32(UINT16_MAX));
+	}
+
+	static void __vectorcall linear_to_planes_row(float* const __restrict L, float* const __restrict A, float* const __restrict B, uint16_t const* const __restrict row, uint32_t const width)
+	{
+		uint32_t x(0);
+		for (; (x + 8) <= width; x += 8) {
+			linear_to_planes8(L + x, A + x, B + x, row + (x << 2));
+		}
+		if (x < width) {
+
+			alignas(32) uint16_t px[8 * 4]{};
+			alignas(32) float l[8], a[8], b[8];
+
+			memcpy(px, row + (x << 2), (width - x) * 4 * sizeof(uint16_t));
+			linear_to_planes8(l, a, b, px);
+			memcpy(L + x, l, (width - x) * sizeof(float)); memcpy(A + x, a, (width - x) * sizeof(float)); memcpy(B + x, b, (width - x) * sizeof(float));
+		}
+	}
+
+	static void __vectorcall planes_to_linear_row(uint16_t* const __restrict row, float const* const __restrict L, float const* const __restrict A, float const* const __restrict B, uint32_t const width)
+	{
+		uint32_t x(0);
+		for (; (x + 8) <= width; x += 8) {
+			planes_to_linear8(row + (x << 2), L + x, A + x, B + x);
+		}
+		if (x < width) {
+
+			alignas(32) uint16_t px[8 * 4];
+			alignas(32) float l[8]{}, a[8]{}, b[8]{};
+
+			memcpy(l, L + x, (width - x) * sizeof(float)); memcpy(a, A + x, (width - x) * sizeof(float)); memcpy(b, B + x, (width - x) * sizeof(float));
+			planes_to_linear8(px, l, a, b);
+			memcpy(row + (x << 2), px, (width - x) * 4 * sizeof(uint16_t));
+		}
+	}
+
+	// 8bpc srgb mode <-> 16bpc linear mode of the same layout
+	static bool const __vectorcall pair(eIMAGINGMODE const mode, eIMAGINGMODE& __restrict other, uint32_t& __restrict channels, bool& __restrict alpha)
+	{
+		switch (mode)
+		{
+		case MODE_L:		other = MODE_L16;		channels = 1; alpha = false;	break;
+		case MODE_LA:		other = MODE_LA16;		channels = 2; alpha = true;		break;
+		case MODE_RGB:		other = MODE_RGB16;		channels = 3; alpha = false;	break;
+		case MODE_BGRX:		other = MODE_BGRX16;	channels = 4; alpha = true;		break; // x is linear
+		case MODE_BGRA:		other = MODE_BGRA16;	channels = 4; alpha = true;		break;
+		case MODE_L16:		other = MODE_L;			channels = 1; alpha = false;	break;
+		case MODE_LA16:		other = MODE_LA;		channels = 2; alpha = true;		break;
+		case MODE_RGB16:	other = MODE_RGB;		channels = 3; alpha = false;	break;
+		case MODE_BGRX16:	other = MODE_BGRX;		channels = 4; alpha = true;		break;
+		case MODE_BGRA16:	other = MODE_BGRA;		channels = 4; alpha = true;		break;
+		default:
+			return(false);
+		}
+		return(true);
+	}
+
+	STATIC_INLINE_PURE bool const is_rgba16(ImagingMemoryInstance const* const __restrict im)
+	{
+		return(nullptr != im && (MODE_BGRX16 == im->mode || MODE_BGRA16 == im->mode));
+	}
+
+} // end ns
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingSRGBToLinear16(ImagingMemoryInstance const* const __restrict im)
+{
+	eIMAGINGMODE mode;
+	uint32_t channels;
+	bool alpha;
+	if (!im || !color_space::pair(im->mode, mode, channels, alpha) || im->pixelsize != int32_t(channels)) { // 8bpc source
+		return (Imaging)ImagingError_ModeError();
+	}
+
+	Imaging const imOut(ImagingNew(mode, im->xsize, im->ysize));
+	if (!imOut) {
+		return(nullptr);
+	}
+
+	struct { // avoid lambda heap
+		uint8_t const* const* const __restrict image_in;
+		uint8_t* const* const __restrict       image_out;
+		uint32_t const count, channels;
+		bool const alpha;
+		uint32_t const* const __restrict to_linear;
+
+	} const p = { im->image, imOut->image, uint32_t(im->xsize) * channels, channels, alpha, color_space::get_tables().to_linear };
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, im->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+		color_space::pattern pattern;
+		color_space::make_pattern(pattern, p.channels, p.alpha, 0, false);
+
+		for (int y = rows.begin(); y < rows.end(); ++y) {
+			color_space::srgb_to_linear_row((uint16_t*)p.image_out[y], p.image_in[y], p.count, pattern, p.to_linear);
+		}
+	});
+
+	return(imOut);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLinear16ToSRGB(ImagingMemoryInstance const* const __restrict im, bool const dither)
+{
+	eIMAGINGMODE mode;
+	uint32_t channels;
+	bool alpha;
+	if (!im || !color_space::pair(im->mode, mode, channels, alpha) || im->pixelsize != int32_t(channels * sizeof(uint16_t))) { // 16bpc source
+		return (Imaging)ImagingError_ModeError();
+	}
+
+	Imaging const imOut(ImagingNew(mode, im->xsize, im->ysize));
+	if (!imOut) {
+		return(nullptr);
+	}
+
+	struct { // avoid lambda heap
+		uint8_t const* const* const __restrict image_in;
+		uint8_t* const* const __restrict       image_out;
+		uint32_t const count, channels;
+		bool const alpha, dither;
+		float const* const __restrict to_srgb;
+
+	} const p = { im->image, imOut->image, uint32_t(im->xsize) * channels, channels, alpha, dither, color_space::get_tables().to_srgb };
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, im->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+		color_space::pattern pattern;
+
+		for (int y = rows.begin(); y < rows.end(); ++y) {
+			if (rows.begin() == y || p.dither) { // dither pattern changes every row
+				color_space::make_pattern(pattern, p.channels, p.alpha, y, p.dither);
+			}
+			color_space::linear_to_srgb_row(p.image_out[y], (uint16_t const*)p.image_in[y], p.count, pattern, p.to_srgb);
+		}
+	});
+
+	return(imOut);
+}
+
+template<void(__vectorcall* const op)(uint16_t* const __restrict)>
+static bool const __vectorcall ImagingOKLABInplace(ImagingMemoryInstance* const __restrict im)
+{
+	if (!color_space::is_rgba16(im)) {
+		return(false);
+	}
+
+	struct { // avoid lambda heap
+		uint8_t* const* const __restrict image;
+		uint32_t const width;
+
+	} const p = { im->image, uint32_t(im->xsize) };
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, im->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+		for (int y = rows.begin(); y < rows.end(); ++y) {
+			color_space::inplace_row<op>((uint16_t*)p.image[y], p.width);
+		}
+	});
+
+	return(true);
+}
+
+bool const __vectorcall ImagingLinearToOKLAB(ImagingMemoryInstance* const __restrict im)
+{
+	return(ImagingOKLABInplace<&color_space::linear_to_oklab8>(im));
+}
+
+bool const __vectorcall ImagingOKLABToLinear(ImagingMemoryInstance* const __restrict im)
+{
+	return(ImagingOKLABInplace<&color_space::oklab_to_linear8>(im));
+}
+
+bool const __vectorcall ImagingLinearToOKLAB(ImagingMemoryInstance const* const __restrict im, ImagingMemoryInstance*& __restrict L, ImagingMemoryInstance*& __restrict a, ImagingMemoryInstance*& __restrict b)
+{
+	L = a = b = nullptr;
+	if (!color_space::is_rgba16(im)) {
+		return(false);
+	}
+
+	L = ImagingNew(MODE_F32, im->xsize, im->ysize);
+	a = ImagingNew(MODE_F32, im->xsize, im->ysize);
+	b = ImagingNew(MODE_F32, im->xsize, im->ysize);
+	if (!L || !a || !b) {
+		ImagingDelete(L); ImagingDelete(a); ImagingDelete(b);
+		L = a = b = nullptr;
+		return(false);
+	}
+
+	struct { // avoid lambda heap
+		uint8_t const* const* const __restrict image_in;
+		uint8_t* const* const __restrict L;
+		uint8_t* const* const __restrict a;
+		uint8_t* const* const __restrict b;
+		uint32_t const width;
+
+	} const p = { im->image, L->image, a->image, b->image, uint32_t(im->xsize) };
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, im->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+		for (int y = rows.begin(); y < rows.end(); ++y) {
+			color_space::linear_to_planes_row((float*)p.L[y], (float*)p.a[y], (float*)p.b[y], (uint16_t const*)p.image_in[y], p.width);
+		}
+	});
+
+	return(true);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingOKLABToLinear(ImagingMemoryInstance const* const __restrict L, ImagingMemoryInstance const* const __restrict a, ImagingMemoryInstance const* const __restrict b)
+{
+	if (!L || !a || !b || MODE_F32 != L->mode || MODE_F32 != a->mode || MODE_F32 != b->mode) {
+		return (Imaging)ImagingError_ModeError();
+	}
+	if (L->xsize != a->xsize || L->xsize != b->xsize || L->ysize != a->ysize || L->ysize != b->ysize) {
+		return (Imaging)ImagingError_Mismatch();
+	}
+
+	Imaging const imOut(ImagingNew(MODE_BGRX16, L->xsize, L->ysize));
+	if (!imOut) {
+		return(nullptr);
+	}
+
+	struct { // avoid lambda heap
+		uint8_t* const* const __restrict image_out;
+		uint8_t const* const* const __restrict L;
+		uint8_t const* const* const __restrict a;
+		uint8_t const* const* const __restrict b;
+		uint32_t const width;
+
+	} const p = { imOut->image, L->image, a->image, b->image, uint32_t(L->xsize) };
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, imOut->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+		for (int y = rows.begin(); y < rows.end(); ++y) {
+			color_space::planes_to_linear_row((uint16_t*)p.image_out[y], (float const*)p.L[y], (float const*)p.a[y], (float const*)p.b[y], p.width);
+		}
+	});
+
+	return(imOut);
+}
+
+namespace normal_map { // tangent space normal maps (red X+ right, green Y+ down, blue Z+ near) stored as BGRX16 / BGRA16. 8 normals per iteration in SoA (color_space::load8 / store8), rows in parallel.
+
+	static constexpr float const FLAT_EPSILON = 1e-7f; // shorter vectors are flat (0, 0, 1)
+
+	STATIC_INLINE_PURE __m256 const __vectorcall decode(__m256i const v) { return(_mm256_fmsub_ps(color_space::normalize(v), _mm256_set1_ps(2.0f), _mm256_set1_ps(1.0f))); } // 0 ... 65535 -> -1 ... +1
+	STATIC_INLINE_PURE __m256i const __vectorcall encode(__m256 const n) { return(color_space::denormalize(_mm256_fmadd_ps(n, _mm256_set1_ps(0.5f), _mm256_set1_ps(0.5f)))); } // -1 ... +1 -> 0 ... 65535 (saturated by store8)
+	STATIC_INLINE_PURE __m256 const __vectorcall abs(__m256 const v) { return(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), v)); }
+
+	// unit length, returns the length before normalization
+	static __inline __m256 const __vectorcall normalize(__m256& __restrict x, __m256& __restrict y, __m256& __restrict z)
+	{
+		__m256 const length(_mm256_sqrt_ps(_mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_mul_ps(z, z)))));
+		__m256 const valid(_mm256_cmp_ps(length, _mm256_set1_ps(FLAT_EPSILON), _CMP_GT_OQ));
+		__m256 const inv(_mm256_div_ps(_mm256_set1_ps(1.0f), length));
+
+		x = _mm256_and_ps(valid, _mm256_mul_ps(x, inv));
+		y = _mm256_and_ps(valid, _mm256_mul_ps(y, inv));
+		z = _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(z, inv), valid);
+		return(length);
+	}
+
+	static __inline void __vectorcall load8(uint16_t const* const __restrict px, __m256& __restrict x, __m256& __restrict y, __m256& __restrict z, __m256i& __restrict a) // decoded & normalized
+	{
+		__m256i r, g, b;
+		color_space::load8(px, r, g, b, a);
+
+		x = decode(r); y = decode(g); z = decode(b);
+		normalize(x, y, z);
+	}
+
+	// Mikkelsen2020Bump.pdf - https://mmikkelsen3d.blogspot.com/2011/07/derivative-maps.html
+	// in vulkan texture origin is upper-left, however TS (tangent space) uses -1 as up aswell. So the *y component is already negated* So it passes thru untouched, do not negate it again!
+	static __inline void __vectorcall derivative8(uint32_t* const __restrict out, uint16_t const* const __restrict px)
+	{
+		static constexpr float const scale = 1.0f / 128.0f; // 89.55 degrees
+
+		__m256 x, y, z;
+		__m256i a;
+		load8(px, x, y, z, a);
+
+		// avoid division by zero on absolute value
+		__m256 const z_ma(_mm256_max_ps(_mm256_set1_ps(0.0001f), _mm256_max_ps(abs(z), _mm256_mul_ps(_mm256_set1_ps(scale), _mm256_max_ps(abs(x), abs(y))))));
+
+		// -float2(vM.x, vM.y) / z_ma, signed -> 0 ... 1 -> uint16_t range
+		__m256i const dx(encode(_mm256_div_ps(_mm256_xor_ps(x, _mm256_set1_ps(-0.0f)), z_ma))),
+					  dy(encode(_mm256_div_ps(_mm256_xor_ps(y, _mm256_set1_ps(-0.0f)), z_ma)));
+
+		__m256i const pair(_mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15));
+		_mm256_storeu_si256((__m256i*)out, _mm256_shuffle_epi8(_mm256_packus_epi32(dx, dy), pair)); // LA16 (L = x, A = y)
+	}
+
+	static void __vectorcall derivative_row(uint32_t* const __restrict out, uint16_t const* const __restrict row, uint32_t const width)
+	{
+		uint32_t x(0);
+		for (; (x + 8) <= width; x += 8) {
+			derivative8(out + x, row + (x << 2));
+		}
+		if (x < width) {
+
+			alignas(32) uint16_t px[8 * 4]{};
+			alignas(32) uint32_t la[8];
+
+			memcpy(px, row + (x << 2), (width - x) * 4 * sizeof(uint16_t));
+			derivative8(la, px);
+			memcpy(out + x, la, (width - x) * sizeof(uint32_t));
+		}
+	}
+
+	static __inline void __vectorcall renormalize8(uint16_t* const __restrict px)
+	{
+		__m256 x, y, z;
+		__m256i a;
+		load8(px, x, y, z, a);
+
+		color_space::store8(px, encode(x), encode(y), encode(z), a);
+	}
+
+	// height -> normal
+	typedef struct gradient_kernel {
+
+		float edge, center; // weights of the 3x3 kernel rows (columns), normalized so the gradient is height per pixel
+
+	} gradient_kernel;
+
+	static constexpr gradient_kernel const SOBEL{ 1.0f / 8.0f, 2.0f / 8.0f },
+										   SCHARR{ 3.0f / 32.0f, 10.0f / 32.0f };
+
+	// a row of height as float w/ one pixel of padding on both sides (wrapped or clamped) + 8 floats of slack for the last group
+	static void __vectorcall height_row(float* const __restrict dst, ImagingMemoryInstance const* const __restrict im, int32_t const y, bool const wrap)
+	{
+		int32_t const width(im->xsize), height(im->ysize);
+		int32_t const sy(wrap ? int32_t(geometry::wrap(y, height)) : SFM::min(SFM::max(y, 0), height - 1));
+
+		float* const __restrict row(dst + 1);
+
+		if (MODE_F32 == im->mode) {
+			memcpy(row, im->image[sy], width * sizeof(float));
+		}
+		else { // MODE_L16
+			uint16_t const* const __restrict src((uint16_t const*)im->image[sy]);
+
+			int32_t x(0);
+			for (; (x + 8) <= width; x += 8) {
+				_mm256_storeu_ps(row + x, color_space::normalize(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const*)(src + x)))));
+			}
+			for (; x < width; ++x) {
+				row[x] = float(src[x]) * color_space::NORMALIZE_16BIT;
+			}
+		}
+
+		row[-1] = row[wrap ? width - 1 : 0];
+		row[width] = row[wrap ? 0 : width - 1];
+	}
+
+	static __inline void __vectorcall height_to_normal8(uint16_t* const __restrict px, float const* const __restrict above, float const* const __restrict center, float const* const __restrict below,
+														__m256 const edge, __m256 const middle, __m256 const strength)
+	{
+		__m256 const tl(_mm256_loadu_ps(above)), t(_mm256_loadu_ps(above + 1)), tr(_mm256_loadu_ps(above + 2)),
+					 l(_mm256_loadu_ps(center)), r(_mm256_loadu_ps(center + 2)),
+					 bl(_mm256_loadu_ps(below)), b(_mm256_loadu_ps(below + 1)), br(_mm256_loadu_ps(below + 2));
+
+		__m256 const gx(_mm256_fmadd_ps(edge, _mm256_add_ps(_mm256_sub_ps(tr, tl), _mm256_sub_ps(br, bl)), _mm256_mul_ps(middle, _mm256_sub_ps(r, l)))),
+					 gy(_mm256_fmadd_ps(edge, _mm256_add_ps(_mm256_sub_ps(bl, tl), _mm256_sub_ps(br, tr)), _mm256_mul_ps(middle, _mm256_sub_ps(b, t))));
+
+		// n = (-dh/dx, -dh/dy, 1), y is down in both the image & tangent space
+		__m256 x(_mm256_mul_ps(gx, _mm256_xor_ps(strength, _mm256_set1_ps(-0.0f)))), y(_mm256_mul_ps(gy, _mm256_xor_ps(strength, _mm256_set1_ps(-0.0f)))), z(_mm256_set1_ps(1.0f));
+		normalize(x, y, z);
+
+		color_space::store8(px, encode(x), encode(y), encode(z), _mm256_set1_epi32(UINT16_MAX));
+	}
+
+	static void __vectorcall height_to_normal_row(uint16_t* const __restrict out, float const* const __restrict above, float const* const __restrict center, float const* const __restrict below, uint32_t const width,
+												  gradient_kernel const& __restrict kernel, float const strength)
+	{
+		__m256 const edge(_mm256_set1_ps(kernel.edge)), middle(_mm256_set1_ps(kernel.center)), scale(_mm256_set1_ps(strength));
+
+		uint32_t x(0);
+		for (; (x + 8) <= width; x += 8) {
+			height_to_normal8(out + (x << 2), above + x, center + x, below + x, edge, middle, scale);
+		}
+		if (x < width) { // reads are within the slack of the padded rows
+
+			alignas(32) uint16_t px[8 * 4];
+
+			height_to_normal8(px, above + x, center + x, below + x, edge, middle, scale);
+			memcpy(out + (x << 2), px, (width - x) * 4 * sizeof(uint16_t));
+		}
+	}
+
+	// mips: the normals of level 0 are decoded to F32 planes, each level is the 2x2 average of the previous level's planes (unnormalized, so it is the average over the whole footprint).
+	// the stored level is renormalized, the length of the average is the variance of the normals (Toksvig) that can optionally replace alpha.
+	typedef struct planes {
+
+		ImagingMemoryInstance* __restrict plane[4]; // x, y, z, alpha (MODE_F32)
+
+	} planes;
+
+	static void __vectorcall delete_planes(planes& __restrict p)
+	{
+		for (uint32_t i = 0; i < 4; ++i) {
+			ImagingDelete(p.plane[i]);
+			p.plane[i] = nullptr;
+		}
+	}
+
+	static bool const __vectorcall new_planes(planes& __restrict p, int const width, int const height)
+	{
+		for (uint32_t i = 0; i < 4; ++i) {
+			p.plane[i] = ImagingNew(MODE_F32, width, height);
+		}
+		if (!p.plane[0] || !p.plane[1] || !p.plane[2] || !p.plane[3]) {
+			delete_planes(p);
+			return(false);
+		}
+		return(true);
+	}
+
+	static __inline void __vectorcall to_planes8(float* const __restrict x, float* const __restrict y, float* const __restrict z, float* const __restrict a, uint16_t const* const __restrict px)
+	{
+		__m256 vx, vy, vz;
+		__m256i va;
+		load8(px, vx, vy, vz, va);
+
+		_mm256_storeu_ps(x, vx); _mm256_storeu_ps(y, vy); _mm256_storeu_ps(z, vz); _mm256_storeu_ps(a, color_space::normalize(va));
+	}
+
+	static void __vectorcall to_planes_row(float* const __restrict x, float* const __restrict y, float* const __restrict z, float* const __restrict a, uint16_t const* const __restrict row, uint32_t const width)
+	{
+		uint32_t i(0);
+		for (; (i + 8) <= width; i += 8) {
+			to_planes8(x + i, y + i, z + i, a + i, row + (i << 2));
+		}
+		if (i < width) {
+
+			alignas(32) uint16_t px[8 * 4]{};
+			alignas(32) float vx[8], vy[8], vz[8], va[8];
+
+			size_t const count(width - i);
+			memcpy(px, row + (i << 2), count * 4 * sizeof(uint16_t));
+			to_planes8(vx, vy, vz, va, px);
+			memcpy(x + i, vx, count * sizeof(float)); memcpy(y + i, vy, count * sizeof(float)); memcpy(z + i, vz, count * sizeof(float)); memcpy(a + i, va, count * sizeof(float));
+		}
+	}
+
+	static __inline void __vectorcall from_planes8(uint16_t* const __restrict px, float const* const __restrict x, float const* const __restrict y, float const* const __restrict z, float const* const __restrict a, bool const toksvig)
+	{
+		__m256 vx(_mm256_loadu_ps(x)), vy(_mm256_loadu_ps(y)), vz(_mm256_loadu_ps(z));
+		__m256 const length(normalize(vx, vy, vz));
+
+		color_space::store8(px, encode(vx), encode(vy), encode(vz), color_space::denormalize(toksvig ? _mm256_min_ps(length, _mm256_set1_ps(1.0f)) : _mm256_loadu_ps(a)));
+	}
+
+	static void __vectorcall from_planes_row(uint16_t* const __restrict row, float const* const __restrict x, float const* const __restrict y, float const* const __restrict z, float const* const __restrict a, uint32_t const width, bool const toksvig)
+	{
+		uint32_t i(0);
+		for (; (i + 8) <= width; i += 8) {
+			from_planes8(row + (i << 2), x + i, y + i, z + i, a + i, toksvig);
+		}
+		if (i < width) {
+
+			alignas(32) uint16_t px[8 * 4];
+			alignas(32) float vx[8]{}, vy[8]{}, vz[8]{}, va[8]{};
+
+			size_t const count(width - i);
+			memcpy(vx, x + i, count * sizeof(float)); memcpy(vy, y + i, count * sizeof(float)); memcpy(vz, z + i, count * sizeof(float)); memcpy(va, a + i, count * sizeof(float));
+			from_planes8(px, vx, vy, vz, va, toksvig);
+			memcpy(row + (i << 2), px, count * 4 * sizeof(uint16_t));
+		}
+	}
+
+	// 2x2 average, the last column & row are repeated for odd sizes
+	static void __vectorcall reduce_row(float* const __restrict out, float const* const __restrict row0, float const* const __restrict row1, int32_t const src_width, int32_t const width)
+	{
+		__m256 const quarter(_mm256_set1_ps(0.25f));
+
+		int32_t const simd_end(src_width >> 1); // output pixel x reads 2x & 2x + 1
+
+		int32_t x(0);
+		for (; (x + 8) <= simd_end; x += 8) {
+			__m256 const lo(_mm256_add_ps(_mm256_loadu_ps(row0 + (x << 1)), _mm256_loadu_ps(row1 + (x << 1)))),
+						 hi(_mm256_add_ps(_mm256_loadu_ps(row0 + (x << 1) + 8), _mm256_loadu_ps(row1 + (x << 1) + 8)));
+
+			_mm256_storeu_ps(out + x, _mm256_mul_ps(_mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_hadd_ps(lo, hi)), _MM_SHUFFLE(3, 1, 2, 0))), quarter));
+		}
+		for (; x < width; ++x) {
+			int32_t const sx0(SFM::min(x << 1, src_width - 1)), sx1(SFM::min((x << 1) + 1, src_width - 1));
+			out[x] = ((row0[sx0] + row0[sx1]) + (row1[sx0] + row1[sx1])) * 0.25f;
+		}
+	}
+
+	static void __vectorcall reduce(planes& __restrict dst, planes const& __restrict src)
+	{
+		struct { // avoid lambda heap
+			planes const& __restrict dst;
+			planes const& __restrict src;
+
+		} const p = { dst, src };
+
+		tbb::parallel_for(tbb::blocked_range<int>(0, dst.plane[0]->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+			int32_t const src_height(p.src.plane[0]->ysize);
+
+			for (int y = rows.begin(); y < rows.end(); ++y) {
+
+				int32_t const y0(SFM::min(y << 1, src_height - 1)), y1(SFM::min((y << 1) + 1, src_height - 1));
+
+				for (uint32_t i = 0; i < 4; ++i) {
+					reduce_row((float*)p.dst.plane[i]->image[y], (float const*)p.src.plane[i]->image[y0], (float const*)p.src.plane[i]->image[y1], p.src.plane[i]->xsize, p.dst.plane[i]->xsize);
+				}
+			}
+		});
+	}
+
+	STATIC_INLINE_PURE bool const is_normal_map(ImagingMemoryInstance const* const __restrict im)
+	{
+		return(color_space::is_rgba16(im));
+	}
+
+} // end ns
+
+// (NOT INPLACE) - new image returned of LA16 type, requires normal map of type BGRA16 input.
+ImagingMemoryInstance* const __restrict __vectorcall ImagingTangentSpaceNormalMapToDerivativeMapBGRA16(ImagingMemoryInstance* const __restrict im)
+{
+	if (!normal_map::is_normal_map(im)) {
+		return (Imaging)ImagingError_ModeError();
+	}
+
+	Imaging const img_returned(ImagingNew(MODE_LA16, im->xsize, im->ysize));
+	if (!img_returned) {
+		return(nullptr);
+	}
+
+	struct { // avoid lambda heap
+		uint8_t const* const* const __restrict image_in;
+		uint8_t* const* const __restrict       image_out;
+		uint32_t const width;
+
+	} const p = { im->image, img_returned->image, uint32_t(im->xsize) };
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, im->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+		for (int y = rows.begin(); y < rows.end(); ++y) {
+			normal_map::derivative_row((uint32_t*)p.image_out[y], (uint16_t const*)p.image_in[y], p.width);
+		}
+	});
+
+	return(img_returned);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingHeightMapToNormalMap(ImagingMemoryInstance const* const __restrict im, float const strength, int const kernel, bool const wrap)
+{
+	if (!im || (MODE_L16 != im->mode && MODE_F32 != im->mode)) {
+		return (Imaging)ImagingError_ModeError();
+	}
+
+	Imaging const img_returned(ImagingNew(MODE_BGRX16, im->xsize, im->ysize));
+	if (!img_returned) {
+		return(nullptr);
+	}
+
+	struct { // avoid lambda heap
+		ImagingMemoryInstance const* const __restrict im;
+		uint8_t* const* const __restrict image_out;
+		normal_map::gradient_kernel const kernel;
+		float const strength;
+		bool const wrap;
+
+	} const p = { im, img_returned->image, (IMAGING_NORMAL_SCHARR == kernel ? normal_map::SCHARR : normal_map::SOBEL), strength, wrap };
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, im->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+		size_t const stride(size_t(p.im->xsize) + 2 + 8); // padding + slack
+		float* const __restrict buffer((float*)scalable_aligned_malloc(3 * stride * sizeof(float), CACHE_LINE_BYTES));
+		if (!buffer) {
+			return;
+		}
+		memset(buffer, 0, 3 * stride * sizeof(float));
+
+		// rolling window of 3 rows
+		float* __restrict window[3]{ buffer, buffer + stride, buffer + 2 * stride };
+		normal_map::height_row(window[0], p.im, rows.begin() - 1, p.wrap);
+		normal_map::height_row(window[1], p.im, rows.begin(), p.wrap);
+
+		for (int y = rows.begin(); y < rows.end(); ++y) {
+
+			normal_map::height_row(window[2], p.im, y + 1, p.wrap);
+			normal_map::height_to_normal_row((uint16_t*)p.image_out[y], window[0], window[1], window[2], p.im->xsize, p.kernel, p.strength);
+
+			std::swap(window[0], window[1]);
+			std::swap(window[1], window[2]);
+		}
+
+		scalable_aligned_free(buffer);
+	});
+
+	return(img_returned);
+}
+
+bool const __vectorcall ImagingRenormalizeNormalMap(ImagingMemoryInstance* const __restrict im)
+{
+	if (!normal_map::is_normal_map(im)) {
+		return(false);
+	}
+
+	struct { // avoid lambda heap
+		uint8_t* const* const __restrict image;
+		uint32_t const width;
+
+	} const p = { im->image, uint32_t(im->xsize) };
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, im->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+		for (int y = rows.begin(); y < rows.end(); ++y) {
+			color_space::inplace_row<&normal_map::renormalize8>((uint16_t*)p.image[y], p.width);
+		}
+	});
+
+	return(true);
+}
+
+ImagingMipChain* const __restrict __vectorcall ImagingGenerateNormalMipChain(ImagingMemoryInstance const* const __restrict im, uint32_t const maxLevels, bool const toksvig)
+{
+	if (!normal_map::is_normal_map(im)) {
+		return((ImagingMipChain*)ImagingError_ModeError());
+	}
+
+	// full chain down to 1x1
+	uint32_t count(1);
+	while ((uint32_t(SFM::max(im->xsize, im->ysize)) >> count) > 0) {
+		++count;
+	}
+	if (0 != maxLevels) {
+		count = SFM::min(count, maxLevels);
+	}
+
+	ImagingMipChain* const __restrict chain(ImagingNewMipChain(count));
+	if (!chain) {
+		return(nullptr);
+	}
+
+	chain->levels[0] = ImagingCopy(im);
+
+	normal_map::planes previous{}, next{};
+	if (!chain->levels[0] || !normal_map::new_planes(previous, im->xsize, im->ysize)) {
+		ImagingDelete(chain);
+		return(nullptr);
+	}
+
+	{ // level 0 -> planes
+		struct { // avoid lambda heap
+			uint8_t const* const* const __restrict image;
+			normal_map::planes const& __restrict planes;
+			uint32_t const width;
+
+		} const p = { im->image, previous, uint32_t(im->xsize) };
+
+		tbb::parallel_for(tbb::blocked_range<int>(0, im->ysize), [&p](tbb::blocked_range<int> const& rows) {
+
+			for (int y = rows.begin(); y < rows.end(); ++y) {
+				normal_map::to_planes_row((float*)p.planes.plane[0]->image[y], (float*)p.planes.plane[1]->image[y], (float*)p.planes.plane[2]->image[y], (float*)p.planes.plane[3]->image[y], (uint16_t const*)p.image[y], p.width);
+			}
+		});
+	}
+
+	for (uint32_t level = 1; level < count; ++level) {
+
+		int const width(mipScale(im->xsize, level)), height(mipScale(im->ysize, level));
+
+		ImagingMemoryInstance* const __restrict out(ImagingNew(im->mode, width, height));
+		if (!out || !normal_map::new_planes(next, width, height)) {
+			ImagingDelete(out);
+			normal_map::delete_planes(previous);
+			ImagingDelete(chain);
+			return(nullptr);
+		}
+		chain->levels[level] = out;
+
+		normal_map::reduce(next, previous);
+
+		struct { // avoid lambda heap
+			uint8_t* const* const __restrict image;
+			normal_map::planes const& __restrict planes;
+			uint32_t const width;
+			bool const toksvig;
+
+		} const p = { out->image, next, uint32_t(width), toksvig };
+
+		tbb::parallel_for(tbb::blocked_range<int>(0, height), [&p](tbb::blocked_range<int> const& rows) {
+
+			for (int y = rows.begin(); y < rows.end(); ++y) {
+				normal_map::from_planes_row((uint16_t*)p.image[y], (float const*)p.planes.plane[0]->image[y], (float const*)p.planes.plane[1]->image[y], (float const*)p.planes.plane[2]->image[y], (float const*)p.planes.plane[3]->image[y], p.width, p.toksvig);
+			}
+		});
+
+		normal_map::delete_planes(previous);
+		std::swap(previous, next);
+	}
+
+	normal_map::delete_planes(previous);
+	return(chain);
+}
+
+bool const __vectorcall ImagingSaveLUT(ImagingLUT const* const __restrict lut, std::string_view const title, std::wstring_view const cubefilenamepath)
+{
+	if (fs::path(cubefilenamepath).extension() == cube_lut::EXTENSION_BINARY) {
+		return(cube_lut::save_binary(lut, title, cubefilenamepath));
+	}
+
+	bool bReturn(false);
+
+	FILE* fOut;
+
+	if (0 == _wfopen_s(&fOut, cubefilenamepath.data(), L"w"))
+	{
+		std::string buffer("");
+
+		buffer = fmt::format("TITLE \"{:s}\"\n", title);
+
+		fwrite(buffer.data(), 1, buffer.length(), fOut);
+
+		buffer = fmt::format("# Created by Imaging - supersinfulsilicon software\n");
+
+		fwrite(buffer.data(), 1, buffer.length(), fOut);
+
+		uint32_t const lut_size(lut->size);
+		buffer = fmt::format("LUT_3D_SIZE {:d}\n\n", lut_size);
+
+		fwrite(buffer.data(), 1, buffer.length(), fOut);
+
+		static constexpr float const NORMALIZE = 1.0f / float(UINT16_MAX);
+
+		XMVECTOR const xmNorm(_mm_set1_ps(NORMALIZE));
+
+		uint16_t const* const __restrict lut_block = lut->block;
+
+		for (uint32_t b = 0; b < lut_size; ++b) {
+			for (uint32_t g = 0; g < lut_size; ++g) {
+				for (uint32_t r = 0; r < lut_size; ++r) {
+
+					// slices ordered by r
+					// (b * rMax * gMax) + (g * rMax) + r;
+					uint16_t const* const lut_color(lut_block + (((b * lut_size * lut_size) + (g * lut_size) + r) << 2));
+					
+					uvec4_v const rgba(lut_color[0], lut_color[1], lut_color[2], 0);
+
+					XMVECTOR const xmOut = SFM::saturate( XMVectorMultiply(rgba.v4f(), xmNorm) );
+
+					XMFLOAT4A vOut;
+					XMStoreFloat4A(&vOut, xmOut);
+
+					buffer = fmt::format("{:.8f} {:.8f} {:.8f}\n", vOut.x, vOut.y, vOut.z);
+
+					fwrite(buffer.data(), 1, buffer.length(), fOut);
+				}
+			}
+		}
+		fclose(fOut); fOut = nullptr;
+		bReturn = true;
+	}
+	return(bReturn);
+}
+
+bool const __vectorcall ImagingSaveRaw(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath)
+{
+	bool bReturn(false);
+
+	FILE* fOut;
+
+	if (0 == _wfopen_s(&fOut, filenamepath.data(), L"wbS"))
+	{
+		uint8_t const*  __restrict pOut = pSrcImage->block;
+		uint32_t const stride = pSrcImage->linesize;
+
+		int scanline(pSrcImage->ysize);
+		while (0 != scanline) {
+
+			fwrite(pOut, 1, stride, fOut);
+			pOut += stride;
+
+			--scanline;
+		}
+
+		fclose(fOut); fOut = nullptr;
+		bReturn = true;
+	}
+	return(bReturn);
+}
+
+bool const ImagingSaveJPEG(eIMAGINGMODE const outClrSpace, ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath)
+{
+#if INCLUDE_JPEG_SUPPORT
+	static constexpr uint32_t const JPEG_QUALITY = 98;
+	bool bReleaseSrcImageCopy(false);
+
+	FILE* fOut;
+
+	if (0 == _wfopen_s(&fOut, filenamepath.data(), L"wbS"))
+	{
+		struct jpeg_compress_struct cinfo;
+		struct jpeg_error_mgr jerr;
+
+		// Create JPEG Object
+		cinfo.err = jpeg_std_error(&jerr);
+		jpeg_create_compress(&cinfo);
+		jpeg_stdio_dest(&cinfo, fOut);	// set to output to file
+		cinfo.image_width = pSrcImage->xsize;    /* image width and height, in pixels */
+		cinfo.image_height = pSrcImage->ysize;
+
+		if (MODE_L == outClrSpace) {
+			// use fast 2 gray conversion (linear)
+			Imaging rgbCopy(nullptr);
+			if (MODE_BGRX == pSrcImage->mode) {
+				rgbCopy = ImagingNew(MODE_RGB, cinfo.image_width, cinfo.image_height);
+				Parallel_BGRX2BGR(rgbCopy->image, pSrcImage->image, cinfo.image_width, cinfo.image_height);
+			}
+			else if (MODE_RGB == pSrcImage->mode) {
+				rgbCopy = ImagingCopy(pSrcImage);
+			}
+
+			if (nullptr != rgbCopy) {
+				Imaging grayImage = ImagingNew(MODE_L, cinfo.image_width, cinfo.image_height);
+				Fast2Gray::rgb2gray_ToLinear(rgbCopy->block, cinfo.image_width, cinfo.image_height,
+											 grayImage->block);
+				// override
+				const_cast<ImagingMemoryInstance const* __restrict&>(pSrcImage) = grayImage;
+				bReleaseSrcImageCopy = true;
+
+				ImagingDelete(rgbCopy);
+			}
+			else
+				return(false); // unsupported
+		}
+										// Configure JPEG Compression
+		
+		cinfo.input_components = pSrcImage->pixelsize;				/* # of color components per pixel */
+		/* colorspace of input image */
+		switch (pSrcImage->mode)
+		{
+		case MODE_1BIT:
+		case MODE_L:
+			cinfo.in_color_space = JCS_GRAYSCALE;
+			break;
+		case MODE_RGB:
+			cinfo.in_color_space = JCS_RGB;
+			break;
+		case MODE_BGRX:
+			cinfo.in_color_space = JCS_EXT_BGRX;
+			break;
+		case MODE_U32:
+		case MODE_BGRA:
+			cinfo.in_color_space = JCS_EXT_BGRA;
+			break;
+		}
+		 
+		jpeg_set_defaults(&cinfo); // dependent on colorspace first being set
+
+		jpeg_set_quality(&cinfo, JPEG_QUALITY, TRUE /* limit to baseline-JPEG values */);
+
+		cinfo.write_Adobe_marker = FALSE;
+		cinfo.arith_code = FALSE;
+		cinfo.dct_method = JDCT_FLOAT;
+		cinfo.progressive_mode = FALSE;
+		cinfo.optimize_coding = TRUE;
+		cinfo.smoothing_factor = 0;
+		
+		/* colorspace of output image */
+		switch (outClrSpace)
+		{
+		case MODE_1BIT:
+		case MODE_L:
+			cinfo.jpeg_color_space = JCS_GRAYSCALE;
+			cinfo.num_components = 1;
+			break;
+		case MODE_RGB:
+			cinfo.jpeg_color_space = JCS_RGB;
+			cinfo.num_components = 3;
+			break;
+		case MODE_BGRX:
+			cinfo.jpeg_color_space = JCS_EXT_BGRX;
+			cinfo.num_components = 4;
+			break;
+		case MODE_U32:
+		case MODE_BGRA:
+			cinfo.jpeg_color_space = JCS_EXT_BGRA;
+			cinfo.num_components = 4;
+			break;
+		}
+
+		// Start Compression //
+		jpeg_start_compress(&cinfo, TRUE);
+
+		//JSAMPROW row_pointer(pSrcImage->block);      /* pointer to JSAMPLE row[s] */
+		//int const row_stride(cinfo.image_width * cinfo.input_components);  /* physical row width in image buffer */
+									  /* JSAMPLEs per row in image_buffer */
+		//cinfo.next_scanline = 0;
+		//while (cinfo.next_scanline < cinfo.image_height) {
+			/* jpeg_write_scanlines expects an array of pointers to scanlines.
+			* Here the array is only one element long, but you could pass
+			* more than one scanline at a time if that's more convenient.
+			*/
+		//	(void)jpeg_write_scanlines(&cinfo, &row_pointer, 1);
+		//	row_pointer += row_stride;
+		//}
+
+		// feed the compressor scanlines
+		uint8_t* const* __restrict ppOut = pSrcImage->image;
+
+		/* jpeg_write_scanlines expects an array of pointers to scanlines.
+		* Here the array is only one element long, but you could pass
+		* more than one scanline at a time if that's more convenient.
+		*/
+		(void)jpeg_write_scanlines(&cinfo, (JSAMPARRAY)ppOut, cinfo.image_height);
+
+		// Finish compression
+		jpeg_finish_compress(&cinfo);
+		fflush(fOut);
+
+		fclose(fOut); fOut = nullptr;
+
+		// Release memory
+		jpeg_destroy_compress(&cinfo);
+
+		if (bReleaseSrcImageCopy) {
+			ImagingDelete(const_cast<ImagingMemoryInstance* __restrict&>(pSrcImage)); // lazy but works
+		}
+		return(true);
+	}
+
+#endif
+
+	return(false);
+}
+
+void ImagingSaveJPEG(tbb::task_group& __restrict tG, eIMAGINGMODE const outClrSpace, ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath)
+{
+#if INCLUDE_JPEG_SUPPORT
+	wchar_t* threadLocalPathFile = new wchar_t[filenamepath.length() + 1];
+	
+	filenamepath.copy(threadLocalPathFile, filenamepath.length());
+
+	// make a quick copy just to bullet proof (a little)
+	Imaging cpyImage = ImagingCopy(pSrcImage);
+
+	// async non blocking file export
+	tG.run([threadLocalPathFile, cpyImage, outClrSpace]
+	{
+		ImagingSaveJPEG(outClrSpace, cpyImage, threadLocalPathFile);
+
+		ImagingDelete(cpyImage);
+
+		if (threadLocalPathFile) {
+			delete[] threadLocalPathFile;
+		}
+	});
+#endif
+}
+
+#if INCLUDE_TIF_SUPPORT
+bool const __vectorcall ImagingSaveToTif(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath)						// single image //
+{
+	bool bReturn(false);
+	if (((MODE_L | MODE_LA | MODE_L16 | MODE_LA16 | MODE_BGRX | MODE_BGRA | MODE_BGRX16 | MODE_BGRA16) & pSrcImage->mode))
+	{
+		uint32_t samples(0),    // # of components
+			     bits(0),       // bitdepth of a component
+			     interpret(0);  // TinyTIFFWriter_Greyscale, etc
+
+		samples = pSrcImage->bands; // samples / bands / components
+
+		switch (pSrcImage->mode)
+		{
+		case MODE_L:
+			interpret = TinyTIFFWriter_Greyscale;
+			bits = 8;
+			break;
+		case MODE_LA:
+			interpret = TinyTIFFWriter_GreyscaleAndAlpha;
+			bits = 8;
+			break;
+		case MODE_L16:
+			interpret = TinyTIFFWriter_Greyscale;
+			bits = 16;
+			break;
+		case MODE_LA16:
+			interpret = TinyTIFFWriter_GreyscaleAndAlpha;
+			bits = 16;
+			break;
+		case MODE_BGRX16:
+		case MODE_BGRA16:
+			interpret = TinyTIFFWriter_RGBA;
+			bits = 16;
+			break;
+		case MODE_BGRX:
+		case MODE_BGRA:
+		default:
+			interpret = TinyTIFFWriter_RGBA;
+			bits = 8;
+			break;
+		}
+
+		// TINYTIFF_EXPORT TinyTIFFWriterFile* TinyTIFFWriter_open(const char* filename, uint16_t bitsPerSample, enum TinyTIFFWriterSampleFormat sampleFormat, uint16_t samples, uint32_t width, uint32_t height, enum TinyTIFFWriterSampleInterpretation sampleInterpretation);
+
+		TinyTIFFWriterFile* tif = TinyTIFFWriter_open(stringconv::ws2s(filenamepath).c_str(), bits, TinyTIFFWriter_UInt, samples, pSrcImage->xsize, pSrcImage->ysize, (TinyTIFFWriterSampleInterpretation)interpret);
+		if (tif) {
+
+			TinyTIFFWriter_writeImage(tif, pSrcImage->block);
+
+			TinyTIFFWriter_close(tif); tif = nullptr;
+
+			bReturn = true;
+		}
+	}
+
+	return(bReturn);
+}
+#endif
+
+struct KtxHeader {
+	uint8_t identifier[12];
+	uint32_t endianness;
+	uint32_t glType;
+	uint32_t glTypeSize;
+	uint32_t glFormat;
+	uint32_t glInternalFormat;
+	uint32_t glBaseInternalFormat;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t numberOfArrayElements;
+	uint32_t numberOfFaces;
+	uint32_t numberOfMipmapLevels;
+	uint32_t bytesOfKeyValueData;
+};
+
+static uint32_t const __vectorcall ktx_version_from_extension(fs::path const& filename);
+
+bool const __vectorcall ImagingSaveToKTX(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath, int const supercompression) // RGB images should be converted to BGRX first
+{
+	bool bReturn(false);
+
+	if ((MODE_BC1 | MODE_BC4 | MODE_BC5 | MODE_BC7) & pSrcImage->mode) {
+		return(ImagingSaveCompressedBC7ToKTX(pSrcImage, filenamepath));
+	}
+
+	if (KTX_VERSION::KTX2 == ktx_version_from_extension(fs::path(filenamepath))) { // single level chain
+		ImagingMemoryInstance* level(const_cast<ImagingMemoryInstance*>(pSrcImage));
+		ImagingMipChain const chain{ &level, 1, nullptr };
+		return(ImagingSaveMipChainToKTX(&chain, filenamepath, supercompression));
+	}
+
+	// supporting L8, LA8 and RGBA8
+
+	//internal format
+	static constexpr uint32_t const KTX_R8 = 0x8229;
+	static constexpr uint32_t const KTX_RG8 = 0x822B;
+	static constexpr uint32_t const KTX_R16 = 0x822A;
+	static constexpr uint32_t const KTX_RG16 = 0x822C;
+	static constexpr uint32_t const KTX_RGBA8 = 0x8058;
+	static constexpr uint32_t const KTX_RGBA16 = 0x805B;
+
+	//base internal format
+	static constexpr uint32_t const KTX__R = 0x1903;
+	static constexpr uint32_t const KTX__RG = 0x8227;
+	static constexpr uint32_t const KTX__RGBA = 0x1908;
+	
+	static constexpr uint32_t const KTX_UNSIGNED_SHORT = 0x1403;
+	static constexpr uint32_t const KTX_UNSIGNED_BYTE = 0x1401;
+	static constexpr uint32_t const KTX_ENDIAN_REF(0x04030201);
+
+	static constexpr const uint8_t ktx_magic_id[12] = {
+		0xAB, 0x4B, 0x54, 0x58,
+		0x20, 0x31, 0x31, 0xBB,
+		0x0D, 0x0A, 0x1A, 0x0A
+	};
+
+	FILE* fOut;
+
+	if (((MODE_L|MODE_LA|MODE_L16|MODE_LA16|MODE_BGRX|MODE_BGRA|MODE_BGRX16|MODE_BGRA16) & pSrcImage->mode) && 0 == _wfopen_s(&fOut, filenamepath.data(), L"wbS"))
+	{
+		KtxHeader header = {};
+		memcpy(header.identifier, ktx_magic_id, 12);
+
+		header.endianness = KTX_ENDIAN_REF;
+
+		if ((MODE_L16 | MODE_LA16 | MODE_BGRX16 | MODE_BGRA16) & pSrcImage->mode)
+			header.glType = KTX_UNSIGNED_SHORT; //  For compressed formats, type=0.
+		else
+			header.glType = KTX_UNSIGNED_BYTE; //  For compressed formats, type=0.
+
+		header.glTypeSize = pSrcImage->pixelsize;
+
+		switch (pSrcImage->mode)
+		{
+		case MODE_L:
+			header.glFormat = header.glBaseInternalFormat = KTX__R;
+			header.glInternalFormat = KTX_R8;
+			break;
+		case MODE_LA:
+			header.glFormat = header.glBaseInternalFormat = KTX__RG;
+			header.glInternalFormat = KTX_RG8;
+			break;
+		case MODE_L16:
+			header.glFormat = header.glBaseInternalFormat = KTX__R;
+			header.glInternalFormat = KTX_R16;
+			break;
+		case MODE_LA16:
+			header.glFormat = header.glBaseInternalFormat = KTX__RG;
+			header.glInternalFormat = KTX_RG16;
+			break;
+		case MODE_BGRA16:
+		case MODE_BGRX16:
+			header.glFormat = header.glBaseInternalFormat = KTX__RGBA;
+			header.glInternalFormat = KTX_RGBA16;
+			break;
+		case MODE_BGRA:
+		case MODE_BGRX:
+		default:
+			header.glFormat = header.glBaseInternalFormat = KTX__RGBA;
+			header.glInternalFormat = KTX_RGBA8;
+			break;
+		}
+
+		header.pixelWidth = pSrcImage->xsize;
+		header.pixelHeight = pSrcImage->ysize;
+		header.pixelDepth = 0; // must be 0 for 2D/cubemap textures
+		// KTX spec says this field must be 0 for non-array textures
+		header.numberOfArrayElements = 0;
+		header.numberOfFaces = 1;
+		header.numberOfMipmapLevels = 1;
+		header.bytesOfKeyValueData = 0;
+
+		// write header
+		fwrite(&header, sizeof(KtxHeader), 1, fOut);
+
+		// write size of data
+		uint32_t const dataSize(pSrcImage->xsize * pSrcImage->ysize * pSrcImage->pixelsize);
+		fwrite(&dataSize, sizeof(uint32_t), 1, fOut);
+
+		// write data
+		fwrite(&(*pSrcImage->block), dataSize, 1, fOut);
+
+		fflush(fOut);
+		fclose(fOut); fOut = nullptr;
+		bReturn = true;
+	}
+	return(bReturn);
+}
+
+bool const __vectorcall ImagingSaveLayersToKTX(ImagingMemoryInstance const* const* const __restrict pSrcImages, uint32_t const numLayers, std::wstring_view const filenamepath) // RGB images should be converted to BGRX first
+{
+	bool bReturn(false);
+
+	if (numLayers <= 1) {
+		return(false);
+	}
+
+	// supporting L8, LA8 and RGBA8, all images for layers must be equal in type and dimensions
+
+	//internal format
+	static constexpr uint32_t const KTX_R8 = 0x8229;
+	static constexpr uint32_t const KTX_RG8 = 0x822B;
+	static constexpr uint32_t const KTX_R16 = 0x822A;
+	static constexpr uint32_t const KTX_RG16 = 0x822C;
+	static constexpr uint32_t const KTX_RGBA8 = 0x8058;
+	static constexpr uint32_t const KTX_RGBA16 = 0x805B;
+
+	//base internal format
+	static constexpr uint32_t const KTX__R = 0x1903;
+	static constexpr uint32_t const KTX__RG = 0x8227;
+	static constexpr uint32_t const KTX__RGBA = 0x1908;
+
+	static constexpr uint32_t const KTX_UNSIGNED_SHORT = 0x1403;
+	static constexpr uint32_t const KTX_UNSIGNED_BYTE = 0x1401;
+	static constexpr uint32_t const KTX_ENDIAN_REF(0x04030201);
+
+	static constexpr const uint8_t ktx_magic_id[12] = {
+		0xAB, 0x4B, 0x54, 0x58,
+		0x20, 0x31, 0x31, 0xBB,
+		0x0D, 0x0A, 0x1A, 0x0A
+	};
+
+	FILE* fOut;
+	KtxHeader header = {};
+	memcpy(header.identifier, ktx_magic_id, 12);
+
+	if (((MODE_L | MODE_LA | MODE_L16 | MODE_LA16 | MODE_BGRX | MODE_BGRA | MODE_BGRX16 | MODE_BGRA16) & pSrcImages[0]->mode))
+	{
+		header.endianness = KTX_ENDIAN_REF;
+
+		if ((MODE_L16 | MODE_LA16 | MODE_BGRX16 | MODE_BGRA16) & pSrcImages[0]->mode)
+			header.glType = KTX_UNSIGNED_SHORT; //  For compressed formats, type=0.
+		else
+			header.glType = KTX_UNSIGNED_BYTE; //  For compressed formats, type=0.
+
+		header.glTypeSize = pSrcImages[0]->pixelsize;
+
+		switch (pSrcImages[0]->mode)
+		{
+		case MODE_L:
+			header.glFormat = header.glBaseInternalFormat = KTX__R;
+			header.glInternalFormat = KTX_R8;
+			break;
+		case MODE_LA:
+			header.glFormat = header.glBaseInternalFormat = KTX__RG;
+			header.glInternalFormat = KTX_RG8;
+			break;
+		case MODE_L16:
+			header.glFormat = header.glBaseInternalFormat = KTX__R;
+			header.glInternalFormat = KTX_R16;
+			break;
+		case MODE_LA16:
+			header.glFormat = header.glBaseInternalFormat = KTX__RG;
+			header.glInternalFormat = KTX_RG16;
+			break;
+		case MODE_BGRA16:
+		case MODE_BGRX16:
+			header.glFormat = header.glBaseInternalFormat = KTX__RGBA;
+			header.glInternalFormat = KTX_RGBA16;
+			break;
+		case MODE_BGRA:
+		case MODE_BGRX:
+		default:
+			header.glFormat = header.glBaseInternalFormat = KTX__RGBA;
+			header.glInternalFormat = KTX_RGBA8;
+			break;
+		}
+
+		header.pixelWidth = pSrcImages[0]->xsize;
+		header.pixelHeight = pSrcImages[0]->ysize;
+		header.pixelDepth = 0; // must be 0 for 2D/cubemap textures
+		// KTX spec says this field must be 0 for non-array textures
+		header.numberOfArrayElements = numLayers;
+		header.numberOfFaces = 1;
+		header.numberOfMipmapLevels = 1;
+		header.bytesOfKeyValueData = 0;
+	}
+	else if (MODE_BC7 == pSrcImages[0]->mode)
+	{
+		return(false); // todo when needed
+
+	}
+	else
+		return(false);
+
+	if (0 == _wfopen_s(&fOut, filenamepath.data(), L"wbS"))
+	{
+		// write header
+		fwrite(&header, sizeof(KtxHeader), 1, fOut);
+
+		// write size of data
+		uint32_t const layerDataSize(pSrcImages[0]->xsize * pSrcImages[0]->ysize * pSrcImages[0]->pixelsize);
+		fwrite(&layerDataSize, sizeof(uint32_t), 1, fOut);
+
+		// write data
+		for (uint32_t layer = 0; layer < numLayers; ++layer) {
+			fwrite(&(*pSrcImages[layer]->block), layerDataSize, 1, fOut);
+		}
+
+		fflush(fOut);
+		fclose(fOut); fOut = nullptr;
+		bReturn = true;
+	}
+	return(bReturn);
+}
+
+namespace bc_encode { // native block compression. 4x4 blocks are encoded in parallel, tiles of blocks per task. per block: principal axis (power iteration) -> endpoints -> indices by projection onto the endpoint axis -> least squares refit of the endpoints. the 16 pixels of a block are 2 x 8 lanes (AVX2) per channel.
+	                  // normalizedQuality is the search effort: number of refit iterations & exhaustive trials (bc1 3 color mode, bc7 p-bits)
+
+	static constexpr uint32_t const BLOCK_DIM = 4,
+		                            BLOCK_PIXELS = BLOCK_DIM * BLOCK_DIM,
+		                            TILE_BLOCKS = 16; // blocks per tile side (64x64 pixels)
+
+	static constexpr uint32_t const BC1_BLOCK_BYTES = 8,
+		                            BC4_BLOCK_BYTES = 8,
+		                            BC5_BLOCK_BYTES = 16,
+		                            BC7_BLOCK_BYTES = 16;
+
+	static constexpr int32_t const CHANNEL_CONSTANT = -1; // source channel offset, channel is 255 (opaque alpha of BGRX)
+
+	typedef struct alignas(32) block_pixels {
+
+		__m256 c[4][2]; // channel, pixels 0...7 | 8...15. channels that are not used are zero
+
+	} block_pixels;
+
+	typedef struct effort {
+
+		uint32_t const refine; // least squares iterations
+		bool const exhaustive;
+
+		explicit effort(float const normalizedQuality)
+			: refine(1 + uint32_t(SFM::saturate(normalizedQuality) * 3.0f)), exhaustive(normalizedQuality >= 0.5f)
+		{}
+
+	} effort;
+
+	static __inline float const __vectorcall hsum(__m256 const v)
+	{
+		__m128 s(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+		s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+		s = _mm_add_ss(s, _mm_movehdup_ps(s));
+		return(_mm_cvtss_f32(s));
+	}
+
+	// 4x4 pixels at block (bx, by), edges are clamped (replicated) for images that are not a multiple of 4
+	template<uint32_t const Channels>
+	static void __vectorcall fetch(block_pixels& __restrict px, uint8_t const* const* const __restrict image, uint32_t const pixelsize, int32_t const (&offsets)[4],
+		                           uint32_t const width, uint32_t const height, uint32_t const bx, uint32_t const by)
+	{
+		alignas(32) float values[Channels][BLOCK_PIXELS];
+
+		for (uint32_t y = 0; y < BLOCK_DIM; ++y) {
+
+			uint8_t const* const __restrict row(image[std::min(by * BLOCK_DIM + y, height - 1)]);
+
+			for (uint32_t x = 0; x < BLOCK_DIM; ++x) {
+
+				uint8_t const* const __restrict pixel(row + std::min(bx * BLOCK_DIM + x, width - 1) * pixelsize);
+
+				for (uint32_t c = 0; c < Channels; ++c) {
+					values[c][y * BLOCK_DIM + x] = (CHANNEL_CONSTANT == offsets[c] ? 255.0f : float(pixel[offsets[c]]));
+				}
+			}
+		}
+
+		for (uint32_t c = 0; c < 4; ++c) {
+			px.c[c][0] = (c < Channels ? _mm256_load_ps(values[c]) : _mm256_setzero_ps());
+			px.c[c][1] = (c < Channels ? _mm256_load_ps(values[c] + 8) : _mm256_setzero_ps());
+		}
+	}
+
+	// endpoints at the extents of the pixels projected onto the principal axis
+	template<uint32_t const Channels>
+	static void __vectorcall axis_fit(block_pixels const& __restrict px, float (&e0)[4], float (&e1)[4])
+	{
+		float mean[4]{}, axis[4]{}, cov[4][4]{};
+		__m256 d[4][2];
+
+		for (uint32_t c = 0; c < Channels; ++c) {
+			mean[c] = hsum(_mm256_add_ps(px.c[c][0], px.c[c][1])) * (1.0f / float(BLOCK_PIXELS));
+
+			__m256 const m(_mm256_set1_ps(mean[c]));
+			d[c][0] = _mm256_sub_ps(px.c[c][0], m);
+			d[c][1] = _mm256_sub_ps(px.c[c][1], m);
+		}
+
+		for (uint32_t i = 0; i < Channels; ++i) {
+			for (uint32_t j = i; j < Channels; ++j) {
+				cov[i][j] = cov[j][i] = hsum(_mm256_fmadd_ps(d[i][0], d[j][0], _mm256_mul_ps(d[i][1], d[j][1])));
+			}
+		}
+
+		// power iteration, starting from the channel w/ the largest variance
+		uint32_t largest(0);
+		for (uint32_t c = 1; c < Channels; ++c) {
+			if (cov[c][c] > cov[largest][largest]) {
+				largest = c;
+			}
+		}
+		axis[largest] = 1.0f;
+
+		for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+
+			float next[4]{}, length(0.0f);
+
+			for (uint32_t i = 0; i < Channels; ++i) {
+				for (uint32_t j = 0; j < Channels; ++j) {
+					next[i] += cov[i][j] * axis[j];
+				}
+				length = std::max(length, std::abs(next[i]));
+			}
+
+			if (length < 1e-6f) { // flat block
+				break;
+			}
+
+			for (uint32_t c = 0; c < Channels; ++c) {
+				axis[c] = next[c] / length;
+			}
+		}
+
+		// extents along the axis
+		__m256 t[2] = { _mm256_setzero_ps(), _mm256_setzero_ps() };
+		for (uint32_t c = 0; c < Channels; ++c) {
+			__m256 const a(_mm256_set1_ps(axis[c]));
+			t[0] = _mm256_fmadd_ps(d[c][0], a, t[0]);
+			t[1] = _mm256_fmadd_ps(d[c][1], a, t[1]);
+		}
+
+		alignas(32) float projected[BLOCK_PIXELS];
+		_mm256_store_ps(projected, t[0]);
+		_mm256_store_ps(projected + 8, t[1]);
+
+		float t_min(projected[0]), t_max(projected[0]);
+		for (uint32_t i = 1; i < BLOCK_PIXELS; ++i) {
+			t_min = std::min(t_min, projected[i]);
+			t_max = std::max(t_max, projected[i]);
+		}
+
+		float axis_length(0.0f);
+		for (uint32_t c = 0; c < Channels; ++c) {
+			axis_length += axis[c] * axis[c];
+		}
+		axis_length = (axis_length > 0.0f ? 1.0f / axis_length : 0.0f); // projection was not normalized
+
+		for (uint32_t c = 0; c < Channels; ++c) {
+			e0[c] = SFM::clamp(mean[c] + t_min * axis_length * axis[c], 0.0f, 255.0f);
+			e1[c] = SFM::clamp(mean[c] + t_max * axis_length * axis[c], 0.0f, 255.0f);
+		}
+	}
+
+	// index along e0 -> e1, 0 ... levels - 1
+	template<uint32_t const Channels>
+	static void __vectorcall indices(block_pixels const& __restrict px, float const (&e0)[4], float const (&e1)[4], uint32_t const levels, int32_t (&idx)[BLOCK_PIXELS])
+	{
+		float d[4]{}, dd(0.0f);
+		for (uint32_t c = 0; c < Channels; ++c) {
+			d[c] = e1[c] - e0[c];
+			dd += d[c] * d[c];
+		}
+
+		if (dd < 1e-6f) {
+			memset(idx, 0, sizeof(idx));
+			return;
+		}
+
+		__m256 const scale(_mm256_set1_ps(float(levels - 1) / dd)), last(_mm256_set1_ps(float(levels - 1)));
+
+		for (uint32_t h = 0; h < 2; ++h) {
+
+			__m256 t(_mm256_setzero_ps());
+			for (uint32_t c = 0; c < Channels; ++c) {
+				t = _mm256_fmadd_ps(_mm256_sub_ps(px.c[c][h], _mm256_set1_ps(e0[c])), _mm256_set1_ps(d[c]), t);
+			}
+			t = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(t, scale), _mm256_setzero_ps()), last);
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(idx + h * 8), _mm256_cvtps_epi32(t));
+		}
+	}
+
+	// squared error of the block reconstructed from the (decoded) endpoints, weights are 0.0 ... 1.0 per index
+	template<uint32_t const Channels>
+	static float const __vectorcall error(block_pixels const& __restrict px, float const (&e0)[4], float const (&e1)[4], int32_t const (&idx)[BLOCK_PIXELS], float const* const __restrict weights)
+	{
+		alignas(32) float w[BLOCK_PIXELS];
+		for (uint32_t i = 0; i < BLOCK_PIXELS; ++i) {
+			w[i] = weights[idx[i]];
+		}
+
+		__m256 sum(_mm256_setzero_ps());
+		for (uint32_t h = 0; h < 2; ++h) {
+
+			__m256 const wh(_mm256_load_ps(w + h * 8));
+			for (uint32_t c = 0; c < Channels; ++c) {
+				__m256 const reconstructed(_mm256_fmadd_ps(wh, _mm256_set1_ps(e1[c] - e0[c]), _mm256_set1_ps(e0[c])));
+				__m256 const diff(_mm256_sub_ps(reconstructed, px.c[c][h]));
+				sum = _mm256_fmadd_ps(diff, diff, sum);
+			}
+		}
+
+		return(hsum(sum));
+	}
+
+	// least squares endpoints for the current indices, false if the indices are degenerate (single value)
+	template<uint32_t const Channels>
+	static bool const __vectorcall refit(block_pixels const& __restrict px, int32_t const (&idx)[BLOCK_PIXELS], float const* const __restrict weights, float (&e0)[4], float (&e1)[4])
+	{
+		alignas(32) float w[BLOCK_PIXELS];
+		for (uint32_t i = 0; i < BLOCK_PIXELS; ++i) {
+			w[i] = weights[idx[i]];
+		}
+
+		__m256 const one(_mm256_set1_ps(1.0f));
+		__m256 const w0(_mm256_load_ps(w)), w1(_mm256_load_ps(w + 8));
+		__m256 const v0(_mm256_sub_ps(one, w0)), v1(_mm256_sub_ps(one, w1));
+
+		float const A(hsum(_mm256_fmadd_ps(v0, v0, _mm256_mul_ps(v1, v1)))),
+			        B(hsum(_mm256_fmadd_ps(v0, w0, _mm256_mul_ps(v1, w1)))),
+			        C(hsum(_mm256_fmadd_ps(w0, w0, _mm256_mul_ps(w1, w1))));
+
+		float const det(A * C - B * B);
+		if (std::abs(det) < 1e-6f) {
+			return(false);
+		}
+		float const inv_det(1.0f / det);
+
+		for (uint32_t c = 0; c < Channels; ++c) {
+			float const X0(hsum(_mm256_fmadd_ps(v0, px.c[c][0], _mm256_mul_ps(v1, px.c[c][1])))),
+				        X1(hsum(_mm256_fmadd_ps(w0, px.c[c][0], _mm256_mul_ps(w1, px.c[c][1]))));
+
+			e0[c] = SFM::clamp((C * X0 - B * X1) * inv_det, 0.0f, 255.0f);
+			e1[c] = SFM::clamp((A * X1 - B * X0) * inv_det, 0.0f, 255.0f);
+		}
+
+		return(true);
+	}
+
+	// BC1 //
+	static constexpr float const BC1_WEIGHTS4[4] = { 0.0f, 1.0f / 3.0f, 2.0f / 3.0f, 1.0f },
+		                         BC1_WEIGHTS3[3] = { 0.0f, 0.5f, 1.0f };
+
+	static __inline uint32_t const __vectorcall quantize565(float const (&e)[4])
+	{
+		uint32_t const r(SFM::round_to_u32(e[0] * (31.0f / 255.0f))), g(SFM::round_to_u32(e[1] * (63.0f / 255.0f))), b(SFM::round_to_u32(e[2] * (31.0f / 255.0f)));
+		return((r << 11) | (g << 5) | b);
+	}
+	static __inline void __vectorcall decode565(uint32_t const c, float (&e)[4])
+	{
+		uint32_t const r((c >> 11) & 31), g((c >> 5) & 63), b(c & 31);
+		e[0] = float((r << 3) | (r >> 2)); e[1] = float((g << 2) | (g >> 4)); e[2] = float((b << 3) | (b >> 2)); e[3] = 0.0f;
+	}
+
+	typedef struct bc1_candidate {
+		uint32_t c0, c1;
+		int32_t idx[BLOCK_PIXELS];
+		float err;
+	} bc1_candidate;
+
+	// 4 color (levels = 4) or 3 color (levels = 3) mode
+	static void __vectorcall bc1_search(block_pixels const& __restrict px, uint32_t const levels, effort const& __restrict e, bc1_candidate& __restrict best)
+	{
+		float const* const __restrict weights(4 == levels ? BC1_WEIGHTS4 : BC1_WEIGHTS3);
+
+		float e0[4], e1[4];
+		axis_fit<3>(px, e0, e1);
+
+		for (uint32_t iteration = 0; iteration <= e.refine; ++iteration) {
+
+			bc1_candidate candidate;
+			float d0[4], d1[4];
+
+			candidate.c0 = quantize565(e0); candidate.c1 = quantize565(e1);
+			decode565(candidate.c0, d0); decode565(candidate.c1, d1);
+
+			indices<3>(px, d0, d1, levels, candidate.idx);
+			candidate.err = error<3>(px, d0, d1, candidate.idx, weights);
+
+			if (candidate.err < best.err) {
+				best = candidate;
+			}
+
+			if (iteration == e.refine || !refit<3>(px, candidate.idx, weights, e0, e1)) {
+				break;
+			}
+		}
+	}
+
+	static void __vectorcall bc1(block_pixels& __restrict px, effort const& __restrict e, uint8_t* const __restrict out)
+	{
+		alignas(32) float alpha[BLOCK_PIXELS];
+		_mm256_store_ps(alpha, px.c[3][0]);
+		_mm256_store_ps(alpha + 8, px.c[3][1]);
+
+		uint32_t transparent(0); // bit per pixel
+		for (uint32_t i = 0; i < BLOCK_PIXELS; ++i) {
+			transparent |= uint32_t(alpha[i] < 128.0f) << i;
+		}
+
+		bc1_candidate best;
+		best.err = FLT_MAX;
+
+		bool three_color(0 != transparent);
+
+		if (0xffff == transparent) { // all transparent
+			best.c0 = best.c1 = 0;
+			memset(best.idx, 0, sizeof(best.idx));
+		}
+		else if (transparent) { // punch through alpha, transparent pixels take the mean of the opaque pixels so they do not affect the fit
+			alignas(32) float values[3][BLOCK_PIXELS];
+			float mean[3]{}, count(0.0f);
+
+			for (uint32_t c = 0; c < 3; ++c) {
+				_mm256_store_ps(values[c], px.c[c][0]);
+				_mm256_store_ps(values[c] + 8, px.c[c][1]);
+			}
+			for (uint32_t i = 0; i < BLOCK_PIXELS; ++i) {
+				if (0 == (transparent & (1 << i))) {
+					mean[0] += values[0][i]; mean[1] += values[1][i]; mean[2] += values[2][i];
+					count += 1.0f;
+				}
+			}
+			for (uint32_t c = 0; c < 3; ++c) {
+				mean[c] /= count;
+				for (uint32_t i = 0; i < BLOCK_PIXELS; ++i) {
+					if (transparent & (1 << i)) {
+						values[c][i] = mean[c];
+					}
+				}
+				px.c[c][0] = _mm256_load_ps(values[c]);
+				px.c[c][1] = _mm256_load_ps(values[c] + 8);
+			}
+
+			bc1_search(px, 3, e, best);
+		}
+		else {
+			bc1_search(px, 4, e, best);
+
+			if (e.exhaustive) {
+				bc1_candidate three;
+				three.err = best.err;
+				bc1_search(px, 3, e, three);
+
+				if (three.err < best.err) {
+					best = three;
+					three_color = true;
+				}
+			}
+		}
+
+		// color0 > color1 selects 4 color mode, color0 <= color1 selects 3 color mode (+ transparent black)
+		uint32_t c0(best.c0), c1(best.c1);
+		uint32_t selector(0);
+
+		if (three_color) {
+			static constexpr uint32_t const remap[3] = { 0, 2, 1 }; // along the axis -> bc1 index
+
+			bool const swap(c0 > c1);
+			if (swap) {
+				std::swap(c0, c1);
+			}
+			for (uint32_t i = 0; i < BLOCK_PIXELS; ++i) {
+				uint32_t const index((transparent & (1 << i)) ? 3 : remap[swap ? 2 - best.idx[i] : best.idx[i]]);
+				selector |= index << (i * 2);
+			}
+		}
+		else {
+			static constexpr uint32_t const remap[4] = { 0, 2, 3, 1 }; // along the axis -> bc1 index
+
+			if (c0 != c1) {
+				bool const swap(c0 < c1);
+				if (swap) {
+					std::swap(c0, c1);
+				}
+				for (uint32_t i = 0; i < BLOCK_PIXELS; ++i) {
+					selector |= remap[swap ? 3 - best.idx[i] : best.idx[i]] << (i * 2);
+				}
+			} // else single color, all indices 0
+		}
+
+		uint16_t const colors[2] = { uint16_t(c0), uint16_t(c1) };
+		memcpy(out, colors, sizeof(colors));
+		memcpy(out + 4, &selector, sizeof(selector));
+	}
+
+	// BC4 //
+	static constexpr float const BC4_WEIGHTS[8] = { 0.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f, 1.0f };
+
+	// single channel of px (channel is moved to 0), 8 value mode (red0 > red1)
+	static void __vectorcall bc4(block_pixels const& __restrict source, uint32_t const channel, effort const& __restrict e, uint8_t* const __restrict out)
+	{
+		block_pixels px;
+		px.c[0][0] = source.c[channel][0];
+		px.c[0][1] = source.c[channel][1];
+
+		float e0[4]{}, e1[4]{};
+		{
+			__m256 const lo(_mm256_min_ps(px.c[0][0], px.c[0][1])), hi(_mm256_max_ps(px.c[0][0], px.c[0][1]));
+			alignas(32) float l[8], h[8];
+			_mm256_store_ps(l, lo); _mm256_store_ps(h, hi);
+
+			e0[0] = *std::max_element(h, h + 8);
+			e1[0] = *std::min_element(l, l + 8);
+		}
+
+		uint32_t best_r0(0), best_r1(0);
+		int32_t best_idx[BLOCK_PIXELS]{};
+		float best_err(FLT_MAX);
+
+		for (uint32_t iteration = 0; iteration <= e.refine; ++iteration) {
+
+			uint32_t const r0(SFM::round_to_u32(e0[0])), r1(SFM::round_to_u32(e1[0]));
+			float const d0[4] = { float(r0) }, d1[4] = { float(r1) };
+
+			int32_t idx[BLOCK_PIXELS];
+			indices<1>(px, d0, d1, 8, idx);
+			float const err(error<1>(px, d0, d1, idx, BC4_WEIGHTS));
+
+			if (err < best_err) {
+				best_err = err; best_r0 = r0; best_r1 = r1;
+				memcpy(best_idx, idx, sizeof(idx));
+			}
+
+			if (iteration == e.refine || 0.0f == err || !refit<1>(px, idx, BC4_WEIGHTS, e0, e1)) {
+				break;
+			}
+		}
+
+		uint64_t selector(0);
+
+		if (best_r0 != best_r1) { // else single value, all indices 0
+			bool const swap(best_r0 < best_r1);
+			if (swap) {
+				std::swap(best_r0, best_r1);
+			}
+			for (uint32_t i = 0; i < BLOCK_PIXELS; ++i) {
+				uint32_t const t(swap ? 7 - best_idx[i] : best_idx[i]); // along the axis
+				uint64_t const index(0 == t ? 0 : (7 == t ? 1 : t + 1)); // -> bc4 index
+				selector |= index << (i * 3);
+			}
+		}
+
+		out[0] = uint8_t(best_r0);
+		out[1] = uint8_t(best_r1);
+		memcpy(out + 2, &selector, 6);
+	}
+
+	// BC7 // mode 6 only: 1 subset, rgba 7.7.7.7 endpoints + unique p-bit, 4 bit indices
+	static constexpr float const BC7_WEIGHTS[16] = { 0.0f / 64.0f, 4.0f / 64.0f, 9.0f / 64.0f, 13.0f / 64.0f, 17.0f / 64.0f, 21.0f / 64.0f, 26.0f / 64.0f, 30.0f / 64.0f,
+		                                             34.0f / 64.0f, 38.0f / 64.0f, 43.0f / 64.0f, 47.0f / 64.0f, 51.0f / 64.0f, 55.0f / 64.0f, 60.0f / 64.0f, 64.0f / 64.0f };
+
+	static __inline void __vectorcall quantize7(float const (&e)[4], uint32_t const p, uint32_t (&q)[4], float (&d)[4])
+	{
+		for (uint32_t c = 0; c < 4; ++c) {
+			q[c] = std::min(127u, SFM::round_to_u32(std::max(0.0f, e[c] - float(p)) * 0.5f));
+			d[c] = float((q[c] << 1) | p);
+		}
+	}
+
+	typedef struct bc7_candidate {
+		uint32_t q0[4], q1[4], p0, p1;
+		int32_t idx[BLOCK_PIXELS];
+		float err;
+	} bc7_candidate;
+
+	static void __vectorcall bc7_evaluate(block_pixels const& __restrict px, float const (&e0)[4], float const (&e1)[4], uint32_t const p0, uint32_t const p1, bc7_candidate& __restrict best)
+	{
+		bc7_candidate candidate;
+		float d0[4], d1[4];
+
+		quantize7(e0, p0, candidate.q0, d0);
+		quantize7(e1, p1, candidate.q1, d1);
+		candidate.p0 = p0; candidate.p1 = p1;
+
+		indices<4>(px, d0, d1, 16, candidate.idx);
+		candidate.err = error<4>(px, d0, d1, candidate.idx, BC7_WEIGHTS);
+
+		if (candidate.err < best.err) {
+			best = candidate;
+		}
+	}
+
+	static __inline uint32_t const __vectorcall nearest_pbit(float const (&e)[4])
+	{
+		float err[2]{};
+		for (uint32_t p = 0; p < 2; ++p) {
+			uint32_t q[4]; float d[4];
+			quantize7(e, p, q, d);
+			for (uint32_t c = 0; c < 4; ++c) {
+				err[p] += (d[c] - e[c]) * (d[c] - e[c]);
+			}
+		}
+		return(err[1] < err[0] ? 1 : 0);
+	}
+
+	typedef struct bc7_bits { // little endian bit stream of 128 bits
+
+		uint64_t v[2]{};
+		uint32_t position = 0;
+
+		__inline void __vectorcall put(uint64_t const value, uint32_t const bits) {
+
+			uint32_t const word(position >> 6), shift(position & 63);
+
+			v[word] |= value << shift;
+			if (shift + bits > 64) {
+				v[word + 1] |= value >> (64 - shift);
+			}
+			position += bits;
+		}
+
+	} bc7_bits;
+
+	static void __vectorcall bc7(block_pixels const& __restrict px, effort const& __restrict e, uint8_t* const __restrict out)
+	{
+		float e0[4], e1[4];
+		axis_fit<4>(px, e0, e1);
+
+		bc7_candidate best;
+		best.err = FLT_MAX;
+
+		for (uint32_t iteration = 0; iteration <= e.refine; ++iteration) {
+
+			if (e.exhaustive) { // all p-bit combinations
+				for (uint32_t p = 0; p < 4; ++p) {
+					bc7_evaluate(px, e0, e1, p & 1, p >> 1, best);
+				}
+			}
+			else {
+				bc7_evaluate(px, e0, e1, nearest_pbit(e0), nearest_pbit(e1), best);
+			}
+
+			if (iteration == e.refine || 0.0f == best.err || !refit<4>(px, best.idx, BC7_WEIGHTS, e0, e1)) {
+				break;
+			}
+		}
+
+		// anchor index (pixel 0) msb must be 0
+		if (best.idx[0] >= 8) {
+			std::swap(best.q0, best.q1);
+			std::swap(best.p0, best.p1);
+			for (uint32_t i = 0; i < BLOCK_PIXELS; ++i) {
+				best.idx[i] = 15 - best.idx[i];
+			}
+		}
+
+		bc7_bits bits;
+		bits.put(1 << 6, 7); // mode 6
+
+		for (uint32_t c = 0; c < 4; ++c) {
+			bits.put(best.q0[c], 7);
+			bits.put(best.q1[c], 7);
+		}
+		bits.put(best.p0, 1);
+		bits.put(best.p1, 1);
+
+		bits.put(best.idx[0], 3);
+		for (uint32_t i = 1; i < BLOCK_PIXELS; ++i) {
+			bits.put(best.idx[i], 4);
+		}
+
+		memcpy(out, bits.v, sizeof(bits.v));
+	}
+
+	// all blocks of the image, tiles of blocks in parallel
+	template<uint32_t const Channels, typename Encode>
+	static void __vectorcall encode(ImagingMemoryInstance const* const __restrict im, int32_t const (&offsets)[4], uint8_t* const __restrict out, uint32_t const block_bytes, Encode&& encode_block)
+	{
+		struct { // avoid lambda heap
+			uint8_t const* const* const __restrict image;
+			uint8_t* const __restrict out;
+			int32_t const (&offsets)[4];
+			uint32_t const pixelsize, width, height, blocks_x, block_bytes;
+
+		} const p = { im->image, out, offsets, (uint32_t)im->pixelsize, (uint32_t)im->xsize, (uint32_t)im->ysize,
+			          ((uint32_t)im->xsize + BLOCK_DIM - 1) / BLOCK_DIM, block_bytes };
+
+		uint32_t const blocks_y(((uint32_t)im->ysize + BLOCK_DIM - 1) / BLOCK_DIM);
+
+		tbb::parallel_for(tbb::blocked_range2d<uint32_t>(0, blocks_y, TILE_BLOCKS, 0, p.blocks_x, TILE_BLOCKS), [&p, &encode_block](tbb::blocked_range2d<uint32_t> const& r) {
+
+			block_pixels px;
+
+			for (uint32_t by = r.rows().begin(); by < r.rows().end(); ++by) {
+				for (uint32_t bx = r.cols().begin(); bx < r.cols().end(); ++bx) {
+
+					fetch<Channels>(px, p.image, p.pixelsize, p.offsets, p.width, p.height, bx, by);
+					encode_block(px, p.out + (size_t(by) * size_t(p.blocks_x) + size_t(bx)) * size_t(p.block_bytes));
+				}
+			}
+		});
+	}
+
+	static size_t const __vectorcall compressed_size(uint32_t const width, uint32_t const height, uint32_t const block_bytes)
+	{
+		return(size_t((width + BLOCK_DIM - 1) / BLOCK_DIM) * size_t((height + BLOCK_DIM - 1) / BLOCK_DIM) * size_t(block_bytes));
+	}
+
+	static uint32_t const __vectorcall block_bytes(eIMAGINGMODE const mode)
+	{
+		switch (mode)
+		{
+		case MODE_BC1:
+			return(BC1_BLOCK_BYTES);
+		case MODE_BC4:
+			return(BC4_BLOCK_BYTES);
+		case MODE_BC5:
+			return(BC5_BLOCK_BYTES);
+		case MODE_BC7:
+		case MODE_BC6A:
+		default:
+			return(BC7_BLOCK_BYTES);
+		}
+	}
+
+} // end ns
+
+bool const __vectorcall ImagingSaveCompressedBC7ToKTX(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath)
+{
+	bool bReturn(false);
+
+	static constexpr uint32_t const KTX_COMPRESSED_RGBA_BPTC_UNORM_ARB = 0x8E8C;
+	static constexpr uint32_t const KTX_COMPRESSED_RGBA_S3TC_DXT1_EXT = 0x83F1;
+	static constexpr uint32_t const KTX_COMPRESSED_RED_RGTC1 = 0x8DBB;
+	static constexpr uint32_t const KTX_COMPRESSED_RG_RGTC2 = 0x8DBD;
+	static constexpr uint32_t const KTX__RGBA = 0x1908;
+	static constexpr uint32_t const KTX__RED = 0x1903;
+	static constexpr uint32_t const KTX__RG = 0x8227;
+	static constexpr uint32_t const KTX_UNSIGNED_BYTE = 0x1401;
+	static constexpr uint32_t const KTX_ENDIAN_REF(0x04030201);
+	
+	static constexpr const uint8_t ktx_magic_id[12] = {
+		0xAB, 0x4B, 0x54, 0x58,
+		0x20, 0x31, 0x31, 0xBB,
+		0x0D, 0x0A, 0x1A, 0x0A
+	};
+
+	FILE* fOut;
+
+	if (((MODE_BC1 | MODE_BC4 | MODE_BC5 | MODE_BC7) & pSrcImage->mode) && 0 == _wfopen_s(&fOut, filenamepath.data(), L"wbS"))
+	{
+		KtxHeader header = {};
+		memcpy(header.identifier, ktx_magic_id, 12);
+
+		header.endianness = KTX_ENDIAN_REF;
+		header.glType = 0; //  For compressed formats, type=0.
+		header.glTypeSize = 1; // or endianness conversion. for compressed types, size=1
+		header.glFormat = 0; // For compressed formats, format=0
+		switch (pSrcImage->mode)
+		{
+		case MODE_BC1:
+			header.glInternalFormat = KTX_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+			header.glBaseInternalFormat = KTX__RGBA;
+			break;
+		case MODE_BC4:
+			header.glInternalFormat = KTX_COMPRESSED_RED_RGTC1;
+			header.glBaseInternalFormat = KTX__RED;
+			break;
+		case MODE_BC5:
+			header.glInternalFormat = KTX_COMPRESSED_RG_RGTC2;
+			header.glBaseInternalFormat = KTX__RG;
+			break;
+		case MODE_BC7:
+		default:
+			header.glInternalFormat = KTX_COMPRESSED_RGBA_BPTC_UNORM_ARB;
+			header.glBaseInternalFormat = KTX__RGBA;
+			break;
+		}
+		header.pixelWidth = pSrcImage->xsize;
+		header.pixelHeight = pSrcImage->ysize;
+		header.pixelDepth = 0; // must be 0 for 2D/cubemap textures
+		// KTX spec says this field must be 0 for non-array textures
+		header.numberOfArrayElements = 0;
+		header.numberOfFaces = 1;
+		header.numberOfMipmapLevels = 1;
+		header.bytesOfKeyValueData = 0;
+
+		// write header
+		fwrite(&header, sizeof(KtxHeader), 1, fOut);
+
+		// write size of compressed data, partial blocks at the edges are whole blocks
+		uint32_t const dataCompressedSize((uint32_t)bc_encode::compressed_size(header.pixelWidth, header.pixelHeight, bc_encode::block_bytes(pSrcImage->mode)));
+		fwrite(&dataCompressedSize, sizeof(uint32_t), 1, fOut);
+
+		fwrite(&(*pSrcImage->block), dataCompressedSize, 1, fOut);
+		fflush(fOut);
+		fclose(fOut); fOut = nullptr;
+		bReturn = true;
+	}
+	return(bReturn);
+}
+
+static ImagingMemoryInstance* const __restrict __vectorcall ImagingNewCompressed(eIMAGINGMODE const mode, ImagingMemoryInstance const* const __restrict pSrcImage)
+{
+	return(ImagingNewCompressed(mode, pSrcImage->xsize, pSrcImage->ysize, (int)bc_encode::compressed_size(pSrcImage->xsize, pSrcImage->ysize, bc_encode::block_bytes(mode))));
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingCompressBGRAToBC1(ImagingMemoryInstance const* const __restrict pSrcImage, float const normalizedQuality)
+{
+	static constexpr int32_t const offsets[4] = { 0, 1, 2, 3 }; // rgba mem order
+
+	if (MODE_BGRA != pSrcImage->mode && MODE_BGRX != pSrcImage->mode) {
+		return((Imaging)ImagingError_ModeError());
+	}
+
+	Imaging const imgReturn(ImagingNewCompressed(MODE_BC1, pSrcImage));
+	if (nullptr == imgReturn) {
+		return(nullptr);
+	}
+
+	bc_encode::effort const e(normalizedQuality);
+	bool const alpha(MODE_BGRA == pSrcImage->mode); // BGRX is always opaque, 4 color mode only
+
+	bc_encode::encode<4>(pSrcImage, offsets, imgReturn->block, bc_encode::BC1_BLOCK_BYTES, [&e, alpha](bc_encode::block_pixels& px, uint8_t* const __restrict out) {
+
+		if (!alpha) {
+			px.c[3][0] = px.c[3][1] = _mm256_set1_ps(255.0f);
+		}
+		bc_encode::bc1(px, e, out);
+	});
+
+	return(imgReturn);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingCompressToBC4(ImagingMemoryInstance const* const __restrict pSrcImage, float const normalizedQuality)
+{
+	static constexpr int32_t const offsets[4] = { 0, 0, 0, 0 }; // L or R
+
+	if (0 == ((MODE_L | MODE_LA | MODE_BGRX | MODE_BGRA) & pSrcImage->mode)) {
+		return((Imaging)ImagingError_ModeError());
+	}
+
+	Imaging const imgReturn(ImagingNewCompressed(MODE_BC4, pSrcImage));
+	if (nullptr == imgReturn) {
+		return(nullptr);
+	}
+
+	bc_encode::effort const e(normalizedQuality);
+
+	bc_encode::encode<1>(pSrcImage, offsets, imgReturn->block, bc_encode::BC4_BLOCK_BYTES, [&e](bc_encode::block_pixels& px, uint8_t* const __restrict out) {
+
+		bc_encode::bc4(px, 0, e, out);
+	});
+
+	return(imgReturn);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingCompressToBC5(ImagingMemoryInstance const* const __restrict pSrcImage, float const normalizedQuality)
+{
+	static constexpr int32_t const offsets[4] = { 0, 1, 0, 0 }; // L, A or R, G
+
+	if (0 == ((MODE_LA | MODE_BGRX | MODE_BGRA) & pSrcImage->mode)) {
+		return((Imaging)ImagingError_ModeError());
+	}
+
+	Imaging const imgReturn(ImagingNewCompressed(MODE_BC5, pSrcImage));
+	if (nullptr == imgReturn) {
+		return(nullptr);
+	}
+
+	bc_encode::effort const e(normalizedQuality);
+
+	bc_encode::encode<2>(pSrcImage, offsets, imgReturn->block, bc_encode::BC5_BLOCK_BYTES, [&e](bc_encode::block_pixels& px, uint8_t* const __restrict out) {
+
+		bc_encode::bc4(px, 0, e, out);
+		bc_encode::bc4(px, 1, e, out + bc_encode::BC4_BLOCK_BYTES);
+	});
+
+	return(imgReturn);
+}
+
+// Isolated Dynamic DLL Compressonator.dll //
+// Loaded dynamically at run time, to isolate and shutdown thread usage //
+typedef BC_ERROR (CMP_API * const PROC_CMP_InitializeBCLibrary)(void);
+typedef CMP_DWORD (CMP_API * const PROC_CMP_CalculateBufferSize)(const CMP_Texture* pTexture);
+typedef BC_ERROR (CMP_API * const PROC_CMP_ShutdownBCLibrary)(void);
+typedef CMP_ERROR (CMP_API * const PROC_CMP_ConvertTexture)(CMP_Texture* pSourceTexture, CMP_Texture* pDestTexture, const CMP_CompressOptions* pOptions,
+	CMP_Feedback_Proc pFeedbackProc, CMP_DWORD_PTR pUser1, CMP_DWORD_PTR pUser2);
+
+static ImagingMemoryInstance* const __restrict __vectorcall CompressonatorBGRAToBC7(ImagingMemoryInstance const* const __restrict pSrcImage, float const normalizedQuality) // nullptr if Compressonator.dll is not available or failed
+{
+	ImagingMemoryInstance* __restrict imgReturn(nullptr);
+
+	HINSTANCE hinstLib(LoadLibrary(L"Compressonator.dll"));
+	if (nullptr != hinstLib) {
+
+		PROC_CMP_InitializeBCLibrary	InitializeBCLibrary( (PROC_CMP_InitializeBCLibrary)GetProcAddress(hinstLib, "CMP_InitializeBCLibrary") );
+		PROC_CMP_CalculateBufferSize	CalculateBufferSize((PROC_CMP_CalculateBufferSize)GetProcAddress(hinstLib, "CMP_CalculateBufferSize"));
+		PROC_CMP_ShutdownBCLibrary		ShutdownBCLibrary((PROC_CMP_ShutdownBCLibrary)GetProcAddress(hinstLib, "CMP_ShutdownBCLibrary"));
+		PROC_CMP_ConvertTexture			ConvertTexture((PROC_CMP_ConvertTexture)GetProcAddress(hinstLib, "CMP_ConvertTexture"));
+
+		if (nullptr != InitializeBCLibrary && nullptr != CalculateBufferSize && nullptr != ShutdownBCLibrary && nullptr != ConvertTexture) {
+
+			InitializeBCLibrary();
+
+			CMP_Texture srcTexture;
+			srcTexture.dwSize = sizeof(CMP_Texture);
+			srcTexture.dwWidth = pSrcImage->xsize;
+			srcTexture.dwHeight = pSrcImage->ysize;
+			srcTexture.dwPitch = pSrcImage->linesize;
+			srcTexture.dwDataSize = pSrcImage->pixelsize * pSrcImage->xsize * pSrcImage->ysize;
+			srcTexture.pData = pSrcImage->block;
+			srcTexture.format = CMP_FORMAT_BGRA_8888;
+
+			//===================================
+			// Initialize Compressed Destination
+			//===================================
+			CMP_Texture destTexture;
+			destTexture.dwSize = sizeof(destTexture);
+			destTexture.dwWidth = srcTexture.dwWidth;
+			destTexture.dwHeight = srcTexture.dwHeight;
+			destTexture.dwPitch = 0;
+			destTexture.format = CMP_FORMAT_BC7;
+			destTexture.dwDataSize = CalculateBufferSize(&destTexture);
+			imgReturn = ImagingNewCompressed(MODE_BC7, destTexture.dwWidth, destTexture.dwHeight, destTexture.dwDataSize);
+			
+			if (nullptr != imgReturn) {
+
+				destTexture.pData = (CMP_BYTE*)imgReturn->block;
+				destTexture.nBlockWidth = bc_encode::BLOCK_DIM;
+				destTexture.nBlockHeight = bc_encode::BLOCK_DIM;
+				destTexture.nBlockDepth = 1;
+
+				//==========================
+				// Set Compression Options
+				//==========================
+				CMP_CompressOptions options = { 0 };
+				options.dwSize = sizeof(options);
+				options.fquality = normalizedQuality;
+				options.dwnumThreads = 1;
+				options.bDisableMultiThreading = true;  // compressonator libray spawns multiple threads that stick around eatring resourcfes of the main application
+
+				//==========================
+				// Compress Texture
+				//==========================
+				CMP_ERROR cmp_status = ConvertTexture(&srcTexture, &destTexture, &options, NULL, NULL, NULL);
+				if (CMP_OK != cmp_status)
+				{
+					ImagingDelete(imgReturn); imgReturn = nullptr;
+				}
 			}
-			else {
-				mode = MODE_L;
+			ShutdownBCLibrary();
+		}
+		FreeLibrary(hinstLib);
+		CoFreeUnusedLibrariesEx(0, 0); // actually unloads the dll from memory immediately if ShutdownBCLibrary has been called first or InitializeBCLibrary was never called
+	}
+
+	return(imgReturn);
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall ImagingCompressBGRAToBC7(ImagingMemoryInstance const* const __restrict pSrcImage, float const normalizedQuality)
+{
+	static constexpr int32_t const offsets_bgra[4] = { 0, 1, 2, 3 }, // rgba mem order
+		                           offsets_bgrx[4] = { 0, 1, 2, bc_encode::CHANNEL_CONSTANT };
+
+	if (MODE_BGRA != pSrcImage->mode && MODE_BGRX != pSrcImage->mode) {
+		return((Imaging)ImagingError_ModeError());
+	}
+
+	if (normalizedQuality >= 0.5f) { // full quality (all bc7 modes) thru Compressonator when available
+		Imaging const imgCompressonator(CompressonatorBGRAToBC7(pSrcImage, normalizedQuality));
+		if (nullptr != imgCompressonator) {
+			return(imgCompressonator);
+		}
+	}
+
+	// native fast encoder (mode 6) - Compressonator.dll is not available or the fast path was requested
+	Imaging const imgReturn(ImagingNewCompressed(MODE_BC7, pSrcImage));
+	if (nullptr == imgReturn) {
+		return(nullptr);
+	}
+
+	bc_encode::effort const e(normalizedQuality);
+
+	bc_encode::encode<4>(pSrcImage, (MODE_BGRA == pSrcImage->mode ? offsets_bgra : offsets_bgrx), imgReturn->block, bc_encode::BC7_BLOCK_BYTES, [&e](bc_encode::block_pixels& px, uint8_t* const __restrict out) {
+
+		bc_encode::bc7(px, e, out);
+	});
+
+	return(imgReturn);
+}
+
+static uint32_t const __vectorcall ktx_version_from_extension(fs::path const& filename)
+{
+	static constexpr wchar_t const* const EXTENSION_KTX1 = L".ktx";
+	static constexpr wchar_t const* const EXTENSION_KTX2 = L".ktx2";
+
+	if (filename.extension() == EXTENSION_KTX1) {
+		return(KTX_VERSION::KTX1);
+	}
+	else if (filename.extension() == EXTENSION_KTX2) {
+		return(KTX_VERSION::KTX2);
+	}
+	return(0);
+}
+
+struct Ktx2Header {
+	uint8_t identifier[12];
+	uint32_t vkFormat;
+	uint32_t typeSize;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t layerCount;
+	uint32_t faceCount;
+	uint32_t levelCount;
+	uint32_t supercompressionScheme;
+	uint32_t dfdByteOffset;
+	uint32_t dfdByteLength;
+	uint32_t kvdByteOffset;
+	uint32_t kvdByteLength;
+	uint64_t sgdByteOffset;
+	uint64_t sgdByteLength;
+};
+static_assert(80 == sizeof(Ktx2Header));
+
+struct Ktx2LevelIndex {
+	uint64_t byteOffset;
+	uint64_t byteLength;
+	uint64_t uncompressedByteLength;
+};
+
+namespace writer { // file output, directly to a FILE or to a growing memory buffer (encoded ahead of the write, export queue)
+
+	typedef struct file {
+
+		FILE* __restrict fOut;
+
+		void write(void const* const __restrict data, size_t const bytes) { fwrite(data, bytes, 1, fOut); }
+
+	} file;
+
+	typedef struct memory { // the buffer is sector aligned & sized so it can be written unbuffered
+
+		static constexpr size_t const ALIGNMENT = 4096;
+
+		uint8_t* __restrict data = nullptr;
+		size_t size = 0, capacity = 0;
+		bool ok = true;
+
+		bool const reserve(size_t const bytes)
+		{
+			if (bytes > capacity) {
+				size_t const grown(std::max(capacity << 1, ((bytes + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT));
+				uint8_t* const __restrict grown_data((uint8_t*)scalable_aligned_realloc(data, grown, ALIGNMENT));
+				if (!grown_data) {
+					ok = false;
+					return(false);
+				}
+				data = grown_data;
+				capacity = grown;
 			}
-			break;
-		case 2:
-			if (bits > 8) {
-				mode = MODE_LA16;
+			return(true);
+		}
+
+		void write(void const* const __restrict src, size_t const bytes)
+		{
+			if (ok && reserve(size + bytes)) {
+				memcpy(data + size, src, bytes);
+				size += bytes;
 			}
-			else {
-				mode = MODE_LA;
+		}
+
+		void release()
+		{
+			if (data) {
+				scalable_aligned_free(data); data = nullptr;
 			}
-			break;
-		case 3:
-			if (bits > 8) {
-				mode = MODE_RGB16;
+			size = capacity = 0;
+		}
+
+	} memory;
+
+} // end ns
+
+template<typename Writer>
+static void __vectorcall ktx_write_level(ImagingMemoryInstance const* const __restrict level, Writer& __restrict out)
+{
+	uint32_t const rowSize(level->xsize * level->pixelsize);
+
+	for (int y = 0; y < level->ysize; ++y) {
+		out.write(level->image[y], rowSize);
+	}
+}
+
+template<typename Writer>
+static void __vectorcall ktx_write_padding(uint32_t const padding, Writer& __restrict out)
+{
+	static constexpr uint8_t const zeroes[16]{};
+
+	if (padding) {
+		out.write(zeroes, padding);
+	}
+}
+
+namespace ktx_supercompression { // KTX2 supercompression scheme 2 (zstd). a level is split into frames of whole rows (~FRAME_BYTES uncompressed), the frames of all levels are compressed / decompressed in parallel.
+								 // the concatenated frames of a level are a valid zstd stream for any reader, levels written by other tools (a single frame) decompress as one task.
+
+	static constexpr uint32_t const SCHEME_NONE = 0,
+									SCHEME_ZSTD = 2;
+	static constexpr size_t const FRAME_BYTES = 1 << 20;
+
+	typedef struct frame {
+
+		uint8_t const* __restrict src;
+		size_t                    src_bytes;
+		uint8_t* __restrict       dst;
+		size_t                    dst_bytes;
+
+		uint32_t level, first_row, rows; // compression source
+
+	} frame;
+
+	typedef struct compressed_level { // frames in order
+
+		uint32_t first, count;
+		uint64_t bytes;
+
+	} compressed_level;
+
+	static void __vectorcall release(std::vector<frame>& __restrict frames)
+	{
+		for (frame& f : frames) {
+			if (f.dst) {
+				scalable_free(f.dst); f.dst = nullptr;
 			}
-			else {
-				mode = MODE_RGB;
+		}
+	}
+
+	// frames[] of every level in the chain, levels[] indexes them. the compressed frame data is released w/ release()
+	static bool const __vectorcall compress(ImagingMipChain const* const __restrict chain, int const compression, std::vector<frame>& __restrict frames, std::vector<compressed_level>& __restrict levels)
+	{
+#if INCLUDE_ZSTD_SUPPORT
+		levels.resize(chain->count);
+
+		for (uint32_t level = 0; level < chain->count; ++level) {
+			ImagingMemoryInstance const* const __restrict im(chain->levels[level]);
+
+			size_t const row_bytes(size_t(im->xsize) * size_t(im->pixelsize));
+			uint32_t const rows_per_frame((uint32_t)std::max(size_t(1), FRAME_BYTES / row_bytes));
+
+			levels[level] = { (uint32_t)frames.size(), 0, 0 };
+			for (uint32_t row = 0; row < (uint32_t)im->ysize; row += rows_per_frame) {
+				frames.push_back(frame{ nullptr, 0, nullptr, 0, level, row, SFM::min(rows_per_frame, (uint32_t)im->ysize - row) });
+				++levels[level].count;
+			}
+		}
+
+		std::atomic_bool ok(true);
+
+		struct { // avoid lambda heap
+			ImagingMipChain const* const __restrict chain;
+			frame* const __restrict frames;
+			int const compression;
+			std::atomic_bool& __restrict ok;
+
+		} const p = { chain, frames.data(), compression, ok };
+
+		tbb::parallel_for(size_t(0), frames.size(), [&p](size_t const i) {
+
+			frame& __restrict f(p.frames[i]);
+			ImagingMemoryInstance const* const __restrict im(p.chain->levels[f.level]);
+
+			size_t const row_bytes(size_t(im->xsize) * size_t(im->pixelsize));
+			size_t const bytes(row_bytes * f.rows);
+			size_t const capacity(ZSTD_compressBound(bytes));
+
+			f.dst = (uint8_t*)scalable_malloc(capacity);
+			ZSTD_CCtx* const cctx(ZSTD_createCCtx());
+			if (!f.dst || !cctx) {
+				ZSTD_freeCCtx(cctx);
+				p.ok = false;
+				return;
+			}
+
+			ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, p.compression);
+			ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1); // corruption is detected when decompressed
+			ZSTD_CCtx_setPledgedSrcSize(cctx, bytes); // frame content size is in the frame header, frames are decompressed directly to their place in the level
+
+			ZSTD_outBuffer out{ f.dst, capacity, 0 };
+			for (uint32_t row = 0; row < f.rows; ++row) { // rows are not necessarily contiguous
+
+				ZSTD_inBuffer in{ im->image[f.first_row + row], row_bytes, 0 };
+				while (in.pos < in.size) {
+					if (ZSTD_isError(ZSTD_compressStream2(cctx, &out, &in, ZSTD_e_continue))) {
+						ZSTD_freeCCtx(cctx);
+						p.ok = false;
+						return;
+					}
+				}
+			}
+
+			ZSTD_inBuffer end{ nullptr, 0, 0 };
+			size_t remaining;
+			do {
+				remaining = ZSTD_compressStream2(cctx, &out, &end, ZSTD_e_end);
+			} while (0 != remaining && !ZSTD_isError(remaining));
+
+			ZSTD_freeCCtx(cctx);
+
+			if (ZSTD_isError(remaining)) {
+				p.ok = false;
+				return;
+			}
+			f.dst_bytes = out.pos;
+		});
+
+		if (!ok) {
+			release(frames);
+			return(false);
+		}
+
+		for (compressed_level& l : levels) {
+			for (uint32_t i = 0; i < l.count; ++i) {
+				l.bytes += frames[l.first + i].dst_bytes;
+			}
+		}
+		return(true);
+#else
+		return(false);
+#endif
+	}
+
+	// decompressed data of the levels [first, first + count), data[] is released w/ scalable_free
+	static bool const __vectorcall decompress(KTXFileLayout<KTX_VERSION::KTX2> const& ktxFile, uint8_t const* const __restrict pReadPointer, uint32_t const first, uint32_t const count, uint8_t** const __restrict data)
+	{
+		memset(data, 0, count * sizeof(uint8_t*));
+
+#if INCLUDE_ZSTD_SUPPORT
+		std::vector<frame> frames;
+
+		bool ok(true);
+		for (uint32_t i = 0; i < count && ok; ++i) {
+			uint32_t const level(first + i);
+
+			uint64_t const bytes(ktxFile.uncompressed_size(level));
+			data[i] = (uint8_t*)scalable_malloc(std::max(uint64_t(ktxFile.size(level)), bytes)); // size() is padded for upload
+			if (!data[i]) {
+				ok = false;
+				break;
+			}
+
+			// frame boundaries, only the headers are read
+			uint8_t const* __restrict src(pReadPointer + ktxFile.offset(level, 0, 0));
+			size_t remaining(ktxFile.compressed_size(level));
+			uint64_t offset(0);
+
+			while (remaining) {
+				size_t const frame_bytes(ZSTD_findFrameCompressedSize(src, remaining));
+				if (ZSTD_isError(frame_bytes)) {
+					ok = false;
+					break;
+				}
+
+				unsigned long long content(ZSTD_getFrameContentSize(src, frame_bytes));
+				if (ZSTD_CONTENTSIZE_ERROR == content) {
+					ok = false;
+					break;
+				}
+				if (ZSTD_CONTENTSIZE_UNKNOWN == content) { // streamed by the writer, only as the last frame of the level
+					if (remaining != frame_bytes) {
+						ok = false;
+						break;
+					}
+					content = bytes - offset;
+				}
+				if (offset + content > bytes) {
+					ok = false;
+					break;
+				}
+
+				frames.push_back(frame{ src, frame_bytes, data[i] + offset, size_t(content), level, 0, 0 });
+
+				src += frame_bytes;
+				remaining -= frame_bytes;
+				offset += content;
+			}
+			ok = ok && (offset == bytes);
+		}
+
+		if (ok) {
+			std::atomic_bool decoded(true);
+
+			tbb::parallel_for(size_t(0), frames.size(), [&frames, &decoded](size_t const i) {
+
+				frame const& __restrict f(frames[i]);
+				if (ZSTD_decompress(f.dst, f.dst_bytes, f.src, f.src_bytes) != f.dst_bytes) { // also false for errors
+					decoded = false;
+				}
+			});
+
+			ok = decoded;
+		}
+
+		if (!ok) {
+			for (uint32_t i = 0; i < count; ++i) {
+				if (data[i]) {
+					scalable_free(data[i]); data[i] = nullptr;
+				}
+			}
+		}
+		return(ok);
+#else
+		return(false);
+#endif
+	}
+
+	// levels [first, first + count) of a zstd supercompressed KTX2, uploaded to a mip chain of count levels
+	static ImagingMipChain* const __restrict __vectorcall upload(KTXFileLayout<KTX_VERSION::KTX2> const& ktxFile, uint8_t const* const __restrict pReadPointer, uint32_t const first, uint32_t const count)
+	{
+		if (first + count > ktxFile.mipLevels()) {
+			return(nullptr);
+		}
+
+		std::vector<uint8_t*> data(count);
+		if (!decompress(ktxFile, pReadPointer, first, count, data.data())) {
+			return(nullptr);
+		}
+
+		ImagingMipChain* __restrict chain(ImagingNewMipChain(count));
+		for (uint32_t i = 0; i < count && chain; ++i) {
+
+			chain->levels[i] = ktxFile.upload(data[i], first + i);
+			if (!chain->levels[i]) {
+				ImagingDelete(chain); chain = nullptr;
 			}
+		}
+
+		for (uint8_t* const level : data) {
+			scalable_free(level);
+		}
+		return(chain);
+	}
+
+	// single level, the chain is released
+	static ImagingMemoryInstance* const __restrict __vectorcall upload(KTXFileLayout<KTX_VERSION::KTX2> const& ktxFile, uint8_t const* const __restrict pReadPointer, uint32_t const mipLevel)
+	{
+		ImagingMipChain* const __restrict chain(upload(ktxFile, pReadPointer, mipLevel, 1));
+		if (!chain) {
+			return(nullptr);
+		}
+
+		ImagingMemoryInstance* const __restrict level(chain->levels[0]);
+		chain->levels[0] = nullptr;
+		ImagingDelete(chain);
+
+		return(level);
+	}
+
+} // end ns
+
+// supporting L8, LA8, L16, LA16, RGBA8 and RGBA16
+static bool const __vectorcall ktx_chain_supported(ImagingMipChain const* const __restrict chain)
+{
+	if (!chain || !chain->count || !chain->levels[0]) {
+		return(false);
+	}
+
+	ImagingMemoryInstance const* const __restrict base(chain->levels[0]);
+
+	if (!((MODE_L | MODE_LA | MODE_L16 | MODE_LA16 | MODE_BGRX | MODE_BGRA | MODE_BGRX16 | MODE_BGRA16) & base->mode)) {
+		return(false);
+	}
+
+	// all levels must be complete and share the same mode
+	for (uint32_t level = 0; level < chain->count; ++level) {
+		ImagingMemoryInstance const* const __restrict im(chain->levels[level]);
+		if (!im || im->mode != base->mode || (uint32_t)im->xsize != mipScale(base->xsize, level) || (uint32_t)im->ysize != mipScale(base->ysize, level)) {
+			return(false);
+		}
+	}
+	return(true);
+}
+
+// the whole file, zstd frames are already compressed (ktx_supercompression::compress)
+template<typename Writer>
+static void __vectorcall ktx_encode_chain(ImagingMipChain const* const __restrict chain, uint32_t const version, bool const zstd,
+										  std::vector<ktx_supercompression::frame> const& __restrict frames, std::vector<ktx_supercompression::compressed_level> const& __restrict compressed, Writer& __restrict out)
+{
+	ImagingMemoryInstance const* const __restrict base(chain->levels[0]);
+
+	bool const b16bpc(0 != ((MODE_L16 | MODE_LA16 | MODE_BGRX16 | MODE_BGRA16) & base->mode));
+
+	if (KTX_VERSION::KTX1 == version) {
+
+		//internal format
+		static constexpr uint32_t const KTX_R8 = 0x8229;
+		static constexpr uint32_t const KTX_RG8 = 0x822B;
+		static constexpr uint32_t const KTX_R16 = 0x822A;
+		static constexpr uint32_t const KTX_RG16 = 0x822C;
+		static constexpr uint32_t const KTX_RGBA8 = 0x8058;
+		static constexpr uint32_t const KTX_RGBA16 = 0x805B;
+
+		//base internal format
+		static constexpr uint32_t const KTX__R = 0x1903;
+		static constexpr uint32_t const KTX__RG = 0x8227;
+		static constexpr uint32_t const KTX__RGBA = 0x1908;
+
+		static constexpr uint32_t const KTX_UNSIGNED_SHORT = 0x1403;
+		static constexpr uint32_t const KTX_UNSIGNED_BYTE = 0x1401;
+		static constexpr uint32_t const KTX_ENDIAN_REF(0x04030201);
+
+		static constexpr const uint8_t ktx_magic_id[12] = {
+			0xAB, 0x4B, 0x54, 0x58,
+			0x20, 0x31, 0x31, 0xBB,
+			0x0D, 0x0A, 0x1A, 0x0A
+		};
+
+		KtxHeader header = {};
+		memcpy(header.identifier, ktx_magic_id, 12);
+
+		header.endianness = KTX_ENDIAN_REF;
+		header.glType = b16bpc ? KTX_UNSIGNED_SHORT : KTX_UNSIGNED_BYTE;
+		header.glTypeSize = base->pixelsize;
+
+		switch (base->mode)
+		{
+		case MODE_L:
+			header.glFormat = header.glBaseInternalFormat = KTX__R;
+			header.glInternalFormat = KTX_R8;
+			break;
+		case MODE_LA:
+			header.glFormat = header.glBaseInternalFormat = KTX__RG;
+			header.glInternalFormat = KTX_RG8;
+			break;
+		case MODE_L16:
+			header.glFormat = header.glBaseInternalFormat = KTX__R;
+			header.glInternalFormat = KTX_R16;
+			break;
+		case MODE_LA16:
+			header.glFormat = header.glBaseInternalFormat = KTX__RG;
+			header.glInternalFormat = KTX_RG16;
+			break;
+		case MODE_BGRA16:
+		case MODE_BGRX16:
+			header.glFormat = header.glBaseInternalFormat = KTX__RGBA;
+			header.glInternalFormat = KTX_RGBA16;
 			break;
-		case 4:
+		case MODE_BGRA:
+		case MODE_BGRX:
 		default:
-			if (bits > 8) {
-				mode = MODE_BGRA16;
-			}
-			else {
-				mode = MODE_BGRA;
-			}
+			header.glFormat = header.glBaseInternalFormat = KTX__RGBA;
+			header.glInternalFormat = KTX_RGBA8;
 			break;
 		}
 
-		uint32_t const width(TinyTIFFReader_getWidth(tif));
-		uint32_t const height(TinyTIFFReader_getHeight(tif));
+		header.pixelWidth = base->xsize;
+		header.pixelHeight = base->ysize;
+		header.pixelDepth = 0; // must be 0 for 2D/cubemap textures
+		header.numberOfArrayElements = 0;
+		header.numberOfFaces = 1;
+		header.numberOfMipmapLevels = chain->count;
+		header.bytesOfKeyValueData = 0;
 
-		returnL = ImagingNew((eIMAGINGMODE)mode, width, height);
-		ImagingClear(returnL); // ensure memory is zeroed
+		out.write(&header, sizeof(KtxHeader));
 
-		// read entire image data (only supporting tif with interleaved/chunky image data - single frame)
-		TinyTIFFWriter_readImage(tif, returnL->block, size_t(returnL->ysize) * size_t(returnL->linesize));
+		// levels largest first, each prefixed with its size and padded to 4 bytes (mipPadding)
+		for (uint32_t level = 0; level < chain->count; ++level) {
+			ImagingMemoryInstance const* const __restrict im(chain->levels[level]);
 
-		TinyTIFFReader_close(tif); tif = nullptr;
+			uint32_t const dataSize(im->xsize * im->ysize * im->pixelsize);
+			out.write(&dataSize, sizeof(uint32_t));
 
-		// auto convert to BGRX
-		if (MODE_RGB == mode) {
-			Imaging const promoted_image(ImagingRGBToBGRX(returnL));
-			ImagingDelete(returnL); returnL = promoted_image;
-		}
-		else if (MODE_RGB16 == mode) {
-			Imaging const promoted_image(ImagingRGB16ToBGRX16(returnL));
-			ImagingDelete(returnL); returnL = promoted_image;
+			ktx_write_level(im, out);
+			ktx_write_padding(((dataSize + 3) & ~3) - dataSize, out);
 		}
 	}
-	
-	return(returnL);
-}
-#endif
-
-/*
-ImagingSequence* const __restrict __vectorcall
-ImagingResample(ImagingSequence const* const __restrict imIn, int const xsize, int const ysize, int const filter)
-{
-	ImagingSequence* imOut(nullptr);
+	else { // KTX2
+
+		static constexpr const uint8_t ktx2_magic_id[12] = {
+			0xAB, 0x4B, 0x54, 0x58,
+			0x20, 0x32, 0x30, 0xBB,
+			0x0D, 0x0A, 0x1A, 0x0A
+		};
+
+		// data format descriptor, basic block (khronos data format specification 1.3)
+		static constexpr uint32_t const KHR_DF_MODEL_RGBSDA = 1,
+			                            KHR_DF_PRIMARIES_BT709 = 1,
+			                            KHR_DF_TRANSFER_LINEAR = 1,
+			                            KHR_DF_VERSIONNUMBER_1_3 = 2,
+			                            KHR_DF_CHANNEL_ALPHA = 15;
+
+		uint32_t const channels(base->pixelsize / (b16bpc ? 2 : 1));
+		uint32_t const channelBits(b16bpc ? 16 : 8);
+		uint32_t const blockSize(24 + 16 * channels);
+
+		uint32_t dfd[1 + 6 + 4 * 4]{};
+		dfd[0] = 4 + blockSize;													// dfdTotalSize
+		dfd[1] = 0;																// vendorId | descriptorType
+		dfd[2] = KHR_DF_VERSIONNUMBER_1_3 | (blockSize << 16);					// versionNumber | descriptorBlockSize
+		dfd[3] = KHR_DF_MODEL_RGBSDA | (KHR_DF_PRIMARIES_BT709 << 8) | (KHR_DF_TRANSFER_LINEAR << 16); // colorModel | colorPrimaries | transferFunction | flags (straight alpha)
+		dfd[4] = 0;																// texelBlockDimension 1x1x1x1
+		dfd[5] = zstd ? 0 : base->pixelsize;									// bytesPlane0 (0 when supercompressed)
+		dfd[6] = 0;																// bytesPlane4..7
+
+		for (uint32_t channel = 0; channel < channels; ++channel) {
+			uint32_t* const __restrict sample(&dfd[7 + channel * 4]);
+
+			uint32_t const channelId((3 == channel || (2 == channels && 1 == channel && (MODE_LA | MODE_LA16) & base->mode)) ? KHR_DF_CHANNEL_ALPHA : channel);
+
+			sample[0] = (channel * channelBits) | ((channelBits - 1) << 16) | (channelId << 24); // bitOffset | bitLength | channelType
+			sample[1] = 0;																	    // samplePosition
+			sample[2] = 0;																	    // sampleLower
+			sample[3] = (1u << channelBits) - 1u;											    // sampleUpper
+		}
 
-	imOut = (ImagingSequence*)scalable_malloc(1 * sizeof(ImagingSequence));
-	memset(&(*imOut), 0, sizeof(ImagingSequence));
+		uint32_t const dfdSize(dfd[0]);
+		uint32_t const levelIndexOffset(sizeof(Ktx2Header));
+		uint32_t const dfdOffset(levelIndexOffset + chain->count * sizeof(Ktx2LevelIndex));
+		uint32_t const alignment(zstd ? 1 : (0 == (base->pixelsize & 3) ? base->pixelsize : base->pixelsize * 4 / (base->pixelsize & 1 ? 1 : 2))); // lcm(texel block size, 4), 1 when supercompressed
 
-	// Setup ouput image descriptor //
-	uint32_t const count(imIn->count);
-	imOut->count = count;
-	imOut->xsize = xsize;
-	imOut->ysize = ysize;
+		// levels smallest first, each aligned to lcm(texel block size, 4)
+		std::vector<Ktx2LevelIndex> levelIndex(chain->count);
 
-	uint32_t const linesize(xsize * imIn->pixelsize),
-					 imagesize(ysize * linesize);
+		uint64_t offset(dfdOffset + dfdSize);
+		for (int32_t level = (int32_t)chain->count - 1; level >= 0; --level) {
+			ImagingMemoryInstance const* const __restrict im(chain->levels[level]);
 
-	imOut->linesize = linesize;
+			offset = ((offset + alignment - 1) / alignment) * alignment;
 
-	imOut->destroy = static_cast<void(*)(ImagingSequence* const __restrict)>(&ImagingDestroyBlock_Sequence);
+			levelIndex[level].byteOffset = offset;
+			levelIndex[level].uncompressedByteLength = (uint64_t)im->xsize * (uint64_t)im->ysize * (uint64_t)im->pixelsize;
+			levelIndex[level].byteLength = zstd ? compressed[level].bytes : levelIndex[level].uncompressedByteLength;
 
-	imOut->images = (ImagingSequenceInstance*)scalable_malloc(count * sizeof(ImagingSequenceInstance));
-	memset(imOut->images, 0, count * sizeof(ImagingSequenceInstance));
+			offset += levelIndex[level].byteLength;
+		}
 
-	// setup translation to be compatible (ImagingSequenceInstance->ImagingMemoryInstance)
-	ImagingMemoryInstance translationIn{};
+		Ktx2Header header = {};
+		memcpy(header.identifier, ktx2_magic_id, 12);
+
+		header.vkFormat = ImagingModeToVKFormat(base->mode);
+		header.typeSize = b16bpc ? 2 : 1;
+		header.pixelWidth = base->xsize;
+		header.pixelHeight = base->ysize;
+		header.pixelDepth = 0;
+		header.layerCount = 0;
+		header.faceCount = 1;
+		header.levelCount = chain->count;
+		header.supercompressionScheme = zstd ? ktx_supercompression::SCHEME_ZSTD : ktx_supercompression::SCHEME_NONE;
+		header.dfdByteOffset = dfdOffset;
+		header.dfdByteLength = dfdSize;
+
+		out.write(&header, sizeof(Ktx2Header));
+		out.write(levelIndex.data(), sizeof(Ktx2LevelIndex) * levelIndex.size());
+		out.write(dfd, dfdSize);
+
+		uint64_t position(dfdOffset + dfdSize);
+		for (int32_t level = (int32_t)chain->count - 1; level >= 0; --level) {
+
+			ktx_write_padding((uint32_t)(levelIndex[level].byteOffset - position), out);
+			if (zstd) {
+				for (uint32_t i = 0; i < compressed[level].count; ++i) {
+					ktx_supercompression::frame const& f(frames[compressed[level].first + i]);
+					out.write(f.dst, f.dst_bytes);
+				}
+			}
+			else {
+				ktx_write_level(chain->levels[level], out);
+			}
 
-	translationIn.mode = MODE_BGRX;
-	translationIn.type = IMAGING_TYPE_UINT8;
-	translationIn.bands = 3;
-	translationIn.xsize = imIn->xsize;
-	translationIn.ysize = imIn->ysize;
-	translationIn.pixelsize = imIn->pixelsize;
-	translationIn.linesize = imIn->linesize;
+			position = levelIndex[level].byteOffset + levelIndex[level].byteLength;
+		}
+	}
+}
 
-	// temporary allocation for aliasing pointers, which ImagingResample requires
-	translationIn.image = (uint8_t**)scalable_malloc(translationIn.ysize * sizeof(void*));
+bool const __vectorcall ImagingSaveMipChainToKTX(ImagingMipChain const* const __restrict chain, std::wstring_view const filenamepath, int const supercompression)
+{
+	if (!ktx_chain_supported(chain)) {
+		return(false);
+	}
 
-	for (uint32_t i = 0; i < count; ++i) {
+	uint32_t const version(ktx_version_from_extension(fs::path(filenamepath)));
+	if (0 == version) {
+		return(false);
+	}
 
-		// setup out image
-		imOut->images[i].block = (uint8_t*)scalable_malloc(imagesize);
-		imOut->images[i].destroy = static_cast<void(*)(ImagingSequenceInstance* const __restrict)>(&ImagingDestroyBlock_SequenceInstance);
+	// KTX2 zstd supercompression, the levels are compressed before the file is opened
+	bool const zstd(KTX_VERSION::KTX2 == version && supercompression > 0);
+	std::vector<ktx_supercompression::frame> frames;
+	std::vector<ktx_supercompression::compressed_level> compressed;
 
-		imOut->images[i].xsize = xsize;
-		imOut->images[i].ysize = ysize;
-		imOut->images[i].linesize = linesize;
+	if (zstd && !ktx_supercompression::compress(chain, supercompression, frames, compressed)) {
+		return(false);
+	}
 
-		imOut->images[i].delay = imIn->images[i].delay;
+	FILE* fOut;
 
-		// setup in image (translation)
-		translationIn.block = imIn->images[i].block;
+	if (0 != _wfopen_s(&fOut, filenamepath.data(), L"wbS")) {
+		ktx_supercompression::release(frames);
+		return(false);
+	}
 
-		// map alias lines to block memory
-		size_t y, o;
-		for (y = o = 0; y < translationIn.ysize; ++y) {
-			translationIn.image[y] = translationIn.block + o;
-			o += translationIn.linesize;
-		}
-		// Initialize alias pointers to pixel data. 
-		translationIn.image32 = (int32_t**)translationIn.image; // always a pixelsize of 4 for ImagingSequence BGRX
+	writer::file out{ fOut };
+	ktx_encode_chain(chain, version, zstd, frames, compressed, out);
 
-		// resample the current frame
-		Imaging resampled = ImagingResample(&translationIn, xsize, ysize, filter);
+	fflush(fOut);
+	fclose(fOut); fOut = nullptr;
 
-		{ // copy resampled image to output image sequence
-			memcpy(imOut->images[i].block, resampled->block, imagesize);
-		}
+	ktx_supercompression::release(frames);
 
-		// free temp resampled image
-		ImagingDelete(resampled);
+	return(true);
+}
 
-	} // for count images
+// in memory, export queue
+static bool const __vectorcall ktx_encode_chain(ImagingMipChain const* const __restrict chain, uint32_t const version, int const supercompression, writer::memory& __restrict out)
+{
+	if (0 == version || !ktx_chain_supported(chain)) {
+		return(false);
+	}
 
-	// free alias pointers
-	scalable_free(translationIn.image); translationIn.image = nullptr;
+	bool const zstd(KTX_VERSION::KTX2 == version && supercompression > 0);
+	std::vector<ktx_supercompression::frame> frames;
+	std::vector<ktx_supercompression::compressed_level> compressed;
 
-	return(imOut);
-}
-*/
+	if (zstd && !ktx_supercompression::compress(chain, supercompression, frames, compressed)) {
+		return(false);
+	}
 
-enum GIFConstants {
-	    //Graphics control extension has most of animation info
-	     GCE_Code = GRAPHICS_EXT_FUNC_CODE,
-	     GCE_Size = 4,
-	    //Fields of the above
-	     GCE_Flags = 0,
-	     GCE_Delay = 1,
-	     GCE_TransColor = 3,
-	    //Contents of mask
-	     GCE_DisposalUnspecified = DISPOSAL_UNSPECIFIED,		/* No disposal specified. */
-	     GCE_DisposalDoNot = DISPOSE_DO_NOT,					/* Leave image in place */
-	     GCE_DisposalBackground = DISPOSE_BACKGROUND,			/* Set area to background color */
-	     GCE_DisposalPrevious = DISPOSE_PREVIOUS,				/* Restore to previous content */
-};
+	ktx_encode_chain(chain, version, zstd, frames, compressed, out);
 
-typedef struct FrameHistory
-{
-	ImagingMemoryInstance const*			 image = nullptr;
+	ktx_supercompression::release(frames);
 
-} FrameHistory;
+	return(out.ok);
+}
 
-typedef struct Metadata
+ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadKTX(std::wstring_view const filenamepath)
 {
-	uint32_t mode = DISPOSAL_UNSPECIFIED;
-	uint32_t delay = 100;
-	int32_t  trans_key = -1;  // -1 denotes an index that has no color key for transparency
-} Metadata;
+	fs::path const filename(filenamepath);
 
-STATIC_INLINE_PURE uint32_t const frame_delay(uint8_t const* const __restrict loc) {
-	return (10 * (loc[0] | (((uint32_t)loc[1]) << 8)));
-}
+	if (!fs::exists(filename)) {
+		return(nullptr);
+	}
 
-template<bool const replace_all_pixels = false>
-STATIC_INLINE_PURE void __vectorcall ImagingGIFSetPixels(
-											GifColorType const* const& __restrict colors,
-											ImagingMemoryInstance* const __restrict image_dst,
-											SavedImage const& __restrict image_src, 
-											uint32_t const exclude_index = 0)
-{
-	uint32_t* const __restrict block(reinterpret_cast<uint32_t* const __restrict>(image_dst->block));
-	uint32_t const dst_width(image_dst->xsize);
-	
-	for (int32_t y = 0; y < image_src.ImageDesc.Height; ++y) {
+	uint32_t const version(ktx_version_from_extension(filename));
 
-		for (int32_t x = 0; x < image_src.ImageDesc.Width; ++x) {
+	if (0 != version) {
+		std::error_code error{};
 
-			uint32_t const src(y * image_src.ImageDesc.Width + x);
-			uint32_t const map = uint32_t((uint8_t const)image_src.RasterBits[src]);
+		mio::mmap_source mmap = mio::make_mmap_source(filenamepath, false, error);
+		if (!error) {
 
-			uint32_t const dst((y + image_src.ImageDesc.Top) * dst_width + (x + image_src.ImageDesc.Left));
+			if (mmap.is_open() && mmap.is_mapped()) {
+				___prefetch_vmem(mmap.data(), mmap.size());
 
-			uint32_t alpha;
+				uint8_t const* const pReadPointer((uint8_t*)mmap.data());
+				
+				if (KTX_VERSION::KTX1 == version) {
+					KTXFileLayout<KTX_VERSION::KTX1> const ktxFile(pReadPointer, pReadPointer + mmap.length());
 
-			if constexpr (replace_all_pixels) {		
-				alpha = 0xFF; // opaque
-			}
-			else if (exclude_index != map) {
-				// only draw pixels that "exist" in current frame
-				alpha = 0xFF;
-			}
-			else {
-				alpha = 0x01; // bugfix - allows frame to decay so there isn't a persistant image in blend, after many blends
-			}
-			// GIF is almost 30 years old
-			block[dst] = SFM::pack_rgba(colors[map].Red, colors[map].Green, colors[map].Blue, alpha);
-		}
-	}
-}
-STATIC_INLINE_PURE void __vectorcall ImagingGIFDisposePixels(
-	ImagingMemoryInstance* const __restrict image_dst,
-	SavedImage const& __restrict image_src,
-	uint32_t const background_rgba)
-{
-	uint32_t* const __restrict block(reinterpret_cast<uint32_t* const __restrict>(image_dst->block));
-	uint32_t const dst_width(image_dst->xsize);
+					if (ktxFile.ok()) {
 
-	for (int32_t y = 0; y < image_src.ImageDesc.Height; ++y) {
+						uint64_t const baseOffset(ktxFile.offset(0, 0, 0));
+						return(ktxFile.upload(pReadPointer + baseOffset));
+					}
+				}
+				else {
+					KTXFileLayout<KTX_VERSION::KTX2> const ktx2File(pReadPointer, pReadPointer + mmap.length());
 
-		uint32_t const dst((y + image_src.ImageDesc.Top) * dst_width + (image_src.ImageDesc.Left));
+					if (ktx2File.ok()) {
 
-		memset(&block[dst], background_rgba, image_src.ImageDesc.Width << 2u);
-	}
-}
+						if (ktx_supercompression::SCHEME_ZSTD == ktx2File.supercompression()) {
+							return(ktx_supercompression::upload(ktx2File, pReadPointer, 0));
+						}
 
-static ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadGIFFrame(uint32_t const frame,
-																				FrameHistory* const __restrict history,
-																				SavedImage const& __restrict image,
-																				ImagingSequence const* const __restrict im, 
-																				ColorMapObject const* const common_colormap,
-																				int32_t const background_color_index)
-{
-	ImagingSequenceInstance& __restrict meta_data_image(im->images[frame]);
-	ExtensionBlock* ext(nullptr);
-	for (auto i = 0; i < image.ExtensionBlockCount; ++i) {
-		if (GRAPHICS_EXT_FUNC_CODE == image.ExtensionBlocks[i].Function && GCE_Size == image.ExtensionBlocks[i].ByteCount) {
-			ext = &(image.ExtensionBlocks[i]);
-			break;
-		}
-	}
-	Metadata meta;
-	if (ext) {
+						uint64_t const baseOffset(ktx2File.offset(0, 0, 0));
+						return(ktx2File.upload(pReadPointer + baseOffset));
+					}
+				}
+			}
 
-		if (ext->Bytes[GCE_Flags] & 1) {
-			meta.trans_key = ((uint8_t)ext->Bytes[GCE_TransColor]);
 		}
-		meta.mode = ((ext->Bytes[GCE_Flags] >> 2) & 7);
-
-		meta.delay = frame_delay((uint8_t const* const)&ext->Bytes[GCE_Delay]);
-		if (0 == meta.delay)
-			meta.delay = 1;
 	}
-	meta_data_image.delay = meta.delay; // for the output images, only the delay is needed, everything else is "pre-processed"
 
-	ColorMapObject const* const colormap(image.ImageDesc.ColorMap ? image.ImageDesc.ColorMap : common_colormap);
-	// GIF is almost 30 years old
-	uint32_t const background_rgba(SFM::pack_rgba(colormap->Colors[background_color_index].Red, colormap->Colors[background_color_index].Green, colormap->Colors[background_color_index].Blue, 0x00));
-	
-	Imaging returnL(ImagingNew(MODE_BGRA, im->xsize, im->ysize));
+	return(nullptr);
+}
 
-	// always clear to transparent
-	memset(returnL->block, 0 == frame ? (background_rgba | 0xFF000000) : 0, im->ysize * im->linesize);
+template<uint32_t const version>
+static ImagingMemoryInstance const* const __restrict __vectorcall ktx_map_level(KTXFileLayout<version> const& ktxFile, mio::mmap_source&& mmap, uint32_t const mipLevel)
+{
+	if (mipLevel >= ktxFile.mipLevels()) {
+		return(nullptr);
+	}
 
-	bool bBlend(false);
+	uint64_t const offset(ktxFile.offset(mipLevel, 0, 0));
 
-	switch (meta.mode)
+	switch (ktxFile.format())
 	{
-/*3*/case GCE_DisposalPrevious: //- don't do anything and the last frame will just repeat (ImageBlend - dst all transparent, src will replace)
-		bBlend = (0 != frame);
-		break;
-/*0*/case GCE_DisposalUnspecified: // -all pixels are replaced regardless of transparency
-		ImagingGIFSetPixels<true>(colormap->Colors, returnL, image);
-		break;
-/*2*/case GCE_DisposalBackground: //-fill image rect defined for this frame with background color (note the opaque flag is set here, so ImageBlend composition doesn't replace these pixels)
-		ImagingGIFDisposePixels(returnL, image, background_rgba | 0xFF000000);	
-/*1*/case GCE_DisposalDoNot: // -new pixels are drawn with transparency ImageBlend then does the hard work of vomposition of dst and src
-		//fall-through//
-	default:
-		if (-1 != meta.trans_key) {
-			ImagingGIFSetPixels(colormap->Colors, returnL, image, meta.trans_key);
-		}
-		else {
-			ImagingGIFSetPixels<true>(colormap->Colors, returnL, image);
-		}
-		bBlend = (0 != frame);
-		break;
+	case MODE_BGRA16:
+	case MODE_BGRA:
+	case MODE_LA16:
+	case MODE_LA:
+	case MODE_L16:
+	case MODE_L: // stored as is, zero-copy
+		return(ImagingNewMapped(ktxFile.format(), ktxFile.width(mipLevel), ktxFile.height(mipLevel), std::move(mmap), offset));
+	default: // promoted or unsupported, same as ImagingLoadKTX
+		return(ktxFile.upload((uint8_t const*)mmap.data() + offset, mipLevel));
 	}
+}
 
-	// apply chroma key filter 1st
-	ImagingChromaKey(returnL); // must be applied here, to the raw'ist of data before it becomes blended, dithered, etc.
-
-	if (bBlend) {
-
-		// blend previous frame with current frame based on transparency
-		ImagingBlend(returnL, history[frame - 1].image);
+ImagingMemoryInstance const* const __restrict __vectorcall ImagingMapKTX(std::wstring_view const filenamepath, uint32_t const mipLevel)
+{
+	fs::path const filename(filenamepath);
 
+	if (!fs::exists(filename)) {
+		return(nullptr);
 	}
-		
-	history[frame].image = returnL; // released later
 
-	return(returnL); // do not release
-}
+	uint32_t const version(ktx_version_from_extension(filename));
 
-typedef struct _task_frame_data { // avoid lambda heap
-	FrameHistory* const history;
-	SavedImage const* const __restrict gif_images;
-	ImagingMemoryInstance** const __restrict images;
-	ImagingSequence const* const __restrict im;
-	ColorMapObject const* const __restrict common_colormap;
-	int32_t const background_color_index;
-	uint32_t const width, height;
-} const task_frame_data; 
+	if (0 != version) {
+		std::error_code error{};
 
-static void task_frame_process(uint32_t const i, task_frame_data p)
-{
-	ImagingMemoryInstance* const frame = ImagingLoadGIFFrame(i, p.history, p.gif_images[i], p.im, p.common_colormap, p.background_color_index);
+		mio::mmap_source mmap = mio::make_mmap_source(filenamepath, false, error);
+		if (!error) {
 
-	if (i & 1) // only dither odd frames so static dither pattern doesn't persist between frames
-	{
-		static constexpr float const GOLDEN_RATIO = 0.61803398874989484820f; // slightly bias lerp to non dithered original version
+			if (mmap.is_open() && mmap.is_mapped()) {
 
-		ImagingMemoryInstance const* const original = ImagingCopy(frame);
+				uint8_t const* const pReadPointer((uint8_t*)mmap.data());
 
-		ImagingDither(frame); // enhance by dithering, (any inter-frame blending also benefits!)
+				if (KTX_VERSION::KTX1 == version) {
+					KTXFileLayout<KTX_VERSION::KTX1> const ktxFile(pReadPointer, pReadPointer + mmap.length());
 
-		ImagingLerp(frame, original, GOLDEN_RATIO);
+					if (ktxFile.ok()) {
+						return(ktx_map_level(ktxFile, std::move(mmap), mipLevel));
+					}
+				}
+				else {
+					KTXFileLayout<KTX_VERSION::KTX2> const ktx2File(pReadPointer, pReadPointer + mmap.length());
 
-		ImagingDelete(original);
-	}
+					if (ktx2File.ok()) {
+						if (ktx_supercompression::SCHEME_ZSTD == ktx2File.supercompression()) { // decompressed copy
+							return(ktx_supercompression::upload(ktx2File, pReadPointer, mipLevel));
+						}
+						return(ktx_map_level(ktx2File, std::move(mmap), mipLevel));
+					}
+				}
+			}
 
-	p.images[i] = ImagingResample(frame, p.width, p.height, IMAGING_TRANSFORM_BICUBIC);
+		}
+	}
 
-	// do not delete frame_dithered - it is history for blending (released later) //
+	return(nullptr);
 }
 
-// this function is purposely single threaded, so when used asynchnously in a background thread it uses minimal cpu resources
-ImagingSequence* const __restrict __vectorcall ImagingLoadGIFSequence(std::wstring_view const giffilenamepath, uint32_t width, uint32_t height)
+template<uint32_t const version>
+static ImagingMipChain* const __restrict __vectorcall ktx_upload_mip_chain(KTXFileLayout<version> const& ktxFile, uint8_t const* const __restrict pReadPointer)
 {
-	ImagingSequence* im(nullptr);
-	int	ErrorCode(0);
-
-	GifFileType* GifFileIn(DGifOpenFileName(giffilenamepath.data(), &ErrorCode));
+	ImagingMipChain* const __restrict chain(ImagingNewMipChain(ktxFile.mipLevels()));
 
-	if (nullptr != GifFileIn) {
+	if (chain) {
+		for (uint32_t level = 0; level < chain->count; ++level) {
 
-		if (GIF_ERROR != DGifSlurp(GifFileIn)) {
+			chain->levels[level] = ktxFile.upload(pReadPointer + ktxFile.offset(level, 0, 0), level);
+			if (!chain->levels[level]) {
+				ImagingDelete(chain);
+				return(nullptr);
+			}
+		}
+	}
 
-			im = (ImagingSequence*)scalable_malloc(1 * sizeof(ImagingSequence));
-			memset(&(*im), 0, sizeof(ImagingSequence));
+	return(chain);
+}
 
-			/* Setup image descriptor */
-			uint32_t const count(uint32_t(GifFileIn->ImageCount));
-			im->count = count;
-			// the remaining values here are temporary, will be changed to reflect final palettized image dimensions 
-			im->xsize = GifFileIn->SWidth;
-			im->ysize = GifFileIn->SHeight;
-			im->linesize = im->xsize * 4; // for now BGRX is used
+ImagingMipChain* const __restrict __vectorcall ImagingLoadKTXMipChain(std::wstring_view const filenamepath)
+{
+	fs::path const filename(filenamepath);
 
-			// if zero is passed in for either width or height, default to the native corresponding dimension
-			if ( 0 == width )
-				width = im->xsize;
-			if ( 0 == height )
-				height = im->ysize;
+	if (!fs::exists(filename)) {
+		return(nullptr);
+	}
 
-			im->destroy = static_cast<void(*)(ImagingSequence* const __restrict)>(&ImagingDestroyBlock_Sequence);
+	uint32_t const version(ktx_version_from_extension(filename));
 
-			// ########## Load all gif frames, while resampling to desired size
-			ImagingMemoryInstance** __restrict images;
-			// non-contigous memory is used during this process for each sequence instance (frame)
-			images = (ImagingMemoryInstance**)scalable_malloc(count * sizeof(ImagingMemoryInstance*));
-			// move to contigous memory in already allocated im->images[] that also already contains updated meta deta (frame delay)
-			// is done afterwards goto line: 864
+	if (0 != version) {
+		std::error_code error{};
 
-			// allocate the final frames so we can fill with metadata (ExtensionBlock data)
-			im->images = (ImagingSequenceInstance*)scalable_malloc(count * sizeof(ImagingSequenceInstance));
-			memset(im->images, 0, count * sizeof(ImagingSequenceInstance));
+		mio::mmap_source mmap = mio::make_mmap_source(filenamepath, false, error);
+		if (!error) {
 
-			FrameHistory* history = (FrameHistory*)scalable_malloc(count * sizeof(FrameHistory));
-			memset(history, 0, count * sizeof(FrameHistory));
+			if (mmap.is_open() && mmap.is_mapped()) {
+				___prefetch_vmem(mmap.data(), mmap.size());
 
-			{
-				task_frame_data p{ history, GifFileIn->SavedImages, images, im, GifFileIn->SColorMap, GifFileIn->SBackGroundColor, width, height };
+				uint8_t const* const pReadPointer((uint8_t*)mmap.data());
 
-				// must always process frame 0 first, so potentisl dependency chain does not dead-lock
+				if (KTX_VERSION::KTX1 == version) {
+					KTXFileLayout<KTX_VERSION::KTX1> const ktxFile(pReadPointer, pReadPointer + mmap.length());
 
-				// process the remaining frames
-				for (uint32_t i = 0; i < count; ++i) {
-					task_frame_process(i, p);
+					if (ktxFile.ok()) {
+						return(ktx_upload_mip_chain(ktxFile, pReadPointer));
+					}
 				}
+				else {
+					KTXFileLayout<KTX_VERSION::KTX2> const ktx2File(pReadPointer, pReadPointer + mmap.length());
 
-				// release original frames (must be done after loading all frames has completed (above)
-				for (uint32_t i = 0; i < count; ++i) {
-					ImagingDelete(history[i].image);
+					if (ktx2File.ok()) {
+						if (ktx_supercompression::SCHEME_ZSTD == ktx2File.supercompression()) {
+							return(ktx_supercompression::upload(ktx2File, pReadPointer, 0, ktx2File.mipLevels()));
+						}
+						return(ktx_upload_mip_chain(ktx2File, pReadPointer));
+					}
 				}
-				scalable_free(history); history = nullptr;
 			}
 
-			// no longer need gif ....
-			DGifCloseFile(GifFileIn, &ErrorCode); GifFileIn = nullptr;
+		}
+	}
 
-			// update image sequence dimensions to the resampled width/height, and linesize now reflects the correct size for sequence image
-			im->xsize = width;
-			im->ysize = height;
+	return(nullptr);
+}
 
-			uint32_t const linesize(width * im->pixelsize),
-						   imagesize(height * linesize);
+/* Export Queue */
+/* ------------ */
+/* Bounded, asynchronous batched saving. Images are owned by the queue once submitted. RAW & KTX are encoded into a memory buffer on the tbb arena (compute) and written by the i/o threads, */
+/* the i/o threads only ever block on the file system. TIF & JPEG are written thru FILE* by their libraries so they are encoded & written by the i/o threads. */
 
-			im->linesize = linesize;
+namespace export_queue { // ImagingExportQueue internals
 
-			// ########## MOVE	
-			for (uint32_t i = 0; i < count; ++i) {
+	static constexpr size_t const WRITE_CHUNK_BYTES = (8ull << 20ull); // large sequential writes, multiple of the sector size
 
-				im->images[i].block = (uint8_t*)scalable_malloc(imagesize);
-				im->images[i].destroy = static_cast<void(*)(ImagingSequenceInstance* const __restrict)>(&ImagingDestroyBlock_SequenceInstance);
+	typedef struct job {
 
-				im->images[i].xsize = width;
-				im->images[i].ysize = height;
-				im->images[i].linesize = linesize;
+		ImagingMemoryInstance* __restrict image; // owned
+		eIMAGINGEXPORT const format;
+		int const option;
+		std::wstring const path;
 
-				{ // moving to contigous memory im->images[], can't use memcpy as the meta data (frame delay) would be clobbered
-					// however for data in ImagingMemoryInstance can be memcpy or moved
-					memcpy(im->images[i].block, images[i]->block, imagesize);
-				}
-				ImagingDelete(images[i]);
-			} // for count images
+		writer::memory encoded;
+		std::promise<bool> promise;
 
-			scalable_free(images); images = nullptr;
-		}
-	}
+		job(ImagingMemoryInstance* const __restrict image_, eIMAGINGEXPORT const format_, int const option_, std::wstring_view const path_)
+			: image(image_), format(format_), option(option_), path(path_)
+		{}
 
-	if (nullptr != GifFileIn) { // error handling, ensure released
-		DGifCloseFile(GifFileIn, &ErrorCode);
-	}
+	} job;
 
-	return(im);
-}
+	typedef struct state {
 
+		tbb::task_arena arena;							// encoding
+		tbb::concurrent_bounded_queue<job*> io;			// writing, nullptr stops an i/o thread
+		std::vector<std::thread> threads;
+		std::counting_semaphore<> slots;				// backpressure, capacity jobs in flight
 
-ImagingLUT* const __restrict __vectorcall ImagingLoadLUT(std::wstring_view const cubefilenamepath)
-{
-	ImagingLUT* lut(nullptr);
+		std::mutex lock;								// idle
+		std::condition_variable idle;
 
-	FILE* fIn;
-	if (0 == _wfopen_s(&fIn, cubefilenamepath.data(), L"r"))
-	{
-		static constexpr uint32_t const MAX_LINE_SZ = 250;  // .cube spec states maximum line size
-		char buffer[MAX_LINE_SZ];
+		std::atomic<uint64_t> submitted, completed, failed, pending, bytes;
+		std::atomic<uint64_t> encode_ns, write_ns;
+		tbb::tick_count const start;
 
-		// .cube lut specification
-		// https://wwwimages2.adobe.com/content/dam/acom/en/products/speedgrade/cc/pdfs/cube-lut-specification-1.0.pdf
-		//
-		while (0 != fgets(buffer, MAX_LINE_SZ, fIn)) {
+		bool const unbuffered;
 
-			std::istringstream line(buffer);
-			std::string keyword;
+		state(uint32_t const capacity, bool const unbuffered_)
+			: slots(capacity), submitted(0), completed(0), failed(0), pending(0), bytes(0), encode_ns(0), write_ns(0), start(tbb::tick_count::now()), unbuffered(unbuffered_)
+		{}
 
-			line >> keyword;
+	} state;
 
-			// only care about this keyword
-			if ("LUT_3D_SIZE" == keyword) {
-				
-				// allocate memory for lut and 3d lut data
-				if (nullptr == lut) {
+	STATIC_INLINE_PURE uint64_t const nanoseconds(tbb::tick_count const t0, tbb::tick_count const t1)
+	{
+		return(uint64_t((t1 - t0).seconds() * 1e9));
+	}
+
+	// RAW & KTX of uncompressed modes are encoded to memory, everything else is saved by the i/o thread
+	static bool const __vectorcall encoded_in_memory(job const& __restrict j)
+	{
+		switch (j.format)
+		{
+		case EXPORT_RAW:
+			return(true);
+		case EXPORT_KTX:
+			return(0 == ((MODE_BC1 | MODE_BC4 | MODE_BC5 | MODE_BC7 | MODE_BC6A) & j.image->mode));
+		default:
+			return(false);
+		}
+	}
 
-					int32_t size(0);
-					line >> size;  // size of dimension
+	static bool const __vectorcall encode(job& __restrict j)
+	{
+		ImagingMemoryInstance const* const __restrict im(j.image);
 
-					lut = ImagingNew(size);
-				}
-				// end find keywords, start a new loop for 3D table data
+		if (EXPORT_RAW == j.format) { // same as ImagingSaveRaw
+
+			if (!j.encoded.reserve(size_t(im->linesize) * size_t(im->ysize))) {
+				return(false);
 			}
-			else if ("+" < keyword && keyword < ":") {
-				//lines of table data come after keywords
-				break;
+			for (int y = 0; y < im->ysize; ++y) {
+				j.encoded.write(im->image[y], im->linesize);
 			}
-		} // end while
+			return(j.encoded.ok);
+		}
 
-		if (nullptr != lut && nullptr != lut->block) {
+		// KTX, a single level chain. ktx & ktx2 (by extension)
+		ImagingMemoryInstance* level(j.image);
+		ImagingMipChain const chain{ &level, 1, nullptr };
 
-			static constexpr float const DENORMALIZE = float(UINT16_MAX);
+		return(ktx_encode_chain(&chain, ktx_version_from_extension(fs::path(j.path)), j.option, j.encoded));
+	}
 
-			XMVECTOR const xmDeNorm(_mm_set1_ps(DENORMALIZE));
+	// encoded buffer is written in large sequential writes. unbuffered bypasses the os file cache: whole sectors from the sector aligned buffer, the file is truncated to the actual size after.
+	static bool const __vectorcall write(std::wstring const& __restrict path, writer::memory& __restrict encoded, bool const unbuffered)
+	{
+		DWORD const flags(FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN | (unbuffered ? (FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH) : 0));
 
-			uint32_t const lut_size(lut->size);
-			uint16_t* const __restrict lut_block = lut->block;
+		HANDLE const hFile(CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, flags, nullptr));
+		if (INVALID_HANDLE_VALUE == hFile) {
+			return(false);
+		}
 
-			for (uint32_t b = 0; b < lut_size; ++b) {
-				for (uint32_t g = 0; g < lut_size; ++g) {
-					for (uint32_t r = 0; r < lut_size; ++r) {			
+		size_t const bytes(unbuffered ? ((encoded.size + writer::memory::ALIGNMENT - 1) / writer::memory::ALIGNMENT) * writer::memory::ALIGNMENT : encoded.size);
+		if (bytes > encoded.size) { // capacity is always a multiple of the alignment
+			memset(encoded.data + encoded.size, 0, bytes - encoded.size);
+		}
 
-						std::istringstream line(buffer);
-						line.precision(8);
+		bool bReturn(true);
 
-						XMFLOAT4A vColor{};
+		for (size_t offset = 0; bReturn && offset < bytes; ) {
+			DWORD const chunk(DWORD(std::min(bytes - offset, WRITE_CHUNK_BYTES)));
+			DWORD written(0);
 
-						line >> vColor.x;
-						line >> vColor.y;
-						line >> vColor.z;
+			bReturn = WriteFile(hFile, encoded.data + offset, chunk, &written, nullptr) && chunk == written;
+			offset += chunk;
+		}
 
-						XMVECTOR const xmIn = XMVectorMultiply(XMLoadFloat4A(&vColor), xmDeNorm);
+		if (bReturn && bytes != encoded.size) {
+			FILE_END_OF_FILE_INFO eof{};
+			eof.EndOfFile.QuadPart = LONGLONG(encoded.size);
 
-						uvec4_t rgba;
-						SFM::saturate_to_u16(xmIn, rgba);
-						
-						// slices ordered by r
-						// (b * rMax * gMax) + (g * rMax) + r;
-						uint16_t* const lut_color(lut_block + (((b * lut_size * lut_size) + (g * lut_size) + r) << 2));
+			bReturn = SetFileInformationByHandle(hFile, FileEndOfFileInfo, &eof, sizeof(eof));
+		}
 
-						lut_color[0] = rgba.r;
-						lut_color[1] = rgba.g;
-						lut_color[2] = rgba.b;
+		CloseHandle(hFile);
+		return(bReturn);
+	}
 
-						//next line
-						[[unlikely]]
-						if (0 == fgets(buffer, MAX_LINE_SZ, fIn)) {
-							// error!
-							if ((lut_size - 1) != (b & g & r)) {
-								return(nullptr);
-							}
-							// else eof matching end of cube (ok.)
-						}
-					}
-				}
-			}
+	// blocking savers, on the i/o thread
+	static bool const __vectorcall save(job const& __restrict j)
+	{
+		switch (j.format)
+		{
+		case EXPORT_KTX: // block compressed
+			return(ImagingSaveToKTX(j.image, j.path));
+#if INCLUDE_TIF_SUPPORT
+		case EXPORT_TIF:
+			return(ImagingSaveToTif(j.image, j.path));
+#endif
+#if INCLUDE_JPEG_SUPPORT
+		case EXPORT_JPEG:
+			return(ImagingSaveJPEG(0 == j.option ? MODE_BGRX : eIMAGINGMODE(j.option), j.image, j.path));
+#endif
+		default:
+			return(false);
 		}
-
-		fclose(fIn); fIn = nullptr;
 	}
 
-	return(lut);
-}
+	static void __vectorcall finish(state& __restrict s, job* const j, bool const ok, uint64_t const written)
+	{
+		if (j->image) {
+			ImagingDelete(j->image); j->image = nullptr;
+		}
+		j->encoded.release();
 
-void __vectorcall ImagingCopyRaw(void* const pDstMemory, ImagingMemoryInstance const* const __restrict pSrcImage)
-{
-	uint8_t* __restrict pOut(reinterpret_cast<uint8_t* const __restrict>(pDstMemory));
-	uint8_t const * __restrict pIn(pSrcImage->block);
-	uint32_t const stride = pSrcImage->linesize;
+		if (ok) {
+			s.bytes.fetch_add(written, std::memory_order_relaxed);
+		}
+		else {
+			s.failed.fetch_add(1, std::memory_order_relaxed);
+		}
+		s.completed.fetch_add(1, std::memory_order_relaxed);
 
-	int scanline(pSrcImage->ysize);
-	while (0 != scanline) {
+		j->promise.set_value(ok);
 
-		memcpy(pOut, pIn, stride);
-		pOut += stride; pIn += stride;
+		std::destroy_at(j);
+		scalable_free(j);
 
-		--scanline;
+		s.slots.release();
+
+		{
+			std::lock_guard<std::mutex> lock(s.lock);
+			if (1 == s.pending.fetch_sub(1, std::memory_order_acq_rel)) {
+				s.idle.notify_all();
+			}
+		}
 	}
-}
 
-void __vectorcall ImagingSwapRB(ImagingMemoryInstance* const __restrict im)
-{
-	uint32_t const width(im->xsize);
-	uint32_t const height(im->ysize);
+	static void __vectorcall io_thread(state& __restrict s)
+	{
+		for (;;) {
+			job* j(nullptr);
+			s.io.pop(j);
 
-	uint32_t* const __restrict block(reinterpret_cast<uint32_t* const>(im->block));
+			if (nullptr == j) { // stop
+				break;
+			}
 
-	uvec4_t rgba_dst{};
+			tbb::tick_count const t0(tbb::tick_count::now());
 
-	for (uint32_t y = 0; y < height; ++y) {
+			bool ok;
+			uint64_t written(0);
 
-		for (uint32_t x = 0; x < width; ++x) {
+			if (j->encoded.data) {
+				written = j->encoded.size;
+				ok = write(j->path, j->encoded, s.unbuffered);
+			}
+			else {
+				ok = save(*j);
+				if (ok) {
+					std::error_code error{};
+					uintmax_t const size(fs::file_size(fs::path(j->path), error));
+					written = error ? 0 : uint64_t(size);
+				}
+			}
 
-			uint32_t const pixel(y * width + x);
+			s.write_ns.fetch_add(nanoseconds(t0, tbb::tick_count::now()), std::memory_order_relaxed);
 
-			SFM::unpack_rgba(block[pixel], rgba_dst.r, rgba_dst.g, rgba_dst.b, rgba_dst.a);
-			block[pixel] = SFM::pack_rgba(rgba_dst.b, rgba_dst.g, rgba_dst.r, rgba_dst.a);
+			finish(s, j, ok, written);
 		}
 	}
-}
-
-// dMin, dMax are optional - by default the range is automatically determined by the images data min/max
-ImagingMemoryInstance* const __restrict __vectorcall  ImagingF32ToL16(ImagingMemoryInstance const* const __restrict pSrcImageF, double dMin, double dMax)
-{
-	ImagingMemoryInstance* const __restrict imageL = ImagingNew(eIMAGINGMODE::MODE_L16, pSrcImageF->xsize, pSrcImageF->ysize);
-
-	struct { // avoid lambda heap
-		float const* const* const __restrict image_in;
-		uint16_t* const* const __restrict    image_out;
-		int const size;
-
-	} const p = { (float**)pSrcImageF->image32, (uint16_t**)imageL->image32, imageL->xsize };
-
-	// get the minmax of the float image
-	uint32_t const width(pSrcImageF->xsize),
-	               height(pSrcImageF->ysize);
-	
-	for (uint32_t y = 0; y < height; ++y) {
 
-		float const* __restrict pIn(p.image_in[y]);
+	static void __vectorcall encode_task(state& __restrict s, job* const j)
+	{
+		tbb::tick_count const t0(tbb::tick_count::now());
 
-		for (uint32_t x = 0; x < width; ++x) {
+		bool const ok(encode(*j));
 
-			float const value(*pIn);
+		// the source image is no longer needed, release the memory before the write
+		ImagingDelete(j->image); j->image = nullptr;
 
-			dMin = SFM::min(dMin, (double)value);
-			dMax = SFM::max(dMax, (double)value);
+		s.encode_ns.fetch_add(nanoseconds(t0, tbb::tick_count::now()), std::memory_order_relaxed);
 
-			++pIn;
+		if (!ok) {
+			finish(s, j, false, 0);
+			return;
 		}
+		s.io.push(j);
 	}
 
-	// perform conversion in double precision
-	double const dMini(dMin), dMaxi(dMax);
+} // end ns
+
+static void ImagingDestroyBlock_ExportQueue(ImagingExportQueue* const __restrict queue)
+{
+	if (queue) {
+
+		if (queue->internal) {
 
-	tbb::parallel_for(int(0), imageL->ysize, [&p, dMini, dMaxi](int const y) {
+			ImagingExportWait(queue);
 
-		static constexpr double const DENORMALIZE_L16 = double(UINT16_MAX);
+			export_queue::state* const __restrict s(static_cast<export_queue::state* const>(queue->internal));
 
-		int x = p.size - 1;
-		float const* __restrict pIn(p.image_in[y]);
-		uint16_t* __restrict pOut(p.image_out[y]);
-		do {
+			for (size_t i = 0; i < s->threads.size(); ++i) {
+				s->io.push(nullptr);
+			}
+			for (std::thread& thread : s->threads) {
+				thread.join();
+			}
 
-			double value = (double)(*pIn);                // perform conversion in double precision
+			std::destroy_at(s);
+			scalable_free(s); queue->internal = nullptr;
+		}
+		queue->destroy = nullptr;
+	}
+}
 
-			value = SFM::linearstep(dMini, dMaxi, value); // linearize range to 0.0 ... 1.0
+ImagingExportQueue* const __restrict __vectorcall ImagingNewExportQueue(uint32_t const capacity, uint32_t const io_threads, bool const unbuffered)
+{
+	ImagingExportQueue* const __restrict queue((ImagingExportQueue*)scalable_malloc(sizeof(ImagingExportQueue)));
+	if (!queue) {
+		return (ImagingExportQueue*)ImagingError_MemoryError();
+	}
+	memset(&(*queue), 0, sizeof(ImagingExportQueue));
 
-			value = value * DENORMALIZE_L16;              //  0.0 ... 65535.0
-			*pOut = SFM::saturate_to_u16(value);          //    0 ... 65535 
+	void* const __restrict internal(scalable_malloc(sizeof(export_queue::state)));
+	if (!internal) {
+		scalable_free(queue);
+		return (ImagingExportQueue*)ImagingError_MemoryError();
+	}
 
-			++pOut;
-			++pIn;
+	queue->capacity = SFM::max(1u, capacity);
+	queue->io_threads = SFM::max(1u, io_threads);
+	queue->unbuffered = unbuffered;
 
-		} while (--x >= 0);
+	export_queue::state* const __restrict s(new (internal) export_queue::state(queue->capacity, unbuffered));
+	queue->internal = s;
+	queue->destroy = static_cast<void(*)(ImagingExportQueue* const __restrict)>(&ImagingDestroyBlock_ExportQueue);
 
-	});
+	s->threads.reserve(queue->io_threads);
+	for (uint32_t i = 0; i < queue->io_threads; ++i) {
+		s->threads.emplace_back(&export_queue::io_thread, std::ref(*s));
+	}
 
-	return(imageL);
+	return(queue);
 }
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLLToLA(ImagingMemoryInstance const* const __restrict pSrcImageL, ImagingMemoryInstance const* const __restrict pSrcImageA)
+std::future<bool> __vectorcall ImagingExport(ImagingExportQueue* const __restrict queue, ImagingMemoryInstance* const __restrict image, eIMAGINGEXPORT const format, std::wstring_view const filenamepath, int const option)
 {
-	int const width(pSrcImageL->xsize), height(pSrcImageL->ysize);
-
-	if (width != pSrcImageA->xsize
-		|| height != pSrcImageA->ysize) {
+	if (!queue || !queue->internal || !image) {
+		ImagingDelete(image);
 
-		return(nullptr); // assume both L images passed in are the same dimensions.
+		std::promise<bool> failed;
+		failed.set_value(false);
+		return(failed.get_future());
 	}
 
-	Imaging returnLA(ImagingNew(MODE_LA, width, height));
+	export_queue::state& __restrict s(*static_cast<export_queue::state* const>(queue->internal));
 
-	uint8_t* __restrict pOut = returnLA->block;
-	uint8_t const* __restrict pInL = pSrcImageL->block;  // L
-	uint8_t const* __restrict pInA = pSrcImageA->block;  // A
+	void* const __restrict memory(scalable_malloc(sizeof(export_queue::job)));
+	if (!memory) {
+		ImagingDelete(image);
 
-	uint32_t const stride = pSrcImageL->linesize; // using checked src dimensions, want iterations in bytes.
+		std::promise<bool> failed;
+		failed.set_value(false);
+		return(failed.get_future());
+	}
 
-	uint32_t scanline(height);
-	while (0 != scanline) {
+	s.slots.acquire(); // blocks while capacity jobs are in flight
 
-		uint32_t pixels(stride);
-		while (0 != pixels) {
-		
-			*pOut++ = *pInL++;
-			*pOut++ = *pInA++;
+	export_queue::job* const j(new (memory) export_queue::job(image, format, option, filenamepath));
+	std::future<bool> result(j->promise.get_future());
 
-			pixels -= 2;
-		}
+	s.submitted.fetch_add(1, std::memory_order_relaxed);
+	s.pending.fetch_add(1, std::memory_order_acq_rel);
 
-		--scanline;
+	if (export_queue::encoded_in_memory(*j)) {
+		export_queue::state* const ps(&s);
+		s.arena.enqueue([ps, j] { export_queue::encode_task(*ps, j); });
+	}
+	else {
+		s.io.push(j);
 	}
 
-	return(returnLA);
+	return(result);
 }
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingL16L16ToLA16(ImagingMemoryInstance const* const __restrict pSrcImageL, ImagingMemoryInstance const* const __restrict pSrcImageA)
+void __vectorcall ImagingExportWait(ImagingExportQueue* const __restrict queue)
 {
-	int const width(pSrcImageL->xsize), height(pSrcImageL->ysize);
+	export_queue::state& __restrict s(*static_cast<export_queue::state* const>(queue->internal));
 
-	if (width != pSrcImageA->xsize
-		|| height != pSrcImageA->ysize) {
+	std::unique_lock<std::mutex> lock(s.lock);
+	s.idle.wait(lock, [&s] { return(0 == s.pending.load(std::memory_order_acquire)); });
+}
 
-		return(nullptr); // assume both L images passed in are the same dimensions.
+ImagingExportStats const __vectorcall ImagingExportQueueStats(ImagingExportQueue const* const __restrict queue)
+{
+	export_queue::state const& __restrict s(*static_cast<export_queue::state const* const>(queue->internal));
+
+	ImagingExportStats stats{};
+
+	stats.submitted = s.submitted.load(std::memory_order_relaxed);
+	stats.completed = s.completed.load(std::memory_order_relaxed);
+	stats.failed = s.failed.load(std::memory_order_relaxed);
+	stats.pending = s.pending.load(std::memory_order_relaxed);
+	stats.bytes = s.bytes.load(std::memory_order_relaxed);
+	stats.seconds = (tbb::tick_count::now() - s.start).seconds();
+	stats.encode_seconds = double(s.encode_ns.load(std::memory_order_relaxed)) * 1e-9;
+	stats.write_seconds = double(s.write_ns.load(std::memory_order_relaxed)) * 1e-9;
+
+	if (stats.seconds > 0.0) {
+		stats.images_per_second = double(stats.completed - stats.failed) / stats.seconds;
+		stats.bytes_per_second = double(stats.bytes) / stats.seconds;
 	}
 
-	Imaging returnLA16(ImagingNew(MODE_LA16, width, height));
-
-	uint16_t* __restrict pOut = (uint16_t * __restrict)returnLA16->block;
-	uint16_t const* __restrict pInL16 = (uint16_t const* __restrict)pSrcImageL->block;  // L
-	uint16_t const* __restrict pInA16 = (uint16_t const* __restrict)pSrcImageA->block;  // A
+	return(stats);
+}
 
-	uint32_t const stride = pSrcImageL->linesize; // using checked src dimensions, want iterations in bytes.
+/* Tile Streaming */
+/* -------------- */
+/* Bounded memory access to images larger than memory or IMAGING_LIMIT. The file is memory mapped read only, only the tiles (+ apron) in flight are resident. */
 
-	uint32_t scanline(height);
-	while (0 != scanline) {
+static uint32_t const __vectorcall mode_pixelsize(eIMAGINGMODE const mode)
+{
+	switch (mode)
+	{
+	case MODE_1BIT:
+	case MODE_L:
+		return(1);
+	case MODE_LA:
+	case MODE_L16:
+		return(2);
+	case MODE_RGB:
+		return(3);
+	case MODE_LA16:
+	case MODE_U32:
+	case MODE_BGRX:
+	case MODE_BGRA:
+	case MODE_F32:
+		return(4);
+	case MODE_RGB16:
+		return(6);
+	case MODE_BGRX16:
+	case MODE_BGRA16:
+		return(8);
+	default:
+		return(0); // unsupported (compressed)
+	}
+}
 
-		uint32_t pixels(stride);
-		while (0 != pixels) {
+typedef struct tile_stream_source {
 
-			*pOut++ = *pInL16++;
-			*pOut++ = *pInA16++;
+	mio::mmap_source mapping;
+	eIMAGINGMODE     file_mode;		// mode of the pixels stored in the file
+	uint32_t         file_pixelsize;
 
-			pixels -= 2;
-		}
+	// the file is a grid of chunks, each chunk is chunk_xsize * chunk_ysize pixels stored row major at offsets[chunk]. raw is a single chunk, tif strips are full width chunks.
+	uint32_t chunk_xsize, chunk_ysize, chunks_x;
+	std::vector<uint64_t> offsets;
 
-		--scanline;
-	}
+} tile_stream_source;
 
-	return(returnLA16);
-}
-// residual pixels
-STATIC_INLINE_PURE void convertRGBToBGRX(uint8_t* const __restrict dst, uint8_t const* const __restrict src, uint32_t const pixel_count)
-{
-	// compiler will optimize this simple loop //
-	for (uint32_t i = 0; i < pixel_count; ++i) {
-		dst[4 * i] = src[3 * i];
-		dst[4 * i + 1] = src[3 * i + 1];
-		dst[4 * i + 2] = src[3 * i + 2];
-		dst[4 * i + 3] = 0xff; // opaque
-	}
-}
-STATIC_INLINE_PURE void convertRGB16ToBGRX16(uint16_t* const __restrict dst, uint16_t const* const __restrict src, uint32_t const pixel_count)
+static void __vectorcall tile_stream_delete_source(tile_stream_source* const __restrict source)
 {
-	// compiler will optimize this simple loop //
-	for (uint32_t i = 0; i < pixel_count; ++i) {
-		dst[4 * i] = src[3 * i];
-		dst[4 * i + 1] = src[3 * i + 1];
-		dst[4 * i + 2] = src[3 * i + 2];
-		dst[4 * i + 3] = 0xffff; // opaque
-	}
+	std::destroy_at(source); // unmaps
+	scalable_free(source);
 }
 
-void ImagingFastRGBTOBGRX(uint8_t* const __restrict blockOut, uint8_t const* const __restrict blockIn, uint32_t const width, uint32_t const height) // exposed for usage with other buffers, or direct access to two existing Imaging instances' raw data blocks
+static void ImagingDestroyBlock_TileStream(ImagingTileStream* const __restrict stream)
 {
-	// each line is done in parallel
-	tbb::parallel_for(uint32_t(0), height, [blockOut, blockIn, width](uint32_t const y) {
-
-		uint32_t const row(y * width);
-		convertRGBToBGRX(blockOut + row * 4, blockIn + row * 3, width);
+	if (stream) {
+		if (stream->source) {
 
-	});
+			tile_stream_delete_source(static_cast<tile_stream_source* const>(stream->source)); stream->source = nullptr;
+		}
+		stream->destroy = nullptr;
+	}
 }
-void ImagingFastRGB16TOBGRX16(uint16_t* const __restrict blockOut, uint16_t const* const __restrict blockIn, uint32_t const width, uint32_t const height)
+
+static tile_stream_source* const __restrict __vectorcall tile_stream_new_source(std::wstring_view const filenamepath)
 {
-	// each line is done in parallel
-	tbb::parallel_for(uint32_t(0), height, [blockOut, blockIn, width](uint32_t const y) {
+	std::error_code error{};
 
-		uint32_t const row(y * width);
-	    convertRGB16ToBGRX16(blockOut + row * 4, blockIn + row * 3, width);
+	mio::mmap_source mmap = mio::make_mmap_source(filenamepath, false, error);
+	if (error || !mmap.is_open() || !mmap.is_mapped()) {
+		return(nullptr);
+	}
 
-	});
+	tile_stream_source* const __restrict source((tile_stream_source*)scalable_malloc(sizeof(tile_stream_source)));
+	if (!source) {
+		return (tile_stream_source*)ImagingError_MemoryError();
+	}
+
+	std::construct_at(source);
+	source->mapping = std::move(mmap);
+
+	return(source);
 }
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingRGBToBGRX(ImagingMemoryInstance const* const __restrict pSrcImageRGB)
+// takes ownership of source
+static ImagingTileStream* const __restrict __vectorcall
+ImagingNewTileStream(tile_stream_source* const __restrict source, int const xsize, int const ysize, int const tile_xsize, int const tile_ysize, int const apron)
 {
-	int const width(pSrcImageRGB->xsize), height(pSrcImageRGB->ysize);
+	if (xsize <= 0 || ysize <= 0 || tile_xsize <= 0 || tile_ysize <= 0 || apron < 0
+		|| 0 == source->file_pixelsize || 0 == source->chunk_xsize || 0 == source->chunk_ysize || 0 == source->chunks_x) {
+		tile_stream_delete_source(source);
+		return (ImagingTileStream*)ImagingError_ValueError("bad image size");
+	}
 
-	Imaging returnBGRX(ImagingNew(MODE_BGRX, width, height));
+	// every chunk must be inside the file, only the rows inside the image are required
+	uint64_t const chunk_linesize(uint64_t(source->chunk_xsize) * uint64_t(source->file_pixelsize));
 
-	ImagingFastRGBTOBGRX(returnBGRX->block, pSrcImageRGB->block, width, height);
+	for (size_t chunk = 0; chunk < source->offsets.size(); ++chunk) {
 
-	return(returnBGRX);
-}
+		uint64_t const chunk_y(uint64_t(chunk / source->chunks_x) * uint64_t(source->chunk_ysize));
+		uint64_t const rows(chunk_y + source->chunk_ysize > uint64_t(ysize) ? uint64_t(ysize) - chunk_y : uint64_t(source->chunk_ysize));
 
+		uint64_t const offset(source->offsets[chunk]), size(source->mapping.size());
 
+		if (offset > size || rows * chunk_linesize > size - offset) { // no wrap around of offset + length
+			tile_stream_delete_source(source);
+			return (ImagingTileStream*)ImagingError_ValueError("file too small for image size");
+		}
+	}
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingRGB16ToBGRX16(ImagingMemoryInstance const* const __restrict pSrcImageRGB16)
-{
-	int const width(pSrcImageRGB16->xsize), height(pSrcImageRGB16->ysize);
+	ImagingTileStream* const __restrict stream((ImagingTileStream*)scalable_malloc(sizeof(ImagingTileStream)));
+	if (!stream) {
+		tile_stream_delete_source(source);
+		return (ImagingTileStream*)ImagingError_MemoryError();
+	}
+	memset(&(*stream), 0, sizeof(ImagingTileStream));
 
-	Imaging returnBGRX16(ImagingNew(MODE_BGRX16, width, height));
+	switch (source->file_mode)
+	{
+	case MODE_RGB: // auto convert to BGRX
+		stream->mode = MODE_BGRX;
+		break;
+	case MODE_RGB16:
+		stream->mode = MODE_BGRX16;
+		break;
+	default:
+		stream->mode = source->file_mode;
+		break;
+	}
 
-	ImagingFastRGB16TOBGRX16(reinterpret_cast<uint16_t* const __restrict>(returnBGRX16->block), reinterpret_cast<uint16_t* const __restrict>(pSrcImageRGB16->block), width, height);
+	stream->xsize = xsize;
+	stream->ysize = ysize;
+	stream->tile_xsize = SFM::min(tile_xsize, xsize);
+	stream->tile_ysize = SFM::min(tile_ysize, ysize);
+	stream->apron = SFM::min(apron, SFM::max(xsize, ysize));
+	stream->tiles_x = (xsize + stream->tile_xsize - 1) / stream->tile_xsize;
+	stream->tiles_y = (ysize + stream->tile_ysize - 1) / stream->tile_ysize;
 
-	return(returnBGRX16);
+	stream->source = source;
+	stream->destroy = static_cast<void(*)(ImagingTileStream* const __restrict)>(&ImagingDestroyBlock_TileStream);
+
+	return(stream);
 }
 
-bool const __vectorcall ImagingSaveLUT(ImagingLUT const* const __restrict lut, std::string_view const title, std::wstring_view const cubefilenamepath)
+// copies width pixels of row y starting at x, a row can span several chunks
+static void __vectorcall tile_stream_copy_row(tile_stream_source const& __restrict source, uint8_t* __restrict out, uint32_t x, uint32_t const y, uint32_t width)
 {
-	bool bReturn(false);
+	uint8_t const* const __restrict base((uint8_t const*)source.mapping.data());
+	uint32_t const pixelsize(source.file_pixelsize);
 
-	FILE* fOut;
+	size_t const chunk_row(size_t(y / source.chunk_ysize) * size_t(source.chunks_x));
+	uint64_t const row(uint64_t(y % source.chunk_ysize) * uint64_t(source.chunk_xsize));
 
-	if (0 == _wfopen_s(&fOut, cubefilenamepath.data(), L"w"))
-	{
-		std::string buffer("");
+	while (0 != width) {
 
-		buffer = fmt::format("TITLE \"{:s}\"\n", title);
+		uint32_t const column(x % source.chunk_xsize);
+		uint32_t const run(SFM::min(width, source.chunk_xsize - column));
 
-		fwrite(buffer.data(), 1, buffer.length(), fOut);
+		memcpy(out, base + source.offsets[chunk_row + x / source.chunk_xsize] + (row + column) * pixelsize, size_t(run) * size_t(pixelsize));
 
-		buffer = fmt::format("# Created by Imaging - supersinfulsilicon software\n");
+		out += size_t(run) * size_t(pixelsize);
+		x += run;
+		width -= run;
+	}
+}
 
-		fwrite(buffer.data(), 1, buffer.length(), fOut);
+static ImagingMemoryInstance* const __restrict __vectorcall
+tile_stream_read(ImagingTileStream const* const __restrict stream, uint32_t const tile_index, int const apron, ImagingTileRect& __restrict rect)
+{
+	if (!stream || !stream->source || tile_index >= stream->tiles_x * stream->tiles_y) {
+		return(nullptr);
+	}
 
-		uint32_t const lut_size(lut->size);
-		buffer = fmt::format("LUT_3D_SIZE {:d}\n\n", lut_size);
+	tile_stream_source const& __restrict source(*static_cast<tile_stream_source const* const>(stream->source));
 
-		fwrite(buffer.data(), 1, buffer.length(), fOut);
+	// interior
+	int const x0(int(tile_index % stream->tiles_x) * stream->tile_xsize),
+		      y0(int(tile_index / stream->tiles_x) * stream->tile_ysize);
+	int const x1(SFM::min(x0 + stream->tile_xsize, stream->xsize)),
+		      y1(SFM::min(y0 + stream->tile_ysize, stream->ysize));
 
-		static constexpr float const NORMALIZE = 1.0f / float(UINT16_MAX);
+	// interior + apron, clamped to the image edges
+	int const ax0(SFM::max(0, x0 - apron)), ay0(SFM::max(0, y0 - apron)),
+		      ax1(SFM::min(x1 + apron, stream->xsize)), ay1(SFM::min(y1 + apron, stream->ysize));
 
-		XMVECTOR const xmNorm(_mm_set1_ps(NORMALIZE));
+	Imaging tile(ImagingNew(source.file_mode, ax1 - ax0, ay1 - ay0));
+	if (!tile) {
+		return(nullptr);
+	}
 
-		uint16_t const* const __restrict lut_block = lut->block;
+	for (int y = ay0; y < ay1; ++y) {
+		tile_stream_copy_row(source, tile->image[y - ay0], ax0, y, ax1 - ax0);
+	}
 
-		for (uint32_t b = 0; b < lut_size; ++b) {
-			for (uint32_t g = 0; g < lut_size; ++g) {
-				for (uint32_t r = 0; r < lut_size; ++r) {
+	// auto convert to BGRX
+	if (MODE_RGB == source.file_mode) {
+		Imaging const promoted_image(ImagingRGBToBGRX(tile));
+		ImagingDelete(tile); tile = promoted_image;
+	}
+	else if (MODE_RGB16 == source.file_mode) {
+		Imaging const promoted_image(ImagingRGB16ToBGRX16(tile));
+		ImagingDelete(tile); tile = promoted_image;
+	}
 
-					// slices ordered by r
-					// (b * rMax * gMax) + (g * rMax) + r;
-					uint16_t const* const lut_color(lut_block + (((b * lut_size * lut_size) + (g * lut_size) + r) << 2));
-					
-					uvec4_v const rgba(lut_color[0], lut_color[1], lut_color[2], 0);
+	rect = ImagingTileRect{ x0, y0, x1 - x0, y1 - y0, x0 - ax0, y0 - ay0 };
 
-					XMVECTOR const xmOut = SFM::saturate( XMVectorMultiply(rgba.v4f(), xmNorm) );
+	return(tile);
+}
 
-					XMFLOAT4A vOut;
-					XMStoreFloat4A(&vOut, xmOut);
+ImagingMemoryInstance* const __restrict __vectorcall ImagingReadTile(ImagingTileStream const* const __restrict stream, uint32_t const tile_index, ImagingTileRect& __restrict rect)
+{
+	if (!stream) {
+		return(nullptr);
+	}
 
-					buffer = fmt::format("{:.8f} {:.8f} {:.8f}\n", vOut.x, vOut.y, vOut.z);
+	return(tile_stream_read(stream, tile_index, stream->apron, rect));
+}
 
-					fwrite(buffer.data(), 1, buffer.length(), fOut);
-				}
-			}
-		}
-		fclose(fOut); fOut = nullptr;
-		bReturn = true;
+ImagingMemoryInstance* const __restrict __vectorcall ImagingReadNextTile(ImagingTileStream* const __restrict stream, ImagingTileRect& __restrict rect)
+{
+	if (!stream || stream->next >= stream->tiles_x * stream->tiles_y) {
+		return(nullptr);
 	}
-	return(bReturn);
+
+	return(tile_stream_read(stream, stream->next++, stream->apron, rect));
 }
 
-bool const __vectorcall ImagingSaveRaw(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath)
+ImagingTileStream* const __restrict __vectorcall ImagingOpenTileStreamRaw(eIMAGINGMODE const mode, std::wstring_view const filenamepath, int const width, int const height, int const tile_xsize, int const tile_ysize, int const apron)
 {
-	bool bReturn(false);
+	static constexpr int const RAW_STRIP_ROWS = 256; // native layout
 
-	FILE* fOut;
+	tile_stream_source* const __restrict source(tile_stream_new_source(filenamepath));
+	if (!source) {
+		return(nullptr);
+	}
 
-	if (0 == _wfopen_s(&fOut, filenamepath.data(), L"wbS"))
-	{
-		uint8_t const*  __restrict pOut = pSrcImage->block;
-		uint32_t const stride = pSrcImage->linesize;
+	source->file_mode = mode;
+	source->file_pixelsize = mode_pixelsize(mode);
+	source->chunk_xsize = (uint32_t)SFM::max(0, width);
+	source->chunk_ysize = (uint32_t)SFM::max(0, height);
+	source->chunks_x = 1;
+	source->offsets.push_back(0);
 
-		int scanline(pSrcImage->ysize);
-		while (0 != scanline) {
+	return(ImagingNewTileStream(source, width, height, 0 == tile_xsize ? width : tile_xsize, 0 == tile_ysize ? RAW_STRIP_ROWS : tile_ysize, apron));
+}
 
-			fwrite(pOut, 1, stride, fOut);
-			pOut += stride;
+#if INCLUDE_TIF_SUPPORT
+// TinyTIFF can only read & write a whole frame, streaming uses the tif directory directly. uncompressed & interleaved/chunky only, first directory (frame) only.
+namespace tif_stream
+{
+	enum eTAG : uint16_t {
+		IMAGE_WIDTH = 256, IMAGE_LENGTH = 257, BITS_PER_SAMPLE = 258, COMPRESSION = 259, PHOTOMETRIC = 262,
+		STRIP_OFFSETS = 273, SAMPLES_PER_PIXEL = 277, ROWS_PER_STRIP = 278, STRIP_BYTE_COUNTS = 279, PLANAR_CONFIG = 284,
+		TILE_WIDTH = 322, TILE_LENGTH = 323, TILE_OFFSETS = 324, EXTRA_SAMPLES = 338, SAMPLE_FORMAT = 339
+	};
+	enum eTYPE : uint16_t {
+		TYPE_SHORT = 3, TYPE_LONG = 4, TYPE_LONG8 = 16
+	};
 
-			--scanline;
+	static constexpr uint16_t const CLASSIC = 42, BIGTIFF = 43;
+	static constexpr uint16_t const SAMPLE_FORMAT_UINT = 1, SAMPLE_FORMAT_FLOAT = 3;
+	static constexpr uint16_t const PHOTOMETRIC_GREY = 1, PHOTOMETRIC_RGB = 2;
+	static constexpr uint16_t const EXTRA_UNSPECIFIED = 0, EXTRA_ALPHA = 2; // unassociated alpha
+
+	typedef struct directory {
+		uint8_t const* __restrict base;
+		uint64_t size;
+		uint8_t const* __restrict entries;
+		uint64_t count;
+		bool big;
+	} directory;
+
+#pragma pack(push, 1)
+	typedef struct big_header {
+		uint8_t  order[2];
+		uint16_t version;
+		uint16_t offset_size;
+		uint16_t reserved;
+		uint64_t ifd;
+	} big_header;
+
+	typedef struct big_entry {
+		uint16_t tag, type;
+		uint64_t count;
+		uint64_t value; // inline, left justified
+	} big_entry;
+#pragma pack(pop)
+	static_assert(16 == sizeof(big_header));
+	static_assert(20 == sizeof(big_entry));
+
+	static uint32_t const __vectorcall type_size(uint16_t const type)
+	{
+		switch (type)
+		{
+		case TYPE_SHORT:
+			return(sizeof(uint16_t));
+		case TYPE_LONG:
+			return(sizeof(uint32_t));
+		case TYPE_LONG8:
+			return(sizeof(uint64_t));
+		default:
+			return(0);
 		}
+	}
 
-		fclose(fOut); fOut = nullptr;
-		bReturn = true;
+	static uint8_t const* const __restrict __vectorcall find(directory const& __restrict dir, uint16_t const tag)
+	{
+		size_t const entry_size(dir.big ? 20 : 12);
+
+		for (uint64_t i = 0; i < dir.count; ++i) {
+
+			uint8_t const* const __restrict entry(dir.entries + i * entry_size);
+
+			uint16_t entry_tag(0);
+			memcpy(&entry_tag, entry, sizeof(uint16_t));
+			if (tag == entry_tag) {
+				return(entry);
+			}
+		}
+		return(nullptr);
 	}
-	return(bReturn);
-}
 
-bool const ImagingSaveJPEG(eIMAGINGMODE const outClrSpace, ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath)
-{
-#if INCLUDE_JPEG_SUPPORT
-	static constexpr uint32_t const JPEG_QUALITY = 98;
-	bool bReleaseSrcImageCopy(false);
+	static uint64_t const __vectorcall count(directory const& __restrict dir, uint16_t const tag)
+	{
+		uint8_t const* const __restrict entry(find(dir, tag));
+		if (!entry) {
+			return(0);
+		}
 
-	FILE* fOut;
+		uint64_t count(0);
+		memcpy(&count, entry + 4, dir.big ? sizeof(uint64_t) : sizeof(uint32_t)); // little endian
+		return(count);
+	}
 
-	if (0 == _wfopen_s(&fOut, filenamepath.data(), L"wbS"))
+	// value at index of the tag, default_value if the tag is missing or invalid
+	static uint64_t const __vectorcall value(directory const& __restrict dir, uint16_t const tag, uint64_t const index = 0, uint64_t const default_value = 0)
 	{
-		struct jpeg_compress_struct cinfo;
-		struct jpeg_error_mgr jerr;
+		uint8_t const* const __restrict entry(find(dir, tag));
+		if (!entry) {
+			return(default_value);
+		}
 
-		// Create JPEG Object
-		cinfo.err = jpeg_std_error(&jerr);
-		jpeg_create_compress(&cinfo);
-		jpeg_stdio_dest(&cinfo, fOut);	// set to output to file
-		cinfo.image_width = pSrcImage->xsize;    /* image width and height, in pixels */
-		cinfo.image_height = pSrcImage->ysize;
+		uint16_t type(0);
+		memcpy(&type, entry + 2, sizeof(uint16_t));
 
-		if (MODE_L == outClrSpace) {
-			// use fast 2 gray conversion (linear)
-			Imaging rgbCopy(nullptr);
-			if (MODE_BGRX == pSrcImage->mode) {
-				rgbCopy = ImagingNew(MODE_RGB, cinfo.image_width, cinfo.image_height);
-				Parallel_BGRX2BGR(rgbCopy->image, pSrcImage->image, cinfo.image_width, cinfo.image_height);
-			}
-			else if (MODE_RGB == pSrcImage->mode) {
-				rgbCopy = ImagingCopy(pSrcImage);
-			}
+		uint64_t const size(type_size(type)), values(count(dir, tag));
+		if (0 == size || index >= values || values > dir.size) {
+			return(default_value);
+		}
 
-			if (nullptr != rgbCopy) {
-				Imaging grayImage = ImagingNew(MODE_L, cinfo.image_width, cinfo.image_height);
-				Fast2Gray::rgb2gray_ToLinear(rgbCopy->block, cinfo.image_width, cinfo.image_height,
-											 grayImage->block);
-				// override
-				const_cast<ImagingMemoryInstance const* __restrict&>(pSrcImage) = grayImage;
-				bReleaseSrcImageCopy = true;
+		uint8_t const* __restrict data(entry + (dir.big ? 12 : 8));
+		size_t const inline_size(dir.big ? sizeof(uint64_t) : sizeof(uint32_t));
 
-				ImagingDelete(rgbCopy);
+		if (values * size > inline_size) { // stored at offset
+
+			uint64_t offset(0);
+			memcpy(&offset, data, inline_size);
+			if (offset + values * size > dir.size) {
+				return(default_value);
 			}
-			else
-				return(false); // unsupported
+			data = dir.base + offset;
 		}
-										// Configure JPEG Compression
-		
-		cinfo.input_components = pSrcImage->pixelsize;				/* # of color components per pixel */
-		/* colorspace of input image */
-		switch (pSrcImage->mode)
-		{
-		case MODE_1BIT:
-		case MODE_L:
-			cinfo.in_color_space = JCS_GRAYSCALE;
-			break;
-		case MODE_RGB:
-			cinfo.in_color_space = JCS_RGB;
-			break;
-		case MODE_BGRX:
-			cinfo.in_color_space = JCS_EXT_BGRX;
-			break;
-		case MODE_U32:
-		case MODE_BGRA:
-			cinfo.in_color_space = JCS_EXT_BGRA;
-			break;
+
+		uint64_t v(0);
+		memcpy(&v, data + index * size, size);
+		return(v);
+	}
+
+	static bool const __vectorcall parse(tile_stream_source& __restrict source, int& __restrict width, int& __restrict height)
+	{
+		uint8_t const* const __restrict base((uint8_t const*)source.mapping.data());
+		uint64_t const size(source.mapping.size());
+
+		if (size < sizeof(big_header) || 'I' != base[0] || 'I' != base[1]) { // little endian only
+			return(false);
 		}
-		 
-		jpeg_set_defaults(&cinfo); // dependent on colorspace first being set
 
-		jpeg_set_quality(&cinfo, JPEG_QUALITY, TRUE /* limit to baseline-JPEG values */);
+		uint16_t version(0);
+		memcpy(&version, base + 2, sizeof(uint16_t));
 
-		cinfo.write_Adobe_marker = FALSE;
-		cinfo.arith_code = FALSE;
-		cinfo.dct_method = JDCT_FLOAT;
-		cinfo.progressive_mode = FALSE;
-		cinfo.optimize_coding = TRUE;
-		cinfo.smoothing_factor = 0;
-		
-		/* colorspace of output image */
-		switch (outClrSpace)
-		{
-		case MODE_1BIT:
-		case MODE_L:
-			cinfo.jpeg_color_space = JCS_GRAYSCALE;
-			cinfo.num_components = 1;
-			break;
-		case MODE_RGB:
-			cinfo.jpeg_color_space = JCS_RGB;
-			cinfo.num_components = 3;
-			break;
-		case MODE_BGRX:
-			cinfo.jpeg_color_space = JCS_EXT_BGRX;
-			cinfo.num_components = 4;
-			break;
-		case MODE_U32:
-		case MODE_BGRA:
-			cinfo.jpeg_color_space = JCS_EXT_BGRA;
-			cinfo.num_components = 4;
-			break;
+		directory dir{ base, size, nullptr, 0, BIGTIFF == version };
+		if (!dir.big && CLASSIC != version) {
+			return(false);
 		}
 
-		// Start Compression //
-		jpeg_start_compress(&cinfo, TRUE);
+		uint64_t ifd(0);
+		memcpy(&ifd, base + (dir.big ? 8 : 4), dir.big ? sizeof(uint64_t) : sizeof(uint32_t));
 
-		//JSAMPROW row_pointer(pSrcImage->block);      /* pointer to JSAMPLE row[s] */
-		//int const row_stride(cinfo.image_width * cinfo.input_components);  /* physical row width in image buffer */
-									  /* JSAMPLEs per row in image_buffer */
-		//cinfo.next_scanline = 0;
-		//while (cinfo.next_scanline < cinfo.image_height) {
-			/* jpeg_write_scanlines expects an array of pointers to scanlines.
-			* Here the array is only one element long, but you could pass
-			* more than one scanline at a time if that's more convenient.
-			*/
-		//	(void)jpeg_write_scanlines(&cinfo, &row_pointer, 1);
-		//	row_pointer += row_stride;
-		//}
+		size_t const count_size(dir.big ? sizeof(uint64_t) : sizeof(uint16_t));
+		if (ifd + count_size > size) {
+			return(false);
+		}
+		memcpy(&dir.count, base + ifd, count_size);
+		if (dir.count > size || ifd + count_size + dir.count * (dir.big ? 20 : 12) > size) {
+			return(false);
+		}
+		dir.entries = base + ifd + count_size;
 
-		// feed the compressor scanlines
-		uint8_t* const* __restrict ppOut = pSrcImage->image;
+		uint64_t const w(value(dir, IMAGE_WIDTH)), h(value(dir, IMAGE_LENGTH)),
+			           samples(value(dir, SAMPLES_PER_PIXEL, 0, 1)),
+			           bits(value(dir, BITS_PER_SAMPLE, 0, 1)),
+			           format(value(dir, SAMPLE_FORMAT, 0, SAMPLE_FORMAT_UINT));
 
-		/* jpeg_write_scanlines expects an array of pointers to scanlines.
-		* Here the array is only one element long, but you could pass
-		* more than one scanline at a time if that's more convenient.
-		*/
-		(void)jpeg_write_scanlines(&cinfo, (JSAMPARRAY)ppOut, cinfo.image_height);
+		if (0 == w || 0 == h || w > INT32_MAX || h > INT32_MAX || samples < 1 || samples > 4
+			|| 1 != value(dir, COMPRESSION, 0, 1) || 1 != value(dir, PLANAR_CONFIG, 0, 1)) {
+			return(false);
+		}
 
-		// Finish compression
-		jpeg_finish_compress(&cinfo);
-		fflush(fOut);
+		// determine imaging mode, same as ImagingLoadTif
+		static constexpr eIMAGINGMODE const modes8[4] = { MODE_L, MODE_LA, MODE_RGB, MODE_BGRA },
+			                                modes16[4] = { MODE_L16, MODE_LA16, MODE_RGB16, MODE_BGRA16 };
+
+		if (SAMPLE_FORMAT_FLOAT == format) {
+			if (32 != bits || 1 != samples) {
+				return(false);
+			}
+			source.file_mode = MODE_F32;
+		}
+		else if (8 == bits) {
+			source.file_mode = modes8[samples - 1];
+		}
+		else if (16 == bits) {
+			source.file_mode = modes16[samples - 1];
+		}
+		else {
+			return(false);
+		}
+		source.file_pixelsize = mode_pixelsize(source.file_mode);
 
-		fclose(fOut); fOut = nullptr;
+		// layout
+		uint64_t chunks(0);
+		uint16_t offsets_tag(0);
 
-		// Release memory
-		jpeg_destroy_compress(&cinfo);
+		if (find(dir, TILE_WIDTH)) { // tiled
 
-		if (bReleaseSrcImageCopy) {
-			ImagingDelete(const_cast<ImagingMemoryInstance* __restrict&>(pSrcImage)); // lazy but works
+			uint64_t const tw(value(dir, TILE_WIDTH)), th(value(dir, TILE_LENGTH));
+			if (0 == tw || 0 == th || tw > UINT32_MAX || th > UINT32_MAX) {
+				return(false);
+			}
+			source.chunk_xsize = uint32_t(tw);
+			source.chunk_ysize = uint32_t(th);
+			source.chunks_x = uint32_t((w + tw - 1) / tw);
+			chunks = uint64_t(source.chunks_x) * ((h + th - 1) / th);
+			offsets_tag = TILE_OFFSETS;
 		}
-		return(true);
-	}
+		else { // stripped
 
-#endif
-
-	return(false);
-}
+			uint64_t const rows(std::min(value(dir, ROWS_PER_STRIP, 0, h), h));
+			if (0 == rows) {
+				return(false);
+			}
+			source.chunk_xsize = uint32_t(w);
+			source.chunk_ysize = uint32_t(rows);
+			source.chunks_x = 1;
+			chunks = (h + rows - 1) / rows;
+			offsets_tag = STRIP_OFFSETS;
+		}
 
-void ImagingSaveJPEG(tbb::task_group& __restrict tG, eIMAGINGMODE const outClrSpace, ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath)
-{
-#if INCLUDE_JPEG_SUPPORT
-	wchar_t* threadLocalPathFile = new wchar_t[filenamepath.length() + 1];
-	
-	filenamepath.copy(threadLocalPathFile, filenamepath.length());
+		if (count(dir, offsets_tag) < chunks) {
+			return(false);
+		}
 
-	// make a quick copy just to bullet proof (a little)
-	Imaging cpyImage = ImagingCopy(pSrcImage);
+		source.offsets.resize(chunks);
+		for (uint64_t chunk = 0; chunk < chunks; ++chunk) {
 
-	// async non blocking file export
-	tG.run([threadLocalPathFile, cpyImage, outClrSpace]
-	{
-		ImagingSaveJPEG(outClrSpace, cpyImage, threadLocalPathFile);
+			source.offsets[chunk] = value(dir, offsets_tag, chunk);
+			if (0 == source.offsets[chunk]) { // offset 0 is the header
+				return(false);
+			}
+		}
 
-		ImagingDelete(cpyImage);
+		width = int(w);
+		height = int(h);
 
-		if (threadLocalPathFile) {
-			delete[] threadLocalPathFile;
-		}
-	});
-#endif
-}
+		return(true);
+	}
 
-#if INCLUDE_TIF_SUPPORT
-bool const __vectorcall ImagingSaveToTif(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath)						// single image //
-{
-	bool bReturn(false);
-	if (((MODE_L | MODE_LA | MODE_L16 | MODE_LA16 | MODE_BGRX | MODE_BGRA | MODE_BGRX16 | MODE_BGRA16) & pSrcImage->mode))
+	// same interpretation of the pixels as ImagingSaveToTif
+	static bool const __vectorcall describe(eIMAGINGMODE const mode, uint16_t& __restrict samples, uint16_t& __restrict bits, uint16_t& __restrict photometric, uint16_t& __restrict format, uint16_t& __restrict extra)
 	{
-		uint32_t samples(0),    // # of components
-			     bits(0),       // bitdepth of a component
-			     interpret(0);  // TinyTIFFWriter_Greyscale, etc
-
-		samples = pSrcImage->bands; // samples / bands / components
+		format = SAMPLE_FORMAT_UINT;
+		extra = EXTRA_UNSPECIFIED;
 
-		switch (pSrcImage->mode)
+		switch (mode)
 		{
 		case MODE_L:
-			interpret = TinyTIFFWriter_Greyscale;
-			bits = 8;
+			samples = 1; bits = 8; photometric = PHOTOMETRIC_GREY;
 			break;
 		case MODE_LA:
-			interpret = TinyTIFFWriter_GreyscaleAndAlpha;
-			bits = 8;
+			samples = 2; bits = 8; photometric = PHOTOMETRIC_GREY; extra = EXTRA_ALPHA;
 			break;
 		case MODE_L16:
-			interpret = TinyTIFFWriter_Greyscale;
-			bits = 16;
+			samples = 1; bits = 16; photometric = PHOTOMETRIC_GREY;
 			break;
 		case MODE_LA16:
-			interpret = TinyTIFFWriter_GreyscaleAndAlpha;
-			bits = 16;
+			samples = 2; bits = 16; photometric = PHOTOMETRIC_GREY; extra = EXTRA_ALPHA;
+			break;
+		case MODE_BGRX:
+			samples = 4; bits = 8; photometric = PHOTOMETRIC_RGB;
+			break;
+		case MODE_BGRA:
+			samples = 4; bits = 8; photometric = PHOTOMETRIC_RGB; extra = EXTRA_ALPHA;
 			break;
 		case MODE_BGRX16:
+			samples = 4; bits = 16; photometric = PHOTOMETRIC_RGB;
+			break;
 		case MODE_BGRA16:
-			interpret = TinyTIFFWriter_RGBA;
-			bits = 16;
+			samples = 4; bits = 16; photometric = PHOTOMETRIC_RGB; extra = EXTRA_ALPHA;
 			break;
-		case MODE_BGRX:
-		case MODE_BGRA:
-		default:
-			interpret = TinyTIFFWriter_RGBA;
-			bits = 8;
+		case MODE_F32:
+			samples = 1; bits = 32; photometric = PHOTOMETRIC_GREY; format = SAMPLE_FORMAT_FLOAT;
 			break;
+		default:
+			return(false);
 		}
+		return(true);
+	}
 
-		// TINYTIFF_EXPORT TinyTIFFWriterFile* TinyTIFFWriter_open(const char* filename, uint16_t bitsPerSample, enum TinyTIFFWriterSampleFormat sampleFormat, uint16_t samples, uint32_t width, uint32_t height, enum TinyTIFFWriterSampleInterpretation sampleInterpretation);
+	// directory follows the pixels, word aligned
+	static uint64_t const __vectorcall directory_offset(eIMAGINGMODE const mode, uint32_t const width, uint32_t const height, uint64_t const data_offset)
+	{
+		return(uint64_t(SFM::roundToMultipleOf<true>(int64_t(data_offset + uint64_t(width) * uint64_t(height) * uint64_t(mode_pixelsize(mode))), int64_t(8))));
+	}
 
-		TinyTIFFWriterFile* tif = TinyTIFFWriter_open(stringconv::ws2s(filenamepath).c_str(), bits, TinyTIFFWriter_UInt, samples, pSrcImage->xsize, pSrcImage->ysize, (TinyTIFFWriterSampleInterpretation)interpret);
-		if (tif) {
+	static bool const __vectorcall write_header(FILE* const __restrict fOut, uint64_t const ifd)
+	{
+		big_header const header{ { 'I', 'I' }, BIGTIFF, sizeof(uint64_t), 0, ifd };
 
-			TinyTIFFWriter_writeImage(tif, pSrcImage->block);
+		return(0 == _fseeki64(fOut, 0, SEEK_SET) && 1 == fwrite(&header, sizeof(header), 1, fOut));
+	}
 
-			TinyTIFFWriter_close(tif); tif = nullptr;
+	// pixels are a single strip at data_offset (readers such as libtiff chop large uncompressed strips)
+	static bool const __vectorcall write_directory(FILE* const __restrict fOut, eIMAGINGMODE const mode, uint32_t const width, uint32_t const height, uint64_t const data_offset, uint64_t const ifd)
+	{
+		uint16_t samples(0), bits(0), photometric(0), format(0), extra(0);
+		if (!describe(mode, samples, bits, photometric, format, extra)) {
+			return(false);
+		}
 
-			bReturn = true;
+		auto const per_sample = [samples](uint16_t const v) {
+			uint64_t packed(0);
+			for (uint32_t i = 0; i < samples; ++i) {
+				packed |= uint64_t(v) << (i << 4);
+			}
+			return(packed);
+		};
+
+		uint64_t const data_size(uint64_t(width) * uint64_t(height) * uint64_t(mode_pixelsize(mode)));
+
+		big_entry entries[12];
+		uint64_t count(0);
+
+		// ascending tag order
+		entries[count++] = big_entry{ IMAGE_WIDTH, TYPE_LONG, 1, width };
+		entries[count++] = big_entry{ IMAGE_LENGTH, TYPE_LONG, 1, height };
+		entries[count++] = big_entry{ BITS_PER_SAMPLE, TYPE_SHORT, samples, per_sample(bits) };
+		entries[count++] = big_entry{ COMPRESSION, TYPE_SHORT, 1, 1 };
+		entries[count++] = big_entry{ PHOTOMETRIC, TYPE_SHORT, 1, photometric };
+		entries[count++] = big_entry{ STRIP_OFFSETS, TYPE_LONG8, 1, data_offset };
+		entries[count++] = big_entry{ SAMPLES_PER_PIXEL, TYPE_SHORT, 1, samples };
+		entries[count++] = big_entry{ ROWS_PER_STRIP, TYPE_LONG, 1, height };
+		entries[count++] = big_entry{ STRIP_BYTE_COUNTS, TYPE_LONG8, 1, data_size };
+		entries[count++] = big_entry{ PLANAR_CONFIG, TYPE_SHORT, 1, 1 };
+		if (0 == (samples & 1)) { // LA, BGRX & BGRA have an extra sample
+			entries[count++] = big_entry{ EXTRA_SAMPLES, TYPE_SHORT, 1, extra };
 		}
-	}
+		entries[count++] = big_entry{ SAMPLE_FORMAT, TYPE_SHORT, samples, per_sample(format) };
 
-	return(bReturn);
-}
-#endif
+		uint64_t const next_ifd(0); // single frame
 
-struct KtxHeader {
-	uint8_t identifier[12];
-	uint32_t endianness;
-	uint32_t glType;
-	uint32_t glTypeSize;
-	uint32_t glFormat;
-	uint32_t glInternalFormat;
-	uint32_t glBaseInternalFormat;
-	uint32_t pixelWidth;
-	uint32_t pixelHeight;
-	uint32_t pixelDepth;
-	uint32_t numberOfArrayElements;
-	uint32_t numberOfFaces;
-	uint32_t numberOfMipmapLevels;
-	uint32_t bytesOfKeyValueData;
-};
+		return(0 == _fseeki64(fOut, int64_t(ifd), SEEK_SET)
+			&& 1 == fwrite(&count, sizeof(count), 1, fOut)
+			&& count == fwrite(entries, sizeof(big_entry), count, fOut)
+			&& 1 == fwrite(&next_ifd, sizeof(next_ifd), 1, fOut));
+	}
+} // end ns
 
-bool const __vectorcall ImagingSaveToKTX(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath) // RGB images should be converted to BGRX first
+ImagingTileStream* const __restrict __vectorcall ImagingOpenTileStreamTif(std::wstring_view const filenamepath, int const tile_xsize, int const tile_ysize, int const apron)
 {
-	bool bReturn(false);
-
-	if (MODE_BC7 == pSrcImage->mode) {
-		return(ImagingSaveCompressedBC7ToKTX(pSrcImage, filenamepath));
+	tile_stream_source* const __restrict source(tile_stream_new_source(filenamepath));
+	if (!source) {
+		return(nullptr);
 	}
 
-	// supporting L8, LA8 and RGBA8
+	int width(0), height(0);
+	if (!tif_stream::parse(*source, width, height)) {
+		tile_stream_delete_source(source);
+		return (ImagingTileStream*)ImagingError_ValueError("unsupported tif layout");
+	}
 
-	//internal format
-	static constexpr uint32_t const KTX_R8 = 0x8229;
-	static constexpr uint32_t const KTX_RG8 = 0x822B;
-	static constexpr uint32_t const KTX_R16 = 0x822A;
-	static constexpr uint32_t const KTX_RG16 = 0x822C;
-	static constexpr uint32_t const KTX_RGBA8 = 0x8058;
-	static constexpr uint32_t const KTX_RGBA16 = 0x805B;
+	// native layout is the strip or tile size of the file
+	return(ImagingNewTileStream(source, width, height, 0 == tile_xsize ? (int)SFM::min(source->chunk_xsize, (uint32_t)width) : tile_xsize,
+		                                               0 == tile_ysize ? (int)SFM::min(source->chunk_ysize, (uint32_t)height) : tile_ysize, apron));
+}
+#endif
 
-	//base internal format
-	static constexpr uint32_t const KTX__R = 0x1903;
-	static constexpr uint32_t const KTX__RG = 0x8227;
-	static constexpr uint32_t const KTX__RGBA = 0x1908;
-	
-	static constexpr uint32_t const KTX_UNSIGNED_SHORT = 0x1403;
-	static constexpr uint32_t const KTX_UNSIGNED_BYTE = 0x1401;
-	static constexpr uint32_t const KTX_ENDIAN_REF(0x04030201);
+typedef struct tile_writer_sink {
 
-	static constexpr const uint8_t ktx_magic_id[12] = {
-		0xAB, 0x4B, 0x54, 0x58,
-		0x20, 0x31, 0x31, 0xBB,
-		0x0D, 0x0A, 0x1A, 0x0A
-	};
+	FILE*    file;
+	uint64_t data_offset;	// byte offset of the first row
+	bool     tif;
+	bool     failed;
 
-	FILE* fOut;
+} tile_writer_sink;
 
-	if (((MODE_L|MODE_LA|MODE_L16|MODE_LA16|MODE_BGRX|MODE_BGRA|MODE_BGRX16|MODE_BGRA16) & pSrcImage->mode) && 0 == _wfopen_s(&fOut, filenamepath.data(), L"wbS"))
-	{
-		KtxHeader header = {};
-		memcpy(header.identifier, ktx_magic_id, 12);
+static void ImagingDestroyBlock_TileWriter(ImagingTileWriter* const __restrict writer)
+{
+	if (writer) {
+		if (writer->sink) {
 
-		header.endianness = KTX_ENDIAN_REF;
+			tile_writer_sink* const __restrict sink(static_cast<tile_writer_sink* const>(writer->sink));
+			if (sink->file) {
+				fclose(sink->file); sink->file = nullptr;
+			}
+			scalable_free(sink); writer->sink = nullptr;
+		}
+		writer->destroy = nullptr;
+	}
+}
 
-		if ((MODE_L16 | MODE_LA16 | MODE_BGRX16 | MODE_BGRA16) & pSrcImage->mode)
-			header.glType = KTX_UNSIGNED_SHORT; //  For compressed formats, type=0.
-		else
-			header.glType = KTX_UNSIGNED_BYTE; //  For compressed formats, type=0.
+static ImagingTileWriter* const __restrict __vectorcall
+ImagingNewTileWriter(eIMAGINGMODE const mode, std::wstring_view const filenamepath, int const xsize, int const ysize, uint64_t const data_offset, bool const tif)
+{
+	uint32_t const pixelsize(mode_pixelsize(mode));
 
-		header.glTypeSize = pSrcImage->pixelsize;
+	if (xsize <= 0 || ysize <= 0 || 0 == pixelsize) {
+		return (ImagingTileWriter*)ImagingError_ValueError("bad image size");
+	}
 
-		switch (pSrcImage->mode)
-		{
-		case MODE_L:
-			header.glFormat = header.glBaseInternalFormat = KTX__R;
-			header.glInternalFormat = KTX_R8;
-			break;
-		case MODE_LA:
-			header.glFormat = header.glBaseInternalFormat = KTX__RG;
-			header.glInternalFormat = KTX_RG8;
-			break;
-		case MODE_L16:
-			header.glFormat = header.glBaseInternalFormat = KTX__R;
-			header.glInternalFormat = KTX_R16;
-			break;
-		case MODE_LA16:
-			header.glFormat = header.glBaseInternalFormat = KTX__RG;
-			header.glInternalFormat = KTX_RG16;
-			break;
-		case MODE_BGRA16:
-		case MODE_BGRX16:
-			header.glFormat = header.glBaseInternalFormat = KTX__RGBA;
-			header.glInternalFormat = KTX_RGBA16;
-			break;
-		case MODE_BGRA:
-		case MODE_BGRX:
-		default:
-			header.glFormat = header.glBaseInternalFormat = KTX__RGBA;
-			header.glInternalFormat = KTX_RGBA8;
-			break;
-		}
+	FILE* fOut(nullptr);
 
-		header.pixelWidth = pSrcImage->xsize;
-		header.pixelHeight = pSrcImage->ysize;
-		header.pixelDepth = 0; // must be 0 for 2D/cubemap textures
-		// KTX spec says this field must be 0 for non-array textures
-		header.numberOfArrayElements = 0;
-		header.numberOfFaces = 1;
-		header.numberOfMipmapLevels = 1;
-		header.bytesOfKeyValueData = 0;
+	if (0 != _wfopen_s(&fOut, filenamepath.data(), L"wb")) { // random access
+		return (ImagingTileWriter*)ImagingError_IOError();
+	}
 
-		// write header
-		fwrite(&header, sizeof(KtxHeader), 1, fOut);
+	// the full size of the file is reserved up front, tiles can then be written in any order
+	uint64_t const data_size(uint64_t(xsize) * uint64_t(ysize) * uint64_t(pixelsize));
 
-		// write size of data
-		uint32_t const dataSize(pSrcImage->xsize * pSrcImage->ysize * pSrcImage->pixelsize);
-		fwrite(&dataSize, sizeof(uint32_t), 1, fOut);
+	if (0 != _fseeki64(fOut, int64_t(data_offset + data_size - 1), SEEK_SET) || EOF == fputc(0, fOut)) {
+		fclose(fOut);
+		return (ImagingTileWriter*)ImagingError_IOError();
+	}
 
-		// write data
-		fwrite(&(*pSrcImage->block), dataSize, 1, fOut);
+	ImagingTileWriter* const __restrict writer((ImagingTileWriter*)scalable_malloc(sizeof(ImagingTileWriter)));
+	tile_writer_sink* const __restrict sink((tile_writer_sink*)scalable_malloc(sizeof(tile_writer_sink)));
 
-		fflush(fOut);
-		fclose(fOut); fOut = nullptr;
-		bReturn = true;
+	if (!writer || !sink) {
+		scalable_free(writer);
+		scalable_free(sink);
+		fclose(fOut);
+		return (ImagingTileWriter*)ImagingError_MemoryError();
 	}
-	return(bReturn);
+
+	*sink = tile_writer_sink{ fOut, data_offset, tif, false };
+
+	memset(&(*writer), 0, sizeof(ImagingTileWriter));
+	writer->mode = mode;
+	writer->xsize = xsize;
+	writer->ysize = ysize;
+	writer->sink = sink;
+	writer->destroy = static_cast<void(*)(ImagingTileWriter* const __restrict)>(&ImagingDestroyBlock_TileWriter);
+
+	return(writer);
 }
 
-bool const __vectorcall ImagingSaveLayersToKTX(ImagingMemoryInstance const* const* const __restrict pSrcImages, uint32_t const numLayers, std::wstring_view const filenamepath) // RGB images should be converted to BGRX first
+ImagingTileWriter* const __restrict __vectorcall ImagingCreateTileWriterRaw(eIMAGINGMODE const mode, std::wstring_view const filenamepath, int const width, int const height)
 {
-	bool bReturn(false);
+	return(ImagingNewTileWriter(mode, filenamepath, width, height, 0, false));
+}
 
-	if (numLayers <= 1) {
-		return(false);
+#if INCLUDE_TIF_SUPPORT
+ImagingTileWriter* const __restrict __vectorcall ImagingCreateTileWriterTif(eIMAGINGMODE const mode, std::wstring_view const filenamepath, int const width, int const height)
+{
+	uint16_t samples(0), bits(0), photometric(0), format(0), extra(0);
+	if (!tif_stream::describe(mode, samples, bits, photometric, format, extra)) {
+		return (ImagingTileWriter*)ImagingError_ModeError();
 	}
 
-	// supporting L8, LA8 and RGBA8, all images for layers must be equal in type and dimensions
+	ImagingTileWriter* const __restrict writer(ImagingNewTileWriter(mode, filenamepath, width, height, sizeof(tif_stream::big_header), true));
+	if (!writer) {
+		return(nullptr);
+	}
 
-	//internal format
-	static constexpr uint32_t const KTX_R8 = 0x8229;
-	static constexpr uint32_t const KTX_RG8 = 0x822B;
-	static constexpr uint32_t const KTX_R16 = 0x822A;
-	static constexpr uint32_t const KTX_RG16 = 0x822C;
-	static constexpr uint32_t const KTX_RGBA8 = 0x8058;
-	static constexpr uint32_t const KTX_RGBA16 = 0x805B;
+	tile_writer_sink const& __restrict sink(*static_cast<tile_writer_sink const* const>(writer->sink));
 
-	//base internal format
-	static constexpr uint32_t const KTX__R = 0x1903;
-	static constexpr uint32_t const KTX__RG = 0x8227;
-	static constexpr uint32_t const KTX__RGBA = 0x1908;
+	if (!tif_stream::write_header(sink.file, tif_stream::directory_offset(mode, width, height, sink.data_offset))) {
+		ImagingDelete(writer);
+		return (ImagingTileWriter*)ImagingError_IOError();
+	}
 
-	static constexpr uint32_t const KTX_UNSIGNED_SHORT = 0x1403;
-	static constexpr uint32_t const KTX_UNSIGNED_BYTE = 0x1401;
-	static constexpr uint32_t const KTX_ENDIAN_REF(0x04030201);
+	return(writer);
+}
+#endif
 
-	static constexpr const uint8_t ktx_magic_id[12] = {
-		0xAB, 0x4B, 0x54, 0x58,
-		0x20, 0x31, 0x31, 0xBB,
-		0x0D, 0x0A, 0x1A, 0x0A
-	};
+bool const __vectorcall ImagingWriteTile(ImagingTileWriter* const __restrict writer, ImagingMemoryInstance const* const __restrict tile, ImagingTileRect const& __restrict rect)
+{
+	if (!writer || !writer->sink || !tile) {
+		return(false);
+	}
 
-	FILE* fOut;
-	KtxHeader header = {};
-	memcpy(header.identifier, ktx_magic_id, 12);
+	tile_writer_sink& __restrict sink(*static_cast<tile_writer_sink* const>(writer->sink));
 
-	if (((MODE_L | MODE_LA | MODE_L16 | MODE_LA16 | MODE_BGRX | MODE_BGRA | MODE_BGRX16 | MODE_BGRA16) & pSrcImages[0]->mode))
-	{
-		header.endianness = KTX_ENDIAN_REF;
+	if (rect.xsize <= 0 || rect.ysize <= 0) {
+		return(true); // nothing to write
+	}
 
-		if ((MODE_L16 | MODE_LA16 | MODE_BGRX16 | MODE_BGRA16) & pSrcImages[0]->mode)
-			header.glType = KTX_UNSIGNED_SHORT; //  For compressed formats, type=0.
-		else
-			header.glType = KTX_UNSIGNED_BYTE; //  For compressed formats, type=0.
+	if (!sink.file || tile->mode != writer->mode
+		|| rect.x < 0 || rect.y < 0 || rect.x + rect.xsize > writer->xsize || rect.y + rect.ysize > writer->ysize
+		|| rect.apron_left < 0 || rect.apron_top < 0 || rect.apron_left + rect.xsize > tile->xsize || rect.apron_top + rect.ysize > tile->ysize) {
+		return(false);
+	}
+
+	uint64_t const pixelsize(tile->pixelsize);
+	uint64_t const linesize(uint64_t(writer->xsize) * pixelsize);
+	size_t const run(size_t(rect.xsize) * size_t(pixelsize));
 
-		header.glTypeSize = pSrcImages[0]->pixelsize;
+	uint64_t offset(sink.data_offset + uint64_t(rect.y) * linesize + uint64_t(rect.x) * pixelsize);
+	bool bReturn(true);
 
-		switch (pSrcImages[0]->mode)
-		{
-		case MODE_L:
-			header.glFormat = header.glBaseInternalFormat = KTX__R;
-			header.glInternalFormat = KTX_R8;
-			break;
-		case MODE_LA:
-			header.glFormat = header.glBaseInternalFormat = KTX__RG;
-			header.glInternalFormat = KTX_RG8;
-			break;
-		case MODE_L16:
-			header.glFormat = header.glBaseInternalFormat = KTX__R;
-			header.glInternalFormat = KTX_R16;
-			break;
-		case MODE_LA16:
-			header.glFormat = header.glBaseInternalFormat = KTX__RG;
-			header.glInternalFormat = KTX_RG16;
-			break;
-		case MODE_BGRA16:
-		case MODE_BGRX16:
-			header.glFormat = header.glBaseInternalFormat = KTX__RGBA;
-			header.glInternalFormat = KTX_RGBA16;
-			break;
-		case MODE_BGRA:
-		case MODE_BGRX:
-		default:
-			header.glFormat = header.glBaseInternalFormat = KTX__RGBA;
-			header.glInternalFormat = KTX_RGBA8;
-			break;
-		}
+	if (rect.xsize == writer->xsize && rect.xsize == tile->xsize) { // full width rows are contiguous in both the tile and the file
 
-		header.pixelWidth = pSrcImages[0]->xsize;
-		header.pixelHeight = pSrcImages[0]->ysize;
-		header.pixelDepth = 0; // must be 0 for 2D/cubemap textures
-		// KTX spec says this field must be 0 for non-array textures
-		header.numberOfArrayElements = numLayers;
-		header.numberOfFaces = 1;
-		header.numberOfMipmapLevels = 1;
-		header.bytesOfKeyValueData = 0;
+		bReturn = (0 == _fseeki64(sink.file, int64_t(offset), SEEK_SET))
+			   && (size_t(rect.ysize) == fwrite(tile->image[rect.apron_top], run, rect.ysize, sink.file));
 	}
-	else if (MODE_BC7 == pSrcImages[0]->mode)
-	{
-		return(false); // todo when needed
+	else {
+		for (int y = 0; bReturn && y < rect.ysize; ++y) {
 
+			bReturn = (0 == _fseeki64(sink.file, int64_t(offset), SEEK_SET))
+				   && (run == fwrite(tile->image[rect.apron_top + y] + size_t(rect.apron_left) * size_t(pixelsize), 1, run, sink.file));
+			offset += linesize;
+		}
 	}
-	else
+
+	sink.failed |= !bReturn;
+	return(bReturn);
+}
+
+bool const __vectorcall ImagingCloseTileWriter(ImagingTileWriter* const __restrict writer)
+{
+	if (!writer) {
 		return(false);
+	}
 
-	if (0 == _wfopen_s(&fOut, filenamepath.data(), L"wbS"))
-	{
-		// write header
-		fwrite(&header, sizeof(KtxHeader), 1, fOut);
+	bool bReturn(false);
 
-		// write size of data
-		uint32_t const layerDataSize(pSrcImages[0]->xsize * pSrcImages[0]->ysize * pSrcImages[0]->pixelsize);
-		fwrite(&layerDataSize, sizeof(uint32_t), 1, fOut);
+	if (writer->sink) {
+		tile_writer_sink& __restrict sink(*static_cast<tile_writer_sink* const>(writer->sink));
 
-		// write data
-		for (uint32_t layer = 0; layer < numLayers; ++layer) {
-			fwrite(&(*pSrcImages[layer]->block), layerDataSize, 1, fOut);
-		}
+		bReturn = (nullptr != sink.file) && !sink.failed;
 
-		fflush(fOut);
-		fclose(fOut); fOut = nullptr;
-		bReturn = true;
+#if INCLUDE_TIF_SUPPORT
+		if (bReturn && sink.tif) {
+			bReturn = tif_stream::write_directory(sink.file, writer->mode, writer->xsize, writer->ysize, sink.data_offset,
+				                                  tif_stream::directory_offset(writer->mode, writer->xsize, writer->ysize, sink.data_offset));
+		}
+#endif
+		if (sink.file) {
+			bReturn &= (0 == fclose(sink.file)); sink.file = nullptr;
+		}
 	}
+
+	ImagingDelete(writer);
+
 	return(bReturn);
 }
 
-static constexpr uint32_t const
-BLOCK_WIDTH = 4,
-BLOCK_HEIGHT = BLOCK_WIDTH,
-BLOCK_DEPTH = 1;
+#if TBB_VERSION_MAJOR >= 2021 // oneTBB
+static constexpr tbb::filter_mode const TILE_FILTER_SERIAL(tbb::filter_mode::serial_in_order), TILE_FILTER_PARALLEL(tbb::filter_mode::parallel);
+#else
+static constexpr tbb::filter::mode const TILE_FILTER_SERIAL(tbb::filter::serial_in_order), TILE_FILTER_PARALLEL(tbb::filter::parallel);
+#endif
 
-bool const __vectorcall ImagingSaveCompressedBC7ToKTX(ImagingMemoryInstance const* const __restrict pSrcImage, std::wstring_view const filenamepath)
+typedef struct tile_transform_item {
+
+	ImagingMemoryInstance* __restrict tile;
+	ImagingTileRect rect_in, rect_out;
+
+} tile_transform_item;
+
+bool const __vectorcall ImagingTransformTiles(ImagingTileStream* const __restrict stream, ImagingTileWriter* const __restrict writer, ImagingTileOp const op, void* const __restrict user)
 {
-	bool bReturn(false);
+	if (!stream || !writer || !op) {
+		return(false);
+	}
 
-	static constexpr uint32_t const KTX_COMPRESSED_RGBA_BPTC_UNORM_ARB = 0x8E8C;
-	static constexpr uint32_t const KTX__RGBA = 0x1908;
-	static constexpr uint32_t const KTX_UNSIGNED_BYTE = 0x1401;
-	static constexpr uint32_t const KTX_ENDIAN_REF(0x04030201);
-	
-	static constexpr const uint8_t ktx_magic_id[12] = {
-		0xAB, 0x4B, 0x54, 0x58,
-		0x20, 0x31, 0x31, 0xBB,
-		0x0D, 0x0A, 0x1A, 0x0A
-	};
+	// bounded number of tiles in flight (memory), reading & writing are serial - the op is parallel
+	size_t const max_tiles_in_flight(size_t(SFM::max(2, tbb::this_task_arena::max_concurrency())) << 1);
+	uint32_t const tile_count(stream->tiles_x * stream->tiles_y);
 
-	FILE* fOut;
+	std::atomic_bool failed(false);
+	stream->next = 0;
 
-	if (MODE_BC7 == pSrcImage->mode && 0 == _wfopen_s(&fOut, filenamepath.data(), L"wbS"))
-	{
-		KtxHeader header = {};
-		memcpy(header.identifier, ktx_magic_id, 12);
+	tbb::parallel_pipeline(max_tiles_in_flight,
+		tbb::make_filter<void, tile_transform_item>(TILE_FILTER_SERIAL, [&](tbb::flow_control& fc) -> tile_transform_item {
 
-		header.endianness = KTX_ENDIAN_REF;
-		header.glType = 0; //  For compressed formats, type=0.
-		header.glTypeSize = 1; // or endianness conversion. for compressed types, size=1
-		header.glFormat = 0; // For compressed formats, format=0
-		header.glInternalFormat = KTX_COMPRESSED_RGBA_BPTC_UNORM_ARB;
-		header.glBaseInternalFormat = KTX__RGBA;
-		header.pixelWidth = pSrcImage->xsize;
-		header.pixelHeight = pSrcImage->ysize;
-		header.pixelDepth = 0; // must be 0 for 2D/cubemap textures
-		// KTX spec says this field must be 0 for non-array textures
-		header.numberOfArrayElements = 0;
-		header.numberOfFaces = 1;
-		header.numberOfMipmapLevels = 1;
-		header.bytesOfKeyValueData = 0;
+			tile_transform_item item{};
 
-		// write header
-		fwrite(&header, sizeof(KtxHeader), 1, fOut);
+			if (failed || stream->next >= tile_count) {
+				fc.stop();
+				return(item);
+			}
 
-		// write size of compressed data
-		uint32_t dataCompressedSize(0);
-		{
-			uint32_t const num_blocks = (header.pixelWidth / BLOCK_WIDTH) * (header.pixelHeight / BLOCK_HEIGHT);  // BLOCK_DEPTH == 1
-			dataCompressedSize = num_blocks * BC_BLOCK_BYTES;
+			item.tile = ImagingReadNextTile(stream, item.rect_in);
+			if (!item.tile) {
+				failed = true;
+				fc.stop();
+			}
+			item.rect_out = item.rect_in;
+			return(item);
+		}) &
+		tbb::make_filter<tile_transform_item, tile_transform_item>(TILE_FILTER_PARALLEL, [&](tile_transform_item item) -> tile_transform_item {
+
+			ImagingMemoryInstance* const __restrict out(op(item.tile, item.rect_in, item.rect_out, user));
+			if (out != item.tile) {
+				ImagingDelete(item.tile);
+			}
+			item.tile = out;
+			return(item);
+		}) &
+		tbb::make_filter<tile_transform_item, void>(TILE_FILTER_SERIAL, [&](tile_transform_item const item) {
 
-			fwrite(&dataCompressedSize, sizeof(uint32_t), 1, fOut);
-		}
+			if (!item.tile || !ImagingWriteTile(writer, item.tile, item.rect_out)) {
+				failed = true;
+			}
+			ImagingDelete(item.tile);
+		})
+	);
 
-		fwrite(&(*pSrcImage->block), dataCompressedSize, 1, fOut);
-		fflush(fOut);
-		fclose(fOut); fOut = nullptr;
-		bReturn = true;
-	}
-	return(bReturn);
+	return(!failed);
 }
 
-// Isolated Dynamic DLL Compressonator.dll //
-// Loaded dynamically at run time, to isolate and shutdown thread usage //
-typedef BC_ERROR (CMP_API * const PROC_CMP_InitializeBCLibrary)(void);
-
-typedef CMP_DWORD (CMP_API * const PROC_CMP_CalculateBufferSize)(const CMP_Texture* pTexture);
+typedef struct tile_resample_params {
 
-typedef BC_ERROR (CMP_API * const PROC_CMP_ShutdownBCLibrary)(void);
+	int in_xsize, in_ysize;
+	int out_xsize, out_ysize;
+	int filter;
 
-typedef CMP_ERROR (CMP_API * const PROC_CMP_ConvertTexture)(CMP_Texture* pSourceTexture, CMP_Texture* pDestTexture, const CMP_CompressOptions* pOptions,
-	CMP_Feedback_Proc pFeedbackProc, CMP_DWORD_PTR pUser1, CMP_DWORD_PTR pUser2);
+} tile_resample_params;
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingCompressBGRAToBC7(ImagingMemoryInstance const* const __restrict pSrcImage, float const normalizedQuality)
+static ImagingMemoryInstance* const __vectorcall tile_resample(ImagingMemoryInstance* const __restrict tile, ImagingTileRect const& __restrict rect_in, ImagingTileRect& __restrict rect_out, void* const __restrict user)
 {
-	ImagingMemoryInstance* __restrict imgReturn(nullptr);
+	tile_resample_params const& __restrict p(*static_cast<tile_resample_params const* const>(user));
 
-	HINSTANCE hinstLib(LoadLibrary(L"Compressonator.dll"));
+	// interior edges map to the same output pixel for neighbouring tiles, so the interiors cover the output exactly once
+	auto const to_output = [](int const v, int const in, int const out) {
+		return(int((int64_t(v) * int64_t(out) + (in >> 1)) / int64_t(in)));
+	};
 
-	if (nullptr != hinstLib) {
+	int const ix0(to_output(rect_in.x, p.in_xsize, p.out_xsize)), ix1(to_output(rect_in.x + rect_in.xsize, p.in_xsize, p.out_xsize)),
+		      iy0(to_output(rect_in.y, p.in_ysize, p.out_ysize)), iy1(to_output(rect_in.y + rect_in.ysize, p.in_ysize, p.out_ysize));
 
-		PROC_CMP_InitializeBCLibrary	InitializeBCLibrary( (PROC_CMP_InitializeBCLibrary)GetProcAddress(hinstLib, "CMP_InitializeBCLibrary") );
-		PROC_CMP_CalculateBufferSize	CalculateBufferSize((PROC_CMP_CalculateBufferSize)GetProcAddress(hinstLib, "CMP_CalculateBufferSize"));
-		PROC_CMP_ShutdownBCLibrary		ShutdownBCLibrary((PROC_CMP_ShutdownBCLibrary)GetProcAddress(hinstLib, "CMP_ShutdownBCLibrary"));
-		PROC_CMP_ConvertTexture			ConvertTexture((PROC_CMP_ConvertTexture)GetProcAddress(hinstLib, "CMP_ConvertTexture"));
+	rect_out = ImagingTileRect{ ix0, iy0, ix1 - ix0, iy1 - iy0, 0, 0 };
 
-		if (nullptr != InitializeBCLibrary && nullptr != CalculateBufferSize && nullptr != ShutdownBCLibrary && nullptr != ConvertTexture) {
+	if (rect_out.xsize <= 0 || rect_out.ysize <= 0) {
+		return(tile); // tile vanishes at this scale, nothing is written
+	}
 
-			InitializeBCLibrary();
+	// output interior only, sampled on the grid of the full image (the apron supplies the filter support)
+	return(ImagingResampleRegion(tile, rect_in.x - rect_in.apron_left, rect_in.y - rect_in.apron_top, p.in_xsize, p.in_ysize,
+								 p.out_xsize, p.out_ysize, ix0, iy0, rect_out.xsize, rect_out.ysize, p.filter));
+}
 
-			CMP_Texture srcTexture;
+bool const __vectorcall ImagingStreamResample(ImagingTileStream* const __restrict stream, ImagingTileWriter* const __restrict writer, int const filter)
+{
+	if (!stream || !writer || stream->mode != writer->mode) {
+		return(false);
+	}
 
-			srcTexture.dwSize = sizeof(CMP_Texture);
-			srcTexture.dwWidth = pSrcImage->xsize;
-			srcTexture.dwHeight = pSrcImage->ysize;
-			srcTexture.dwPitch = pSrcImage->linesize;
+	tile_resample_params p{ stream->xsize, stream->ysize, writer->xsize, writer->ysize, filter };
 
-			srcTexture.dwDataSize = pSrcImage->pixelsize * pSrcImage->xsize * pSrcImage->ysize;
-			srcTexture.pData = pSrcImage->block;
-			srcTexture.format = CMP_FORMAT_BGRA_8888;
+	return(ImagingTransformTiles(stream, writer, &tile_resample, &p));
+}
 
-			//===================================
-			// Initialize Compressed Destination
-			//===================================
-			CMP_Texture destTexture;
-			destTexture.dwSize = sizeof(destTexture);
+typedef struct tile_range {
 
-			destTexture.dwWidth = srcTexture.dwWidth;
-			destTexture.dwHeight = srcTexture.dwHeight;
-			destTexture.dwPitch = 0;
-			destTexture.format = CMP_FORMAT_BC7;
-			destTexture.dwDataSize = CalculateBufferSize(&destTexture);
+	double dMin, dMax;
+	bool dither;
 
-			imgReturn = ImagingNewCompressed(MODE_BC7, destTexture.dwWidth, destTexture.dwHeight, destTexture.dwDataSize);
-			
-			if (nullptr != imgReturn) {
+} tile_range;
 
-				destTexture.pData = (CMP_BYTE*)imgReturn->block;
-				destTexture.nBlockWidth = BLOCK_WIDTH;
-				destTexture.nBlockHeight = BLOCK_HEIGHT;
-				destTexture.nBlockDepth = BLOCK_DEPTH;
+static ImagingMemoryInstance* const __vectorcall tile_f32_to_l16(ImagingMemoryInstance* const __restrict tile, ImagingTileRect const& __restrict rect_in, ImagingTileRect& __restrict rect_out, void* const __restrict user)
+{
+	tile_range const& __restrict range(*static_cast<tile_range const* const>(user));
 
-				//==========================
-				// Set Compression Options
-				//==========================
-				CMP_CompressOptions options = { 0 };
-				options.dwSize = sizeof(options);
-				options.fquality = normalizedQuality;
-				options.dwnumThreads = 1;
-				options.bDisableMultiThreading = true;  // compressonator libray spawns multiple threads that stick around eatring resourcfes of the main application
+	return(ImagingF32ToL16(tile, range.dMin, range.dMax, range.dither));
+}
 
-				//==========================
-				// Compress Texture
-				//==========================
-				CMP_ERROR cmp_status = ConvertTexture(&srcTexture, &destTexture, &options, NULL, NULL, NULL);
-				if (CMP_OK != cmp_status)
-				{
-					ImagingDelete(imgReturn); imgReturn = nullptr;
+// min & max of all tiles (MODE_F32), a first pass over all tiles. false if a tile could not be read
+static bool const __vectorcall tile_stream_f32_range(ImagingTileStream* const __restrict stream, tile_range& __restrict range)
+{
+	std::atomic_bool failed(false);
+
+	range = tbb::parallel_reduce(tbb::blocked_range<uint32_t>(0, stream->tiles_x * stream->tiles_y, 1), range,
+		[&](tbb::blocked_range<uint32_t> const& r, tile_range partial) -> tile_range {
+
+			for (uint32_t i = r.begin(); i < r.end(); ++i) {
+
+				ImagingTileRect rect;
+				Imaging const tile(tile_stream_read(stream, i, 0, rect)); // apron excluded
+				if (!tile) {
+					failed = true;
+					continue;
+				}
+
+				double dTileMin(0.0), dTileMax(0.0);
+				if (ImagingF32MinMax(tile, dTileMin, dTileMax)) {
+					partial.dMin = SFM::min(partial.dMin, dTileMin);
+					partial.dMax = SFM::max(partial.dMax, dTileMax);
 				}
+
+				ImagingDelete(tile);
 			}
-			ShutdownBCLibrary();
-		}
-		FreeLibrary(hinstLib);
-		CoFreeUnusedLibrariesEx(0, 0); // actually unloads the dll from memory immediately if ShutdownBCLibrary has been called first or InitializeBCLibrary was never called
+			return(partial);
+		},
+		[](tile_range const a, tile_range const b) -> tile_range {
+			return(tile_range{ SFM::min(a.dMin, b.dMin), SFM::max(a.dMax, b.dMax), a.dither });
+		});
+
+	return(!failed);
+}
+
+// dMin, dMax are optional - same as ImagingF32ToL16, when the range is not specified it is determined by a first pass over all tiles
+bool const __vectorcall ImagingStreamF32ToL16(ImagingTileStream* const __restrict stream, ImagingTileWriter* const __restrict writer, double dMin, double dMax, bool const dither)
+{
+	if (!stream || !writer || MODE_F32 != stream->mode || MODE_L16 != writer->mode
+		|| stream->xsize != writer->xsize || stream->ysize != writer->ysize) {
+		return(false);
 	}
 
-	return(imgReturn);
+	tile_range range{ dMin, dMax, dither };
+
+	if (dMin <= dMax) { // range specified, tiles are not scanned
+		return(ImagingTransformTiles(stream, writer, &tile_f32_to_l16, &range));
+	}
+
+	if (!tile_stream_f32_range(stream, range)) {
+		return(false);
+	}
+
+	return(ImagingTransformTiles(stream, writer, &tile_f32_to_l16, &range));
 }
 
-ImagingMemoryInstance* const __restrict __vectorcall ImagingLoadKTX(std::wstring_view const filenamepath)
+// range == nullptr : ImagingNewHistogram(tile), otherwise ImagingNewHistogram(tile, range[0], range[1], count) (MODE_F32)
+static ImagingHistogram* const __restrict __vectorcall tile_stream_histogram(ImagingTileStream* const __restrict stream, float const* const __restrict range, uint32_t const count)
 {
-	static constexpr wchar_t const* const EXTENSION_KTX1 = L".ktx";
-	static constexpr wchar_t const* const EXTENSION_KTX2 = L".ktx2";
+	ImagingHistogram* __restrict histo(nullptr);
+	uint32_t const tile_count(stream->tiles_x * stream->tiles_y);
 
-	fs::path const filename(filenamepath);
+	for (uint32_t i = 0; i < tile_count; ++i) {
 
-	uint32_t version(0);
+		ImagingTileRect rect;
+		Imaging const tile(tile_stream_read(stream, i, 0, rect)); // apron excluded
+		if (!tile) {
+			ImagingDelete(histo);
+			return(nullptr);
+		}
+
+		ImagingHistogram* const __restrict tile_histo(range ? ImagingNewHistogram(tile, range[0], range[1], count) : ImagingNewHistogram(tile));
+		ImagingDelete(tile);
 
-	if (fs::exists(filename)) {
+		if (!tile_histo) {
+			ImagingDelete(histo);
+			return(nullptr);
+		}
 
-		if (filename.extension() == EXTENSION_KTX1) {
-			version = KTX_VERSION::KTX1;
+		if (!histo) {
+			histo = tile_histo;
 		}
-		else if (filename.extension() == EXTENSION_KTX2) {
-			version = KTX_VERSION::KTX2;
+		else { // accumulate
+
+			histogram::merge(histo, tile_histo->block, 1);
+			histo->total += tile_histo->total;
+			histo->minmax[0] = SFM::min(histo->minmax[0], tile_histo->minmax[0]);
+			histo->minmax[1] = SFM::max(histo->minmax[1], tile_histo->minmax[1]);
+			ImagingDelete(tile_histo);
 		}
 	}
-	else {
+
+	return(histo);
+}
+
+ImagingHistogram* const __restrict __vectorcall ImagingNewHistogram(ImagingTileStream* const __restrict stream)
+{
+	if (!stream) {
 		return(nullptr);
 	}
 
-	if (0 != version) {
-		std::error_code error{};
-
-		mio::mmap_source mmap = mio::make_mmap_source(filenamepath, false, error);
-		if (!error) {
+	if (MODE_F32 == stream->mode) { // range of the data, first pass over all tiles
 
-			if (mmap.is_open() && mmap.is_mapped()) {
-				___prefetch_vmem(mmap.data(), mmap.size());
+		tile_range range{ FLT_MAX, -FLT_MAX, false };
+		if (!tile_stream_f32_range(stream, range)) {
+			return(nullptr);
+		}
+		if (range.dMin > range.dMax) { // no data (all nan)
+			return (ImagingHistogram*)ImagingError_ValueError("no data");
+		}
 
-				uint8_t const* const pReadPointer((uint8_t*)mmap.data());
-				
-				if (KTX_VERSION::KTX1 == version) {
-					KTXFileLayout<KTX_VERSION::KTX1> const ktxFile(pReadPointer, pReadPointer + mmap.length());
+		float const fMin(float(range.dMin));
+		float const fMax(float(range.dMax) > fMin ? float(range.dMax) : std::nextafter(fMin, FLT_MAX)); // constant image, one value - range must not be empty
 
-					if (ktxFile.ok()) {
+		return(ImagingNewHistogram(stream, fMin, fMax));
+	}
 
-						uint32_t const baseOffset(ktxFile.offset(0, 0, 0));
-						return(ktxFile.upload(pReadPointer + baseOffset));
-					}
-				}
-				else {
-					KTXFileLayout<KTX_VERSION::KTX2> const ktx2File(pReadPointer, pReadPointer + mmap.length());
+	return(tile_stream_histogram(stream, nullptr, 0));
+}
 
-					if (ktx2File.ok()) {
+ImagingHistogram* const __restrict __vectorcall ImagingNewHistogram(ImagingTileStream* const __restrict stream, float const fMin, float const fMax, uint32_t const count)
+{
+	if (!stream) {
+		return(nullptr);
+	}
 
-						uint32_t const baseOffset(ktx2File.offset(0, 0, 0));
-						return(ktx2File.upload(pReadPointer + baseOffset));
-					}
-				}
-			}
+	if (MODE_F32 != stream->mode) {
+		return (ImagingHistogram*)ImagingError_ModeError();
+	}
 
-		}
+	if (0 == count || !(fMax > fMin)) {
+		return (ImagingHistogram*)ImagingError_ValueError("bad histogram range");
 	}
 
-	return(nullptr);
-}
\ No newline at end of file
+	float const range[2]{ fMin, fMax };
+
+	return(tile_stream_histogram(stream, range, count));
+}
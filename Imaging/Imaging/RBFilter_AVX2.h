@@ -1,9 +1,13 @@
 #pragma once
 
+#include <tbb\enumerable_thread_specific.h>
+
 // Optimized AVX2 implementation of Recursive Bilateral Filter
 // 
-#define RBF_MAX_THREADS 8 // converted to use tbb
-#define STAGE_BUFFER_COUNT 3
+#define RBF_PITCH_ALIGN 256 // row pitch alignment in bytes
+#define RBF_ROW_PAIR_GRAIN 8 // horizontal pass work unit (pairs of rows), rows and columns are split at runtime across all available threads (work stealing)
+#define RBF_COLUMN_GRAIN 8 // vertical pass work unit (32 byte columns)
+#define STAGE_BUFFER_COUNT 3 // frames in flight in pipelined mode
 
 #define EDGE_COLOR_USE_MAXIMUM 0			// results in much smoother background gradients at loss of some detail - excellent for vectorization
 
@@ -16,11 +20,22 @@
 // if EDGE_COLOR_USE_ADDITION is defined, then edge color detection works by calculating
 // sum of all 3 components, while enforcing 255 maximum. This method is much more sensitive to small differences 
 
-template<uint32_t const edge_detection = EDGE_COLOR_USE_MAXIMUM, uint32_t const thread_count = RBF_MAX_THREADS>
+template<uint32_t const edge_detection = EDGE_COLOR_USE_MAXIMUM>
 class CRBFilterAVX2
 {
+	typedef struct line_caches // 1 per thread, allocated on first use
+	{
+		float*		h = nullptr; // line cache for horizontal filter pass
+		float*		v = nullptr; // line cache for vertical filter pass
+
+		line_caches() = default;
+		line_caches(line_caches const&) : line_caches() {} // copies never share the buffers
+		~line_caches();
+	} line_caches;
+
 	int				m_reserved_width = 0;
 	int				m_reserved_height = 0;
+	int				m_bytes_per_pixel = 0; // 4 (8bpc) or 8 (16bpc)
 
 	float			m_sigma_spatial = 0.f;
 	float			m_sigma_range = 0.f;
@@ -28,17 +43,20 @@ class CRBFilterAVX2
 	float*			m_range_table = nullptr;
 
 	int				m_filter_counter = 0; // used in pipelined mode
-	unsigned char*	m_stage_buffer[STAGE_BUFFER_COUNT] = { nullptr }; // size width * height * 4, others are null if not pipelined
-	float**			m_h_line_cache = nullptr; // line cache for horizontal filter pass, 1 per thread
-	float**			m_v_line_cache = nullptr; // line cache for vertical filter pass, 1 per thread
-	unsigned char*	m_out_buffer[STAGE_BUFFER_COUNT] = { nullptr }; // used for keeping track of current output buffer in pipelined mode 
-	int				m_image_width = 0; // cache of sizes for pipelined mode
-	int				m_image_height = 0;
-	int				m_image_pitch = 0;
-
-	// core filter functions
-	void horizontalFilter(int const thread_index, const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const width, int const height, int const pitch);
-	void verticalFilter(int const thread_index, const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const width, int const height, int const pitch);
+	unsigned char*	m_stage_buffer[STAGE_BUFFER_COUNT] = { nullptr }; // size pitch * height, others are null if not pipelined
+	tbb::enumerable_thread_specific<line_caches> m_line_caches;
+
+	// core filter functions, rows [row_begin, row_end) in pairs - columns [x_begin, x_end) in multiples of 32 bytes
+	void horizontalFilter(float* __restrict line_cache, const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const row_begin, int const row_end, int const pitch);
+	void verticalFilter(float* __restrict line_cache, const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const x_begin, int const x_end, int const height, int const pitch);
+	void horizontalFilter16(float* __restrict line_cache, const uint16_t* __restrict img_src, uint16_t* __restrict img_dst, int const row_begin, int const row_end, int const width, int const pitch);
+	void verticalFilter16(float* __restrict line_cache, const uint16_t* __restrict img_src, uint16_t* __restrict img_dst, int const x_begin, int const x_end, int const height, int const pitch);
+
+	// each pass is split over all available threads
+	line_caches* const localCaches();
+	bool const horizontalPass(const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const width, int const height, int const pitch);
+	bool const verticalPass(const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const width, int const height, int const pitch);
+	bool const validate(int const bytes_per_pixel, int const width, int const height, int const pitch) const;
 
 public:
 
@@ -57,8 +75,10 @@ public:
 	// Source and destination images are assumed to be 4 component
 	// 'width' - maximum image width
 	// 'height' - maximum image height
+	// 'bytes_per_pixel' - 4 (BGRA) or 8 (BGRA16)
+	// 'pipelined' - reserves the stage buffers for filter_stream() to overlap frames
 	// Return true if successful, had very basic error checking
-	bool const initialize(int width, int height);
+	bool const initialize(int width, int height, int const bytes_per_pixel = 4, bool const pipelined = false);
 	
 	// de-initialize, free memory
 	void release();
@@ -73,8 +93,20 @@ public:
 	// return false if failed for some reason
 	bool const filter(unsigned char* __restrict out_data, const unsigned char* __restrict in_data, int const width, int const height, int const pitch);
 
+	// 16bpc version, initialize() w/ 8 bytes per pixel. 'pitch' is still the row size in bytes
+	bool const filter(uint16_t* __restrict out_data, const uint16_t* __restrict in_data, int const width, int const height, int const pitch);
+
+	// streaming (pipelined) filter of a sequence of frames, returns when the stream ends or fails
+	// the vertical pass of frame N overlaps the horizontal pass of frame N+1, initialize() w/ pipelined = true (otherwise frames are filtered one at a time)
+	// 'source' - bool(unsigned char*& out_data, const unsigned char*& in_data), called in frame order for the next frame, returns false at the end of the stream
+	// 'sink' - void(unsigned char* out_data), called in frame order when the output frame is complete
+	// all frames are the same size, 16bpc frames are passed as bytes
+	template<typename Source, typename Sink>
+	bool const filter_stream(Source&& source, Sink&& sink, int const width, int const height, int const pitch);
+
 private:
 	static __inline __declspec(noalias) void __vectorcall getDiffFactor3x(__m256i pix8, __m256i pix8p, __m256i* diff8x);
+	static __inline __declspec(noalias) int const __vectorcall getDiffFactor16(__m128i pix, __m128i pixp);
 };
 
 // example of edge color difference calculation from original implementation
@@ -91,8 +123,8 @@ private:
 //	return ((c1 + c3) >> 2) + (c2 >> 1);
 //}
 
-template<uint32_t const edge_detection, uint32_t const thread_count>
-__inline __declspec(noalias) void __vectorcall CRBFilterAVX2<edge_detection, thread_count>::getDiffFactor3x(__m256i pix8, __m256i pix8p, __m256i* diff8x)
+template<uint32_t const edge_detection>
+__inline __declspec(noalias) void __vectorcall CRBFilterAVX2<edge_detection>::getDiffFactor3x(__m256i pix8, __m256i pix8p, __m256i* diff8x)
 {
 	__m256i const byte_mask = _mm256_set1_epi32(255);
 	__m256i diff;
@@ -129,6 +161,32 @@ __inline __declspec(noalias) void __vectorcall CRBFilterAVX2<edge_detection, thr
 	_mm256_store_si256(diff8x, diff);
 }
 
+// 16bpc, 1 pixel (4 x 32bit components). The difference is scaled to 0-255 (range table index), same methods as above
+template<uint32_t const edge_detection>
+__inline __declspec(noalias) int const __vectorcall CRBFilterAVX2<edge_detection>::getDiffFactor16(__m128i pix, __m128i pixp)
+{
+	__m128i const diff = _mm_srli_epi32(_mm_abs_epi32(_mm_sub_epi32(pix, pixp)), 8);
+
+	int const c1 = _mm_cvtsi128_si32(diff);
+
+	if constexpr (EDGE_GRAYSCALE == edge_detection) {
+		return(c1);
+	}
+	else {
+		int const c2 = _mm_extract_epi32(diff, 1);
+		int const c3 = _mm_extract_epi32(diff, 2);
+
+		if constexpr (EDGE_COLOR_USE_ADDITION == edge_detection) {
+			int const sum = c1 + c2 + c3;
+			return(sum < 255 ? sum : 255); // saturate
+		}
+		else {
+			int const c12 = c1 > c2 ? c1 : c2;
+			return(c12 > c3 ? c12 : c3);
+		}
+	}
+}
+
 
 //template inline include
 #include "RBFilter_AVX2.inl"
@@ -5,29 +5,45 @@
 #include <immintrin.h>
 #include <smmintrin.h>
 
-#include <tbb\parallel_for.h>
+#include <tbb\tbb.h>
 #include <tbb\scalable_allocator.h>
+#include <atomic>
 
 #define MAX_RANGE_TABLE_SIZE UINT8_MAX
 #define ALIGN_SIZE 32
 
-template<uint32_t const edge_detection, uint32_t const thread_count>
-CRBFilterAVX2<edge_detection, thread_count>::CRBFilterAVX2()
+template<uint32_t const edge_detection>
+CRBFilterAVX2<edge_detection>::CRBFilterAVX2()
 {
 	m_range_table = new float[MAX_RANGE_TABLE_SIZE + 1];
 	memset(m_range_table, 0, (MAX_RANGE_TABLE_SIZE + 1) * sizeof(float));
 }
 
-template<uint32_t const edge_detection, uint32_t const thread_count>
-CRBFilterAVX2<edge_detection, thread_count>::~CRBFilterAVX2()
+template<uint32_t const edge_detection>
+CRBFilterAVX2<edge_detection>::~CRBFilterAVX2()
 {
 	release();
 
 	delete[] m_range_table;
 }
 
-template<uint32_t const edge_detection, uint32_t const thread_count>
-bool const CRBFilterAVX2<edge_detection, thread_count>::initialize(int width, int height)
+template<uint32_t const edge_detection>
+CRBFilterAVX2<edge_detection>::line_caches::~line_caches()
+{
+	if (h)
+	{
+		scalable_aligned_free(h);
+		h = nullptr;
+	}
+	if (v)
+	{
+		scalable_aligned_free(v);
+		v = nullptr;
+	}
+}
+
+template<uint32_t const edge_detection>
+bool const CRBFilterAVX2<edge_detection>::initialize(int width, int height, int const bytes_per_pixel, bool const pipelined)
 {
 	// basic sanity check, not strict
 	if (width < 16 || width > 16384)
@@ -36,60 +52,37 @@ bool const CRBFilterAVX2<edge_detection, thread_count>::initialize(int width, in
 	if (height < 2 || height > 16384)
 		return false;
 
+	if (4 != bytes_per_pixel && 8 != bytes_per_pixel)
+		return false;
+
 	release();
 
 	// round height to nearest even number
 	if (height & 1)
 		height++;
 
-	m_reserved_width = getOptimalPitch(width, 4) >> 2;
+	m_reserved_width = getOptimalPitch(width, bytes_per_pixel) / bytes_per_pixel;
 	m_reserved_height = height;
-	
-
-	m_stage_buffer[0] = (unsigned char*)scalable_aligned_malloc(m_reserved_width * m_reserved_height * 4, ALIGN_SIZE);
-	if (!m_stage_buffer[0])
-		return false;
-
-	/////////////////
-	m_h_line_cache = new (std::nothrow) float*[thread_count];
-	if (!m_h_line_cache)
-		return false;
+	m_bytes_per_pixel = bytes_per_pixel;
 
-	// zero just in case
-	for (int i = 0; i < thread_count; ++i)
-		m_h_line_cache[i] = nullptr;
-
-	for (int i = 0; i < thread_count; ++i)
+	int const stage_count = pipelined ? STAGE_BUFFER_COUNT : 1;
+	for (int i = 0; i < stage_count; ++i)
 	{
-		m_h_line_cache[i] = (float*)scalable_aligned_malloc(m_reserved_width * 12 * sizeof(float) * 2 + 128, ALIGN_SIZE);
-		if (!m_h_line_cache[i])
+		m_stage_buffer[i] = (unsigned char*)scalable_aligned_malloc(size_t(m_reserved_width) * size_t(m_reserved_height) * size_t(bytes_per_pixel), ALIGN_SIZE);
+		if (!m_stage_buffer[i])
+		{
+			release();
 			return false;
-
-		// 1st 8 bytes of line cache should remain constant zero
-		memset(m_h_line_cache[i], 0, 8 * sizeof(float));
+		}
 	}
 
-	////////////////
-	m_v_line_cache = new (std::nothrow) float*[thread_count];
-	if (!m_v_line_cache)
-		return false;
-
-	for (int i = 0; i < thread_count; ++i)
-		m_v_line_cache[i] = nullptr;
-
-	int v_line_size = (m_reserved_width * 16 * sizeof(float)) / thread_count;
-	for (int i = 0; i < thread_count; ++i)
-	{
-		m_v_line_cache[i] = (float*)scalable_aligned_malloc(v_line_size, ALIGN_SIZE);
-		if (!m_v_line_cache[i])
-			return false;
-	}
+	// line caches are allocated per thread on first use
 
 	return true;
 }
 
-template<uint32_t const edge_detection, uint32_t const thread_count>
-void CRBFilterAVX2<edge_detection, thread_count>::release()
+template<uint32_t const edge_detection>
+void CRBFilterAVX2<edge_detection>::release()
 {
 	for (int i = 0; i < STAGE_BUFFER_COUNT; ++i)
 	{
@@ -100,39 +93,20 @@ void CRBFilterAVX2<edge_detection, thread_count>::release()
 		}
 	}
 
-	if (m_h_line_cache)
-	{
-		for (int i = 0; i < thread_count; ++i)
-		{
-			if (m_h_line_cache[i])
-				scalable_aligned_free(m_h_line_cache[i]);
-		}
-		delete[] m_h_line_cache;
-		m_h_line_cache = nullptr;
-	}
-
-	if (m_v_line_cache)
-	{
-		for (int i = 0; i < thread_count; ++i)
-		{
-			if (m_v_line_cache[i])
-				scalable_aligned_free(m_v_line_cache[i]);
-		}
-		delete[] m_v_line_cache;
-		m_v_line_cache = nullptr;
-	}
+	m_line_caches.clear(); // line caches are sized by the reserved width
 
 	m_reserved_width = 0;
 	m_reserved_height = 0;
+	m_bytes_per_pixel = 0;
 	m_filter_counter = 0;
 }
 
-template<uint32_t const edge_detection, uint32_t const thread_count>
-int const CRBFilterAVX2<edge_detection, thread_count>::getOptimalPitch(int width, int bytesperpixel)
+template<uint32_t const edge_detection>
+int const CRBFilterAVX2<edge_detection>::getOptimalPitch(int width, int bytesperpixel)
 {
 	width *= bytesperpixel;
 
-	int const round_up = ALIGN_SIZE * thread_count;
+	int const round_up = RBF_PITCH_ALIGN;
 	if (width % round_up)
 	{
 		width += round_up - width % round_up;
@@ -141,8 +115,8 @@ int const CRBFilterAVX2<edge_detection, thread_count>::getOptimalPitch(int width
 	return(width);
 }
 
-template<uint32_t const edge_detection, uint32_t const thread_count>
-void CRBFilterAVX2<edge_detection, thread_count>::setSigma(float sigma_spatial, float sigma_range)
+template<uint32_t const edge_detection>
+void CRBFilterAVX2<edge_detection>::setSigma(float sigma_spatial, float sigma_range)
 {
 	if (m_sigma_spatial != sigma_spatial || m_sigma_range != sigma_range)
 	{
@@ -162,24 +136,17 @@ void CRBFilterAVX2<edge_detection, thread_count>::setSigma(float sigma_spatial,
 	}
 }
 
-template<uint32_t const edge_detection, uint32_t const thread_count>
-void CRBFilterAVX2<edge_detection, thread_count>::horizontalFilter(int const thread_index, const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const width, int const height, int const pitch)
+template<uint32_t const edge_detection>
+void CRBFilterAVX2<edge_detection>::horizontalFilter(float* __restrict line_cache, const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const row_begin, int const row_end, int const pitch)
 {
-	// force height segments to be even cause this filter processes 2 lines at a time
-	int height_segment = (height / thread_count) & (~1);
-	int buffer_offset = thread_index * height_segment * pitch;
+	// this filter processes 2 lines at a time, the segment is always even
+	int height_segment = row_end - row_begin;
+	int buffer_offset = row_begin * pitch;
 	img_src += buffer_offset;
 	img_dst += buffer_offset;
 
 	int width32 = pitch / 32;
 
-	// last segment should account for uneven height
-	// since reserve buffer height is rounded up to even number, it's OK if source is uneven
-	// but that assumes hozitonal filter output buffer is the reservered buffer, or that destination is rounded up to even number
-	if (thread_index + 1 == thread_count)
-		height_segment = height - thread_index * height_segment - 1;		// bugfix for odd linenumber height
-
-//	float* alpha_cache_start = m_alpha_cache[thread_index];
 	// cache line structure: 
 	// 4 floats of alpha_f from line 1
 	// 4 floats of alpha_f from line 2
@@ -187,7 +154,6 @@ void CRBFilterAVX2<edge_detection, thread_count>::horizontalFilter(int const thr
 	// 4 floats of source color premultiplied with 'm_inv_alpha_f' from line 2
 	// 4 floats of 1st pass result color from line 1
 	// 4 floats of 1st pass result color from line 2
-	float* line_cache = m_h_line_cache[thread_index];
 	const float* range_table = m_range_table;
 
 	__declspec(align(32)) long color_diff[16];
@@ -718,17 +684,12 @@ void CRBFilterAVX2<edge_detection, thread_count>::horizontalFilter(int const thr
 
 }
 
-template<uint32_t const edge_detection, uint32_t const thread_count>
-void CRBFilterAVX2<edge_detection, thread_count>::verticalFilter(int const thread_index, const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const width, int const height, int const pitch)
+template<uint32_t const edge_detection>
+void CRBFilterAVX2<edge_detection>::verticalFilter(float* __restrict line_cache, const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const x_begin, int const x_end, int const height, int const pitch)
 {
-	int width_segment = width / thread_count;
-	// make sure width segments round to 32 byte boundary
-	width_segment -= width_segment % 8;
-	int start_offset = width_segment * thread_index;
-	if (thread_index == thread_count - 1) // last one
-	{
-		width_segment = (getOptimalPitch(width, 4) >> 2) - start_offset;
-	}
+	// width segments are on a 32 byte boundary
+	int start_offset = x_begin;
+	int width_segment = x_end - x_begin;
 
 	int width8 = width_segment / 8;
 
@@ -736,7 +697,6 @@ void CRBFilterAVX2<edge_detection, thread_count>::verticalFilter(int const threa
 	img_src += start_offset * 4;
 	img_dst += start_offset * 4;
 
-	float* line_cache = m_v_line_cache[thread_index];
 	const float* range_table = m_range_table;
 
 	_mm256_zeroall();
@@ -1014,11 +974,365 @@ void CRBFilterAVX2<edge_detection, thread_count>::verticalFilter(int const threa
 	}
 }
 
-template<uint32_t const edge_detection, uint32_t const thread_count>
-bool const CRBFilterAVX2<edge_detection, thread_count>::filter(unsigned char* __restrict out_data, const unsigned char* __restrict in_data, int const width, int const height, int const pitch)
+template<uint32_t const edge_detection>
+void CRBFilterAVX2<edge_detection>::horizontalFilter16(float* __restrict line_cache, const uint16_t* __restrict img_src, uint16_t* __restrict img_dst, int const row_begin, int const row_end, int const width, int const pitch)
+{
+	// same cache line structure as the 8bpc version, 24 floats per pixel for 2 lines
+	// pixel x is cached at entry x + 1, entry 0 is the constant zero weight for the first pixel of the left to right pass
+	int const stride = pitch / sizeof(uint16_t);
+	const float* range_table = m_range_table;
+
+	_mm256_zeroall();
+
+	__m256 const inv_alpha = _mm256_set1_ps(m_inv_alpha_f);
+
+	// process 2 horizontal lines at a time
+	for (int y = row_begin; y < row_end; y += 2)
+	{
+		__m256 alpha_prev = _mm256_set1_ps(1.f);
+		__m256 color_prev;
+
+		const uint16_t* src1 = img_src + y * stride;
+		const uint16_t* src2 = src1 + stride;
+
+		/////////////////////////////
+		// right to left pass
+		__m128i pix_prev1 = _mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i const*)(src1 + (width - 1) * 4)));
+		__m128i pix_prev2 = _mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i const*)(src2 + (width - 1) * 4)));
+
+		for (int x = width - 1; x >= 0; --x)
+		{
+			float* line_buffer = line_cache + (x + 1) * 24;
+
+			__m128i const pix1 = _mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i const*)(src1 + x * 4)));
+			__m128i const pix2 = _mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i const*)(src2 + x * 4)));
+
+			// alpha factor
+			float alpha1_f = range_table[getDiffFactor16(pix1, pix_prev1)];
+			float alpha2_f = range_table[getDiffFactor16(pix2, pix_prev2)];
+			__m256 alpha_f_8x = _mm256_set_ps(alpha2_f, alpha2_f, alpha2_f, alpha2_f,
+				alpha1_f, alpha1_f, alpha1_f, alpha1_f);
+			_mm256_store_ps(line_buffer, alpha_f_8x); // cache weights
+
+			// source pixel
+			__m256 pix2f = _mm256_cvtepi32_ps(_mm256_set_m128i(pix2, pix1)); // convert to floats
+			if (x == width - 1) // have to initialize prev_color with last pixel color
+				color_prev = pix2f;
+			pix2f = _mm256_mul_ps(pix2f, inv_alpha); // pre-multiply source color
+			_mm256_store_ps(line_buffer + 8, pix2f);
+
+			// filter 
+			alpha_prev = _mm256_fmadd_ps(alpha_prev, alpha_f_8x, inv_alpha); // filter factor
+			color_prev = _mm256_fmadd_ps(color_prev, alpha_f_8x, pix2f); // filter color
+
+			// final color
+			__m256 out_color = _mm256_div_ps(color_prev, alpha_prev); // get final color
+			_mm256_store_ps(line_buffer + 16, out_color); // cache final color
+
+			pix_prev1 = pix1;
+			pix_prev2 = pix2;
+		}
+
+		/////////////////////////////
+		// left to right pass
+		uint16_t* dst1 = img_dst + y * stride;
+		uint16_t* dst2 = dst1 + stride;
+
+		for (int x = 0; x < width; ++x)
+		{
+			// alpha, weight between this pixel and the previous pixel is cached w/ the previous pixel
+			__m256 alpha_f_8x = _mm256_load_ps(line_cache + x * 24);
+
+			float* line_buffer = line_cache + (x + 1) * 24;
+
+			// get pre-multiplied source color
+			__m256 pix2f = _mm256_load_ps(line_buffer + 8);
+
+			// first pixel in line needs to initialize color_prev to original source color
+			if (x == 0)
+				color_prev = _mm256_div_ps(pix2f, inv_alpha); // source color was premultiplied
+
+			// filter 
+			alpha_prev = _mm256_fmadd_ps(alpha_prev, alpha_f_8x, inv_alpha); // filter factor
+			color_prev = _mm256_fmadd_ps(color_prev, alpha_f_8x, pix2f); // filter color
+
+			// final color 
+			__m256 out_color = _mm256_div_ps(color_prev, alpha_prev); // get final color
+
+			// get final color from previous pass
+			__m256 pix2f_p = _mm256_load_ps(line_buffer + 16);
+			out_color = _mm256_add_ps(out_color, pix2f_p); // combine it with current final color
+			__m256i pix2i = _mm256_cvtps_epi32(out_color); // covert to integer
+			pix2i = _mm256_srli_epi32(pix2i, 1); // division by 2
+
+			// pack result, low half is line 1
+			__m128i const result = _mm_packus_epi32(_mm256_castsi256_si128(pix2i), _mm256_extracti128_si256(pix2i, 1));
+
+			_mm_storel_epi64((__m128i*)(dst1 + x * 4), result);
+			_mm_storeh_pd((double*)(dst2 + x * 4), _mm_castsi128_pd(result));
+		}
+	}
+}
+
+template<uint32_t const edge_detection>
+void CRBFilterAVX2<edge_detection>::verticalFilter16(float* __restrict line_cache, const uint16_t* __restrict img_src, uint16_t* __restrict img_dst, int const x_begin, int const x_end, int const height, int const pitch)
+{
+	// 2 pixels at a time (16 bytes), cache is 8 floats of color factor & 8 floats of color per 2 pixels
+	int const stride = pitch / sizeof(uint16_t);
+	int const width2 = (x_end - x_begin) / 2;
+
+	// adjust img buffer starting positions
+	img_src += x_begin * 4;
+	img_dst += x_begin * 4;
+
+	const float* range_table = m_range_table;
+
+	_mm256_zeroall();
+
+	__m256 const inv_alpha = _mm256_set1_ps(m_inv_alpha_f);
+	__m256 const one = _mm256_set1_ps(1.f);
+
+	/////////////////
+	// Bottom to top pass first
+	{
+		// last line processed separately since no previous
+		{
+			float* line_buffer = line_cache;
+			__m128i* dst_buf = (__m128i*)(img_dst + (height - 1) * stride);
+			const __m128i* src_2xCur = (const __m128i*)(img_src + (height - 1) * stride);
+
+			for (int x = 0; x < width2; x++)
+			{
+				__m128i pix2 = _mm_load_si128(src_2xCur++); // load 2x pixel
+				_mm_store_si128(dst_buf++, pix2); // copy to destination
+
+				_mm256_store_ps(line_buffer, one);
+				_mm256_store_ps(line_buffer + 8, _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(pix2)));
+				line_buffer += 16;
+			}
+		}
+
+		// process other lines
+		for (int y = height - 2; y >= 0; y--)
+		{
+			float* line_buffer = line_cache;
+			__m128i* dst_buf = (__m128i*)(img_dst + y * stride);
+			const __m128i* src_2xCur = (const __m128i*)(img_src + y * stride);
+			const __m128i* src_2xPrev = (const __m128i*)(img_src + (y + 1) * stride);
+
+			for (int x = 0; x < width2; x++)
+			{
+				__m256i pix2i = _mm256_cvtepu16_epi32(_mm_load_si128(src_2xCur++));
+				__m256i pix2ip = _mm256_cvtepu16_epi32(_mm_load_si128(src_2xPrev++));
+
+				// alpha factor
+				float alpha1_f = range_table[getDiffFactor16(_mm256_castsi256_si128(pix2i), _mm256_castsi256_si128(pix2ip))];
+				float alpha2_f = range_table[getDiffFactor16(_mm256_extracti128_si256(pix2i, 1), _mm256_extracti128_si256(pix2ip, 1))];
+				__m256 alpha_f_8x = _mm256_set_ps(alpha2_f, alpha2_f, alpha2_f, alpha2_f,
+					alpha1_f, alpha1_f, alpha1_f, alpha1_f);
+
+				// load previous line color factor & color
+				__m256 alpha_prev = _mm256_load_ps(line_buffer);
+				__m256 color_prev = _mm256_load_ps(line_buffer + 8);
+
+				// filter
+				__m256 pix2f = _mm256_mul_ps(_mm256_cvtepi32_ps(pix2i), inv_alpha);
+				alpha_prev = _mm256_fmadd_ps(alpha_prev, alpha_f_8x, inv_alpha); // filter factor
+				color_prev = _mm256_fmadd_ps(color_prev, alpha_f_8x, pix2f); // filter color
+
+				// store current factor and color as previous for next cycle
+				_mm256_store_ps(line_buffer, alpha_prev);
+				_mm256_store_ps(line_buffer + 8, color_prev);
+				line_buffer += 16;
+
+				// calculate final color, pack float pixels into 16bit pixels
+				pix2i = _mm256_cvtps_epi32(_mm256_div_ps(color_prev, alpha_prev));
+				_mm_store_si128(dst_buf++, _mm_packus_epi32(_mm256_castsi256_si128(pix2i), _mm256_extracti128_si256(pix2i, 1)));
+			}
+		}
+	}
+
+	/////////////////
+	// Top to bottom pass last
+	{
+		// first line processed separately since no previous
+		{
+			float* line_buffer = line_cache;
+			__m128i* dst_line = (__m128i*)img_dst;
+			const __m128i* src_2xCur = (const __m128i*)img_src;
+
+			for (int x = 0; x < width2; x++)
+			{
+				__m128i pix2 = _mm_load_si128(src_2xCur++); // load 2x pixel
+				__m128i pix2_d = _mm_load_si128(dst_line);
+				pix2_d = _mm_avg_epu16(pix2_d, pix2); // average out
+				_mm_store_si128(dst_line++, pix2_d);
+
+				_mm256_store_ps(line_buffer, one);
+				_mm256_store_ps(line_buffer + 8, _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(pix2)));
+				line_buffer += 16;
+			}
+		}
+
+		// process other lines
+		for (int y = 1; y < height; y++)
+		{
+			float* line_buffer = line_cache;
+			__m128i* dst_buf = (__m128i*)(img_dst + y * stride);
+			const __m128i* src_2xCur = (const __m128i*)(img_src + y * stride);
+			const __m128i* src_2xPrev = (const __m128i*)(img_src + (y - 1) * stride);
+
+			for (int x = 0; x < width2; x++)
+			{
+				__m256i pix2i = _mm256_cvtepu16_epi32(_mm_load_si128(src_2xCur++));
+				__m256i pix2ip = _mm256_cvtepu16_epi32(_mm_load_si128(src_2xPrev++));
+
+				// alpha factor
+				float alpha1_f = range_table[getDiffFactor16(_mm256_castsi256_si128(pix2i), _mm256_castsi256_si128(pix2ip))];
+				float alpha2_f = range_table[getDiffFactor16(_mm256_extracti128_si256(pix2i, 1), _mm256_extracti128_si256(pix2ip, 1))];
+				__m256 alpha_f_8x = _mm256_set_ps(alpha2_f, alpha2_f, alpha2_f, alpha2_f,
+					alpha1_f, alpha1_f, alpha1_f, alpha1_f);
+
+				// load previous line color factor & color
+				__m256 alpha_prev = _mm256_load_ps(line_buffer);
+				__m256 color_prev = _mm256_load_ps(line_buffer + 8);
+
+				// filter
+				__m256 pix2f = _mm256_mul_ps(_mm256_cvtepi32_ps(pix2i), inv_alpha);
+				alpha_prev = _mm256_fmadd_ps(alpha_prev, alpha_f_8x, inv_alpha); // filter factor
+				color_prev = _mm256_fmadd_ps(color_prev, alpha_f_8x, pix2f); // filter color
+
+				// store current factor and color as previous for next cycle
+				_mm256_store_ps(line_buffer, alpha_prev);
+				_mm256_store_ps(line_buffer + 8, color_prev);
+				line_buffer += 16;
+
+				// calculate final color, pack float pixels into 16bit pixels
+				pix2i = _mm256_cvtps_epi32(_mm256_div_ps(color_prev, alpha_prev));
+				__m128i pix_out = _mm_packus_epi32(_mm256_castsi256_si128(pix2i), _mm256_extracti128_si256(pix2i, 1));
+
+				// average result with previous values in destination buffer
+				__m128i pix2_d = _mm_load_si128(dst_buf);
+				pix_out = _mm_avg_epu16(pix2_d, pix_out);
+				_mm_store_si128(dst_buf++, pix_out);
+			}
+		}
+	}
+}
+
+template<uint32_t const edge_detection>
+typename CRBFilterAVX2<edge_detection>::line_caches* const CRBFilterAVX2<edge_detection>::localCaches()
+{
+	line_caches& caches = m_line_caches.local();
+
+	if (!caches.h)
+	{
+		// 24 floats per pixel for 2 lines + the leading zero weight entry (+ padding)
+		size_t const h_size = size_t(m_reserved_width + 2) * 24 * sizeof(float);
+		caches.h = (float*)scalable_aligned_malloc(h_size, ALIGN_SIZE);
+		if (!caches.h)
+			return nullptr;
+
+		// 1st 8 floats of line cache should remain constant zero
+		memset(caches.h, 0, 8 * sizeof(float));
+	}
+
+	if (!caches.v)
+	{
+		// up to 16 floats per pixel, a work unit can span the full width
+		size_t const v_size = size_t(m_reserved_width) * 16 * sizeof(float);
+		caches.v = (float*)scalable_aligned_malloc(v_size, ALIGN_SIZE);
+		if (!caches.v)
+			return nullptr;
+	}
+
+	return(&caches);
+}
+
+template<uint32_t const edge_detection>
+bool const CRBFilterAVX2<edge_detection>::horizontalPass(const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const width, int const height, int const pitch)
+{
+	std::atomic_bool failed(false);
+
+	struct { // avoid lambda heap
+		uint8_t const* const __restrict InData;
+		uint8_t* const __restrict StageBuffer;
+		int const Width, Height, Pitch, Pairs;
+		bool const Wide;
+	} const p = { img_src, img_dst, width, height, pitch, height >> 1, 8 == m_bytes_per_pixel };
+
+	// rows are split into work units (pairs of rows) at runtime, work stealing balances the load
+	tbb::parallel_for(tbb::blocked_range<int>(0, p.Pairs, RBF_ROW_PAIR_GRAIN), [&p, &failed, this](tbb::blocked_range<int> const& r)
+	{
+		line_caches* const caches = localCaches();
+		if (!caches) {
+			failed = true;
+			return;
+		}
+
+		int const row_begin = r.begin() << 1;
+		int const row_end = r.end() << 1;
+
+		if (p.Wide)
+			horizontalFilter16(caches->h, (uint16_t const*)p.InData, (uint16_t*)p.StageBuffer, row_begin, row_end, p.Width, p.Pitch);
+		else
+			horizontalFilter(caches->h, p.InData, p.StageBuffer, row_begin, row_end, p.Pitch);
+
+		// odd height, the last line is filtered with the line above it (2 lines at a time), the line above is rewritten with the same result by the same thread
+		if (r.end() == p.Pairs && (p.Height & 1))
+		{
+			if (p.Wide)
+				horizontalFilter16(caches->h, (uint16_t const*)p.InData, (uint16_t*)p.StageBuffer, p.Height - 2, p.Height, p.Width, p.Pitch);
+			else
+				horizontalFilter(caches->h, p.InData, p.StageBuffer, p.Height - 2, p.Height, p.Pitch);
+		}
+	});
+
+	return(!failed);
+}
+
+template<uint32_t const edge_detection>
+bool const CRBFilterAVX2<edge_detection>::verticalPass(const unsigned char* __restrict img_src, unsigned char* __restrict img_dst, int const width, int const height, int const pitch)
+{
+	std::atomic_bool failed(false);
+
+	// columns of 32 bytes, covers the optimal pitch (padding included) like the horizontal pass
+	int const pixels_per_column = ALIGN_SIZE / m_bytes_per_pixel;
+
+	struct { // avoid lambda heap
+		uint8_t const* const __restrict StageBuffer;
+		uint8_t* const __restrict OutData;
+		int const Height, Pitch, PixelsPerColumn;
+		bool const Wide;
+	} const p = { img_src, img_dst, height, pitch, pixels_per_column, 8 == m_bytes_per_pixel };
+
+	int const columns = getOptimalPitch(width, m_bytes_per_pixel) / ALIGN_SIZE;
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, columns, RBF_COLUMN_GRAIN), [&p, &failed, this](tbb::blocked_range<int> const& r)
+	{
+		line_caches* const caches = localCaches();
+		if (!caches) {
+			failed = true;
+			return;
+		}
+
+		int const x_begin = r.begin() * p.PixelsPerColumn;
+		int const x_end = r.end() * p.PixelsPerColumn;
+
+		if (p.Wide)
+			verticalFilter16(caches->v, (uint16_t const*)p.StageBuffer, (uint16_t*)p.OutData, x_begin, x_end, p.Height, p.Pitch);
+		else
+			verticalFilter(caches->v, p.StageBuffer, p.OutData, x_begin, x_end, p.Height, p.Pitch);
+	});
+
+	return(!failed);
+}
+
+template<uint32_t const edge_detection>
+bool const CRBFilterAVX2<edge_detection>::validate(int const bytes_per_pixel, int const width, int const height, int const pitch) const
 {
 	// basic error checking
-	if (!m_stage_buffer[0])
+	if (!m_stage_buffer[0] || bytes_per_pixel != m_bytes_per_pixel)
 		return false;
 
 	if (width < 32 || width > m_reserved_width)
@@ -1027,44 +1341,102 @@ bool const CRBFilterAVX2<edge_detection, thread_count>::filter(unsigned char* __
 	if (height < 16 || height > m_reserved_height)
 		return false;
 
-	if (!out_data || !in_data)
+	// stage buffers & line caches are sized by the reserved width
+	if (pitch < getOptimalPitch(width, bytes_per_pixel) || pitch > m_reserved_width * bytes_per_pixel || (pitch % ALIGN_SIZE))
 		return false;
 
 	if (m_inv_alpha_f == 0.f)
 		return false;
 
+	return true;
+}
+
+template<uint32_t const edge_detection>
+bool const CRBFilterAVX2<edge_detection>::filter(unsigned char* __restrict out_data, const unsigned char* __restrict in_data, int const width, int const height, int const pitch)
+{
+	if (!out_data || !in_data)
+		return false;
+
+	if (!validate(4, width, height, pitch))
+		return false;
+
 	//////////////////////////////////////////////
-	// horizontal filter divided in threads
-	tbb::affinity_partitioner ap;
+	// horizontal filter, then vertical filter - each divided across threads
+	return(horizontalPass(in_data, m_stage_buffer[0], width, height, pitch) &&
+		   verticalPass(m_stage_buffer[0], out_data, width, height, pitch));
+}
 
-	{ // Horizontal Pass
-		struct { // avoid lambda heap
-			uint8_t const* const __restrict InData;
-			uint8_t* const __restrict StageBuffer;
-			int const Width, Height, Pitch;
-		} const p = { in_data, m_stage_buffer[0], width, height, pitch };
+template<uint32_t const edge_detection>
+bool const CRBFilterAVX2<edge_detection>::filter(uint16_t* __restrict out_data, const uint16_t* __restrict in_data, int const width, int const height, int const pitch)
+{
+	if (!out_data || !in_data)
+		return false;
 
-		tbb::parallel_for(uint32_t(0), thread_count, [&p, this](uint32_t i)
-		{
-			horizontalFilter(i, p.InData, p.StageBuffer, p.Width, p.Height, p.Pitch);
-		});
-	}
+	if (!validate(8, width, height, pitch))
+		return false;
 
-	///////////////////////////////////////////// 
-	// vertical filter divided in threads
+	return(horizontalPass((unsigned char const*)in_data, m_stage_buffer[0], width, height, pitch) &&
+		   verticalPass(m_stage_buffer[0], (unsigned char*)out_data, width, height, pitch));
+}
 
-	{ // Vertical Pass
-		struct { // avoid lambda heap
-			uint8_t const* const __restrict StageBuffer;
-			uint8_t* const __restrict OutData;
-			int const Width, Height, Pitch;
-		} const p = { m_stage_buffer[0], out_data, width, height, pitch };
+#if TBB_VERSION_MAJOR >= 2021 // oneTBB
+static constexpr tbb::filter_mode const RBF_FILTER_SERIAL(tbb::filter_mode::serial_in_order);
+#else
+static constexpr tbb::filter::mode const RBF_FILTER_SERIAL(tbb::filter::serial_in_order);
+#endif
 
-		tbb::parallel_for(uint32_t(0), thread_count, [&p, this](uint32_t i)
-		{
-			verticalFilter(i, p.StageBuffer, p.OutData, p.Width, p.Height, p.Pitch);
-		});
-	}
+template<uint32_t const edge_detection>
+template<typename Source, typename Sink>
+bool const CRBFilterAVX2<edge_detection>::filter_stream(Source&& source, Sink&& sink, int const width, int const height, int const pitch)
+{
+	if (!validate(m_bytes_per_pixel, width, height, pitch))
+		return false;
+
+	typedef struct frame {
+		unsigned char* out_data;
+		const unsigned char* in_data;
+		unsigned char* stage_buffer;
+	} frame;
+
+	// each frame in flight owns a stage buffer, frame N+STAGE_BUFFER_COUNT cannot enter until frame N has left the pipeline
+	int const stage_count = m_stage_buffer[STAGE_BUFFER_COUNT - 1] ? STAGE_BUFFER_COUNT : 1;
+	std::atomic_bool failed(false);
 
-	return(true);
-}
\ No newline at end of file
+	m_filter_counter = 0;
+
+	tbb::parallel_pipeline(stage_count,
+		tbb::make_filter<void, frame>(RBF_FILTER_SERIAL, [&](tbb::flow_control& fc) -> frame {
+
+			frame f{};
+
+			if (failed || !source(f.out_data, f.in_data) || !f.out_data || !f.in_data) {
+				fc.stop();
+				return(f);
+			}
+			f.stage_buffer = m_stage_buffer[m_filter_counter++ % stage_count];
+			return(f);
+		}) &
+		tbb::make_filter<frame, frame>(RBF_FILTER_SERIAL, [&](frame const f) -> frame {
+
+			if (!horizontalPass(f.in_data, f.stage_buffer, width, height, pitch)) {
+				failed = true;
+			}
+			return(f);
+		}) &
+		tbb::make_filter<frame, frame>(RBF_FILTER_SERIAL, [&](frame const f) -> frame { // overlaps the horizontal pass of the next frame
+
+			if (!failed && !verticalPass(f.stage_buffer, f.out_data, width, height, pitch)) {
+				failed = true;
+			}
+			return(f);
+		}) &
+		tbb::make_filter<frame, void>(RBF_FILTER_SERIAL, [&](frame const f) {
+
+			if (!failed) {
+				sink(f.out_data);
+			}
+		})
+	);
+
+	return(!failed);
+}
@@ -12,6 +12,8 @@
 
 #include "ResampleSIMD.h"
 #include <tbb/scalable_allocator.h>
+#include <Utility/mem.h>
+#include <atomic>
 
 struct filter {
     double const (*_filter)(double x);
@@ -256,393 +258,1018 @@ normalize_coeffs(int const outSize, int const kmax, double * const __restrict pr
     return coefs_precision;
 }
 
+/* Coefficient tables only depend on (inSize, outSize, filter), batches of same sized images
+   (texture pipelines) reuse them. Tables are immutable once built, so they are shared between
+   concurrent resamples and reference counted. The least recently used table is evicted. */
+#define COEFFS_CACHE_SIZE 16
 
-static Imaging
-ImagingResampleHorizontal_8bpc(ImagingMemoryInstance const* const __restrict imIn, int const xsize, struct filter * const __restrict filterp)
-{
-	Imaging imOut;
-	int ss0;
-	int xx, yy, x, kmax, xmin, xmax;
-	int *xbounds;
-	int16_t *k, *kk;
-	double *prekk;
-	int coefs_precision;
-
-	kmax = precompute_coeffs(imIn->xsize, xsize, filterp, &xbounds, &prekk);
-	if (!kmax) {
-		return (Imaging)ImagingError_MemoryError();
-	}
-
-	coefs_precision = normalize_coeffs(xsize, kmax, prekk, &kk);
-    scalable_free(prekk);
-	if (!coefs_precision) {
-        scalable_free(xbounds);
-		return (Imaging)ImagingError_MemoryError();
-	}
-
-	imOut = ImagingNew(imIn->mode, xsize, imIn->ysize);
-	if (!imOut) {
-        scalable_free(kk);
-        scalable_free(xbounds);
-		return NULL;
-	}
-
-{
-	if (imIn->image8) {
-		for (yy = 0; yy < imOut->ysize; yy++) {
-			for (xx = 0; xx < xsize; xx++) {
-				xmin = xbounds[xx * 2 + 0];
-				xmax = xbounds[xx * 2 + 1];
-				k = &kk[xx * kmax];
-				ss0 = 1 << (coefs_precision - 1);
-				for (x = 0; x < xmax; x++)
-					ss0 += ((uint8_t)imIn->image8[yy][x + xmin]) * k[x];
-				imOut->image8[yy][xx] = clip8(ss0, coefs_precision);
-			}
-		}
-	}
-	else if (imIn->type == IMAGING_TYPE_UINT8) {
-		yy = 0;
-		for (; yy < imOut->ysize - 3; yy += 4) {
-			ImagingResampleHorizontalConvolution8u4x(
-				(uint32_t *)imOut->image32[yy],
-				(uint32_t *)imOut->image32[yy + 1],
-				(uint32_t *)imOut->image32[yy + 2],
-				(uint32_t *)imOut->image32[yy + 3],
-				(uint32_t *)imIn->image32[yy],
-				(uint32_t *)imIn->image32[yy + 1],
-				(uint32_t *)imIn->image32[yy + 2],
-				(uint32_t *)imIn->image32[yy + 3],
-				xsize, xbounds, kk, kmax,
-				coefs_precision
-			);
-		}
-		for (; yy < imOut->ysize; yy++) {
-			ImagingResampleHorizontalConvolution8u(
-				(uint32_t *)imOut->image32[yy],
-				(uint32_t *)imIn->image32[yy],
-				xsize, xbounds, kk, kmax,
-				coefs_precision
-			);
-		}
-	}
-
-}
-    scalable_free(kk);
-    scalable_free(xbounds);
-    return imOut;
+namespace { // local to this file only
+
+    typedef struct coeffs_table {
+
+        int inSize, outSize;
+        struct filter const* filterp;
+
+        int* xbounds;           /* xmin, count pairs for each output pixel */
+        double* prekk;          /* normalized coefficients (32bpc) */
+        float* kkf;             /* normalized coefficients (16bpc, F32) */
+        int16_t* kk;            /* fixed point coefficients (8bpc) */
+        int kmax;
+        int coefs_precision;
+
+        uint64_t last_used;     /* lru tick */
+        int32_t refs;           /* current users of this table */
+        bool cached;            /* false once evicted, last user frees the table */
+
+    } coeffs_table;
+
+    static inline tbb::spin_mutex coeffs_cache_lock;
+    static inline coeffs_table* coeffs_cache[COEFFS_CACHE_SIZE]{};
+    static inline uint64_t coeffs_cache_tick(0);
+
+} // end ns
+
+static void
+free_coeffs(coeffs_table* const __restrict table)
+{
+    scalable_free(table->kk);
+    scalable_free(table->kkf);
+    scalable_free(table->prekk);
+    scalable_free(table->xbounds);
+    scalable_free(table);
 }
 
+static coeffs_table*
+build_coeffs(int const inSize, int const outSize, struct filter * const __restrict filterp)
+{
+    coeffs_table* const table = (coeffs_table*)scalable_malloc(sizeof(coeffs_table));
+    if ( ! table)
+        return NULL;
 
-static Imaging
-ImagingResampleVertical_8bpc(ImagingMemoryInstance const* const __restrict imIn, int const ysize, struct filter * const __restrict filterp)
+    memset(table, 0, sizeof(coeffs_table));
+    table->inSize = inSize;
+    table->outSize = outSize;
+    table->filterp = filterp;
+
+    table->kmax = precompute_coeffs(inSize, outSize, filterp, &table->xbounds, &table->prekk);
+    if ( ! table->kmax) {
+        scalable_free(table);
+        return NULL;
+    }
+
+    table->coefs_precision = normalize_coeffs(outSize, table->kmax, table->prekk, &table->kk);
+    if ( ! table->coefs_precision) {
+        free_coeffs(table);
+        return NULL;
+    }
+
+    /* malloc check ok, overflow checked in precompute_coeffs */
+    table->kkf = (float*)scalable_malloc(outSize * table->kmax * sizeof(float));
+    if ( ! table->kkf) {
+        free_coeffs(table);
+        return NULL;
+    }
+    for (int x = 0; x < outSize * table->kmax; x++) {
+        table->kkf[x] = (float)table->prekk[x];
+    }
+    return table;
+}
+
+// returns a referenced table, every successful acquire must be paired with release_coeffs()
+static coeffs_table const*
+acquire_coeffs(int const inSize, int const outSize, struct filter * const __restrict filterp)
 {
-	Imaging imOut;
-    int ss0;
-    int xx, yy, y, kmax, ymin, ymax;
-    int *xbounds;
-    int16_t *k, *kk;
-    double *prekk;
-    int coefs_precision;
+    {
+        tbb::spin_mutex::scoped_lock lock(coeffs_cache_lock);
+
+        for (uint32_t i = 0; i < COEFFS_CACHE_SIZE; ++i) {
+            coeffs_table* const table(coeffs_cache[i]);
+            if (table && table->inSize == inSize && table->outSize == outSize && table->filterp == filterp) {
+                table->last_used = ++coeffs_cache_tick;
+                ++table->refs;
+                return table;
+            }
+        }
+    }
 
-    kmax = precompute_coeffs(imIn->ysize, ysize, filterp, &xbounds, &prekk);
-    if ( ! kmax) {
-        return (Imaging) ImagingError_MemoryError();
+    // miss - built outside of the lock
+    coeffs_table* const table(build_coeffs(inSize, outSize, filterp));
+    if ( ! table)
+        return NULL;
+
+    table->refs = 1;
+
+    coeffs_table* evicted(nullptr);
+    {
+        tbb::spin_mutex::scoped_lock lock(coeffs_cache_lock);
+
+        uint32_t victim(0);
+        uint64_t oldest(UINT64_MAX);
+        for (uint32_t i = 0; i < COEFFS_CACHE_SIZE; ++i) {
+            coeffs_table const* const entry(coeffs_cache[i]);
+            if (!entry) { // empty slot preferred
+                victim = i;
+                oldest = 0;
+                break;
+            }
+            if (entry->inSize == inSize && entry->outSize == outSize && entry->filterp == filterp) { // another thread built the same table concurrently, keep theirs cached
+                return table; // table->cached == false, freed on release
+            }
+            if (entry->last_used < oldest) {
+                oldest = entry->last_used;
+                victim = i;
+            }
+        }
+
+        evicted = coeffs_cache[victim];
+        if (evicted) {
+            evicted->cached = false;
+            if (0 != evicted->refs) { // still in use, last user frees it
+                evicted = nullptr;
+            }
+        }
+
+        table->cached = true;
+        table->last_used = ++coeffs_cache_tick;
+        coeffs_cache[victim] = table;
     }
-    
-    coefs_precision = normalize_coeffs(ysize, kmax, prekk, &kk);
-    scalable_free(prekk);
-    if ( ! coefs_precision) {
-        scalable_free(xbounds);
-        return (Imaging) ImagingError_MemoryError();
+
+    if (evicted) {
+        free_coeffs(evicted);
     }
+    return table;
+}
 
-    imOut = ImagingNew(imIn->mode, imIn->xsize, ysize);
-    if ( ! imOut) {
-        scalable_free(kk);
-        scalable_free(xbounds);
+static void
+release_coeffs(coeffs_table const* const __restrict ctable)
+{
+    coeffs_table* const table(const_cast<coeffs_table*>(ctable));
+    bool orphaned;
+    {
+        tbb::spin_mutex::scoped_lock lock(coeffs_cache_lock);
+        orphaned = (0 == --table->refs) && !table->cached;
+    }
+    if (orphaned) {
+        free_coeffs(table);
+    }
+}
+
+/* Coefficients of output pixels [out0, out0 + outSize) of a global table, for a source region [src0, src0 + srcSize)
+   of the global input. Windows are rebased to the region, the coefficients are the same as the global resample
+   so neighbouring regions sample the same grid. A window crossing the region edge (region smaller than the
+   filter support) is clipped & renormalized. The table is not cached, free with free_coeffs(). */
+static coeffs_table*
+region_coeffs(coeffs_table const* const __restrict global, int const src0, int const srcSize, int const out0, int const outSize)
+{
+    coeffs_table* const table = (coeffs_table*)scalable_malloc(sizeof(coeffs_table));
+    if ( ! table)
+        return NULL;
+
+    memset(table, 0, sizeof(coeffs_table));
+    table->inSize = srcSize;
+    table->outSize = outSize;
+    table->filterp = global->filterp;
+    table->kmax = global->kmax;
+    table->coefs_precision = global->coefs_precision;
+
+    int const kmax(global->kmax);
+
+    /* malloc check ok, region of a table already checked in precompute_coeffs */
+    table->xbounds = (int*)scalable_malloc(outSize * 2 * sizeof(int));
+    table->prekk = (double*)scalable_malloc(outSize * kmax * sizeof(double));
+    table->kkf = (float*)scalable_malloc(outSize * kmax * sizeof(float));
+    table->kk = (int16_t*)scalable_malloc(outSize * kmax * sizeof(int16_t));
+    if ( ! table->xbounds || ! table->prekk || ! table->kkf || ! table->kk) {
+        free_coeffs(table);
         return NULL;
     }
 
+    for (int xx = 0; xx < outSize; xx++) {
+        int const gx = out0 + xx;
+        int const xmin = global->xbounds[gx * 2 + 0] - src0;
+        int const xmax = global->xbounds[gx * 2 + 1];
+
+        int const first = SFM::max(0, -xmin);
+        int const last = SFM::min(xmax, srcSize - xmin);
+
+        double* const __restrict k = &table->prekk[xx * kmax];
+        float* const __restrict kf = &table->kkf[xx * kmax];
+        int16_t* const __restrict ki = &table->kk[xx * kmax];
+
+        memset(k, 0, kmax * sizeof(double));
+        memset(kf, 0, kmax * sizeof(float));
+        memset(ki, 0, kmax * sizeof(int16_t));
+
+        if (last <= first) { // window entirely outside of the region, nearest edge pixel
+            table->xbounds[xx * 2 + 0] = SFM::min(SFM::max(xmin, 0), srcSize - 1);
+            table->xbounds[xx * 2 + 1] = 1;
+            k[0] = 1.0;
+            kf[0] = 1.0f;
+            ki[0] = (int16_t)SFM::min(1 << table->coefs_precision, INT16_MAX);
+            continue;
+        }
+
+        table->xbounds[xx * 2 + 0] = xmin + first;
+        table->xbounds[xx * 2 + 1] = last - first;
+
+        double const* const __restrict gk = &global->prekk[gx * kmax];
+
+        if (0 == first && xmax == last) { // common case, window inside of the region - exact copy
+            memcpy(k, gk, xmax * sizeof(double));
+            memcpy(kf, &global->kkf[gx * kmax], xmax * sizeof(float));
+            memcpy(ki, &global->kk[gx * kmax], xmax * sizeof(int16_t));
+            continue;
+        }
+
+        double ww(0.0);
+        for (int x = first; x < last; x++) {
+            ww += gk[x];
+        }
+        for (int x = first; x < last; x++) {
+            double const w = (0.0 != ww) ? gk[x] / ww : gk[x];
+            double const fixed = w * (1 << table->coefs_precision);
+
+            k[x - first] = w;
+            kf[x - first] = (float)w;
+            ki[x - first] = (int16_t)SFM::max(SFM::min((int)(fixed < 0.0 ? fixed - 0.5 : fixed + 0.5), INT16_MAX), INT16_MIN);
+        }
+    }
+    return table;
+}
+
+void __vectorcall ImagingResampleFlushCache()
 {
+    coeffs_table* unreferenced[COEFFS_CACHE_SIZE]{};
+    {
+        tbb::spin_mutex::scoped_lock lock(coeffs_cache_lock);
+
+        for (uint32_t i = 0; i < COEFFS_CACHE_SIZE; ++i) {
+            coeffs_table* const table(coeffs_cache[i]);
+            if (table) {
+                table->cached = false;
+                if (0 == table->refs) {
+                    unreferenced[i] = table;
+                }
+                coeffs_cache[i] = nullptr;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < COEFFS_CACHE_SIZE; ++i) {
+        if (unreferenced[i]) {
+            free_coeffs(unreferenced[i]);
+        }
+    }
+}
+
+/* rows per task for the single pass functions */
+#define RESAMPLE_ROW_GRAIN 8
+/* minimum output rows per band for the fused function, each band recomputes the
+   horizontal pass for the rows overlapping the previous band (~kmax source rows) */
+#define RESAMPLE_MIN_BAND_ROWS 16
+
+/* Row kernels, the drivers below are independent of the pixel format.
+   horizontal: resamples count source rows starting at y0, linesOut[i] receives source row (y0 + i)
+   vertical:   resamples output row yy from lines, the ymax rows of its filter window */
+typedef void (__vectorcall* resample_rows_horizontal)(uint8_t * const * const __restrict linesOut, ImagingMemoryInstance const* const __restrict imIn,
+                                                      int const y0, int const count, int const xsize, coeffs_table const* const __restrict coeffs);
+typedef void (__vectorcall* resample_row_vertical)(uint8_t * const __restrict lineOut, uint8_t const * const * const __restrict lines, int const xsize, int const pixelsize,
+                                                   int const yy, coeffs_table const* const __restrict coeffs);
+
+static void __vectorcall
+resample_rows_horizontal_8bpc(uint8_t * const * const __restrict linesOut, ImagingMemoryInstance const* const __restrict imIn,
+                              int const y0, int const count, int const xsize, coeffs_table const* const __restrict coeffs)
+{
+    int const* const __restrict xbounds(coeffs->xbounds);
+    int16_t const* const __restrict kk(coeffs->kk);
+    int const kmax(coeffs->kmax);
+    int const coefs_precision(coeffs->coefs_precision);
+
     if (imIn->image8) {
-        for (yy = 0; yy < ysize; yy++) {
-            k = &kk[yy * kmax];
-            ymin = xbounds[yy * 2 + 0];
-            ymax = xbounds[yy * 2 + 1];
-            for (xx = 0; xx < imOut->xsize; xx++) {
-                ss0 = 1 << (coefs_precision -1);
-                for (y = 0; y < ymax; y++)
-                    ss0 += ((uint8_t) imIn->image8[y + ymin][xx]) * k[y];
-                imOut->image8[yy][xx] = clip8(ss0, coefs_precision);
+        for (int i = 0; i < count; ++i) {
+            uint8_t const* const __restrict lineIn(imIn->image8[y0 + i]);
+            uint8_t* const __restrict lineOut(linesOut[i]);
+
+            for (int xx = 0; xx < xsize; xx++) {
+                int const xmin = xbounds[xx * 2 + 0];
+                int const xmax = xbounds[xx * 2 + 1];
+                int16_t const* const __restrict k = &kk[xx * kmax];
+                int ss0 = 1 << (coefs_precision - 1);
+                for (int x = 0; x < xmax; x++)
+                    ss0 += ((uint8_t)lineIn[x + xmin]) * k[x];
+                lineOut[xx] = clip8(ss0, coefs_precision);
             }
         }
-    } else if (imIn->type == IMAGING_TYPE_UINT8) {
-        for (yy = 0; yy < ysize; yy++) {
-            k = &kk[yy * kmax];
-            ymin = xbounds[yy * 2 + 0];
-            ymax = xbounds[yy * 2 + 1];
-            ImagingResampleVerticalConvolution8u(
-                (uint32_t *) imOut->image32[yy], imIn,
-                ymin, ymax, k, coefs_precision
+    }
+    else {
+        int i = 0;
+        for (; i < count - 3; i += 4) {
+            ImagingResampleHorizontalConvolution8u4x(
+                (uint32_t *)linesOut[i],
+                (uint32_t *)linesOut[i + 1],
+                (uint32_t *)linesOut[i + 2],
+                (uint32_t *)linesOut[i + 3],
+                (uint32_t *)imIn->image32[y0 + i],
+                (uint32_t *)imIn->image32[y0 + i + 1],
+                (uint32_t *)imIn->image32[y0 + i + 2],
+                (uint32_t *)imIn->image32[y0 + i + 3],
+                xsize, xbounds, kk, kmax,
+                coefs_precision
+            );
+        }
+        for (; i < count; i++) {
+            ImagingResampleHorizontalConvolution8u(
+                (uint32_t *)linesOut[i],
+                (uint32_t *)imIn->image32[y0 + i],
+                xsize, xbounds, kk, kmax,
+                coefs_precision
             );
         }
     }
+}
 
+static void __vectorcall
+resample_row_vertical_8bpc(uint8_t * const __restrict lineOut, uint8_t const * const * const __restrict lines, int const xsize, int const pixelsize,
+                           int const yy, coeffs_table const* const __restrict coeffs)
+{
+    int16_t const* const __restrict k(&coeffs->kk[yy * coeffs->kmax]);
+    int const ymax(coeffs->xbounds[yy * 2 + 1]);
+    int const coefs_precision(coeffs->coefs_precision);
+
+    if (1 == pixelsize) {
+        for (int xx = 0; xx < xsize; xx++) {
+            int ss0 = 1 << (coefs_precision - 1);
+            for (int y = 0; y < ymax; y++)
+                ss0 += ((uint8_t)lines[y][xx]) * k[y];
+            lineOut[xx] = clip8(ss0, coefs_precision);
+        }
+    }
+    else {
+        ImagingResampleVerticalConvolution8u(
+            (uint32_t *)lineOut, (uint32_t const* const*)lines, xsize,
+            ymax, k, coefs_precision
+        );
+    }
 }
-    scalable_free(kk);
-    scalable_free(xbounds);
-    return imOut;
+
+// two 8bit components: LA
+static void __vectorcall
+resample_rows_horizontal_LA(uint8_t * const * const __restrict linesOut, ImagingMemoryInstance const* const __restrict imIn,
+                            int const y0, int const count, int const xsize, coeffs_table const* const __restrict coeffs)
+{
+    int const* const __restrict xbounds(coeffs->xbounds);
+    int16_t const* const __restrict kk(coeffs->kk);
+    int const kmax(coeffs->kmax);
+    int const coefs_precision(coeffs->coefs_precision);
+
+    for (int i = 0; i < count; ++i) {
+        uint8_t const* const __restrict lineIn(imIn->image[y0 + i]);
+        uint8_t* const __restrict lineOut(linesOut[i]);
+
+        for (int xx = 0; xx < xsize; xx++) {
+            int const xmin = xbounds[xx * 2 + 0];
+            int const xmax = xbounds[xx * 2 + 1];
+            int16_t const* const __restrict k = &kk[xx * kmax];
+            int ss0 = 1 << (coefs_precision - 1);
+            int ss1 = ss0;
+            for (int x = 0; x < xmax; x++) {
+                ss0 += ((uint8_t)lineIn[(x + xmin) * 2 + 0]) * k[x];
+                ss1 += ((uint8_t)lineIn[(x + xmin) * 2 + 1]) * k[x];
+            }
+            lineOut[xx * 2 + 0] = clip8(ss0, coefs_precision);
+            lineOut[xx * 2 + 1] = clip8(ss1, coefs_precision);
+        }
+    }
+}
+
+static void __vectorcall
+resample_row_vertical_LA(uint8_t * const __restrict lineOut, uint8_t const * const * const __restrict lines, int const xsize, int const pixelsize,
+                         int const yy, coeffs_table const* const __restrict coeffs)
+{
+    int16_t const* const __restrict k(&coeffs->kk[yy * coeffs->kmax]);
+    int const ymax(coeffs->xbounds[yy * 2 + 1]);
+    int const coefs_precision(coeffs->coefs_precision);
+
+    for (int xx = 0; xx < xsize * 2; xx++) { // both components are independent
+        int ss0 = 1 << (coefs_precision - 1);
+        for (int y = 0; y < ymax; y++)
+            ss0 += ((uint8_t)lines[y][xx]) * k[y];
+        lineOut[xx] = clip8(ss0, coefs_precision);
+    }
+}
+
+// 16bit components: L16, LA16, BGRX16, BGRA16
+static void __vectorcall
+resample_rows_horizontal_16bpc(uint8_t * const * const __restrict linesOut, ImagingMemoryInstance const* const __restrict imIn,
+                               int const y0, int const count, int const xsize, coeffs_table const* const __restrict coeffs)
+{
+    for (int i = 0; i < count; ++i) {
+        ImagingResampleHorizontalConvolution16u(
+            (uint16_t *)linesOut[i], (uint16_t const *)imIn->image[y0 + i], imIn->pixelsize >> 1,
+            xsize, coeffs->xbounds, coeffs->kkf, coeffs->kmax
+        );
+    }
+}
+
+static void __vectorcall
+resample_row_vertical_16bpc(uint8_t * const __restrict lineOut, uint8_t const * const * const __restrict lines, int const xsize, int const pixelsize,
+                            int const yy, coeffs_table const* const __restrict coeffs)
+{
+    ImagingResampleVerticalConvolution16u(
+        (uint16_t *)lineOut, (uint16_t const* const*)lines, xsize * (pixelsize >> 1),
+        coeffs->xbounds[yy * 2 + 1], &coeffs->kkf[yy * coeffs->kmax]
+    );
+}
+
+static void __vectorcall
+resample_rows_horizontal_F32(uint8_t * const * const __restrict linesOut, ImagingMemoryInstance const* const __restrict imIn,
+                             int const y0, int const count, int const xsize, coeffs_table const* const __restrict coeffs)
+{
+    for (int i = 0; i < count; ++i) {
+        ImagingResampleHorizontalConvolution32f(
+            (float *)linesOut[i], (float const *)imIn->image[y0 + i],
+            xsize, coeffs->xbounds, coeffs->kkf, coeffs->kmax
+        );
+    }
+}
+
+static void __vectorcall
+resample_row_vertical_F32(uint8_t * const __restrict lineOut, uint8_t const * const * const __restrict lines, int const xsize, int const pixelsize,
+                          int const yy, coeffs_table const* const __restrict coeffs)
+{
+    ImagingResampleVerticalConvolution32f(
+        (float *)lineOut, (float const* const*)lines, xsize,
+        coeffs->xbounds[yy * 2 + 1], &coeffs->kkf[yy * coeffs->kmax]
+    );
+}
+
+// 32bit integer (U32), kept in double precision
+static void __vectorcall
+resample_rows_horizontal_32bpc(uint8_t * const * const __restrict linesOut, ImagingMemoryInstance const* const __restrict imIn,
+                               int const y0, int const count, int const xsize, coeffs_table const* const __restrict coeffs)
+{
+    for (int i = 0; i < count; ++i) {
+        uint32_t const* const __restrict lineIn((uint32_t const*)imIn->image32[y0 + i]);
+        uint32_t* const __restrict lineOut((uint32_t*)linesOut[i]);
+
+        for (int xx = 0; xx < xsize; xx++) {
+            int const xmin = coeffs->xbounds[xx * 2 + 0];
+            int const xmax = coeffs->xbounds[xx * 2 + 1];
+            double const* const __restrict k = &coeffs->prekk[xx * coeffs->kmax];
+            double ss = 0.0;
+            for (int x = 0; x < xmax; x++)
+                ss += lineIn[x + xmin] * k[x];
+            lineOut[xx] = (uint32_t)SFM::round_to_u64(SFM::abs(ss));
+        }
+    }
+}
+
+static void __vectorcall
+resample_row_vertical_32bpc(uint8_t * const __restrict lineOut, uint8_t const * const * const __restrict lines, int const xsize, int const pixelsize,
+                            int const yy, coeffs_table const* const __restrict coeffs)
+{
+    uint32_t const* const* const __restrict linesIn((uint32_t const* const*)lines);
+    double const* const __restrict k(&coeffs->prekk[yy * coeffs->kmax]);
+    int const ymax(coeffs->xbounds[yy * 2 + 1]);
+
+    for (int xx = 0; xx < xsize; xx++) {
+        double ss = 0.0;
+        for (int y = 0; y < ymax; y++)
+            ss += linesIn[y][xx] * k[y];
+        ((uint32_t*)lineOut)[xx] = (uint32_t)SFM::round_to_u64(SFM::abs(ss));
+    }
 }
 
 
 static Imaging
-ImagingResampleHorizontal_32bpc(ImagingMemoryInstance const* const __restrict imIn, int const xsize, struct filter * const __restrict filterp)
+ImagingResampleHorizontal(ImagingMemoryInstance const* const __restrict imIn, int const xsize, struct filter * const __restrict filterp,
+                          resample_rows_horizontal const horizontal)
 {
-	Imaging imOut;
-	double ss;
-	int xx, yy, x, kmax, xmin, xmax;
-	int *xbounds;
-	double *k, *kk;
+    Imaging imOut;
 
-	kmax = precompute_coeffs(imIn->xsize, xsize, filterp, &xbounds, &kk);
-	if (!kmax) {
-		return (Imaging)ImagingError_MemoryError();
-	}
+    coeffs_table const* const coeffs = acquire_coeffs(imIn->xsize, xsize, filterp);
+    if ( ! coeffs) {
+        return (Imaging) ImagingError_MemoryError();
+    }
 
-	imOut = ImagingNew(imIn->mode, xsize, imIn->ysize);
-	if (!imOut) {
-        scalable_free(kk);
-        scalable_free(xbounds);
-		return NULL;
-	}
-
-{
-	for (yy = 0; yy < imOut->ysize; yy++) {
-		for (xx = 0; xx < xsize; xx++) {
-			xmin = xbounds[xx * 2 + 0];
-			xmax = xbounds[xx * 2 + 1];
-			k = &kk[xx * kmax];
-			ss = 0.0;
-			for (x = 0; x < xmax; x++)
-				ss += IMAGING_PIXEL_U32(imIn, x + xmin, yy) * k[x];
-			IMAGING_PIXEL_U32(imOut, xx, yy) = (uint32_t)SFM::round_to_u64(SFM::abs(ss));
-		}
-	}
-}
-    scalable_free(kk);
-    scalable_free(xbounds);
+    imOut = ImagingNew(imIn->mode, xsize, imIn->ysize);
+    if ( ! imOut) {
+        release_coeffs(coeffs);
+        return NULL;
+    }
+
+    tbb::parallel_for(tbb::blocked_range<int>(0, imOut->ysize, RESAMPLE_ROW_GRAIN), [imIn, imOut, coeffs, horizontal](tbb::blocked_range<int> const& r) {
+
+        horizontal(&imOut->image[r.begin()], imIn, r.begin(), (int)r.size(), imOut->xsize, coeffs);
+    });
+
+    release_coeffs(coeffs);
     return imOut;
 }
+
+
 static Imaging
-ImagingResampleHorizontal_16bpc(ImagingMemoryInstance const* const __restrict imIn, int const xsize, struct filter* const __restrict filterp)
+ImagingResampleVertical(ImagingMemoryInstance const* const __restrict imIn, int const ysize, struct filter * const __restrict filterp,
+                        resample_row_vertical const vertical)
 {
     Imaging imOut;
-    double ss;
-    int xx, yy, x, kmax, xmin, xmax;
-    int* xbounds;
-    double* k, * kk;
 
-    kmax = precompute_coeffs(imIn->xsize, xsize, filterp, &xbounds, &kk);
-    if (!kmax) {
-        return (Imaging)ImagingError_MemoryError();
+    coeffs_table const* const coeffs = acquire_coeffs(imIn->ysize, ysize, filterp);
+    if ( ! coeffs) {
+        return (Imaging) ImagingError_MemoryError();
     }
 
-    imOut = ImagingNew(imIn->mode, xsize, imIn->ysize);
-    if (!imOut) {
-        scalable_free(kk);
-        scalable_free(xbounds);
+    imOut = ImagingNew(imIn->mode, imIn->xsize, ysize);
+    if ( ! imOut) {
+        release_coeffs(coeffs);
         return NULL;
     }
 
-    {
-        for (yy = 0; yy < imOut->ysize; yy++) {
-            for (xx = 0; xx < xsize; xx++) {
-                xmin = xbounds[xx * 2 + 0];
-                xmax = xbounds[xx * 2 + 1];
-                k = &kk[xx * kmax];
-                ss = 0.0;
-                for (x = 0; x < xmax; x++)
-                    ss += IMAGING_PIXEL_U16(imIn, x + xmin, yy) * k[x];
-                IMAGING_PIXEL_U16(imOut, xx, yy) = (uint16_t)SFM::round_to_u64(SFM::abs(ss));
+    tbb::parallel_for(tbb::blocked_range<int>(0, ysize, RESAMPLE_ROW_GRAIN), [imIn, imOut, coeffs, vertical](tbb::blocked_range<int> const& r) {
+
+        for (int yy = r.begin(); yy < r.end(); yy++) {
+            int const ymin = coeffs->xbounds[yy * 2 + 0];
+            vertical(imOut->image[yy], &imIn->image[ymin], imOut->xsize, imIn->pixelsize, yy, coeffs);
+        }
+    });
+
+    release_coeffs(coeffs);
+    return imOut;
+}
+
+/* Fused two-pass resize. Output rows are split into bands that are scheduled on tbb, each band owns a
+   ring buffer of kmax (vertical) horizontally resampled rows. As the vertical filter window slides down
+   only the rows entering the window are horizontally resampled, replacing the slots of rows that left.
+   The full size intermediate image of the two-pass resize is never allocated. */
+typedef struct fused_pass {
+    ImagingMemoryInstance const* __restrict imIn;
+    ImagingMemoryInstance const* __restrict imOut;
+    coeffs_table const* __restrict horz;
+    coeffs_table const* __restrict vert;
+    resample_rows_horizontal horizontal;
+    resample_row_vertical vertical;
+    size_t ring_pitch;
+    int ring_rows;
+} fused_pass;
+
+static fused_pass const __vectorcall
+fused_pass_setup(ImagingMemoryInstance const* const __restrict imIn, ImagingMemoryInstance const* const __restrict imOut, coeffs_table const* const __restrict horz, coeffs_table const* const __restrict vert,
+                 resample_rows_horizontal const horizontal, resample_row_vertical const vertical)
+{
+    return fused_pass{ imIn, imOut, horz, vert, horizontal, vertical,
+                       (size_t(imOut->xsize) * size_t(imIn->pixelsize) + (CACHE_LINE_BYTES - 1)) & ~(CACHE_LINE_BYTES - 1), vert->kmax };
+}
+
+// output rows [y0, y1), false if the ring could not be allocated
+static bool const __vectorcall
+resample_fused_band(fused_pass const& __restrict p, int const y0, int const y1)
+{
+    // ring rows followed by the table of row pointers for the current filter window
+    uint8_t* const __restrict ring = (uint8_t*)scalable_aligned_malloc(p.ring_pitch * p.ring_rows + sizeof(uint8_t*) * p.ring_rows, CACHE_LINE_BYTES);
+    if ( ! ring) {
+        return false;
+    }
+    uint8_t const** const __restrict lines = (uint8_t const**)(ring + p.ring_pitch * p.ring_rows);
+
+    int const xsize(p.imOut->xsize);
+    int const pixelsize(p.imIn->pixelsize);
+
+    int next_row(0); // next source row to horizontally resample into the ring
+
+    for (int yy = y0; yy < y1; yy++) {
+        int const ymin = p.vert->xbounds[yy * 2 + 0];
+        int const ymax = p.vert->xbounds[yy * 2 + 1];
+
+        // rows before the window are never needed again, their slots are reused
+        next_row = SFM::max(next_row, ymin);
+
+        while (next_row < ymin + ymax) {
+            uint8_t* rows[4];
+            int const count(SFM::min(4, ymin + ymax - next_row));
+
+            for (int i = 0; i < count; ++i) {
+                rows[i] = ring + size_t((next_row + i) % p.ring_rows) * p.ring_pitch;
             }
+            p.horizontal(rows, p.imIn, next_row, count, xsize, p.horz);
+            next_row += count;
+        }
+
+        for (int y = 0; y < ymax; y++) {
+            lines[y] = ring + size_t((ymin + y) % p.ring_rows) * p.ring_pitch;
         }
+        p.vertical(p.imOut->image[yy], lines, xsize, pixelsize, yy, p.vert);
     }
-    scalable_free(kk);
-    scalable_free(xbounds);
-    return imOut;
+
+    scalable_aligned_free(ring);
+    return true;
 }
 
-static Imaging
-ImagingResampleVertical_32bpc(ImagingMemoryInstance const* const __restrict imIn, int const ysize, struct filter * const __restrict filterp)
+// all output rows, false if a ring could not be allocated
+static bool const __vectorcall
+resample_fused(fused_pass const& __restrict p)
 {
-	Imaging imOut;
-	double ss;
-	int xx, yy, y, kmax, ymin, ymax;
-	int *xbounds;
-	double *k, *kk;
+    std::atomic_bool failed(false);
 
-	kmax = precompute_coeffs(imIn->ysize, ysize, filterp, &xbounds, &kk);
-	if (!kmax) {
-		return (Imaging)ImagingError_MemoryError();
-	}
+    int const ysize(p.imOut->ysize);
+    int const band_rows(SFM::max(RESAMPLE_MIN_BAND_ROWS, ysize / SFM::max(1, tbb::this_task_arena::max_concurrency() << 2)));
 
-	imOut = ImagingNew(imIn->mode, imIn->xsize, ysize);
-	if (!imOut) {
-        scalable_free(kk);
-        scalable_free(xbounds);
-		return NULL;
-	}
-
-
-	for (yy = 0; yy < ysize; yy++) {
-		ymin = xbounds[yy * 2 + 0];
-		ymax = xbounds[yy * 2 + 1];
-		k = &kk[yy * kmax];
-		for (xx = 0; xx < imOut->xsize; xx++) {
-			ss = 0.0;
-			for (y = 0; y < ymax; y++)
-				ss += IMAGING_PIXEL_U32(imIn, xx, y + ymin) * k[y];
-			IMAGING_PIXEL_U32(imOut, xx, yy) = (uint32_t)SFM::round_to_u64(SFM::abs(ss));
-		}
-	}
-
-    scalable_free(kk);
-    scalable_free(xbounds);
-    return imOut;
+    tbb::parallel_for(tbb::blocked_range<int>(0, ysize, band_rows), [&p, &failed](tbb::blocked_range<int> const& r) {
+
+        if ( ! resample_fused_band(p, r.begin(), r.end())) {
+            failed.store(true, std::memory_order_relaxed);
+        }
+
+    }, tbb::simple_partitioner());
+
+    return ! failed;
 }
+
 static Imaging
-ImagingResampleVertical_16bpc(ImagingMemoryInstance const* const __restrict imIn, int const ysize, struct filter* const __restrict filterp)
+ImagingResampleFused(ImagingMemoryInstance const* const __restrict imIn, int const xsize, int const ysize, struct filter * const __restrict filterp,
+                     resample_rows_horizontal const horizontal, resample_row_vertical const vertical)
 {
     Imaging imOut;
-    double ss;
-    int xx, yy, y, kmax, ymin, ymax;
-    int* xbounds;
-    double* k, * kk;
 
-    kmax = precompute_coeffs(imIn->ysize, ysize, filterp, &xbounds, &kk);
-    if (!kmax) {
-        return (Imaging)ImagingError_MemoryError();
+    coeffs_table const* const horz = acquire_coeffs(imIn->xsize, xsize, filterp);
+    if ( ! horz) {
+        return (Imaging) ImagingError_MemoryError();
+    }
+    coeffs_table const* const vert = acquire_coeffs(imIn->ysize, ysize, filterp);
+    if ( ! vert) {
+        release_coeffs(horz);
+        return (Imaging) ImagingError_MemoryError();
     }
 
-    imOut = ImagingNew(imIn->mode, imIn->xsize, ysize);
-    if (!imOut) {
-        scalable_free(kk);
-        scalable_free(xbounds);
+    imOut = ImagingNew(imIn->mode, xsize, ysize);
+    if ( ! imOut) {
+        release_coeffs(vert);
+        release_coeffs(horz);
         return NULL;
     }
 
+    bool const succeeded(resample_fused(fused_pass_setup(imIn, imOut, horz, vert, horizontal, vertical)));
 
-    for (yy = 0; yy < ysize; yy++) {
-        ymin = xbounds[yy * 2 + 0];
-        ymax = xbounds[yy * 2 + 1];
-        k = &kk[yy * kmax];
-        for (xx = 0; xx < imOut->xsize; xx++) {
-            ss = 0.0;
-            for (y = 0; y < ymax; y++)
-                ss += IMAGING_PIXEL_U16(imIn, xx, y + ymin) * k[y];
-            IMAGING_PIXEL_U16(imOut, xx, yy) = (uint16_t)SFM::round_to_u64(SFM::abs(ss));
-        }
-    }
+    release_coeffs(vert);
+    release_coeffs(horz);
 
-    scalable_free(kk);
-    scalable_free(xbounds);
+    if ( ! succeeded) {
+        ImagingDelete(imOut);
+        return (Imaging) ImagingError_MemoryError();
+    }
     return imOut;
 }
 
-// only supports MODE_L, MODE_L16, MODE_BGRX, MODE_BGRA, MODE_U32
-ImagingMemoryInstance* const __restrict __vectorcall
-ImagingResample(ImagingMemoryInstance const* const __restrict imIn, int const xsize, int const ysize, int const filter)
+static struct filter* const __vectorcall
+resample_filter(int const filter)
 {
-    struct filter *filterp;
-    Imaging (*ResampleHorizontal)(ImagingMemoryInstance const* const __restrict imIn, int const xsize, struct filter * const __restrict filterp);
-    Imaging (*ResampleVertical)(ImagingMemoryInstance const* const __restrict imIn, int const xsize, struct filter * const __restrict filterp);
+    switch (filter) {
+    case IMAGING_TRANSFORM_BOX:
+        return &BOX;
+    case IMAGING_TRANSFORM_BILINEAR:
+        return &BILINEAR;
+    case IMAGING_TRANSFORM_HAMMING:
+        return &HAMMING;
+    case IMAGING_TRANSFORM_BICUBIC:
+        return &BICUBIC;
+    case IMAGING_TRANSFORM_LANCZOS:
+        return &LANCZOS;
+    default:
+        return NULL;
+    }
+}
 
-    if (IMAGING_TYPE_SPECIAL == imIn->type || ((MODE_1BIT | MODE_LA | MODE_LA16 | MODE_BGRX16 | MODE_BGRA16 | MODE_RGB | MODE_RGB16 | MODE_F32) & imIn->mode)) {
-        return (Imaging) ImagingError_ModeError();
-    } else if (imIn->image8) { // multiple components (8bpc)
-        ResampleHorizontal = ImagingResampleHorizontal_8bpc;
-        ResampleVertical = ImagingResampleVertical_8bpc;
+// supports MODE_L, MODE_LA, MODE_L16, MODE_LA16, MODE_BGRX, MODE_BGRA, MODE_BGRX16, MODE_BGRA16, MODE_U32, MODE_F32
+static bool const __vectorcall
+resample_kernels(ImagingMemoryInstance const* const __restrict imIn, resample_rows_horizontal& __restrict horizontal, resample_row_vertical& __restrict vertical)
+{
+    if (IMAGING_TYPE_SPECIAL == imIn->type || ((MODE_1BIT | MODE_RGB | MODE_RGB16) & imIn->mode)) {
+        return false;
+    } else if (MODE_LA == imIn->mode) { // two components (8bpc)
+        horizontal = resample_rows_horizontal_LA;
+        vertical = resample_row_vertical_LA;
+    } else if (imIn->image8) { // single component (8bpc)
+        horizontal = resample_rows_horizontal_8bpc;
+        vertical = resample_row_vertical_8bpc;
     } else {
         switch(imIn->type) {
             case IMAGING_TYPE_UINT8: // multiple components (8bpc)
-                ResampleHorizontal = ImagingResampleHorizontal_8bpc;
-                ResampleVertical = ImagingResampleVertical_8bpc;
-                break;
-            case IMAGING_TYPE_UINT32: // only single component (16bpc)
 
-                if (4 == imIn->pixelsize) {
-                    ResampleHorizontal = ImagingResampleHorizontal_32bpc;
-                    ResampleVertical = ImagingResampleVertical_32bpc;
+                if (4 != imIn->pixelsize) {
+                    return false;
                 }
-                else if (2 == imIn->pixelsize) {
-                    ResampleHorizontal = ImagingResampleHorizontal_16bpc;
-                    ResampleVertical = ImagingResampleVertical_16bpc;
+                horizontal = resample_rows_horizontal_8bpc;
+                vertical = resample_row_vertical_8bpc;
+                break;
+            case IMAGING_TYPE_UINT32:
+
+                if (MODE_U32 == imIn->mode) { // single component (32bpc)
+                    horizontal = resample_rows_horizontal_32bpc;
+                    vertical = resample_row_vertical_32bpc;
                 }
-                else {
-                    return (Imaging)ImagingError_ModeError();
+                else { // one or two components (16bpc)
+                    horizontal = resample_rows_horizontal_16bpc;
+                    vertical = resample_row_vertical_16bpc;
                 }
+                break;
+            case IMAGING_TYPE_UINT64: // multiple components (16bpc)
 
+                if (8 != imIn->pixelsize) {
+                    return false;
+                }
+                horizontal = resample_rows_horizontal_16bpc;
+                vertical = resample_row_vertical_16bpc;
+                break;
+            case IMAGING_TYPE_FLOAT32: // single component (32bpc float)
+                horizontal = resample_rows_horizontal_F32;
+                vertical = resample_row_vertical_F32;
                 break;
             default:
-                return (Imaging) ImagingError_ModeError();
+                return false;
         }
     }
+    return true;
+}
+
+ImagingMemoryInstance* const __restrict __vectorcall
+ImagingResample(ImagingMemoryInstance const* const __restrict imIn, int const xsize, int const ysize, int const filter)
+{
+    struct filter *filterp;
+    resample_rows_horizontal horizontal;
+    resample_row_vertical vertical;
+
+    if ( ! resample_kernels(imIn, horizontal, vertical)) {
+        return (Imaging) ImagingError_ModeError();
+    }
 
     /* check filter */
-    switch (filter) {;
-    case IMAGING_TRANSFORM_BOX:
-        filterp = &BOX;
-        break;
-    case IMAGING_TRANSFORM_BILINEAR:
-        filterp = &BILINEAR;
-        break;
-    case IMAGING_TRANSFORM_HAMMING:
-        filterp = &HAMMING;
-        break;
-    case IMAGING_TRANSFORM_BICUBIC:
-        filterp = &BICUBIC;
-        break;
-    case IMAGING_TRANSFORM_LANCZOS:
-        filterp = &LANCZOS;
-        break;
-    default:
+    filterp = resample_filter(filter);
+    if ( ! filterp) {
         return (Imaging) ImagingError_ValueError(
             "unsupported resampling filter"
             );
     }
 
-    Imaging imOut(nullptr);
+    /* both passes in one, no intermediate image */
+    if (imIn->xsize != xsize && imIn->ysize != ysize) {
+        return ImagingResampleFused(imIn, xsize, ysize, filterp, horizontal, vertical);
+    }
 
-    /* two-pass resize, first pass */
+    /* single pass */
     if (imIn->xsize != xsize) {
+        return ImagingResampleHorizontal(imIn, xsize, filterp, horizontal);
+    }
+    if (imIn->ysize != ysize) {
+        return ImagingResampleVertical(imIn, ysize, filterp, vertical);
+    }
+
+    /* image size is no different than source image*/
+    return ImagingCopy(imIn);
+}
 
-        imOut = ResampleHorizontal(imIn, xsize, filterp);
-        if (!imOut)
-            return nullptr;
+/* Region of a resample. imIn is the part of a full image (full_xsize x full_ysize) starting at (src_x, src_y),
+   the output is the region (x0, y0, xsize, ysize) of the full image resampled to (out_xsize x out_ysize).
+   The filter windows are positioned in global coordinates, regions resampled independently tile the full resample
+   exactly when imIn includes the filter support of the output region. The coefficients of the full resample are cached. */
+ImagingMemoryInstance* const __restrict __vectorcall
+ImagingResampleRegion(ImagingMemoryInstance const* const __restrict imIn, int const src_x, int const src_y, int const full_xsize, int const full_ysize,
+                      int const out_xsize, int const out_ysize, int const x0, int const y0, int const xsize, int const ysize, int const filter)
+{
+    resample_rows_horizontal horizontal;
+    resample_row_vertical vertical;
+
+    if ( ! resample_kernels(imIn, horizontal, vertical)) {
+        return (Imaging) ImagingError_ModeError();
     }
 
-    /* second pass */
-    if (imIn->ysize != ysize) {
+    if (src_x < 0 || src_y < 0 || src_x + imIn->xsize > full_xsize || src_y + imIn->ysize > full_ysize
+        || x0 < 0 || y0 < 0 || xsize <= 0 || ysize <= 0 || x0 + xsize > out_xsize || y0 + ysize > out_ysize) {
+        return (Imaging) ImagingError_ValueError("region out of bounds");
+    }
 
-        ImagingMemoryInstance const* imTemp(imOut);
+    struct filter* const filterp(resample_filter(filter));
+    if ( ! filterp) {
+        return (Imaging) ImagingError_ValueError(
+            "unsupported resampling filter"
+            );
+    }
 
-        /* imIn can be the original image or horizontally resampled one */
-        imOut = ResampleVertical((imOut ? imOut : imIn), ysize, filterp);
-        if (imTemp) {
-            ImagingDelete(imTemp); imTemp = nullptr;
+    coeffs_table* horz(NULL);
+    coeffs_table* vert(NULL);
+    {
+        coeffs_table const* const global_horz = acquire_coeffs(full_xsize, out_xsize, filterp);
+        if (global_horz) {
+            horz = region_coeffs(global_horz, src_x, imIn->xsize, x0, xsize);
+            release_coeffs(global_horz);
+        }
+        coeffs_table const* const global_vert = acquire_coeffs(full_ysize, out_ysize, filterp);
+        if (global_vert) {
+            vert = region_coeffs(global_vert, src_y, imIn->ysize, y0, ysize);
+            release_coeffs(global_vert);
         }
-        if (!imOut)
-            return nullptr;
     }
 
-    /* if none of the previous steps are performed, image size is no different than source image*/
-    if (!imOut) {
-        imOut = ImagingCopy(imIn);
+    Imaging imOut((horz && vert) ? ImagingNew(imIn->mode, xsize, ysize) : NULL);
+
+    if (imOut && ! resample_fused(fused_pass_setup(imIn, imOut, horz, vert, horizontal, vertical))) {
+        ImagingDelete(imOut);
+        imOut = NULL;
     }
 
+    if (vert) free_coeffs(vert);
+    if (horz) free_coeffs(horz);
+
+    if ( ! imOut) {
+        return (Imaging) ImagingError_MemoryError();
+    }
     return imOut;
 }
 
 
 
+
+/* Sequence resize. Every frame has the same dimensions so the coefficient tables are acquired once and shared
+   by all frames. Frames are resampled in parallel, the rows of each frame are split into bands nested inside
+   the frame task. The output frames & their row pointers are allocated from one contiguous slab, owned by the sequence. */
+static void ImagingDestroyBlock_ResampledSequence(ImagingSequence* const __restrict im)
+{
+    if (im) {
+        if (im->images) {
+
+            scalable_aligned_free(im->images[0].block); // slab
+
+            scalable_free(im->images); im->images = nullptr;
+        }
+        im->destroy = nullptr;
+    }
+}
+
+// ImagingSequence frames are MODE_BGRX
+ImagingSequence* const __restrict __vectorcall
+ImagingResample(ImagingSequence const* const __restrict imIn, int const xsize, int const ysize, int const filter)
+{
+    if ( ! imIn || ! imIn->images || 0 == imIn->count || xsize <= 0 || ysize <= 0) {
+        return (ImagingSequence*) ImagingError_ValueError("bad sequence");
+    }
+
+    struct filter* const filterp(resample_filter(filter));
+    if ( ! filterp) {
+        return (ImagingSequence*) ImagingError_ValueError(
+            "unsupported resampling filter"
+            );
+    }
+
+    uint32_t const count(imIn->count);
+    int const xsizeIn((int)imIn->xsize), ysizeIn((int)imIn->ysize);
+
+    bool const bHorizontal(xsizeIn != xsize), bVertical(ysizeIn != ysize);
+
+    // shared by all frames
+    coeffs_table const* const horz = bHorizontal ? acquire_coeffs(xsizeIn, xsize, filterp) : NULL;
+    coeffs_table const* const vert = bVertical ? acquire_coeffs(ysizeIn, ysize, filterp) : NULL;
+
+    size_t const linesize(size_t(xsize) * imIn->pixelsize),
+                 imagesize(size_t(ysize) * linesize),
+                 slabsize(((size_t(count) * imagesize + (CACHE_LINE_BYTES - 1)) & ~(CACHE_LINE_BYTES - 1)) + size_t(count) * size_t(ysize) * sizeof(uint8_t*));
+
+    ImagingSequence* const __restrict imOut((ImagingSequence*)scalable_malloc(sizeof(ImagingSequence)));
+    ImagingSequenceInstance* const __restrict images((ImagingSequenceInstance*)scalable_malloc(count * sizeof(ImagingSequenceInstance)));
+    uint8_t* const __restrict slab((uint8_t*)scalable_aligned_malloc(slabsize, CACHE_LINE_BYTES));
+
+    // input frames are blocks only, their row pointers (ImagingResample) are built per frame task
+    uint8_t** const __restrict linesIn((uint8_t**)scalable_malloc(size_t(count) * size_t(ysizeIn) * sizeof(uint8_t*)));
+
+    if ((bHorizontal && ! horz) || (bVertical && ! vert) || ! imOut || ! images || ! slab || ! linesIn) {
+        if (linesIn) scalable_free(linesIn);
+        if (slab) scalable_aligned_free(slab);
+        if (images) scalable_free(images);
+        if (imOut) scalable_free(imOut);
+        if (vert) release_coeffs(vert);
+        if (horz) release_coeffs(horz);
+        return (ImagingSequence*) ImagingError_MemoryError();
+    }
+
+    // Setup ouput sequence descriptor //
+    memset(&(*imOut), 0, sizeof(ImagingSequence));
+    memset(images, 0, count * sizeof(ImagingSequenceInstance));
+
+    imOut->images = images;
+    imOut->count = count;
+    imOut->xsize = xsize;
+    imOut->ysize = ysize;
+    imOut->linesize = (uint32_t)linesize;
+    imOut->destroy = static_cast<void(*)(ImagingSequence* const __restrict)>(&ImagingDestroyBlock_ResampledSequence);
+
+    uint8_t** const __restrict linesOut((uint8_t**)(slab + ((size_t(count) * imagesize + (CACHE_LINE_BYTES - 1)) & ~(CACHE_LINE_BYTES - 1))));
+
+    std::atomic_bool failed(false);
+
+    // bands of all frames together are ~4 tasks per thread
+    int const bands_per_frame(SFM::max(1, (tbb::this_task_arena::max_concurrency() << 2) / (int)SFM::min(count, 1u << 16u)));
+    int const band_rows(SFM::max(RESAMPLE_MIN_BAND_ROWS, ysize / bands_per_frame));
+
+    struct { // avoid lambda heap
+        ImagingSequence const* const __restrict imIn;
+        ImagingSequence* const __restrict imOut;
+        coeffs_table const* const __restrict horz;
+        coeffs_table const* const __restrict vert;
+        uint8_t* const __restrict slab;
+        uint8_t** const __restrict linesIn;
+        uint8_t** const __restrict linesOut;
+        std::atomic_bool* const __restrict failed;
+        size_t const imagesize;
+        int const band_rows;
+
+    } const p = { imIn, imOut, horz, vert, slab, linesIn, linesOut, &failed, imagesize, band_rows };
+
+    tbb::parallel_for(uint32_t(0), count, [&p](uint32_t const i) {
+
+        ImagingSequenceInstance const& __restrict frameIn(p.imIn->images[i]);
+        ImagingSequenceInstance& __restrict frameOut(p.imOut->images[i]);
+
+        // translation to be compatible (ImagingSequenceInstance->ImagingMemoryInstance)
+        ImagingMemoryInstance translationIn{};
+
+        translationIn.mode = MODE_BGRX;
+        translationIn.type = IMAGING_TYPE_UINT8;
+        translationIn.bands = 3;
+        translationIn.xsize = (int32_t)p.imIn->xsize;
+        translationIn.ysize = (int32_t)p.imIn->ysize;
+        translationIn.pixelsize = p.imIn->pixelsize;
+        translationIn.linesize = (int32_t)p.imIn->linesize;
+        translationIn.block = frameIn.block;
+        translationIn.image = &p.linesIn[size_t(i) * size_t(translationIn.ysize)];
+        translationIn.image32 = (uint32_t**)translationIn.image;
+
+        for (int y = 0; y < translationIn.ysize; ++y) {
+            translationIn.image[y] = translationIn.block + size_t(y) * size_t(translationIn.linesize);
+        }
+
+        // output frame, rows are in the slab
+        int32_t const xsize(p.imOut->xsize), ysize(p.imOut->ysize);
+
+        frameOut.mode = MODE_BGRX;
+        frameOut.type = IMAGING_TYPE_UINT8;
+        frameOut.bands = 3;
+        frameOut.xsize = xsize;
+        frameOut.ysize = ysize;
+        frameOut.pixelsize = p.imOut->pixelsize;
+        frameOut.linesize = (int32_t)p.imOut->linesize;
+        frameOut.block = p.slab + size_t(i) * p.imagesize;
+        frameOut.image = &p.linesOut[size_t(i) * size_t(ysize)];
+        frameOut.image32 = (uint32_t**)frameOut.image;
+        frameOut.delay = frameIn.delay;
+
+        for (int y = 0; y < ysize; ++y) {
+            frameOut.image[y] = frameOut.block + size_t(y) * size_t(frameOut.linesize);
+        }
+
+        ImagingMemoryInstance const* const __restrict imIn(&translationIn);
+        ImagingMemoryInstance const* const __restrict imOut(&frameOut);
+
+        if (p.horz && p.vert) { // both passes in one, no intermediate image
+
+            fused_pass const fp(fused_pass_setup(imIn, imOut, p.horz, p.vert, resample_rows_horizontal_8bpc, resample_row_vertical_8bpc));
+
+            tbb::parallel_for(tbb::blocked_range<int>(0, ysize, p.band_rows), [&fp, &p](tbb::blocked_range<int> const& r) {
+
+                if ( ! resample_fused_band(fp, r.begin(), r.end())) {
+                    p.failed->store(true, std::memory_order_relaxed);
+                }
+
+            }, tbb::simple_partitioner());
+        }
+        else if (p.horz) {
+
+            tbb::parallel_for(tbb::blocked_range<int>(0, ysize, p.band_rows), [imIn, imOut, &p](tbb::blocked_range<int> const& r) {
+
+                resample_rows_horizontal_8bpc(&imOut->image[r.begin()], imIn, r.begin(), (int)r.size(), imOut->xsize, p.horz);
+
+            }, tbb::simple_partitioner());
+        }
+        else if (p.vert) {
+
+            tbb::parallel_for(tbb::blocked_range<int>(0, ysize, p.band_rows), [imIn, imOut, &p](tbb::blocked_range<int> const& r) {
+
+                for (int yy = r.begin(); yy < r.end(); yy++) {
+                    int const ymin = p.vert->xbounds[yy * 2 + 0];
+                    resample_row_vertical_8bpc(imOut->image[yy], &imIn->image[ymin], imOut->xsize, imIn->pixelsize, yy, p.vert);
+                }
+
+            }, tbb::simple_partitioner());
+        }
+        else { // same size as the source sequence
+            for (int y = 0; y < ysize; ++y) {
+                memcpy(imOut->image[y], imIn->image[y], imOut->linesize);
+            }
+        }
+    });
+
+    scalable_free(linesIn);
+    if (vert) release_coeffs(vert);
+    if (horz) release_coeffs(horz);
+
+    if (failed) {
+        ImagingDelete(imOut);
+        return (ImagingSequence*) ImagingError_MemoryError();
+    }
+    return imOut;
+}
@@ -5,6 +5,10 @@ void __vectorcall
 ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, ImagingMemoryInstance const * const __restrict imIn,
 	int const xmin, int const xmax, int16_t const * const __restrict k, int const coefs_precision);
 
+void __vectorcall
+ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, uint32_t const * const * const __restrict lines, int const xsize,
+	int const xmax, int16_t const * const __restrict k, int const coefs_precision);
+
 void __vectorcall
 ImagingResampleHorizontalConvolution8u(uint32_t * const __restrict lineOut, uint32_t const* const __restrict lineIn,
 	int const xsize, int const * const __restrict xbounds, int16_t const * const __restrict kk, int const kmax, int const coefs_precision);
@@ -13,4 +17,21 @@ void __vectorcall
 ImagingResampleHorizontalConvolution8u4x(
 	uint32_t * const __restrict lineOut0, uint32_t * const __restrict lineOut1, uint32_t * const __restrict lineOut2, uint32_t * const __restrict lineOut3,
 	uint32_t const * const __restrict lineIn0, uint32_t const * const __restrict lineIn1, uint32_t const * const __restrict lineIn2, uint32_t  const * const __restrict lineIn3,
-	int const xsize, int const * const __restrict xbounds, int16_t const * const __restrict kk, int const kmax, int const coefs_precision);
\ No newline at end of file
+	int const xsize, int const * const __restrict xbounds, int16_t const * const __restrict kk, int const kmax, int const coefs_precision);
+
+// 16bpc & F32 (float coefficients) //
+void __vectorcall
+ImagingResampleHorizontalConvolution16u(uint16_t * const __restrict lineOut, uint16_t const * const __restrict lineIn, int const channels /* 1, 2 or 4 */,
+	int const xsize, int const * const __restrict xbounds, float const * const __restrict kk, int const kmax);
+
+void __vectorcall
+ImagingResampleHorizontalConvolution32f(float * const __restrict lineOut, float const * const __restrict lineIn,
+	int const xsize, int const * const __restrict xbounds, float const * const __restrict kk, int const kmax);
+
+void __vectorcall
+ImagingResampleVerticalConvolution16u(uint16_t * const __restrict lineOut, uint16_t const * const * const __restrict lines, int const count /* xsize * channels */,
+	int const ymax, float const * const __restrict k);
+
+void __vectorcall
+ImagingResampleVerticalConvolution32f(float * const __restrict lineOut, float const * const * const __restrict lines, int const count,
+	int const ymax, float const * const __restrict k);
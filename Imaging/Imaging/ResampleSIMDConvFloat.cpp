@@ -0,0 +1,377 @@
+#include "stdafx.h"
+#include "ResampleSIMD.h"
+
+#include <stdint.h>
+#include <emmintrin.h>
+#include <mmintrin.h>
+#include <smmintrin.h>
+#include <immintrin.h>
+
+#include <Utility/instructionset.h>
+
+// 16bpc (L16, LA16, BGRX16, BGRA16) and F32 convolution, accumulated in single precision with float coefficients.
+// 16bit components are exactly representable and the filter windows are short, so float accumulation is sufficient.
+// AVX2 is the baseline, AVX-512 paths are selected at runtime.
+
+#if defined(__clang__)
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX512
+#endif
+
+namespace { // local to this file only
+
+    static bool const __vectorcall has_avx512()
+    {
+        // cpu support alone is not enough, the os must also save the opmask & zmm register state (XCR0 bits 1, 2, 5, 6, 7)
+        static bool const bAVX512(InstructionSet::AVX512F() && InstructionSet::OSXSAVE() && (0xE6 == (_xgetbv(0) & 0xE6)));
+        return(bAVX512);
+    }
+
+    static __inline __m256 const __vectorcall load8_u16(uint16_t const* const __restrict p)
+    {
+        return(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const*)p))));
+    }
+    static __inline __m128 const __vectorcall load4_u16(uint16_t const* const __restrict p)
+    {
+        return(_mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i const*)p))));
+    }
+    static __inline float const __vectorcall hsum(__m256 const v)
+    {
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_movehdup_ps(s));
+        return(_mm_cvtss_f32(s));
+    }
+    // rounds to nearest and saturates to 0 ... 65535
+    static __inline __m128i const __vectorcall pack8_u16(__m256 const v)
+    {
+        __m256i const i(_mm256_cvtps_epi32(v));
+        return(_mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+    }
+
+} // end ns
+
+// horizontal //
+
+TARGET_AVX512 static void __vectorcall
+ImagingResampleHorizontalConvolution16u_1_AVX512(uint16_t* const __restrict lineOut, uint16_t const* const __restrict lineIn,
+    int const xsize, int const* const __restrict xbounds, float const* const __restrict kk, int const kmax)
+{
+    for (int xx = 0; xx < xsize; xx++) {
+        int const xmin = xbounds[xx * 2 + 0];
+        int const xmax = xbounds[xx * 2 + 1];
+        float const* const __restrict k = &kk[xx * kmax];
+        uint16_t const* const __restrict in = &lineIn[xmin];
+
+        __m512 sss = _mm512_setzero_ps();
+        int x = 0;
+        for (; x < xmax - 15; x += 16) {
+            __m512 const pix = _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(_mm256_loadu_si256((__m256i const*)&in[x])));
+            sss = _mm512_fmadd_ps(pix, _mm512_loadu_ps(&k[x]), sss);
+        }
+        float ss = _mm512_reduce_add_ps(sss);
+        for (; x < xmax; x++)
+            ss += float(in[x]) * k[x];
+        lineOut[xx] = (uint16_t)SFM::saturate_to_u16(ss);
+    }
+}
+
+TARGET_AVX512 static void __vectorcall
+ImagingResampleHorizontalConvolution16u_4_AVX512(uint16_t* const __restrict lineOut, uint16_t const* const __restrict lineIn,
+    int const xsize, int const* const __restrict xbounds, float const* const __restrict kk, int const kmax)
+{
+    __m512i const expand = _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+
+    for (int xx = 0; xx < xsize; xx++) {
+        int const xmin = xbounds[xx * 2 + 0];
+        int const xmax = xbounds[xx * 2 + 1];
+        float const* const __restrict k = &kk[xx * kmax];
+        uint16_t const* const __restrict in = &lineIn[xmin * 4];
+
+        __m512 sss = _mm512_setzero_ps();
+        int x = 0;
+        for (; x < xmax - 3; x += 4) { // 4 pixels at once
+            __m512 const pix = _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(_mm256_loadu_si256((__m256i const*)&in[x * 4])));
+            __m512 const mmk = _mm512_permutexvar_ps(expand, _mm512_castps128_ps512(_mm_loadu_ps(&k[x])));
+            sss = _mm512_fmadd_ps(pix, mmk, sss);
+        }
+        __m128 ss = _mm_add_ps(_mm_add_ps(_mm512_extractf32x4_ps(sss, 0), _mm512_extractf32x4_ps(sss, 1)),
+                               _mm_add_ps(_mm512_extractf32x4_ps(sss, 2), _mm512_extractf32x4_ps(sss, 3)));
+        for (; x < xmax; x++)
+            ss = _mm_fmadd_ps(load4_u16(&in[x * 4]), _mm_set1_ps(k[x]), ss);
+
+        __m128i const v(_mm_cvtps_epi32(ss));
+        _mm_storel_epi64((__m128i*)&lineOut[xx * 4], _mm_packus_epi32(v, v));
+    }
+}
+
+static void __vectorcall
+ImagingResampleHorizontalConvolution16u_1(uint16_t* const __restrict lineOut, uint16_t const* const __restrict lineIn,
+    int const xsize, int const* const __restrict xbounds, float const* const __restrict kk, int const kmax)
+{
+    for (int xx = 0; xx < xsize; xx++) {
+        int const xmin = xbounds[xx * 2 + 0];
+        int const xmax = xbounds[xx * 2 + 1];
+        float const* const __restrict k = &kk[xx * kmax];
+        uint16_t const* const __restrict in = &lineIn[xmin];
+
+        __m256 sss = _mm256_setzero_ps();
+        int x = 0;
+        for (; x < xmax - 7; x += 8) {
+            sss = _mm256_fmadd_ps(load8_u16(&in[x]), _mm256_loadu_ps(&k[x]), sss);
+        }
+        float ss = hsum(sss);
+        for (; x < xmax; x++)
+            ss += float(in[x]) * k[x];
+        lineOut[xx] = (uint16_t)SFM::saturate_to_u16(ss);
+    }
+}
+
+static void __vectorcall
+ImagingResampleHorizontalConvolution16u_2(uint16_t* const __restrict lineOut, uint16_t const* const __restrict lineIn,
+    int const xsize, int const* const __restrict xbounds, float const* const __restrict kk, int const kmax)
+{
+    __m256i const expand = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+
+    for (int xx = 0; xx < xsize; xx++) {
+        int const xmin = xbounds[xx * 2 + 0];
+        int const xmax = xbounds[xx * 2 + 1];
+        float const* const __restrict k = &kk[xx * kmax];
+        uint16_t const* const __restrict in = &lineIn[xmin * 2];
+
+        __m256 sss = _mm256_setzero_ps();
+        int x = 0;
+        for (; x < xmax - 3; x += 4) { // 4 pixels at once
+            __m256 const mmk = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(_mm_loadu_ps(&k[x])), expand);
+            sss = _mm256_fmadd_ps(load8_u16(&in[x * 2]), mmk, sss);
+        }
+        __m128 ss = _mm_add_ps(_mm256_castps256_ps128(sss), _mm256_extractf128_ps(sss, 1));
+        ss = _mm_add_ps(ss, _mm_movehl_ps(ss, ss)); // lanes 0, 1 = luminance, alpha
+        for (; x < xmax; x++) {
+            __m128 const pix = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_cvtsi32_si128(*(int32_t const*)&in[x * 2])));
+            ss = _mm_fmadd_ps(pix, _mm_set1_ps(k[x]), ss);
+        }
+
+        __m128i const v(_mm_cvtps_epi32(ss));
+        *(int32_t*)&lineOut[xx * 2] = _mm_cvtsi128_si32(_mm_packus_epi32(v, v));
+    }
+}
+
+static void __vectorcall
+ImagingResampleHorizontalConvolution16u_4(uint16_t* const __restrict lineOut, uint16_t const* const __restrict lineIn,
+    int const xsize, int const* const __restrict xbounds, float const* const __restrict kk, int const kmax)
+{
+    for (int xx = 0; xx < xsize; xx++) {
+        int const xmin = xbounds[xx * 2 + 0];
+        int const xmax = xbounds[xx * 2 + 1];
+        float const* const __restrict k = &kk[xx * kmax];
+        uint16_t const* const __restrict in = &lineIn[xmin * 4];
+
+        __m256 sss = _mm256_setzero_ps();
+        int x = 0;
+        for (; x < xmax - 1; x += 2) { // 2 pixels at once
+            __m256 const mmk = _mm256_set_m128(_mm_set1_ps(k[x + 1]), _mm_set1_ps(k[x]));
+            sss = _mm256_fmadd_ps(load8_u16(&in[x * 4]), mmk, sss);
+        }
+        __m128 ss = _mm_add_ps(_mm256_castps256_ps128(sss), _mm256_extractf128_ps(sss, 1));
+        for (; x < xmax; x++)
+            ss = _mm_fmadd_ps(load4_u16(&in[x * 4]), _mm_set1_ps(k[x]), ss);
+
+        __m128i const v(_mm_cvtps_epi32(ss));
+        _mm_storel_epi64((__m128i*)&lineOut[xx * 4], _mm_packus_epi32(v, v));
+    }
+}
+
+void __vectorcall
+ImagingResampleHorizontalConvolution16u(uint16_t* const __restrict lineOut, uint16_t const* const __restrict lineIn, int const channels,
+    int const xsize, int const* const __restrict xbounds, float const* const __restrict kk, int const kmax)
+{
+    switch (channels)
+    {
+    case 1:
+        if (has_avx512()) {
+            ImagingResampleHorizontalConvolution16u_1_AVX512(lineOut, lineIn, xsize, xbounds, kk, kmax);
+        }
+        else {
+            ImagingResampleHorizontalConvolution16u_1(lineOut, lineIn, xsize, xbounds, kk, kmax);
+        }
+        break;
+    case 2:
+        ImagingResampleHorizontalConvolution16u_2(lineOut, lineIn, xsize, xbounds, kk, kmax);
+        break;
+    case 4:
+        if (has_avx512()) {
+            ImagingResampleHorizontalConvolution16u_4_AVX512(lineOut, lineIn, xsize, xbounds, kk, kmax);
+        }
+        else {
+            ImagingResampleHorizontalConvolution16u_4(lineOut, lineIn, xsize, xbounds, kk, kmax);
+        }
+        break;
+    }
+}
+
+TARGET_AVX512 static void __vectorcall
+ImagingResampleHorizontalConvolution32f_AVX512(float* const __restrict lineOut, float const* const __restrict lineIn,
+    int const xsize, int const* const __restrict xbounds, float const* const __restrict kk, int const kmax)
+{
+    for (int xx = 0; xx < xsize; xx++) {
+        int const xmin = xbounds[xx * 2 + 0];
+        int const xmax = xbounds[xx * 2 + 1];
+        float const* const __restrict k = &kk[xx * kmax];
+        float const* const __restrict in = &lineIn[xmin];
+
+        __m512 sss = _mm512_setzero_ps();
+        int x = 0;
+        for (; x < xmax - 15; x += 16) {
+            sss = _mm512_fmadd_ps(_mm512_loadu_ps(&in[x]), _mm512_loadu_ps(&k[x]), sss);
+        }
+        float ss = _mm512_reduce_add_ps(sss);
+        for (; x < xmax; x++)
+            ss += in[x] * k[x];
+        lineOut[xx] = ss;
+    }
+}
+
+void __vectorcall
+ImagingResampleHorizontalConvolution32f(float* const __restrict lineOut, float const* const __restrict lineIn,
+    int const xsize, int const* const __restrict xbounds, float const* const __restrict kk, int const kmax)
+{
+    if (has_avx512()) {
+        ImagingResampleHorizontalConvolution32f_AVX512(lineOut, lineIn, xsize, xbounds, kk, kmax);
+        return;
+    }
+
+    for (int xx = 0; xx < xsize; xx++) {
+        int const xmin = xbounds[xx * 2 + 0];
+        int const xmax = xbounds[xx * 2 + 1];
+        float const* const __restrict k = &kk[xx * kmax];
+        float const* const __restrict in = &lineIn[xmin];
+
+        __m256 sss = _mm256_setzero_ps();
+        int x = 0;
+        for (; x < xmax - 7; x += 8) {
+            sss = _mm256_fmadd_ps(_mm256_loadu_ps(&in[x]), _mm256_loadu_ps(&k[x]), sss);
+        }
+        float ss = hsum(sss);
+        for (; x < xmax; x++)
+            ss += in[x] * k[x];
+        lineOut[xx] = ss;
+    }
+}
+
+// vertical // (component count independent, count = xsize * channels)
+
+TARGET_AVX512 static void __vectorcall
+ImagingResampleVerticalConvolution16u_AVX512(uint16_t* const __restrict lineOut, uint16_t const* const* const __restrict lines, int const count,
+    int const ymax, float const* const __restrict k)
+{
+    int xx = 0;
+    for (; xx < count - 31; xx += 32) {
+        __m512 sss0 = _mm512_setzero_ps();
+        __m512 sss1 = _mm512_setzero_ps();
+        for (int y = 0; y < ymax; y++) {
+            __m512 const mmk = _mm512_set1_ps(k[y]);
+            sss0 = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(_mm256_loadu_si256((__m256i const*)&lines[y][xx]))), mmk, sss0);
+            sss1 = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(_mm256_loadu_si256((__m256i const*)&lines[y][xx + 16]))), mmk, sss1);
+        }
+        // negative lobes clamp to zero before the unsigned saturating narrow
+        _mm256_storeu_si256((__m256i*)&lineOut[xx], _mm512_cvtusepi32_epi16(_mm512_max_epi32(_mm512_cvtps_epi32(sss0), _mm512_setzero_si512())));
+        _mm256_storeu_si256((__m256i*)&lineOut[xx + 16], _mm512_cvtusepi32_epi16(_mm512_max_epi32(_mm512_cvtps_epi32(sss1), _mm512_setzero_si512())));
+    }
+    for (; xx < count; xx++) {
+        float ss = 0.0f;
+        for (int y = 0; y < ymax; y++)
+            ss += float(lines[y][xx]) * k[y];
+        lineOut[xx] = (uint16_t)SFM::saturate_to_u16(ss);
+    }
+}
+
+void __vectorcall
+ImagingResampleVerticalConvolution16u(uint16_t* const __restrict lineOut, uint16_t const* const* const __restrict lines, int const count,
+    int const ymax, float const* const __restrict k)
+{
+    if (has_avx512()) {
+        ImagingResampleVerticalConvolution16u_AVX512(lineOut, lines, count, ymax, k);
+        return;
+    }
+
+    int xx = 0;
+    for (; xx < count - 15; xx += 16) {
+        __m256 sss0 = _mm256_setzero_ps();
+        __m256 sss1 = _mm256_setzero_ps();
+        for (int y = 0; y < ymax; y++) {
+            __m256 const mmk = _mm256_broadcast_ss(&k[y]);
+            sss0 = _mm256_fmadd_ps(load8_u16(&lines[y][xx]), mmk, sss0);
+            sss1 = _mm256_fmadd_ps(load8_u16(&lines[y][xx + 8]), mmk, sss1);
+        }
+        _mm_storeu_si128((__m128i*)&lineOut[xx], pack8_u16(sss0));
+        _mm_storeu_si128((__m128i*)&lineOut[xx + 8], pack8_u16(sss1));
+    }
+    for (; xx < count - 7; xx += 8) {
+        __m256 sss = _mm256_setzero_ps();
+        for (int y = 0; y < ymax; y++) {
+            sss = _mm256_fmadd_ps(load8_u16(&lines[y][xx]), _mm256_broadcast_ss(&k[y]), sss);
+        }
+        _mm_storeu_si128((__m128i*)&lineOut[xx], pack8_u16(sss));
+    }
+    for (; xx < count; xx++) {
+        float ss = 0.0f;
+        for (int y = 0; y < ymax; y++)
+            ss += float(lines[y][xx]) * k[y];
+        lineOut[xx] = (uint16_t)SFM::saturate_to_u16(ss);
+    }
+}
+
+TARGET_AVX512 static void __vectorcall
+ImagingResampleVerticalConvolution32f_AVX512(float* const __restrict lineOut, float const* const* const __restrict lines, int const count,
+    int const ymax, float const* const __restrict k)
+{
+    int xx = 0;
+    for (; xx < count - 31; xx += 32) {
+        __m512 sss0 = _mm512_setzero_ps();
+        __m512 sss1 = _mm512_setzero_ps();
+        for (int y = 0; y < ymax; y++) {
+            __m512 const mmk = _mm512_set1_ps(k[y]);
+            sss0 = _mm512_fmadd_ps(_mm512_loadu_ps(&lines[y][xx]), mmk, sss0);
+            sss1 = _mm512_fmadd_ps(_mm512_loadu_ps(&lines[y][xx + 16]), mmk, sss1);
+        }
+        _mm512_storeu_ps(&lineOut[xx], sss0);
+        _mm512_storeu_ps(&lineOut[xx + 16], sss1);
+    }
+    for (; xx < count; xx++) {
+        float ss = 0.0f;
+        for (int y = 0; y < ymax; y++)
+            ss += lines[y][xx] * k[y];
+        lineOut[xx] = ss;
+    }
+}
+
+void __vectorcall
+ImagingResampleVerticalConvolution32f(float* const __restrict lineOut, float const* const* const __restrict lines, int const count,
+    int const ymax, float const* const __restrict k)
+{
+    if (has_avx512()) {
+        ImagingResampleVerticalConvolution32f_AVX512(lineOut, lines, count, ymax, k);
+        return;
+    }
+
+    int xx = 0;
+    for (; xx < count - 15; xx += 16) {
+        __m256 sss0 = _mm256_setzero_ps();
+        __m256 sss1 = _mm256_setzero_ps();
+        for (int y = 0; y < ymax; y++) {
+            __m256 const mmk = _mm256_broadcast_ss(&k[y]);
+            sss0 = _mm256_fmadd_ps(_mm256_loadu_ps(&lines[y][xx]), mmk, sss0);
+            sss1 = _mm256_fmadd_ps(_mm256_loadu_ps(&lines[y][xx + 8]), mmk, sss1);
+        }
+        _mm256_storeu_ps(&lineOut[xx], sss0);
+        _mm256_storeu_ps(&lineOut[xx + 8], sss1);
+    }
+    for (; xx < count; xx++) {
+        float ss = 0.0f;
+        for (int y = 0; y < ymax; y++)
+            ss += lines[y][xx] * k[y];
+        lineOut[xx] = ss;
+    }
+}
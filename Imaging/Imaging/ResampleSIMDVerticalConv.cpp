@@ -9,13 +9,14 @@
 #if defined(__AVX2__)
 #include <immintrin.h>
 #endif
+// lines is a table of xmax source row pointers, lines[0] being the first row in the filter window
+// (rows do not need to be contiguous in memory, so a ring buffer of rows can be passed)
 void __vectorcall
-ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, ImagingMemoryInstance const * const __restrict imIn,
-    int const xmin, int const xmax, int16_t const * const __restrict k, int const coefs_precision)
+ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, uint32_t const * const * const __restrict lines, int const xsize,
+    int const xmax, int16_t const * const __restrict k, int const coefs_precision)
 {
     int x;
     int xx = 0;
-    int xsize = imIn->xsize;
 
     __m128i initial = _mm_set1_epi32((1 << (coefs_precision - 1)));
 
@@ -37,9 +38,9 @@ ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, Imagin
             mmk = _mm256_set1_epi32(*(int32_t*) &k[x]);
             
             source1 = _mm256_loadu_si256(  // top line
-                (__m256i *) &imIn->image32[x + xmin][xx]);
+                (__m256i *) &lines[x][xx]);
             source2 = _mm256_loadu_si256(  // bottom line
-                (__m256i *) &imIn->image32[x + 1 + xmin][xx]);
+                (__m256i *) &lines[x + 1][xx]);
 
             source = _mm256_unpacklo_epi8(source1, source2);
             pix = _mm256_unpacklo_epi8(source, _mm256_setzero_si256());
@@ -58,7 +59,7 @@ ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, Imagin
             mmk = _mm256_set1_epi32(k[x]);
             
             source1 = _mm256_loadu_si256(  // top line
-                (__m256i *) &imIn->image32[x + xmin][xx]);
+                (__m256i *) &lines[x][xx]);
             
             source = _mm256_unpacklo_epi8(source1, _mm256_setzero_si256());
             pix = _mm256_unpacklo_epi8(source, _mm256_setzero_si256());
@@ -103,9 +104,9 @@ ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, Imagin
             mmk = _mm_set1_epi32(*(INT32 *) &k[x]);
             
             source1 = _mm_loadu_si128(  // top line
-                (__m128i *) &imIn->image32[x + xmin][xx]);
+                (__m128i *) &lines[x][xx]);
             source2 = _mm_loadu_si128(  // bottom line
-                (__m128i *) &imIn->image32[x + 1 + xmin][xx]);
+                (__m128i *) &lines[x + 1][xx]);
 
             source = _mm_unpacklo_epi8(source1, source2);
             pix = _mm_unpacklo_epi8(source, _mm_setzero_si128());
@@ -120,9 +121,9 @@ ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, Imagin
             sss3 = _mm_add_epi32(sss3, _mm_madd_epi16(pix, mmk));
             
             source1 = _mm_loadu_si128(  // top line
-                (__m128i *) &imIn->image32[x + xmin][xx + 4]);
+                (__m128i *) &lines[x][xx + 4]);
             source2 = _mm_loadu_si128(  // bottom line
-                (__m128i *) &imIn->image32[x + 1 + xmin][xx + 4]);
+                (__m128i *) &lines[x + 1][xx + 4]);
 
             source = _mm_unpacklo_epi8(source1, source2);
             pix = _mm_unpacklo_epi8(source, _mm_setzero_si128());
@@ -141,7 +142,7 @@ ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, Imagin
             mmk = _mm_set1_epi32(k[x]);
             
             source1 = _mm_loadu_si128(  // top line
-                (__m128i *) &imIn->image32[x + xmin][xx]);
+                (__m128i *) &lines[x][xx]);
             
             source = _mm_unpacklo_epi8(source1, _mm_setzero_si128());
             pix = _mm_unpacklo_epi8(source, _mm_setzero_si128());
@@ -156,7 +157,7 @@ ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, Imagin
             sss3 = _mm_add_epi32(sss3, _mm_madd_epi16(pix, mmk));
 
             source1 = _mm_loadu_si128(  // top line
-                (__m128i *) &imIn->image32[x + xmin][xx + 4]);
+                (__m128i *) &lines[x][xx + 4]);
 
             source = _mm_unpacklo_epi8(source1, _mm_setzero_si128());
             pix = _mm_unpacklo_epi8(source, _mm_setzero_si128());
@@ -203,9 +204,9 @@ ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, Imagin
             mmk = _mm_set1_epi32(*(int32_t*) &k[x]);
 
             source1 = _mm_loadl_epi64(  // top line
-                (__m128i *) &imIn->image32[x + xmin][xx]);
+                (__m128i *) &lines[x][xx]);
             source2 = _mm_loadl_epi64(  // bottom line
-                (__m128i *) &imIn->image32[x + 1 + xmin][xx]);
+                (__m128i *) &lines[x + 1][xx]);
             
             source = _mm_unpacklo_epi8(source1, source2);
             pix = _mm_unpacklo_epi8(source, _mm_setzero_si128());
@@ -218,7 +219,7 @@ ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, Imagin
             mmk = _mm_set1_epi32(k[x]);
             
             source1 = _mm_loadl_epi64(  // top line
-                (__m128i *) &imIn->image32[x + xmin][xx]);
+                (__m128i *) &lines[x][xx]);
             
             source = _mm_unpacklo_epi8(source1, _mm_setzero_si128());
             pix = _mm_unpacklo_epi8(source, _mm_setzero_si128());
@@ -244,16 +245,16 @@ ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, Imagin
             // Load two coefficients at once
             mmk = _mm_set1_epi32(*(int32_t*) &k[x]);
             source1 = _mm_cvtsi32_si128(  // top line
-                *(int *) &imIn->image32[x + xmin][xx]);
+                *(int *) &lines[x][xx]);
             source2 = _mm_cvtsi32_si128(  // bottom line
-                *(int *) &imIn->image32[x + 1 + xmin][xx]);
+                *(int *) &lines[x + 1][xx]);
             
             source = _mm_unpacklo_epi8(source1, source2);
             pix = _mm_unpacklo_epi8(source, _mm_setzero_si128());
             sss = _mm_add_epi32(sss, _mm_madd_epi16(pix, mmk));
         }
         for (; x < xmax; x++) {
-            __m128i pix = _mm_cvtepu8_epi32(*(__m128i*)&imIn->image32[x + xmin][xx]);
+            __m128i pix = _mm_cvtepu8_epi32(*(__m128i*)&lines[x][xx]);
             __m128i mmk = _mm_set1_epi32(k[x]);
             sss = _mm_add_epi32(sss, _mm_madd_epi16(pix, mmk));
         }
@@ -262,3 +263,10 @@ ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, Imagin
         lineOut[xx] = _mm_cvtsi128_si32(_mm_packus_epi16(sss, sss));
     }
 }
+
+void __vectorcall
+ImagingResampleVerticalConvolution8u(uint32_t * const __restrict lineOut, ImagingMemoryInstance const * const __restrict imIn,
+    int const xmin, int const xmax, int16_t const * const __restrict k, int const coefs_precision)
+{
+    ImagingResampleVerticalConvolution8u(lineOut, (uint32_t const* const*)&imIn->image32[xmin], imIn->xsize, xmax, k, coefs_precision);
+}
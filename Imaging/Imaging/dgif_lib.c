@@ -1125,12 +1125,15 @@ DGifBufferedInput(GifFileType *GifFile, GifByteType *Buf, GifByteType *NextByte)
 }
 
 /******************************************************************************
- This routine reads an entire GIF into core, hanging all its state info off
- the GifFileType pointer.  Call DGifOpenFileName() or DGifOpenFileHandle()
- first to initialize I/O.  Its inverse is EGifSpew().
+ This routine reads the next image of a GIF into core, including any extension
+ blocks that precede it, hanging its state info off the GifFileType pointer.
+ ImageIndex is set to the index of the image in SavedImages, or -1 once the
+ terminator has been read. Allows frames to be consumed while the remainder of
+ the GIF is still being decoded. Call DGifOpenFileName() or DGifOpenFileHandle()
+ first to initialize I/O.
 *******************************************************************************/
 int
-DGifSlurp(GifFileType *GifFile)
+DGifSlurpNext(GifFileType *GifFile, int *ImageIndex)
 {
     size_t ImageSize;
     GifRecordType RecordType;
@@ -1138,8 +1141,7 @@ DGifSlurp(GifFileType *GifFile)
     GifByteType *ExtData;
     int ExtFunction;
 
-    GifFile->ExtensionBlocks = NULL;
-    GifFile->ExtensionBlockCount = 0;
+    *ImageIndex = -1;
 
     do {
         if (DGifGetRecordType(GifFile, &RecordType) == GIF_ERROR)
@@ -1199,7 +1201,9 @@ DGifSlurp(GifFileType *GifFile)
                   GifFile->ExtensionBlocks = NULL;
                   GifFile->ExtensionBlockCount = 0;
               }
-              break;
+
+              *ImageIndex = GifFile->ImageCount - 1;
+              return (GIF_OK);
 
           case EXTENSION_RECORD_TYPE:
               if (DGifGetExtension(GifFile,&ExtFunction,&ExtData) == GIF_ERROR)
@@ -1235,6 +1239,27 @@ DGifSlurp(GifFileType *GifFile)
         }
     } while (RecordType != TERMINATE_RECORD_TYPE);
 
+    return (GIF_OK);
+}
+
+/******************************************************************************
+ This routine reads an entire GIF into core, hanging all its state info off
+ the GifFileType pointer.  Call DGifOpenFileName() or DGifOpenFileHandle()
+ first to initialize I/O.  Its inverse is EGifSpew().
+*******************************************************************************/
+int
+DGifSlurp(GifFileType *GifFile)
+{
+    int ImageIndex;
+
+    GifFile->ExtensionBlocks = NULL;
+    GifFile->ExtensionBlockCount = 0;
+
+    do {
+        if (DGifSlurpNext(GifFile, &ImageIndex) == GIF_ERROR)
+            return (GIF_ERROR);
+    } while (ImageIndex != -1);
+
     /* Sanity check for corrupted file */
     if (GifFile->ImageCount == 0) {
 	GifFile->Error = D_GIF_ERR_NO_IMAG_DSCR;
@@ -186,6 +186,7 @@ int EGifPutCodeNext(GifFileType *GifFile,
 GifFileType *DGifOpenFileName(wchar_t const* const GifFileName, int *Error);
 GifFileType *DGifOpenFileHandle(int GifFileHandle, int *Error);
 int DGifSlurp(GifFileType * GifFile);
+int DGifSlurpNext(GifFileType * GifFile, int *ImageIndex);   /* one image at a time, ImageIndex -1 at end of file */
 GifFileType *DGifOpen(void *userPtr, InputFunc readFunc, int *Error);    /* new one (TVT) */
     int DGifCloseFile(GifFileType * GifFile, int *ErrorCode);
 
@@ -27,5 +27,8 @@
 #if INCLUDE_JPEG_SUPPORT
 #pragma comment(lib, "jpeg-static.lib")
 #endif
+#if INCLUDE_ZSTD_SUPPORT
+#pragma comment(lib, "zstd.lib")
+#endif
 
 
@@ -90,13 +90,26 @@ void Mesh::UpdateBuffers() {
 }
 
 void Mesh::CPUSkin(Skeleton& skeleton, Pose& pose) {
+	if (mPosition.size() == 0) { return; }
+
+	pose.GetMatrixPalette(mPosePalette);
+	CPUSkin(skeleton);
+}
+
+void Mesh::CPUSkin(Skeleton& skeleton, OrderedPose& pose) {
+	if (mPosition.size() == 0) { return; }
+
+	pose.GetMatrixPalette(mPosePalette);
+	CPUSkin(skeleton);
+}
+
+void Mesh::CPUSkin(Skeleton& skeleton) {
 	unsigned int numVerts = (unsigned int)mPosition.size();
 	if (numVerts == 0) { return; }
 
 	mSkinnedPosition.resize(numVerts);
 
-	pose.GetMatrixPalette(mPosePalette);
-	std::vector<mat4> invPosePalette = skeleton.GetInvBindPose();
+	std::vector<mat4>& invPosePalette = skeleton.GetInvBindPose();
 
 	for (unsigned int i = 0; i < numVerts; ++i) {
 		ivec4& j = mInfluences[i];
@@ -10,6 +10,7 @@
 #include "Attribute.h"
 #include "Skeleton.h"
 #include "Pose.h"
+#include "OrderedPose.h"
 
 class Mesh {
 protected:
@@ -29,6 +30,8 @@ protected:
 protected:
 	std::vector<vec3> mSkinnedPosition;
 	std::vector<mat4> mPosePalette;
+protected:
+	void CPUSkin(Skeleton& skeleton); // mPosePalette
 public:
 	Mesh();
 	Mesh(const Mesh&);
@@ -51,6 +54,7 @@ public:
 	std::vector<uint32_t>& GetMaterialIndices();
 
 	void CPUSkin(Skeleton& skeleton, Pose& pose);
+	void CPUSkin(Skeleton& skeleton, OrderedPose& pose);
 	void UpdateBuffers();
 };
 
@@ -0,0 +1,270 @@
+#include "OrderedPose.h"
+#include <cstring>
+#include <immintrin.h>
+
+// 8 joints per SIMD batch
+#define ORDEREDPOSE_BATCH 8
+
+// columns of 8 joints, a, b, c & d are 8 joints each -> out[joint] = (a, b, c, d)
+static inline void transpose4x8(__m256 a, __m256 b, __m256 c, __m256 d, __m128* out) {
+	__m256 t0 = _mm256_unpacklo_ps(a, b); // a0 b0 a1 b1 | a4 b4 a5 b5
+	__m256 t1 = _mm256_unpackhi_ps(a, b); // a2 b2 a3 b3 | a6 b6 a7 b7
+	__m256 t2 = _mm256_unpacklo_ps(c, d);
+	__m256 t3 = _mm256_unpackhi_ps(c, d);
+
+	__m256 r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)); // joint 0 | 4
+	__m256 r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)); // joint 1 | 5
+	__m256 r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)); // joint 2 | 6
+	__m256 r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)); // joint 3 | 7
+
+	out[0 * 4] = _mm256_castps256_ps128(r0);
+	out[1 * 4] = _mm256_castps256_ps128(r1);
+	out[2 * 4] = _mm256_castps256_ps128(r2);
+	out[3 * 4] = _mm256_castps256_ps128(r3);
+	out[4 * 4] = _mm256_extractf128_ps(r0, 1);
+	out[5 * 4] = _mm256_extractf128_ps(r1, 1);
+	out[6 * 4] = _mm256_extractf128_ps(r2, 1);
+	out[7 * 4] = _mm256_extractf128_ps(r3, 1);
+}
+
+// out = parent * local, column major (same as mat4 operator*)
+static inline void multiply(float* out, const float* parent, const __m128* local) {
+	__m128 p0 = _mm_loadu_ps(&parent[0]);
+	__m128 p1 = _mm_loadu_ps(&parent[4]);
+	__m128 p2 = _mm_loadu_ps(&parent[8]);
+	__m128 p3 = _mm_loadu_ps(&parent[12]);
+
+	for (int col = 0; col < 4; ++col) {
+		__m128 l = local[col];
+		__m128 r = _mm_mul_ps(p0, _mm_permute_ps(l, _MM_SHUFFLE(0, 0, 0, 0)));
+		r = _mm_fmadd_ps(p1, _mm_permute_ps(l, _MM_SHUFFLE(1, 1, 1, 1)), r);
+		r = _mm_fmadd_ps(p2, _mm_permute_ps(l, _MM_SHUFFLE(2, 2, 2, 2)), r);
+		r = _mm_fmadd_ps(p3, _mm_permute_ps(l, _MM_SHUFFLE(3, 3, 3, 3)), r);
+		_mm_storeu_ps(&out[col * 4], r);
+	}
+}
+
+OrderedPose::OrderedPose() : mSize(0), mAnyDirty(false) { }
+
+OrderedPose::OrderedPose(Pose& pose) : mSize(0), mAnyDirty(false) {
+	Set(pose);
+}
+
+void OrderedPose::Set(Pose& pose) {
+	unsigned int size = pose.Size();
+	unsigned int padded = (size + (ORDEREDPOSE_BATCH - 1)) & ~(ORDEREDPOSE_BATCH - 1);
+	mSize = size;
+
+	// Depth of every joint, each parent chain is only walked once
+	std::vector<int> depth(size, -1);
+	int maxDepth = 0;
+	for (unsigned int i = 0; i < size; ++i) {
+		int steps = 0;
+		int j = (int)i;
+		while (j >= 0 && j < (int)size && depth[j] < 0 && steps <= (int)size) {
+			j = pose.GetParent(j);
+			++steps;
+		}
+		int d = (j >= 0 && j < (int)size && depth[j] >= 0) ? depth[j] + steps : steps - 1;
+		maxDepth = d > maxDepth ? d : maxDepth;
+
+		j = (int)i;
+		for (int step = 0; step < steps; ++step) {
+			depth[j] = d--;
+			j = pose.GetParent(j);
+		}
+	}
+
+	// Sort by depth (stable), parents are always before their children
+	std::vector<unsigned int> start(maxDepth + 2, 0);
+	for (unsigned int i = 0; i < size; ++i) {
+		++start[depth[i] + 1];
+	}
+	for (int d = 0; d <= maxDepth; ++d) {
+		start[d + 1] += start[d];
+	}
+
+	mOrder.resize(size);
+	mSorted.resize(size);
+	mParents.resize(size);
+	for (unsigned int i = 0; i < size; ++i) {
+		mOrder[start[depth[i]]++] = i;
+	}
+	for (unsigned int s = 0; s < size; ++s) {
+		mSorted[mOrder[s]] = s;
+	}
+	for (unsigned int s = 0; s < size; ++s) {
+		int parent = pose.GetParent(mOrder[s]);
+		// a broken hierarchy (cycle) is cut, the joint becomes a root
+		mParents[s] = (parent < 0 || parent >= (int)size || mSorted[parent] >= s) ? -1 : (int)mSorted[parent];
+	}
+
+	// Padding joints are identity
+	mPositionX.assign(padded, 0.0f); mPositionY.assign(padded, 0.0f); mPositionZ.assign(padded, 0.0f);
+	mRotationX.assign(padded, 0.0f); mRotationY.assign(padded, 0.0f); mRotationZ.assign(padded, 0.0f); mRotationW.assign(padded, 1.0f);
+	mScaleX.assign(padded, 1.0f); mScaleY.assign(padded, 1.0f); mScaleZ.assign(padded, 1.0f);
+	mDirty.assign(padded, 0);
+	mGlobal.resize(size);
+
+	for (unsigned int s = 0; s < size; ++s) {
+		SetLocalTransform(mOrder[s], pose.GetLocalTransform(mOrder[s]));
+	}
+}
+
+void OrderedPose::SetLocalTransforms(Pose& pose) {
+	if (pose.Size() != mSize) {
+		Set(pose);
+		return;
+	}
+
+	for (unsigned int s = 0; s < mSize; ++s) {
+		Transform t = pose.GetLocalTransform(mOrder[s]);
+
+		if (t.position.x != mPositionX[s] || t.position.y != mPositionY[s] || t.position.z != mPositionZ[s] ||
+			t.rotation.x != mRotationX[s] || t.rotation.y != mRotationY[s] || t.rotation.z != mRotationZ[s] || t.rotation.w != mRotationW[s] ||
+			t.scale.x != mScaleX[s] || t.scale.y != mScaleY[s] || t.scale.z != mScaleZ[s]) {
+			SetLocalTransform(mOrder[s], t);
+		}
+	}
+}
+
+unsigned int OrderedPose::Size() {
+	return mSize;
+}
+
+Transform OrderedPose::GetLocalTransform(unsigned int index) {
+	unsigned int s = mSorted[index];
+	return Transform(
+		vec3(mPositionX[s], mPositionY[s], mPositionZ[s]),
+		quat(mRotationX[s], mRotationY[s], mRotationZ[s], mRotationW[s]),
+		vec3(mScaleX[s], mScaleY[s], mScaleZ[s]));
+}
+
+void OrderedPose::SetLocalTransform(unsigned int index, const Transform& transform) {
+	unsigned int s = mSorted[index];
+
+	mPositionX[s] = transform.position.x;
+	mPositionY[s] = transform.position.y;
+	mPositionZ[s] = transform.position.z;
+	mRotationX[s] = transform.rotation.x;
+	mRotationY[s] = transform.rotation.y;
+	mRotationZ[s] = transform.rotation.z;
+	mRotationW[s] = transform.rotation.w;
+	mScaleX[s] = transform.scale.x;
+	mScaleY[s] = transform.scale.y;
+	mScaleZ[s] = transform.scale.z;
+
+	mDirty[s] = 1;
+	mAnyDirty = true;
+}
+
+int OrderedPose::GetParent(unsigned int index) {
+	int parent = mParents[mSorted[index]];
+	return parent < 0 ? -1 : (int)mOrder[parent];
+}
+
+mat4 OrderedPose::GetGlobalMatrix(unsigned int index) {
+	UpdateGlobalMatrices();
+	return mGlobal[mSorted[index]];
+}
+
+void OrderedPose::GetMatrixPalette(std::vector<mat4>& out) {
+	UpdateGlobalMatrices();
+
+	if (out.size() != mSize) {
+		out.resize(mSize);
+	}
+	for (unsigned int s = 0; s < mSize; ++s) {
+		out[mOrder[s]] = mGlobal[s];
+	}
+}
+
+void OrderedPose::UpdateGlobalMatrices() {
+	if (!mAnyDirty) {
+		return;
+	}
+
+	// Children of a changed joint change too, parents are always visited first
+	for (unsigned int s = 0; s < mSize; ++s) {
+		if (mParents[s] >= 0) {
+			mDirty[s] |= mDirty[mParents[s]];
+		}
+	}
+
+	__m256 const zero = _mm256_setzero_ps();
+	__m256 const one = _mm256_set1_ps(1.0f);
+	__m128 local[ORDEREDPOSE_BATCH * 4]; // columns of the local matrices in the batch
+
+	for (unsigned int i = 0; i < mSize; i += ORDEREDPOSE_BATCH) {
+		unsigned long long batchDirty;
+		memcpy(&batchDirty, &mDirty[i], sizeof(batchDirty));
+		if (batchDirty == 0) { // unchanged
+			continue;
+		}
+
+		// Rotation basis of the local transforms, same as transformToMat4 (q * basis vector)
+		__m256 x = _mm256_loadu_ps(&mRotationX[i]);
+		__m256 y = _mm256_loadu_ps(&mRotationY[i]);
+		__m256 z = _mm256_loadu_ps(&mRotationZ[i]);
+		__m256 w = _mm256_loadu_ps(&mRotationW[i]);
+
+		__m256 x2 = _mm256_add_ps(x, x);
+		__m256 y2 = _mm256_add_ps(y, y);
+		__m256 z2 = _mm256_add_ps(z, z);
+
+		__m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+		__m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+		__m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+		// w * w - dot(vector, vector)
+		__m256 s = _mm256_fnmadd_ps(z, z, _mm256_fnmadd_ps(y, y, _mm256_fnmadd_ps(x, x, _mm256_mul_ps(w, w))));
+
+		// Scaled basis vectors
+		__m256 scaleX = _mm256_loadu_ps(&mScaleX[i]);
+		__m256 scaleY = _mm256_loadu_ps(&mScaleY[i]);
+		__m256 scaleZ = _mm256_loadu_ps(&mScaleZ[i]);
+
+		transpose4x8(
+			_mm256_mul_ps(_mm256_add_ps(xx, s), scaleX),
+			_mm256_mul_ps(_mm256_add_ps(xy, wz), scaleX),
+			_mm256_mul_ps(_mm256_sub_ps(xz, wy), scaleX),
+			zero, &local[0]);
+		transpose4x8(
+			_mm256_mul_ps(_mm256_sub_ps(xy, wz), scaleY),
+			_mm256_mul_ps(_mm256_add_ps(yy, s), scaleY),
+			_mm256_mul_ps(_mm256_add_ps(yz, wx), scaleY),
+			zero, &local[1]);
+		transpose4x8(
+			_mm256_mul_ps(_mm256_add_ps(xz, wy), scaleZ),
+			_mm256_mul_ps(_mm256_sub_ps(yz, wx), scaleZ),
+			_mm256_mul_ps(_mm256_add_ps(zz, s), scaleZ),
+			zero, &local[2]);
+		transpose4x8(
+			_mm256_loadu_ps(&mPositionX[i]),
+			_mm256_loadu_ps(&mPositionY[i]),
+			_mm256_loadu_ps(&mPositionZ[i]),
+			one, &local[3]);
+
+		// In order, a parent in the same batch is done before its children
+		unsigned int count = mSize - i < ORDEREDPOSE_BATCH ? mSize - i : ORDEREDPOSE_BATCH;
+		for (unsigned int k = 0; k < count; ++k) {
+			unsigned int joint = i + k;
+			if (!mDirty[joint]) {
+				continue;
+			}
+
+			int parent = mParents[joint];
+			if (parent < 0) {
+				for (int col = 0; col < 4; ++col) {
+					_mm_storeu_ps(&mGlobal[joint].v[col * 4], local[k * 4 + col]);
+				}
+			}
+			else {
+				multiply(mGlobal[joint].v, mGlobal[parent].v, &local[k * 4]);
+			}
+		}
+	}
+
+	memset(&mDirty[0], 0, mDirty.size());
+	mAnyDirty = false;
+}
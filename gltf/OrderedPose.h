@@ -0,0 +1,42 @@
+#pragma once
+#ifndef _H_ORDEREDPOSE_
+#define _H_ORDEREDPOSE_
+
+#include <vector>
+#include "Transform.h"
+#include "Pose.h"
+
+// Pose with the joints sorted parent before child & the local transforms stored as SoA.
+// The matrix palette is one linear pass, each joint reuses the global matrix of its parent.
+// Joints are addressed by their index in the source Pose, the sorted order is internal.
+// Only joints whose local transform changed (and their children) are recomputed.
+class OrderedPose {
+protected:
+	// local transforms, sorted order, padded to a multiple of 8 joints
+	std::vector<float> mPositionX, mPositionY, mPositionZ;
+	std::vector<float> mRotationX, mRotationY, mRotationZ, mRotationW;
+	std::vector<float> mScaleX, mScaleY, mScaleZ;
+
+	std::vector<int> mParents;			// sorted index of the parent, always less than the joint's sorted index. -1 is a root
+	std::vector<unsigned int> mOrder;	// sorted index -> joint index
+	std::vector<unsigned int> mSorted;	// joint index -> sorted index
+	std::vector<unsigned char> mDirty;	// sorted order, local transform changed since the last update
+	std::vector<mat4> mGlobal;			// sorted order
+	unsigned int mSize;
+	bool mAnyDirty;
+protected:
+	void UpdateGlobalMatrices();
+public:
+	OrderedPose();
+	OrderedPose(Pose& pose);
+	void Set(Pose& pose); // hierarchy & local transforms, everything is dirty
+	void SetLocalTransforms(Pose& pose); // local transforms of a pose with the same hierarchy (ie. sampled by a Clip), only joints that changed are dirty
+	unsigned int Size();
+	Transform GetLocalTransform(unsigned int index);
+	void SetLocalTransform(unsigned int index, const Transform& transform);
+	int GetParent(unsigned int index);
+	mat4 GetGlobalMatrix(unsigned int index);
+	void GetMatrixPalette(std::vector<mat4>& out); // joint order, same as Pose::GetMatrixPalette
+};
+
+#endif // !_H_ORDEREDPOSE_